@@ -0,0 +1,617 @@
+// ScreenCapBench: headless benchmark of the capture → convert → encode
+// pipeline.  Synthetic FP16 and BGRA8 frames of each size go through every
+// stage; each stage reports throughput (MPix/s at the median) and p50/p99
+// latency.  --replay captures the real desktop with DesktopDuplicator and
+// runs the stages on that frame instead.
+//
+//   ScreenCapBench [--iterations N] [--sizes 1080p,1440p,4k,3x4k]
+//                  [--stage NAME] [--replay]
+//   ScreenCapBench --verify
+//
+// Stages: blit (BGRA8 → FP16 compute blit), readback, crop (CPU crop of
+// the centre quarter), region (the same quarter cut on the GPU and read
+// back, as region captures do), tonemap-cpu, tonemap-gpu, png (Fast
+// preset), png-compact (the default save preset), jxr, dib (CF_DIBV5
+// build), and capture (--replay).
+//
+// --verify runs no benchmark: it checks the CPU tone-map kernel this
+// machine picks against the scalar reference over every half value and
+// reports the largest difference (exit code 1 above one code value).
+
+#include "capture/ClipboardImage.h"
+#include "capture/ConvertCpu.h"
+#include "capture/ConvertShader.h"
+#include "capture/DesktopDuplicator.h"
+#include "capture/FrameData.h"
+#include "capture/GpuToneMapper.h"
+#include "capture/PixelFormats.h"
+#include "capture/SaveImage.h"
+#include "capture/ThreadPool.h"
+
+#include <windows.h>
+#include <objbase.h>
+#include <d3d11.h>
+#include <dxgi.h>
+#include <DirectXPackedVector.h>
+#include <wrl/client.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cwchar>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+using namespace screencap::capture;
+
+namespace {
+
+constexpr UINT kThreadGroupSize = 16;
+constexpr float kPaperWhiteNits = 200.0f;
+
+struct Options {
+    int iterations{20};
+    std::vector<std::wstring> sizes{L"1080p", L"1440p", L"4k", L"3x4k"};
+    std::wstring stage;     // empty = all
+    bool replay{false};
+    bool verify{false};
+};
+
+struct Size {
+    const wchar_t* name;
+    uint32_t width;
+    uint32_t height;
+};
+
+constexpr Size kSizes[] = {
+    {L"1080p", 1920, 1080},
+    {L"1440p", 2560, 1440},
+    {L"4k", 3840, 2160},
+    {L"3x4k", 3 * 3840, 2160},
+};
+
+// Layout matching the compute shader's BlitParams (see DesktopDuplicator).
+struct BlitParams {
+    int srcOffsetX, srcOffsetY;
+    int dstOffsetX, dstOffsetY;
+    int blitW, blitH;
+    int pad0, pad1;
+};
+
+struct Bench {
+    ComPtr<ID3D11Device>        device;
+    ComPtr<ID3D11DeviceContext> ctx;
+    ComPtr<ID3D11Query>         idle;
+    ComPtr<ID3D11ComputeShader> blitCs;
+    ComPtr<ID3D11Buffer>        blitParams;
+    GpuToneMapper               toneMapper;
+    ThreadPool                  pool;
+    Options                     options;
+};
+
+// ── Helpers ─────────────────────────────────────────────────────────
+
+std::optional<Options> ParseArgs(int argc, wchar_t** argv)
+{
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        const std::wstring arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == L"--iterations" && hasValue) {
+            o.iterations = (std::max)(1, _wtoi(argv[++i]));
+        } else if (arg == L"--sizes" && hasValue) {
+            o.sizes.clear();
+            std::wstring list = argv[++i];
+            for (size_t pos = 0; pos <= list.size();) {
+                const size_t comma = (std::min)(list.find(L',', pos), list.size());
+                if (comma > pos) o.sizes.push_back(list.substr(pos, comma - pos));
+                pos = comma + 1;
+            }
+        } else if (arg == L"--stage" && hasValue) {
+            o.stage = argv[++i];
+        } else if (arg == L"--replay") {
+            o.replay = true;
+        } else if (arg == L"--verify") {
+            o.verify = true;
+        } else {
+            return std::nullopt;
+        }
+    }
+    return o;
+}
+
+bool Wanted(const Bench& b, const wchar_t* stage)
+{
+    return b.options.stage.empty() || b.options.stage == stage;
+}
+
+double NowMs()
+{
+    using clock = std::chrono::steady_clock;
+    return std::chrono::duration<double, std::milli>(clock::now().time_since_epoch()).count();
+}
+
+// Block until the GPU has finished everything submitted so far.
+void WaitForGpu(Bench& b)
+{
+    b.ctx->End(b.idle.Get());
+    b.ctx->Flush();
+    BOOL done = FALSE;
+    while (b.ctx->GetData(b.idle.Get(), &done, sizeof(done), 0) == S_FALSE) {
+        ::SwitchToThread();
+    }
+}
+
+// One warm-up run, then `iterations` timed runs of `run`.  `prepare` runs
+// untimed before each.
+std::vector<double> Measure(int iterations, const std::function<void()>& prepare,
+                            const std::function<bool()>& run)
+{
+    std::vector<double> ms;
+    for (int i = 0; i <= iterations; ++i) {
+        if (prepare) prepare();
+        const double start = NowMs();
+        if (!run()) return {};
+        const double elapsed = NowMs() - start;
+        if (i > 0) ms.push_back(elapsed);
+    }
+    return ms;
+}
+
+void Report(const wchar_t* stage, const wchar_t* size, const wchar_t* format,
+            uint64_t pixels, std::vector<double> ms)
+{
+    if (ms.empty()) {
+        std::wprintf(L"%-12s %-6s %-5s   failed / unsupported\n", stage, size, format);
+        return;
+    }
+    std::sort(ms.begin(), ms.end());
+    const double p50 = ms[ms.size() / 2];
+    const double p99 = ms[(std::min)(ms.size() - 1, ms.size() * 99 / 100)];
+    const double mpixPerS = p50 > 0.0 ? static_cast<double>(pixels) / (p50 * 1000.0) : 0.0;
+    std::wprintf(L"%-12s %-6s %-5s %9.1f MPix/s   p50 %8.2f ms   p99 %8.2f ms\n",
+                 stage, size, format, mpixPerS, p50, p99);
+}
+
+// ── Synthetic frames ────────────────────────────────────────────────
+//
+// Gradients with low-order noise, so encoders see realistic entropy, and
+// (FP16) highlights up to 4× paper white in one band.
+
+uint32_t NextRandom(uint32_t& state) noexcept
+{
+    state = state * 1664525u + 1013904223u;
+    return state >> 24;
+}
+
+FrameData MakeBgra8Frame(uint32_t width, uint32_t height)
+{
+    FrameData f;
+    f.width = width;
+    f.height = height;
+    f.format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    f.bytesPerPixel = 4;
+    f.pixels.resize(static_cast<size_t>(width) * height * 4);
+
+    uint32_t rng = 12345;
+    uint8_t* p = f.pixels.data();
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x, p += 4) {
+            const uint32_t noise = NextRandom(rng) & 7;
+            p[0] = static_cast<uint8_t>((x * 255 / width) ^ noise);
+            p[1] = static_cast<uint8_t>((y * 255 / height) ^ noise);
+            p[2] = static_cast<uint8_t>(((x + y) & 0xFF) ^ noise);
+            p[3] = 255;
+        }
+    }
+    return f;
+}
+
+FrameData MakeFp16Frame(uint32_t width, uint32_t height)
+{
+    using DirectX::PackedVector::XMConvertFloatToHalf;
+
+    FrameData f;
+    f.width = width;
+    f.height = height;
+    f.format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+    f.bytesPerPixel = 8;
+    f.pixels.resize(static_cast<size_t>(width) * height * 8);
+
+    const float white = kPaperWhiteNits / 80.0f;
+    uint32_t rng = 54321;
+    auto* p = reinterpret_cast<uint16_t*>(f.pixels.data());
+    for (uint32_t y = 0; y < height; ++y) {
+        const bool highlight = (y * 8 / height) == 3;
+        for (uint32_t x = 0; x < width; ++x, p += 4) {
+            const float noise = static_cast<float>(NextRandom(rng)) / 4096.0f;
+            const float gx = static_cast<float>(x) / static_cast<float>(width);
+            const float gy = static_cast<float>(y) / static_cast<float>(height);
+            const float gain = highlight ? 4.0f * white : white;
+            p[0] = XMConvertFloatToHalf((gx + noise) * gain);
+            p[1] = XMConvertFloatToHalf((gy + noise) * gain);
+            p[2] = XMConvertFloatToHalf((1.0f - gx + noise) * gain);
+            p[3] = XMConvertFloatToHalf(1.0f);
+        }
+    }
+    return f;
+}
+
+ComPtr<ID3D11Texture2D> Upload(Bench& b, const FrameData& f, UINT bindFlags)
+{
+    D3D11_TEXTURE2D_DESC desc{};
+    desc.Width = f.width;
+    desc.Height = f.height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = static_cast<DXGI_FORMAT>(f.format);
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = bindFlags;
+
+    const D3D11_SUBRESOURCE_DATA init{f.pixels.data(), f.width * f.bytesPerPixel, 0};
+    ComPtr<ID3D11Texture2D> tex;
+    if (FAILED(b.device->CreateTexture2D(&desc, f.pixels.empty() ? nullptr : &init, &tex))) return nullptr;
+    return tex;
+}
+
+// A GPU-only copy of the frame's description.
+FrameData GpuView(const FrameData& f, ComPtr<ID3D11Texture2D> tex)
+{
+    FrameData g;
+    g.gpuTexture = std::move(tex);
+    g.width = f.width;
+    g.height = f.height;
+    g.format = f.format;
+    g.bytesPerPixel = f.bytesPerPixel;
+    return g;
+}
+
+// ── Stages ──────────────────────────────────────────────────────────
+
+std::vector<double> BenchBlit(Bench& b, const FrameData& bgra8)
+{
+    if (!b.blitCs) return {};
+
+    FrameData fp16Desc;
+    fp16Desc.width = bgra8.width;
+    fp16Desc.height = bgra8.height;
+    fp16Desc.format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+    fp16Desc.bytesPerPixel = 8;
+
+    const auto src = Upload(b, bgra8, D3D11_BIND_SHADER_RESOURCE);
+    const auto dst = Upload(b, fp16Desc, D3D11_BIND_UNORDERED_ACCESS);
+    if (!src || !dst) return {};
+
+    ComPtr<ID3D11ShaderResourceView> srv;
+    ComPtr<ID3D11UnorderedAccessView> uav;
+    if (FAILED(b.device->CreateShaderResourceView(src.Get(), nullptr, &srv)) ||
+        FAILED(b.device->CreateUnorderedAccessView(dst.Get(), nullptr, &uav))) {
+        return {};
+    }
+
+    const BlitParams params{0, 0, 0, 0, static_cast<int>(bgra8.width), static_cast<int>(bgra8.height), 0, 0};
+    b.ctx->UpdateSubresource(b.blitParams.Get(), 0, nullptr, &params, 0, 0);
+
+    return Measure(b.options.iterations, nullptr, [&] {
+        b.ctx->CSSetShader(b.blitCs.Get(), nullptr, 0);
+        b.ctx->CSSetConstantBuffers(0, 1, b.blitParams.GetAddressOf());
+        b.ctx->CSSetShaderResources(0, 1, srv.GetAddressOf());
+        b.ctx->CSSetUnorderedAccessViews(0, 1, uav.GetAddressOf(), nullptr);
+        b.ctx->Dispatch((bgra8.width + kThreadGroupSize - 1) / kThreadGroupSize,
+                        (bgra8.height + kThreadGroupSize - 1) / kThreadGroupSize, 1);
+        ID3D11ShaderResourceView* nullSrv = nullptr;
+        ID3D11UnorderedAccessView* nullUav = nullptr;
+        b.ctx->CSSetShaderResources(0, 1, &nullSrv);
+        b.ctx->CSSetUnorderedAccessViews(0, 1, &nullUav, nullptr);
+        WaitForGpu(b);
+        return true;
+    });
+}
+
+std::vector<double> BenchReadback(Bench& b, const FrameData& gpu)
+{
+    FrameData f;
+    return Measure(b.options.iterations,
+                   [&] { f = GpuView(gpu, gpu.gpuTexture); },
+                   [&] { return ReadbackPixels(f, b.ctx.Get()); });
+}
+
+// The centre quarter of the frame, standing in for a region selection.
+RECT CentreRegion(const FrameData& f)
+{
+    return {static_cast<LONG>(f.width / 4), static_cast<LONG>(f.height / 4),
+            static_cast<LONG>(f.width * 3 / 4), static_cast<LONG>(f.height * 3 / 4)};
+}
+
+std::vector<double> BenchCrop(Bench& b, const FrameData& cpu)
+{
+    const RECT sel = CentreRegion(cpu);
+    return Measure(b.options.iterations, nullptr, [&] {
+        const FrameData out = CropFrame(cpu, sel);
+        return !out.pixels.empty();
+    });
+}
+
+// Like ExtractRegion: FP16 is tone-mapped on the GPU for just the region,
+// then read back; BGRA8 is read back directly.
+std::vector<double> BenchRegion(Bench& b, const FrameData& gpu)
+{
+    const RECT sel = CentreRegion(gpu);
+    const D3D11_BOX box{static_cast<UINT>(sel.left), static_cast<UINT>(sel.top), 0,
+                        static_cast<UINT>(sel.right), static_cast<UINT>(sel.bottom), 1};
+    const bool fp16 = static_cast<DXGI_FORMAT>(gpu.format) == DXGI_FORMAT_R16G16B16A16_FLOAT;
+    return Measure(b.options.iterations, nullptr, [&] {
+        if (fp16 && b.toneMapper.IsReady()) {
+            auto sdr = b.toneMapper.ToneMapToBgra8(gpu, kPaperWhiteNits, &box);
+            return sdr && ReadbackPixels(*sdr, b.ctx.Get());
+        }
+        FrameData out;
+        return ReadbackRegion(gpu, box, b.ctx.Get(), out);
+    });
+}
+
+std::vector<double> BenchToneMapCpu(Bench& b, const FrameData& fp16)
+{
+    FrameData f;
+    return Measure(b.options.iterations,
+                   [&] { f = fp16; f.sdrCache.reset(); },
+                   [&] { return ConvertToBgra8(f, &b.pool); });
+}
+
+std::vector<double> BenchToneMapGpu(Bench& b, const FrameData& gpuFp16)
+{
+    if (!b.toneMapper.IsReady()) return {};
+    return Measure(b.options.iterations, nullptr, [&] {
+        const auto out = b.toneMapper.ToneMapToBgra8(gpuFp16, kPaperWhiteNits);
+        WaitForGpu(b);
+        return out.has_value();
+    });
+}
+
+template <typename Encode>
+std::vector<double> BenchEncode(Bench& b, Encode&& encode)
+{
+    ComPtr<IStream> stream;
+    return Measure(b.options.iterations,
+                   [&] {
+                       stream.Reset();
+                       (void)::CreateStreamOnHGlobal(nullptr, TRUE, &stream);
+                   },
+                   [&] { return stream && encode(stream.Get()); });
+}
+
+std::vector<double> BenchDib(Bench& b, const FrameData& frame)
+{
+    return Measure(b.options.iterations, nullptr, [&] {
+        HGLOBAL dib = BuildDibV5(frame, &b.pool);
+        if (!dib) return false;
+        ::GlobalFree(dib);
+        return true;
+    });
+}
+
+// Every stage that applies to `cpu` (CPU pixels) / `gpu` (same frame on the GPU).
+void RunStages(Bench& b, const wchar_t* sizeName, const FrameData& cpu, const FrameData& gpu)
+{
+    const bool fp16 = static_cast<DXGI_FORMAT>(cpu.format) == DXGI_FORMAT_R16G16B16A16_FLOAT;
+    const wchar_t* formatName = fp16 ? L"FP16" : L"BGRA8";
+    const uint64_t pixels = static_cast<uint64_t>(cpu.width) * cpu.height;
+
+    if (!fp16 && Wanted(b, L"blit")) {
+        Report(L"blit", sizeName, formatName, pixels, BenchBlit(b, cpu));
+    }
+    if (gpu.gpuTexture && Wanted(b, L"readback")) {
+        Report(L"readback", sizeName, formatName, pixels, BenchReadback(b, gpu));
+    }
+    const uint64_t regionPixels = static_cast<uint64_t>(cpu.width * 3 / 4 - cpu.width / 4) *
+                                  (cpu.height * 3 / 4 - cpu.height / 4);
+    if (Wanted(b, L"crop")) {
+        Report(L"crop", sizeName, formatName, regionPixels, BenchCrop(b, cpu));
+    }
+    if (gpu.gpuTexture && Wanted(b, L"region")) {
+        Report(L"region", sizeName, formatName, regionPixels, BenchRegion(b, gpu));
+    }
+    if (fp16 && Wanted(b, L"tonemap-cpu")) {
+        Report(L"tonemap-cpu", sizeName, formatName, pixels, BenchToneMapCpu(b, cpu));
+    }
+    if (fp16 && gpu.gpuTexture && Wanted(b, L"tonemap-gpu")) {
+        Report(L"tonemap-gpu", sizeName, formatName, pixels, BenchToneMapGpu(b, gpu));
+    }
+
+    // Encoders and the DIB see the SDR rendition already made, so they
+    // time only their own work.
+    (void)SdrBgra8(cpu, &b.pool);
+
+    if (Wanted(b, L"png")) {
+        Report(L"png", sizeName, formatName, pixels, BenchEncode(b, [&](IStream* s) {
+            return EncodePng(cpu, s, &b.pool, PngPreset::Fast);
+        }));
+    }
+    if (Wanted(b, L"png-compact")) {
+        Report(L"png-compact", sizeName, formatName, pixels, BenchEncode(b, [&](IStream* s) {
+            return EncodePng(cpu, s, &b.pool, PngPreset::Compact);
+        }));
+    }
+    if (fp16 && Wanted(b, L"jxr")) {
+        Report(L"jxr", sizeName, formatName, pixels, BenchEncode(b, [&](IStream* s) {
+            return EncodeJxr(cpu, s);
+        }));
+    }
+    if (Wanted(b, L"dib")) {
+        Report(L"dib", sizeName, formatName, pixels, BenchDib(b, cpu));
+    }
+}
+
+void RunSynthetic(Bench& b)
+{
+    for (const auto& name : b.options.sizes) {
+        const auto it = std::find_if(std::begin(kSizes), std::end(kSizes),
+                                     [&](const Size& s) { return name == s.name; });
+        if (it == std::end(kSizes)) {
+            std::wprintf(L"unknown size %s\n", name.c_str());
+            continue;
+        }
+        for (const bool fp16 : {false, true}) {
+            const FrameData cpu = fp16 ? MakeFp16Frame(it->width, it->height)
+                                       : MakeBgra8Frame(it->width, it->height);
+            const FrameData gpu = GpuView(cpu, Upload(b, cpu, D3D11_BIND_SHADER_RESOURCE));
+            RunStages(b, it->name, cpu, gpu);
+        }
+    }
+}
+
+// Capture the real desktop as the app does (continuous mode), then run
+// the stages on that frame.
+bool RunReplay(Bench& b)
+{
+    DesktopDuplicator duplicator;
+    duplicator.SetContinuous(true);
+    if (!duplicator.Init(b.device.Get())) {
+        std::wprintf(L"DesktopDuplicator::Init failed\n");
+        return false;
+    }
+
+    std::optional<FrameData> frame;
+    const auto ms = Measure(b.options.iterations, [&] { frame.reset(); }, [&] {
+        frame = duplicator.CaptureFullDesktop(&b.pool);
+        WaitForGpu(b);
+        return frame.has_value();
+    });
+    if (!frame) {
+        std::wprintf(L"CaptureFullDesktop failed\n");
+        return false;
+    }
+
+    const uint64_t pixels = static_cast<uint64_t>(frame->width) * frame->height;
+    const bool fp16 = static_cast<DXGI_FORMAT>(frame->format) == DXGI_FORMAT_R16G16B16A16_FLOAT;
+    if (Wanted(b, L"capture")) {
+        Report(L"capture", L"live", fp16 ? L"FP16" : L"BGRA8", pixels, ms);
+    }
+
+    FrameData cpu = GpuView(*frame, frame->gpuTexture);
+    if (!ReadbackPixels(cpu, b.ctx.Get())) return false;
+    cpu.gpuTexture.Reset();
+    RunStages(b, L"live", cpu, *frame);
+    return true;
+}
+
+// ── Kernel check ────────────────────────────────────────────────────
+
+// ScRgb16fToBgra8Pixels against ScRgb16fToBgra8PixelsScalar with every
+// half value in each colour channel, at unit scale and at the bench's
+// paper white.  True if they agree to within one code value.
+bool VerifyCpuToneMap()
+{
+    constexpr size_t kHalves = 65536;
+    constexpr uint16_t kHalfOne = 0x3C00;
+
+    // Pixel i: R = G = B = half i.
+    std::vector<uint16_t> src(kHalves * 4);
+    for (size_t i = 0; i < kHalves; ++i) {
+        const auto h = static_cast<uint16_t>(i);
+        src[i * 4 + 0] = h;
+        src[i * 4 + 1] = h;
+        src[i * 4 + 2] = h;
+        src[i * 4 + 3] = kHalfOne;
+    }
+
+    std::wprintf(L"kernel: %s\n", CpuHasAvx2F16c() ? L"AVX2 + F16C" : L"scalar");
+    std::vector<uint8_t> fast(kHalves * 4);
+    std::vector<uint8_t> reference(kHalves * 4);
+    int worstOverall = 0;
+    for (const float scale : {1.0f, 80.0f / kPaperWhiteNits}) {
+        ScRgb16fToBgra8Pixels(src.data(), fast.data(), kHalves, scale);
+        ScRgb16fToBgra8PixelsScalar(src.data(), reference.data(), kHalves, scale);
+
+        int worst = 0;
+        size_t worstHalf = 0;
+        size_t differing = 0;
+        for (size_t i = 0; i < kHalves * 4; ++i) {
+            const int diff = std::abs(static_cast<int>(fast[i]) - static_cast<int>(reference[i]));
+            if (diff != 0) ++differing;
+            if (diff > worst) {
+                worst = diff;
+                worstHalf = i / 4;
+            }
+        }
+        std::wprintf(L"scale %.4f: max difference %d code value(s) (half 0x%04zx), %zu of %zu channels differ\n",
+                     scale, worst, worstHalf, differing, kHalves * 4);
+        worstOverall = (std::max)(worstOverall, worst);
+    }
+    return worstOverall <= 1;
+}
+
+bool InitDevice(Bench& b)
+{
+    HRESULT hr = ::D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr,
+                                     D3D11_CREATE_DEVICE_BGRA_SUPPORT, nullptr, 0,
+                                     D3D11_SDK_VERSION, &b.device, nullptr, &b.ctx);
+    if (FAILED(hr)) return false;
+
+    const D3D11_QUERY_DESC queryDesc{D3D11_QUERY_EVENT, 0};
+    if (FAILED(b.device->CreateQuery(&queryDesc, &b.idle))) return false;
+
+    (void)b.device->CreateComputeShader(kBgra8ToFp16CS, sizeof(kBgra8ToFp16CS), nullptr, &b.blitCs);
+    D3D11_BUFFER_DESC cbDesc{};
+    cbDesc.ByteWidth = sizeof(BlitParams);
+    cbDesc.Usage = D3D11_USAGE_DEFAULT;
+    cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    (void)b.device->CreateBuffer(&cbDesc, nullptr, &b.blitParams);
+
+    (void)b.toneMapper.Init(b.device.Get());
+
+    ComPtr<IDXGIDevice> dxgiDevice;
+    ComPtr<IDXGIAdapter> adapter;
+    DXGI_ADAPTER_DESC desc{};
+    if (SUCCEEDED(b.device.As(&dxgiDevice)) && SUCCEEDED(dxgiDevice->GetAdapter(&adapter)) &&
+        SUCCEEDED(adapter->GetDesc(&desc))) {
+        std::wprintf(L"GPU: %s\n", desc.Description);
+    }
+    std::wprintf(L"CPU workers: %u\n\n", b.pool.WorkerCount());
+    return true;
+}
+
+} // namespace
+
+int wmain(int argc, wchar_t** argv)
+{
+    const auto options = ParseArgs(argc, argv);
+    if (!options) {
+        std::wprintf(L"usage: ScreenCapBench [--iterations N] [--sizes 1080p,1440p,4k,3x4k] "
+                     L"[--stage NAME] [--replay]\n"
+                     L"       ScreenCapBench --verify\n");
+        return 2;
+    }
+    if (options->verify) {
+        return VerifyCpuToneMap() ? 0 : 1;
+    }
+
+    // Per-monitor DPI awareness so duplication sizes are physical pixels.
+    (void)::SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
+
+    // WIC needs COM.
+    const HRESULT com = ::CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    if (FAILED(com)) return 1;
+
+    int ret = 0;
+    {
+        Bench bench;
+        bench.options = *options;
+        if (!InitDevice(bench)) {
+            std::wprintf(L"D3D11CreateDevice failed\n");
+            ret = 1;
+        } else if (bench.options.replay) {
+            ret = RunReplay(bench) ? 0 : 1;
+        } else {
+            RunSynthetic(bench);
+        }
+    }
+
+    ::CoUninitialize();
+    return ret;
+}
@@ -0,0 +1,203 @@
+#include "capture/AsyncReadback.h"
+#include "capture/PixelFormats.h"
+
+#include <cstring>
+
+using Microsoft::WRL::ComPtr;
+
+namespace screencap::capture {
+
+AsyncReadback::~AsyncReadback()
+{
+    for (auto& slot : slots_) {
+        Cancel(slot.ticket);
+    }
+    if (event_) {
+        ::CloseHandle(event_);
+    }
+}
+
+bool AsyncReadback::Init(ID3D11Device* device)
+{
+    for (auto& slot : slots_) {
+        Cancel(slot.ticket);
+        slot.staging.Reset();
+        slot.desc = {};
+    }
+    device_.Reset();
+    ctx_.Reset();
+    ctx4_.Reset();
+    fence_.Reset();
+    fenceValue_ = 0;
+
+    if (!device) return false;
+    device_ = device;
+    device_->GetImmediateContext(&ctx_);
+
+    // Optional: a fence lets callers sleep until the copy lands instead of
+    // polling.  Needs D3D11.4 and driver support.
+    ComPtr<ID3D11Device5> device5;
+    if (SUCCEEDED(device_.As(&device5)) && SUCCEEDED(ctx_.As(&ctx4_)) &&
+        SUCCEEDED(device5->CreateFence(0, D3D11_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_)))) {
+        if (!event_) {
+            event_ = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        }
+    }
+    if (!event_) {
+        fence_.Reset();
+        ctx4_.Reset();
+    }
+
+    return true;
+}
+
+AsyncReadback::Ticket AsyncReadback::Begin(FrameData frame, Callback onDone)
+{
+    if (!device_ || !frame.gpuTexture) return 0;
+
+    // Pick a free slot, or finish the oldest one to make room.
+    Slot* slot = nullptr;
+    for (auto& s : slots_) {
+        if (s.ticket == 0) { slot = &s; break; }
+    }
+    if (!slot) {
+        slot = &slots_[0];
+        for (auto& s : slots_) {
+            if (s.ticket < slot->ticket) slot = &s;
+        }
+        (void)TryComplete(*slot, true);
+    }
+
+    D3D11_TEXTURE2D_DESC desc{};
+    frame.gpuTexture->GetDesc(&desc);
+
+    // Staging textures are kept between captures; only a size or format
+    // change reallocates.
+    if (!slot->staging ||
+        slot->desc.Width != desc.Width || slot->desc.Height != desc.Height ||
+        slot->desc.Format != desc.Format) {
+        D3D11_TEXTURE2D_DESC stagingDesc{};
+        stagingDesc.Width            = desc.Width;
+        stagingDesc.Height           = desc.Height;
+        stagingDesc.MipLevels        = 1;
+        stagingDesc.ArraySize        = 1;
+        stagingDesc.Format           = desc.Format;
+        stagingDesc.SampleDesc.Count = 1;
+        stagingDesc.Usage            = D3D11_USAGE_STAGING;
+        stagingDesc.CPUAccessFlags   = D3D11_CPU_ACCESS_READ;
+
+        slot->staging.Reset();
+        slot->desc = {};
+        if (FAILED(device_->CreateTexture2D(&stagingDesc, nullptr, &slot->staging))) return 0;
+        slot->desc = stagingDesc;
+    }
+
+    ctx_->CopyResource(slot->staging.Get(), frame.gpuTexture.Get());
+
+    if (fence_) {
+        ++fenceValue_;
+        if (SUCCEEDED(ctx4_->Signal(fence_.Get(), fenceValue_))) {
+            (void)fence_->SetEventOnCompletion(fenceValue_, event_);
+        }
+    }
+
+    // Submit now so the copy runs while the caller does other work.
+    ctx_->Flush();
+
+    slot->ticket = nextTicket_++;
+    slot->frame  = std::move(frame);
+    slot->onDone = std::move(onDone);
+    return slot->ticket;
+}
+
+bool AsyncReadback::TryComplete(Slot& slot, bool wait)
+{
+    if (slot.ticket == 0) return true;
+
+    D3D11_MAPPED_SUBRESOURCE mapped{};
+    const HRESULT hr = ctx_->Map(slot.staging.Get(), 0, D3D11_MAP_READ,
+                                 wait ? 0 : D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+    if (hr == DXGI_ERROR_WAS_STILL_DRAWING) return false;
+
+    // Take everything out of the slot first: the callback may Begin() again.
+    FrameData frame = std::move(slot.frame);
+    Callback onDone = std::move(slot.onDone);
+    slot.frame  = {};
+    slot.onDone = nullptr;
+    slot.ticket = 0;
+
+    const bool ok = SUCCEEDED(hr);
+    if (ok) {
+        const uint32_t bpp       = BytesPerPixel(slot.desc.Format);
+        const uint32_t dstStride = slot.desc.Width * bpp;
+        frame.pixels.resize(static_cast<size_t>(dstStride) * slot.desc.Height);
+
+        const auto* src = static_cast<const uint8_t*>(mapped.pData);
+        for (uint32_t row = 0; row < slot.desc.Height; ++row) {
+            std::memcpy(
+                frame.pixels.data() + static_cast<size_t>(row) * dstStride,
+                src + static_cast<size_t>(row) * mapped.RowPitch,
+                dstStride);
+        }
+        ctx_->Unmap(slot.staging.Get(), 0);
+    }
+
+    if (onDone) {
+        onDone(std::move(frame), ok);
+    }
+    return true;
+}
+
+void AsyncReadback::Poll()
+{
+    // Oldest first, so callbacks run in submission order.
+    for (;;) {
+        Slot* oldest = nullptr;
+        for (auto& s : slots_) {
+            if (s.ticket != 0 && (!oldest || s.ticket < oldest->ticket)) oldest = &s;
+        }
+        if (!oldest || !TryComplete(*oldest, false)) return;
+    }
+}
+
+void AsyncReadback::Wait(Ticket ticket)
+{
+    if (ticket == 0) return;
+
+    // Earlier readbacks finish first to keep callbacks in order.
+    for (;;) {
+        Slot* oldest = nullptr;
+        bool found = false;
+        for (auto& s : slots_) {
+            if (s.ticket == 0 || s.ticket > ticket) continue;
+            if (s.ticket == ticket) found = true;
+            if (!oldest || s.ticket < oldest->ticket) oldest = &s;
+        }
+        if (!found || !oldest) return;
+        (void)TryComplete(*oldest, true);
+    }
+}
+
+void AsyncReadback::Cancel(Ticket ticket) noexcept
+{
+    if (ticket == 0) return;
+    for (auto& s : slots_) {
+        if (s.ticket == ticket) {
+            // The staging copy may still be in flight; that's harmless —
+            // the next Begin() on this slot simply overwrites it.
+            s.ticket = 0;
+            s.frame  = {};
+            s.onDone = nullptr;
+        }
+    }
+}
+
+bool AsyncReadback::HasPending() const noexcept
+{
+    for (const auto& s : slots_) {
+        if (s.ticket != 0) return true;
+    }
+    return false;
+}
+
+} // namespace screencap::capture
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "capture/FrameData.h"
+
+#include <d3d11.h>
+#include <d3d11_4.h>
+#include <windows.h>
+#include <wrl/client.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+
+namespace screencap::capture {
+
+// Non-blocking GPU → CPU readback through a small ring of reusable staging
+// textures.  Begin() queues the copy and returns immediately; Poll() maps
+// finished copies with D3D11_MAP_FLAG_DO_NOT_WAIT and runs their callbacks.
+//
+// Uses the device's immediate context, so every call must come from the
+// thread that owns it (the tray/UI thread).
+class AsyncReadback final {
+public:
+    // ok is false if the copy could not be mapped; frame.pixels is then empty.
+    using Callback = std::function<void(FrameData&& frame, bool ok)>;
+    using Ticket   = uint64_t;   // 0 = invalid
+
+    AsyncReadback() = default;
+    ~AsyncReadback();
+
+    AsyncReadback(const AsyncReadback&) = delete;
+    AsyncReadback& operator=(const AsyncReadback&) = delete;
+    AsyncReadback(AsyncReadback&&) = delete;
+    AsyncReadback& operator=(AsyncReadback&&) = delete;
+
+    [[nodiscard]] bool Init(ID3D11Device* device);
+
+    // Queue a readback of frame.gpuTexture.  The frame is handed back,
+    // with pixels filled in, through onDone from Poll() or Wait().
+    // If every slot is busy the oldest one is finished first (blocking).
+    // Returns 0 if the frame has no GPU texture or on error.
+    [[nodiscard]] Ticket Begin(FrameData frame, Callback onDone);
+
+    // Complete every copy the GPU has finished.  Never blocks.
+    void Poll();
+
+    // Block until the given readback has completed and its callback ran.
+    // No-op if the ticket already completed or was cancelled.
+    void Wait(Ticket ticket);
+
+    // Drop a pending readback without running its callback.
+    void Cancel(Ticket ticket) noexcept;
+
+    [[nodiscard]] bool HasPending() const noexcept;
+
+    // Auto-reset event signalled as queued copies finish, for use with
+    // MsgWaitForMultipleObjects.  Null if the driver has no D3D11 fences;
+    // callers then poll on a short timeout.
+    [[nodiscard]] HANDLE CompletionEvent() const noexcept { return event_; }
+
+private:
+    static constexpr size_t kSlotCount = 2;
+
+    struct Slot {
+        Microsoft::WRL::ComPtr<ID3D11Texture2D> staging;
+        D3D11_TEXTURE2D_DESC                    desc{};
+        Ticket                                  ticket{};   // 0 = free
+        FrameData                               frame;
+        Callback                                onDone;
+    };
+
+    // Map (optionally without waiting) and finish one slot.
+    // Returns false only if DO_NOT_WAIT found the copy still in flight.
+    bool TryComplete(Slot& slot, bool wait);
+
+    Microsoft::WRL::ComPtr<ID3D11Device>         device_;
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext>  ctx_;
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext4> ctx4_;
+    Microsoft::WRL::ComPtr<ID3D11Fence>          fence_;
+    uint64_t                                     fenceValue_{0};
+    HANDLE                                       event_{};
+    std::array<Slot, kSlotCount>                 slots_{};
+    Ticket                                       nextTicket_{1};
+};
+
+} // namespace screencap::capture
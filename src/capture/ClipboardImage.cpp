@@ -0,0 +1,175 @@
+#include "capture/ClipboardImage.h"
+#include "capture/SaveImage.h"
+#include "capture/Trace.h"
+
+#include <dxgiformat.h>
+#include <objbase.h>
+#include <wingdi.h>
+#include <wrl/client.h>
+
+#include <cstring>
+
+using Microsoft::WRL::ComPtr;
+
+namespace screencap::capture {
+namespace {
+
+[[nodiscard]] bool IsFp16(const FrameData& frame) noexcept
+{
+    return static_cast<DXGI_FORMAT>(frame.format) == DXGI_FORMAT_R16G16B16A16_FLOAT &&
+           frame.bytesPerPixel == 8;
+}
+
+// "PNG" / JPEG XR: encode straight into a growable HGLOBAL.
+template <typename Encode>
+[[nodiscard]] HGLOBAL BuildEncoded(Encode&& encode)
+{
+    ComPtr<IStream> stream;
+    if (FAILED(::CreateStreamOnHGlobal(nullptr, FALSE, &stream))) return nullptr;
+
+    const bool ok = encode(stream.Get());
+
+    // The stream doesn't free the block on release; the handle is final
+    // only once writing is done.
+    HGLOBAL hMem = nullptr;
+    if (FAILED(::GetHGlobalFromStream(stream.Get(), &hMem))) return nullptr;
+    if (!ok) {
+        stream.Reset();
+        ::GlobalFree(hMem);
+        return nullptr;
+    }
+    return hMem;
+}
+
+} // namespace
+
+HGLOBAL BuildDibV5(const FrameData& frame, ThreadPool* pool)
+{
+    const uint8_t* bgra8 = SdrBgra8(frame, pool);
+    if (!bgra8) return nullptr;
+
+    const size_t imageSize = static_cast<size_t>(frame.width) * 4 * frame.height;
+    HGLOBAL hMem = ::GlobalAlloc(GMEM_MOVEABLE, sizeof(BITMAPV5HEADER) + imageSize);
+    if (!hMem) return nullptr;
+
+    auto* ptr = static_cast<uint8_t*>(::GlobalLock(hMem));
+    if (!ptr) {
+        ::GlobalFree(hMem);
+        return nullptr;
+    }
+
+    auto* bih = reinterpret_cast<BITMAPV5HEADER*>(ptr);
+    std::memset(bih, 0, sizeof(BITMAPV5HEADER));
+    bih->bV5Size        = sizeof(BITMAPV5HEADER);
+    bih->bV5Width       = static_cast<LONG>(frame.width);
+    bih->bV5Height      = -static_cast<LONG>(frame.height); // negative = top-down
+    bih->bV5Planes      = 1;
+    bih->bV5BitCount    = 32;
+    bih->bV5Compression = BI_BITFIELDS;
+    bih->bV5SizeImage   = static_cast<DWORD>(imageSize);
+    bih->bV5RedMask     = 0x00FF0000;
+    bih->bV5GreenMask   = 0x0000FF00;
+    bih->bV5BlueMask    = 0x000000FF;
+    bih->bV5AlphaMask   = 0xFF000000;
+    bih->bV5CSType      = LCS_sRGB;
+    bih->bV5Intent      = LCS_GM_IMAGES;
+
+    std::memcpy(ptr + sizeof(BITMAPV5HEADER), bgra8, imageSize);
+
+    ::GlobalUnlock(hMem);
+    return hMem;
+}
+
+void ClipboardImage::Init(HWND owner, ThreadPool* pool)
+{
+    owner_     = owner;
+    pool_      = pool;
+    pngFormat_ = ::RegisterClipboardFormatW(L"PNG");
+    jxrFormat_ = ::RegisterClipboardFormatW(L"image/vnd.ms-photo");
+}
+
+bool ClipboardImage::Offer(FrameData frame)
+{
+    if (!owner_ || frame.width == 0 || frame.height == 0 || frame.pixels.empty()) {
+        return false;
+    }
+    const bool hdr = IsFp16(frame);
+    const ScopedTrace trace(TraceStage::Clipboard);
+
+    if (!::OpenClipboard(owner_)) {
+        return false;
+    }
+
+    // Sends WM_DESTROYCLIPBOARD to the previous owner — possibly our own
+    // window on another thread — so mutex_ must not be held here.
+    if (!::EmptyClipboard()) {
+        ::CloseClipboard();
+        return false;
+    }
+
+    {
+        std::lock_guard lock(mutex_);
+        frame.gpuTexture.Reset();
+        frame_    = std::move(frame);
+        hasFrame_ = true;
+    }
+
+    // Null handles: rendered on WM_RENDERFORMAT.
+    (void)::SetClipboardData(CF_DIBV5, nullptr);
+    if (pngFormat_) (void)::SetClipboardData(pngFormat_, nullptr);
+    if (hdr && jxrFormat_) (void)::SetClipboardData(jxrFormat_, nullptr);
+
+    ::CloseClipboard();
+    return true;
+}
+
+void ClipboardImage::Render(UINT format)
+{
+    std::lock_guard lock(mutex_);
+    if (!hasFrame_) return;
+
+    const ScopedTrace trace(TraceStage::Clipboard, format);
+    HGLOBAL hMem = Build(format);
+    if (hMem && !::SetClipboardData(format, hMem)) {
+        // The system did not take ownership.
+        ::GlobalFree(hMem);
+    }
+}
+
+void ClipboardImage::RenderAll()
+{
+    if (!owner_ || !::OpenClipboard(owner_)) return;
+
+    // Another app may have taken the clipboard since we were asked.
+    if (::GetClipboardOwner() == owner_) {
+        Render(CF_DIBV5);
+        if (pngFormat_) Render(pngFormat_);
+        if (jxrFormat_) Render(jxrFormat_);
+    }
+    ::CloseClipboard();
+}
+
+void ClipboardImage::Release()
+{
+    std::lock_guard lock(mutex_);
+    frame_    = FrameData{};
+    hasFrame_ = false;
+}
+
+HGLOBAL ClipboardImage::Build(UINT format)
+{
+    if (format == CF_DIBV5) {
+        return BuildDibV5(frame_, pool_);
+    }
+    if (format == pngFormat_) {
+        return BuildEncoded([this](IStream* stream) {
+            return EncodePng(frame_, stream, pool_, PngPreset::Fast);
+        });
+    }
+    if (format == jxrFormat_ && IsFp16(frame_)) {
+        return BuildEncoded([this](IStream* stream) { return EncodeJxr(frame_, stream); });
+    }
+    return nullptr;
+}
+
+} // namespace screencap::capture
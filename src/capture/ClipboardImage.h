@@ -0,0 +1,74 @@
+#pragma once
+
+#include "capture/FrameData.h"
+
+#include <windows.h>
+
+#include <mutex>
+
+namespace screencap::capture {
+
+class ThreadPool;
+
+// CF_DIBV5 block for `frame`: BITMAPV5HEADER + top-down BGRA8 rows, one
+// straight copy.  The caller owns the handle; nullptr on failure.
+[[nodiscard]] HGLOBAL BuildDibV5(const FrameData& frame, ThreadPool* pool = nullptr);
+
+// A captured image on the clipboard with delayed rendering.  Offer() only
+// announces the formats; each one is built when a paste target first asks
+// for it, so a capture nobody pastes costs no conversion at all.
+//
+// Formats offered:
+//   CF_DIBV5            top-down BGRA8, no row flip (CF_DIB / CF_BITMAP are
+//                       synthesised from it by the system)
+//   "PNG"               what browsers and Office prefer
+//   "image/vnd.ms-photo" JPEG XR with the FP16 pixels, for FP16 frames only
+//
+// The owner window must forward WM_RENDERFORMAT, WM_RENDERALLFORMATS and
+// WM_DESTROYCLIPBOARD to Render(), RenderAll() and Release().
+class ClipboardImage final {
+public:
+    ClipboardImage() = default;
+    ~ClipboardImage() = default;
+
+    ClipboardImage(const ClipboardImage&) = delete;
+    ClipboardImage& operator=(const ClipboardImage&) = delete;
+    ClipboardImage(ClipboardImage&&) = delete;
+    ClipboardImage& operator=(ClipboardImage&&) = delete;
+
+    // Registers the clipboard formats.  The pool (optional) is used when a
+    // format is rendered.
+    void Init(HWND owner, ThreadPool* pool = nullptr);
+
+    [[nodiscard]] bool IsReady() const noexcept { return owner_ != nullptr; }
+
+    // Take ownership of the clipboard with `frame` (CPU pixels, BGRA8 or
+    // FP16).  Callable from any thread.  Returns false if the clipboard
+    // could not be opened.
+    [[nodiscard]] bool Offer(FrameData frame);
+
+    // WM_RENDERFORMAT: build `format` and place it (the clipboard is
+    // already open for us).
+    void Render(UINT format);
+
+    // WM_RENDERALLFORMATS: render everything before the owner goes away.
+    void RenderAll();
+
+    // WM_DESTROYCLIPBOARD: someone else owns the clipboard now.
+    void Release();
+
+private:
+    // Global memory block holding `format`, or nullptr.  Caller holds mutex_.
+    [[nodiscard]] HGLOBAL Build(UINT format);
+
+    HWND        owner_{};
+    ThreadPool* pool_{};
+    UINT        pngFormat_{};
+    UINT        jxrFormat_{};
+
+    std::mutex  mutex_;     // frame_ is offered on the encode thread, rendered on the UI thread
+    FrameData   frame_;
+    bool        hasFrame_{false};
+};
+
+} // namespace screencap::capture
@@ -0,0 +1,100 @@
+// AVX2 + F16C kernel.  Kept in its own translation unit and only reached
+// through the runtime CPU check in ScRgb16fToBgra8Pixels().  MSVC accepts
+// the intrinsics without /arch (which would also let the compiler emit
+// AVX2 in shared inline code); clang needs them enabled per function.
+#include "capture/ConvertCpu.h"
+
+#include <immintrin.h>
+
+#include <cstring>
+
+#if defined(__clang__)
+#define SCREENCAP_TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#else
+#define SCREENCAP_TARGET_AVX2
+#endif
+
+namespace screencap::capture {
+namespace {
+
+struct Avx2Consts {
+    __m256  scale;
+    __m256  zero;
+    __m256  one;
+    __m256i lutBase;
+    __m256i byteMask;
+    __m256i alpha;
+    __m256i order;
+};
+
+// Two RGBA16F pixels → eight LUT-encoded channels (BGRA order, one per
+// 32-bit lane).  Alpha lanes are overwritten by the caller.
+SCREENCAP_TARGET_AVX2
+inline __m256i EncodeTwoPixels(const uint16_t* p, const uint8_t* lut, const Avx2Consts& k) noexcept
+{
+    __m256 v = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    v = _mm256_permute_ps(v, _MM_SHUFFLE(3, 0, 1, 2));  // RGBA → BGRA
+
+    // max(x, 0) returns 0 for NaN and -0.0, matching the scalar path.
+    v = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(v, k.scale), k.zero), k.one);
+
+    __m256i idx = _mm256_srli_epi32(_mm256_castps_si256(v), static_cast<int>(kSrgbLutShift));
+    idx = _mm256_max_epi32(_mm256_sub_epi32(idx, k.lutBase), _mm256_setzero_si256());
+
+    const __m256i bytes = _mm256_i32gather_epi32(reinterpret_cast<const int*>(lut), idx, 1);
+    return _mm256_and_si256(bytes, k.byteMask);
+}
+
+// Eight pixels: 32 halves in, 32 bytes out.
+SCREENCAP_TARGET_AVX2
+inline void EncodeEightPixels(const uint16_t* src, uint8_t* dst, const uint8_t* lut, const Avx2Consts& k) noexcept
+{
+    const __m256i q0 = EncodeTwoPixels(src +  0, lut, k);  // px0 | px1
+    const __m256i q1 = EncodeTwoPixels(src +  8, lut, k);  // px2 | px3
+    const __m256i q2 = EncodeTwoPixels(src + 16, lut, k);  // px4 | px5
+    const __m256i q3 = EncodeTwoPixels(src + 24, lut, k);  // px6 | px7
+
+    // Packs work per 128-bit lane: [px0 px2 px4 px6 | px1 px3 px5 px7].
+    const __m256i w01 = _mm256_packus_epi32(q0, q1);
+    const __m256i w23 = _mm256_packus_epi32(q2, q3);
+    __m256i out = _mm256_packus_epi16(w01, w23);
+    out = _mm256_permutevar8x32_epi32(out, k.order);
+    out = _mm256_or_si256(out, k.alpha);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), out);
+}
+
+} // namespace
+
+SCREENCAP_TARGET_AVX2
+void ScRgb16fToBgra8PixelsAvx2(const uint16_t* src, uint8_t* dst, size_t count, float scale) noexcept
+{
+    const uint8_t* lut = SrgbEncodeLut();
+
+    Avx2Consts k{};
+    k.scale    = _mm256_set1_ps(scale);
+    k.zero     = _mm256_setzero_ps();
+    k.one      = _mm256_set1_ps(1.0f);
+    k.lutBase  = _mm256_set1_epi32(static_cast<int>(kSrgbLutBase));
+    k.byteMask = _mm256_set1_epi32(0xFF);
+    k.alpha    = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+    k.order    = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        EncodeEightPixels(src + i * 4, dst + i * 4, lut, k);
+    }
+
+    // Tail: run the same kernel on a zero-padded copy so every pixel goes
+    // through identical maths.
+    if (i < count) {
+        const size_t rest = count - i;
+        uint16_t tailSrc[8 * 4]{};
+        uint8_t  tailDst[8 * 4]{};
+        std::memcpy(tailSrc, src + i * 4, rest * 4 * sizeof(uint16_t));
+        EncodeEightPixels(tailSrc, tailDst, lut, k);
+        std::memcpy(dst + i * 4, tailDst, rest * 4);
+    }
+}
+
+} // namespace screencap::capture
@@ -0,0 +1,86 @@
+#include "capture/ConvertCpu.h"
+#include "capture/PixelFormats.h"
+
+#include <intrin.h>
+#include <immintrin.h>
+
+#include <array>
+
+namespace screencap::capture {
+namespace {
+
+using SrgbLut = std::array<uint8_t, kSrgbLutEntries + 3>;
+
+SrgbLut BuildSrgbLut() noexcept
+{
+    SrgbLut lut{};
+    for (uint32_t i = 0; i < kSrgbLutEntries; ++i) {
+        // Encode the centre of the bucket (half of the dropped mantissa bits).
+        const uint32_t bits = ((i + kSrgbLutBase) << kSrgbLutShift) | (1u << (kSrgbLutShift - 1));
+        float c{};
+        std::memcpy(&c, &bits, sizeof(c));
+        lut[i] = FloatToUNorm8(LinearToSrgb((std::min)(1.0f, c)));
+    }
+    return lut;
+}
+
+} // namespace
+
+const uint8_t* SrgbEncodeLut() noexcept
+{
+    static const SrgbLut lut = BuildSrgbLut();
+    return lut.data();
+}
+
+bool CpuHasAvx2F16c() noexcept
+{
+    int regs[4]{};
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return false;
+
+    __cpuid(regs, 1);
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx     = (regs[2] & (1 << 28)) != 0;
+    const bool f16c    = (regs[2] & (1 << 29)) != 0;
+    if (!osxsave || !avx || !f16c) return false;
+
+    // The OS must preserve YMM state across context switches.
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+}
+
+void ScRgb16fToBgra8PixelsScalar(const uint16_t* src, uint8_t* dst, size_t count, float scale) noexcept
+{
+    for (size_t i = 0; i < count; ++i) {
+        const size_t si = i * 4;
+
+        // Read linear scRGB, normalise by paper white, clamp negatives + HDR.
+        float r = (std::max)(0.0f, HalfToFloat(src[si + 0]) * scale);
+        float g = (std::max)(0.0f, HalfToFloat(src[si + 1]) * scale);
+        float b = (std::max)(0.0f, HalfToFloat(src[si + 2]) * scale);
+
+        r = (std::min)(1.0f, r);
+        g = (std::min)(1.0f, g);
+        b = (std::min)(1.0f, b);
+
+        // Linear → sRGB gamma → 8-bit.  Note: output is BGRA order.
+        dst[si + 0] = FloatToUNorm8(LinearToSrgb(b));
+        dst[si + 1] = FloatToUNorm8(LinearToSrgb(g));
+        dst[si + 2] = FloatToUNorm8(LinearToSrgb(r));
+        dst[si + 3] = 255;
+    }
+}
+
+void ScRgb16fToBgra8Pixels(const uint16_t* src, uint8_t* dst, size_t count, float scale) noexcept
+{
+    static const bool useAvx2 = CpuHasAvx2F16c();
+    if (useAvx2) {
+        ScRgb16fToBgra8PixelsAvx2(src, dst, count, scale);
+    } else {
+        ScRgb16fToBgra8PixelsScalar(src, dst, count, scale);
+    }
+}
+
+} // namespace screencap::capture
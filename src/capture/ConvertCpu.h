@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace screencap::capture {
+
+// ── CPU scRGB FP16 → sRGB BGRA8 kernels ─────────────────────────────
+//
+// Convert `count` tightly packed RGBA16F (linear scRGB) pixels to BGRA8:
+// multiply by `scale` (= 80 / paperWhiteNits), clamp to [0, 1], sRGB
+// gamma, quantise.  Alpha is always written as 255.
+
+// Picks the fastest kernel for this CPU (detected once, at first call).
+void ScRgb16fToBgra8Pixels(const uint16_t* src, uint8_t* dst, size_t count, float scale) noexcept;
+
+// Reference implementation: HalfToFloat + std::pow, one pixel at a time.
+void ScRgb16fToBgra8PixelsScalar(const uint16_t* src, uint8_t* dst, size_t count, float scale) noexcept;
+
+// AVX2 + F16C: hardware half conversion, 8 pixels per iteration, LUT sRGB
+// encode.  Only call when CpuHasAvx2F16c() is true.  Matches the
+// reference to within one code value over every half value
+// (ScreenCapBench --verify checks this).
+void ScRgb16fToBgra8PixelsAvx2(const uint16_t* src, uint8_t* dst, size_t count, float scale) noexcept;
+
+[[nodiscard]] bool CpuHasAvx2F16c() noexcept;
+
+// sRGB encode table shared by the vectorised kernels.
+// Indexed by the top 20 bits of a float in [0, 1], relative to 2^-14:
+//   index = max(0, (floatBits >> 12) - (113 << 11))
+// Values below 2^-14 encode to 0 and 1.0 lands on the last entry.
+// Padded by 3 bytes so 32-bit gathers at any index stay in bounds.
+inline constexpr uint32_t kSrgbLutShift   = 12;
+inline constexpr uint32_t kSrgbLutBase    = 113u << 11;
+inline constexpr size_t   kSrgbLutEntries = (14u << 11) + 1;
+
+[[nodiscard]] const uint8_t* SrgbEncodeLut() noexcept;
+
+} // namespace screencap::capture
@@ -1,5 +1,10 @@
 #pragma once
 
+// Compute shaders, compiled by fxc at build time (see CMakeLists.txt).
+// Each generated header defines `const BYTE <name>[]` holding the DXBC.
+
+#include <windows.h>
+
 namespace screencap::capture {
 
 // Compute shader: BGRA8 (sRGB) → RGBA16F (linear scRGB).
@@ -7,35 +12,91 @@ namespace screencap::capture {
 // t0 = source BGRA8 texture (SRV)
 // u0 = destination FP16 texture (UAV)
 // b0 = { srcOffset, dstOffset, blitSize }
-inline constexpr const char kBgra8ToFp16CS[] = R"(
-Texture2D<float4>   srcTex : register(t0);
-RWTexture2D<float4> dstTex : register(u0);
-
-cbuffer BlitParams : register(b0) {
-    int2 srcOffset;
-    int2 dstOffset;
-    int2 blitSize;
-};
-
-float SrgbToLinear(float c) {
-    return (c <= 0.04045) ? (c / 12.92) : pow((c + 0.055) / 1.055, 2.4);
-}
-
-[numthreads(16, 16, 1)]
-void CSMain(uint3 dtid : SV_DispatchThreadID)
-{
-    if ((int)dtid.x >= blitSize.x || (int)dtid.y >= blitSize.y)
-        return;
-
-    // SRV reads BGRA8 in RGBA channel order (hardware swizzle).
-    float4 c = srcTex[srcOffset + int2(dtid.xy)];
-
-    dstTex[dstOffset + int2(dtid.xy)] = float4(
-        SrgbToLinear(c.r),
-        SrgbToLinear(c.g),
-        SrgbToLinear(c.b),
-        1.0);
-}
-)";
+// kBgra8ToFp16CS from capture/shaders/Bgra8ToFp16.hlsl (cs_5_0, CSMain).
+#include "compiled/Bgra8ToFp16.h"
+
+// Compute shader: RGBA16F (linear scRGB) → BGRA8 (sRGB), for readback.
+// Normalise by each monitor's paper white, apply the exposure, tone map
+// (clip: the same maths as the CPU ScRgb16fToBgra8()), sRGB gamma,
+// quantise (on the UNORM store).  One permutation per ToneMapOperator.
+//
+// t0 = source FP16 texture (SRV)
+// t1 = exposure (structured buffer, one float)
+// u0 = destination BGRA8 texture (UAV, typed store), sized to the region
+// b0 = { srcOffset, size }
+// b1 = { fallbackScale, fallbackPeak, regionCount, regionRect[8], regionWhite[8] }
+//      (per-monitor paper white and peak; the fallback outside the regions)
+// kScRgbToBgra8CS, kScRgbToBgra8{Reinhard,Bt2390,Aces}CS from
+// capture/shaders/ScRgbToBgra8.hlsl (cs_5_0, CSMain, TONEMAP_OPERATOR).
+#include "compiled/ScRgbToBgra8.h"
+#include "compiled/ScRgbToBgra8Reinhard.h"
+#include "compiled/ScRgbToBgra8Bt2390.h"
+#include "compiled/ScRgbToBgra8Aces.h"
+
+// Compute shader: box-filter downsample + tone map → BGRA8 (sRGB), for
+// thumbnails.  Each output pixel averages its whole source footprint in
+// linear light, so the full-size frame never has to leave the GPU.
+//
+// t0 = source texture (SRV): FP16 scRGB, or BGRA8 holding sRGB values
+// t1, b1 = as for kScRgbToBgra8CS (exposure 1 and no regions for sRGB)
+// u0 = destination BGRA8 texture (UAV, typed store), sized to the thumbnail
+// b0 = { srcSize, dstSize, srgbSource }
+// kDownsampleToBgra8CS, kDownsampleToBgra8{Reinhard,Bt2390,Aces}CS from
+// capture/shaders/DownsampleToBgra8.hlsl (cs_5_0, CSMain, TONEMAP_OPERATOR).
+#include "compiled/DownsampleToBgra8.h"
+#include "compiled/DownsampleToBgra8Reinhard.h"
+#include "compiled/DownsampleToBgra8Bt2390.h"
+#include "compiled/DownsampleToBgra8Aces.h"
+
+// Compute shader: log2-luminance histogram of an FP16 region, 64 bins of
+// a quarter stop from 2^-10 of SDR white up; darker pixels are skipped.
+// Group-local bins, merged with one atomic add per bin per group.
+//
+// t0 = source FP16 texture (SRV)
+// u0 = histogram (raw buffer, 64 uints, cleared beforehand)
+// b0, b1 = as for kScRgbToBgra8CS
+// kLuminanceHistogramCS from capture/shaders/LuminanceHistogram.hlsl (cs_5_0, CSMain).
+#include "compiled/LuminanceHistogram.h"
+
+// Compute shader: histogram → exposure, one 64-thread group.  A prefix
+// sum over the bins finds the level that all but 2% of the counted
+// pixels stay under; the exposure maps it to SDR white (1/8 … 1).
+//
+// t0 = histogram (raw buffer SRV)
+// u0 = exposure (structured buffer, one float)
+// kAutoExposureCS from capture/shaders/AutoExposure.hlsl (cs_5_0, CSMain).
+#include "compiled/AutoExposure.h"
+
+// Compute shader: scRGB → video encoder input, bilinear-scaled to the
+// encoded size.  SDR: the ScRgbToBgra8 maths into BGRA8.  HDR10: BT.709 →
+// BT.2020 primaries and the ST 2084 (PQ) curve into R10G10B10A2.
+//
+// t0 = source FP16 texture (SRV), s0 = linear clamp sampler
+// u0 = destination encoder surface (UAV, typed store)
+// b0 = { size, scale, hdr10 }
+// kScRgbToVideoCS from capture/shaders/ScRgbToVideo.hlsl (cs_5_0, CSMain).
+#include "compiled/ScRgbToVideo.h"
+
+// Compute shader: float → float box-filter resample, for the instant-
+// replay ring.  Each output pixel averages factor×factor source pixels;
+// factor 1 converts formats (R11G11B10 storage ↔ FP16 for output).
+//
+// t0 = source float texture (SRV)
+// u0 = destination float texture (UAV, typed store)
+// b0 = { dstSize, factor }
+// kReplayResampleCS from capture/shaders/ReplayResample.hlsl (cs_5_0, CSMain).
+#include "compiled/ReplayResample.h"
+
+// Compute shader: mouse pointer shape over the FP16 composite.  The shape
+// is BGRA8 sRGB with straight alpha; alpha 0 with a colour set inverts
+// those channels (XOR pixels).  Reads a copy of the covered area, so the
+// composite is only written.
+//
+// t0 = copy of the composite under the pointer (SRV)
+// t1 = pointer shape (SRV)
+// u0 = composite (UAV, typed store)
+// b0 = { dstOffset, size, srcOffset, whiteScale }
+// kCursorOverlayCS from capture/shaders/CursorOverlay.hlsl (cs_5_0, CSMain).
+#include "compiled/CursorOverlay.h"
 
 } // namespace screencap::capture
@@ -1,17 +1,35 @@
 #include "capture/DesktopDuplicator.h"
 #include "capture/ConvertShader.h"
 #include "capture/PixelFormats.h"
+#include "capture/ThreadPool.h"
+#include "capture/WhiteLevel.h"
 
-#include <d3dcompiler.h>
+#include <d3d11_4.h>
+#include <dxgi1_6.h>
+
+#include <algorithm>
+#include <cstring>
+#include <cwchar>
 
 using Microsoft::WRL::ComPtr;
 
 namespace screencap::capture {
 namespace {
 
-// ── Per-output frame acquisition ─────────────────────────────────────
+// ── GPU blit helpers ────────────────────────────────────────────────
+
+// Always composite into FP16 (linear scRGB).
+constexpr DXGI_FORMAT kCompositeFormat = DXGI_FORMAT_R16G16B16A16_FLOAT;
 
-using Bounds = DesktopDuplicator::Bounds;
+// Upper bound on pooled composites.  One is enough for the modal preview;
+// extra slots only appear while earlier frames are still held elsewhere.
+constexpr size_t kMaxCompositeSlots = 3;
+
+// Longest wait for an output that has no frame in the composite yet.
+constexpr UINT kAcquireTimeoutMs = 1000;
+
+// Longest wait for the other device to hand over a cross-adapter mirror.
+constexpr DWORD kMirrorSyncMs = 100;
 
 // Constant buffer layout matching the compute shader's BlitParams.
 struct BlitParams {
@@ -21,85 +39,41 @@ struct BlitParams {
     int pad0, pad1;           // Align to 16-byte boundary.
 };
 
-// Compile and cache the BGRA8→FP16 compute shader (once per device).
-ComPtr<ID3D11ComputeShader> CompileConvertCS(ID3D11Device* device)
-{
-    ComPtr<ID3DBlob> blob;
-    ComPtr<ID3DBlob> errors;
-    HRESULT hr = D3DCompile(
-        kBgra8ToFp16CS,
-        sizeof(kBgra8ToFp16CS) - 1,
-        "ConvertBgra8ToFp16",
-        nullptr, nullptr,
-        "CSMain", "cs_5_0",
-        D3DCOMPILE_OPTIMIZATION_LEVEL3, 0,
-        &blob, &errors);
-    if (FAILED(hr)) return nullptr;
+// Constant buffer layout matching the compute shader's CursorParams.
+struct CursorParams {
+    int dstOffsetX, dstOffsetY;
+    int width, height;
+    int srcOffsetX, srcOffsetY;
+    float whiteScale;
+    float pad0;               // Align to 16-byte boundary.
+};
 
+// Create the BGRA8→FP16 compute shader from its build-time bytecode
+// (once per device).
+ComPtr<ID3D11ComputeShader> CreateConvertCS(ID3D11Device* device)
+{
     ComPtr<ID3D11ComputeShader> cs;
-    hr = device->CreateComputeShader(
-        blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &cs);
-    if (FAILED(hr)) return nullptr;
-
+    if (FAILED(device->CreateComputeShader(kBgra8ToFp16CS, sizeof(kBgra8ToFp16CS), nullptr, &cs))) {
+        return nullptr;
+    }
     return cs;
 }
 
 // GPU compute blit: BGRA8 (sRGB) → FP16 (linear scRGB).
-// Copies the DD-acquired texture to a temp SRV-capable texture, then
-// dispatches the conversion shader writing directly into the composite UAV.
-bool BlitConvertedGPU(
-    ID3D11Device* device,
+// Reads the persistent SRV-capable copy of the DD texture (filled by the
+// caller) and dispatches the conversion shader writing directly into the
+// composite UAV.
+void BlitConvertedGPU(
     ID3D11DeviceContext* ctx,
     ID3D11ComputeShader* cs,
-    ID3D11Texture2D* src,
-    const D3D11_TEXTURE2D_DESC& srcDesc,
-    ID3D11Texture2D* composite,
+    ID3D11ShaderResourceView* srv,
+    ID3D11Buffer* paramsCB,
+    ID3D11UnorderedAccessView* compositeUAV,
     int srcX, int srcY,
     int dstX, int dstY,
     int blitW, int blitH)
 {
-    HRESULT hr{};
-
-    // 1. Copy the DD texture to a temp texture with SRV binding
-    //    (DD textures are DWM-owned and don't support SRV).
-    D3D11_TEXTURE2D_DESC tempDesc{};
-    tempDesc.Width            = srcDesc.Width;
-    tempDesc.Height           = srcDesc.Height;
-    tempDesc.MipLevels        = 1;
-    tempDesc.ArraySize        = 1;
-    tempDesc.Format           = srcDesc.Format;
-    tempDesc.SampleDesc.Count = 1;
-    tempDesc.Usage            = D3D11_USAGE_DEFAULT;
-    tempDesc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
-
-    ComPtr<ID3D11Texture2D> temp;
-    hr = device->CreateTexture2D(&tempDesc, nullptr, &temp);
-    if (FAILED(hr)) return false;
-
-    ctx->CopyResource(temp.Get(), src);
-
-    // 2. Create SRV for the source (BGRA8).
-    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
-    srvDesc.Format                    = srcDesc.Format;
-    srvDesc.ViewDimension             = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels       = 1;
-    srvDesc.Texture2D.MostDetailedMip = 0;
-
-    ComPtr<ID3D11ShaderResourceView> srv;
-    hr = device->CreateShaderResourceView(temp.Get(), &srvDesc, &srv);
-    if (FAILED(hr)) return false;
-
-    // 3. Create UAV for the composite (FP16).
-    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
-    uavDesc.Format             = DXGI_FORMAT_R16G16B16A16_FLOAT;
-    uavDesc.ViewDimension      = D3D11_UAV_DIMENSION_TEXTURE2D;
-    uavDesc.Texture2D.MipSlice = 0;
-
-    ComPtr<ID3D11UnorderedAccessView> uav;
-    hr = device->CreateUnorderedAccessView(composite, &uavDesc, &uav);
-    if (FAILED(hr)) return false;
-
-    // 4. Fill constant buffer with blit parameters.
+    // 1. Update the blit parameters (no allocation — DEFAULT constant buffer).
     BlitParams params{};
     params.srcOffsetX = srcX;
     params.srcOffsetY = srcY;
@@ -107,31 +81,20 @@ bool BlitConvertedGPU(
     params.dstOffsetY = dstY;
     params.blitW      = blitW;
     params.blitH      = blitH;
+    ctx->UpdateSubresource(paramsCB, 0, nullptr, &params, 0, 0);
 
-    D3D11_BUFFER_DESC cbDesc{};
-    cbDesc.ByteWidth      = sizeof(BlitParams);
-    cbDesc.Usage           = D3D11_USAGE_DEFAULT;
-    cbDesc.BindFlags       = D3D11_BIND_CONSTANT_BUFFER;
-
-    D3D11_SUBRESOURCE_DATA cbInit{};
-    cbInit.pSysMem = &params;
-
-    ComPtr<ID3D11Buffer> cb;
-    hr = device->CreateBuffer(&cbDesc, &cbInit, &cb);
-    if (FAILED(hr)) return false;
-
-    // 5. Dispatch the compute shader.
+    // 2. Dispatch the compute shader.
     ctx->CSSetShader(cs, nullptr, 0);
-    ctx->CSSetShaderResources(0, 1, srv.GetAddressOf());
-    ctx->CSSetUnorderedAccessViews(0, 1, uav.GetAddressOf(), nullptr);
-    ctx->CSSetConstantBuffers(0, 1, cb.GetAddressOf());
+    ctx->CSSetShaderResources(0, 1, &srv);
+    ctx->CSSetUnorderedAccessViews(0, 1, &compositeUAV, nullptr);
+    ctx->CSSetConstantBuffers(0, 1, &paramsCB);
 
     // 16×16 thread groups.
     const UINT groupsX = (static_cast<UINT>(blitW) + 15u) / 16u;
     const UINT groupsY = (static_cast<UINT>(blitH) + 15u) / 16u;
     ctx->Dispatch(groupsX, groupsY, 1);
 
-    // 6. Unbind resources.
+    // 3. Unbind resources.
     ID3D11ShaderResourceView* nullSRV = nullptr;
     ID3D11UnorderedAccessView* nullUAV = nullptr;
     ID3D11Buffer* nullCB = nullptr;
@@ -139,106 +102,304 @@ bool BlitConvertedGPU(
     ctx->CSSetUnorderedAccessViews(0, 1, &nullUAV, nullptr);
     ctx->CSSetConstantBuffers(0, 1, &nullCB);
     ctx->CSSetShader(nullptr, nullptr, 0);
+}
 
-    return true;
+bool SameLuid(const LUID& a, const LUID& b) noexcept
+{
+    return a.LowPart == b.LowPart && a.HighPart == b.HighPart;
 }
 
-// Acquire one monitor's frame and blit it into the composite texture.
-bool BlitOutputToComposite(
-    ID3D11Device* device,
-    ID3D11DeviceContext* ctx,
-    ID3D11ComputeShader* cs,
-    IDXGIOutputDuplication* dupl,
-    const Bounds& bounds,
-    const DXGI_OUTPUT_DESC& outputDesc,
-    ID3D11Texture2D* composite,
-    DXGI_FORMAT compositeFormat)
-{
-    // Acquire the current desktop frame.
-    DXGI_OUTDUPL_FRAME_INFO info{};
-    ComPtr<IDXGIResource> resource;
-    HRESULT hr = dupl->AcquireNextFrame(1000, &info, &resource);
-    if (FAILED(hr) || !resource) {
-        return false;
+// Outputs are acquired from pool threads while the capture thread keeps
+// using the device.
+void EnableMultithreadProtection(ID3D11Device* device)
+{
+    ComPtr<ID3D11Multithread> mt;
+    if (SUCCEEDED(device->QueryInterface(IID_PPV_ARGS(&mt)))) {
+        mt->SetMultithreadProtected(TRUE);
     }
+}
 
-    ComPtr<ID3D11Texture2D> tex;
-    hr = resource.As(&tex);
-    if (FAILED(hr)) {
-        dupl->ReleaseFrame();
-        return false;
-    }
+// DXGI pointer shape → BGRA8 with straight alpha, for the cursor shader.
+// XOR pixels get alpha 0 and the channels to invert.  Returns false for
+// an unknown shape type.
+bool BuildPointerImage(const uint8_t* src, const DXGI_OUTDUPL_POINTER_SHAPE_INFO& info,
+                       std::vector<uint32_t>& image, UINT& width, UINT& height)
+{
+    const bool mono = (info.Type == DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME);
+    width  = info.Width;
+    height = mono ? info.Height / 2 : info.Height;
+    image.assign(size_t{width} * height, 0);
 
-    D3D11_TEXTURE2D_DESC texDesc{};
-    tex->GetDesc(&texDesc);
+    for (UINT y = 0; y < height; ++y) {
+        for (UINT x = 0; x < width; ++x) {
+            uint32_t& out = image[size_t{y} * width + x];
+            if (mono) {
+                // AND mask above the XOR mask, one bit a pixel, MSB first.
+                const uint8_t bit = static_cast<uint8_t>(0x80u >> (x % 8));
+                const bool andBit = (src[size_t{y} * info.Pitch + x / 8] & bit) != 0;
+                const bool xorBit = (src[size_t{y + height} * info.Pitch + x / 8] & bit) != 0;
+                if (!andBit)     out = xorBit ? 0xFFFFFFFFu : 0xFF000000u;
+                else if (xorBit) out = 0x00FFFFFFu;
+                continue;
+            }
 
-    // Calculate clamped blit region.
-    const auto compW = static_cast<int>(bounds.Width());
-    const auto compH = static_cast<int>(bounds.Height());
+            uint32_t px;
+            std::memcpy(&px, src + size_t{y} * info.Pitch + size_t{x} * 4, sizeof(px));
+            switch (info.Type) {
+            case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR:
+                out = (px >> 24) ? px : 0;
+                break;
+            case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MASKED_COLOR:
+                // Mask 0: the colour replaces the desktop; 0xFF: XOR with it.
+                out = (px >> 24) ? (px & 0x00FFFFFFu) : (px | 0xFF000000u);
+                break;
+            default:
+                image.clear();
+                return false;
+            }
+        }
+    }
+    return true;
+}
 
-    int dstX = outputDesc.DesktopCoordinates.left - bounds.left;
-    int dstY = outputDesc.DesktopCoordinates.top  - bounds.top;
-    int srcX = 0, srcY = 0;
-    int blitW = static_cast<int>(texDesc.Width);
-    int blitH = static_cast<int>(texDesc.Height);
+// RECT → clamped-to-texture RECT; empty if nothing remains.
+RECT ClampRect(const RECT& r, UINT width, UINT height) noexcept
+{
+    RECT out{};
+    out.left   = (std::max)(r.left, 0L);
+    out.top    = (std::max)(r.top, 0L);
+    out.right  = (std::min)(r.right,  static_cast<LONG>(width));
+    out.bottom = (std::min)(r.bottom, static_cast<LONG>(height));
+    return out;
+}
 
-    if (dstX < 0) { srcX = -dstX; blitW -= srcX; dstX = 0; }
-    if (dstY < 0) { srcY = -dstY; blitH -= srcY; dstY = 0; }
-    if (dstX + blitW > compW) { blitW = compW - dstX; }
-    if (dstY + blitH > compH) { blitH = compH - dstY; }
+// An attached output and the adapter that reports it.
+struct OutputInfo {
+    ComPtr<IDXGIOutput1>  output;
+    DXGI_OUTPUT_DESC      desc{};
+    DXGI_COLOR_SPACE_TYPE colorSpace{DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_P709};  // G2084 with HDR on
+    float                 sdrWhiteNits{80.0f};
+    float                 peakNits{0.0f};
+    ComPtr<IDXGIAdapter1> adapter;
+    LUID                  adapterLuid{};
+};
 
-    if (blitW <= 0 || blitH <= 0) {
-        dupl->ReleaseFrame();
-        return false;
+// Attached outputs of every hardware adapter, those of adapter `first`
+// (the shared device's) ahead of the rest.  An output reported by more
+// than one adapter (hybrid GPUs) is kept only for the first.
+std::vector<OutputInfo> EnumerateOutputs(IDXGIFactory1* factory, const LUID& first)
+{
+    std::vector<ComPtr<IDXGIAdapter1>> adapters;
+    for (UINT a = 0; ; ++a) {
+        ComPtr<IDXGIAdapter1> adapter;
+        const HRESULT hr = factory->EnumAdapters1(a, &adapter);
+        if (hr == DXGI_ERROR_NOT_FOUND) break;
+        if (FAILED(hr)) continue;
+
+        DXGI_ADAPTER_DESC1 desc{};
+        adapter->GetDesc1(&desc);
+        if (SameLuid(desc.AdapterLuid, first)) {
+            adapters.insert(adapters.begin(), std::move(adapter));
+        } else if (!(desc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE)) {
+            adapters.push_back(std::move(adapter));
+        }
     }
 
-    // Check format compatibility for a direct GPU copy.
-    const bool formatMatch = (texDesc.Format == compositeFormat);
+    std::vector<OutputInfo> outputs;
+    for (const auto& adapter : adapters) {
+        DXGI_ADAPTER_DESC1 adapterDesc{};
+        adapter->GetDesc1(&adapterDesc);
+        for (UINT i = 0; ; ++i) {
+            ComPtr<IDXGIOutput> output;
+            const HRESULT hr = adapter->EnumOutputs(i, &output);
+            if (hr == DXGI_ERROR_NOT_FOUND) break;
+            if (FAILED(hr)) continue;
 
-    if (formatMatch) {
-        // Fast path — direct GPU blit (same format, no conversion).
-        D3D11_BOX box{};
-        box.left   = static_cast<UINT>(srcX);
-        box.top    = static_cast<UINT>(srcY);
-        box.front  = 0;
-        box.right  = static_cast<UINT>(srcX + blitW);
-        box.bottom = static_cast<UINT>(srcY + blitH);
-        box.back   = 1;
+            OutputInfo oi;
+            output->GetDesc(&oi.desc);
+            if (!oi.desc.AttachedToDesktop) continue;
 
-        ctx->CopySubresourceRegion(
-            composite, 0,
-            static_cast<UINT>(dstX), static_cast<UINT>(dstY), 0,
-            tex.Get(), 0, &box);
+            const bool seen = std::any_of(outputs.begin(), outputs.end(), [&oi](const OutputInfo& o) {
+                return std::wcscmp(o.desc.DeviceName, oi.desc.DeviceName) == 0;
+            });
+            if (seen) continue;
+
+            ComPtr<IDXGIOutput6> output6;
+            DXGI_OUTPUT_DESC1 desc1{};
+            if (SUCCEEDED(output.As(&output6)) && SUCCEEDED(output6->GetDesc1(&desc1))) {
+                oi.colorSpace = desc1.ColorSpace;
+                oi.peakNits   = desc1.MaxLuminance;
+            }
+            // The display-config walk, once per output per layout.  An SDR
+            // output shows nothing brighter than its white.
+            oi.sdrWhiteNits = GetSdrWhiteNitsForMonitor(oi.desc.Monitor);
+            if (oi.colorSpace != DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020) oi.peakNits = oi.sdrWhiteNits;
+            oi.adapter     = adapter;
+            oi.adapterLuid = adapterDesc.AdapterLuid;
+            if (SUCCEEDED(output.As(&oi.output))) {
+                outputs.push_back(std::move(oi));
+            }
+        }
+    }
+    return outputs;
+}
+
+// Duplicate `output` on `device`, in FP16 where DuplicateOutput1 exists.
+HRESULT CreateDuplication(IDXGIOutput1* output, ID3D11Device* device, ComPtr<IDXGIOutputDuplication>& dupl)
+{
+    HRESULT hr{};
+    ComPtr<IDXGIOutput5> out5;
+    if (SUCCEEDED(output->QueryInterface(IID_PPV_ARGS(&out5))) && out5) {
+        const DXGI_FORMAT formats[] = {DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_B8G8R8A8_UNORM};
+        hr = out5->DuplicateOutput1(device, 0, static_cast<UINT>(std::size(formats)), formats, &dupl);
     } else {
-        // Compute-shader path — GPU format conversion (BGRA8 → FP16).
-        BlitConvertedGPU(device, ctx, cs, tex.Get(), texDesc,
-                         composite,
-                         srcX, srcY, dstX, dstY, blitW, blitH);
+        hr = output->DuplicateOutput(device, &dupl);
     }
+    return (SUCCEEDED(hr) && !dupl) ? E_FAIL : hr;
+}
+
+} // namespace
+
+// ── Resource pool ───────────────────────────────────────────────────
+
+bool DesktopDuplicator::EnsureConvertResources(ConvertResources& res, const D3D11_TEXTURE2D_DESC& srcDesc)
+{
+    if (res.srcCopy &&
+        res.desc.Width  == srcDesc.Width &&
+        res.desc.Height == srcDesc.Height &&
+        res.desc.Format == srcDesc.Format) {
+        return true;
+    }
+
+    res = {};
 
-    dupl->ReleaseFrame();
+    D3D11_TEXTURE2D_DESC copyDesc{};
+    copyDesc.Width            = srcDesc.Width;
+    copyDesc.Height           = srcDesc.Height;
+    copyDesc.MipLevels        = 1;
+    copyDesc.ArraySize        = 1;
+    copyDesc.Format           = srcDesc.Format;
+    copyDesc.SampleDesc.Count = 1;
+    copyDesc.Usage            = D3D11_USAGE_DEFAULT;
+    copyDesc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+
+    HRESULT hr = device_->CreateTexture2D(&copyDesc, nullptr, &res.srcCopy);
+    if (FAILED(hr)) return false;
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+    srvDesc.Format                    = srcDesc.Format;
+    srvDesc.ViewDimension             = D3D11_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels       = 1;
+    srvDesc.Texture2D.MostDetailedMip = 0;
+
+    hr = device_->CreateShaderResourceView(res.srcCopy.Get(), &srvDesc, &res.srv);
+    if (FAILED(hr)) { res = {}; return false; }
+
+    D3D11_BUFFER_DESC cbDesc{};
+    cbDesc.ByteWidth = sizeof(BlitParams);
+    cbDesc.Usage     = D3D11_USAGE_DEFAULT;
+    cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+
+    hr = device_->CreateBuffer(&cbDesc, nullptr, &res.params);
+    if (FAILED(hr)) { res = {}; return false; }
+
+    res.desc = copyDesc;
     return true;
 }
 
-} // namespace
+bool DesktopDuplicator::CreateCompositeSlot(CompositeSlot& slot)
+{
+    // BIND_UNORDERED_ACCESS is needed for the compute-shader conversion path.
+    D3D11_TEXTURE2D_DESC compDesc{};
+    compDesc.Width            = bounds_.Width();
+    compDesc.Height           = bounds_.Height();
+    compDesc.MipLevels        = 1;
+    compDesc.ArraySize        = 1;
+    compDesc.Format           = kCompositeFormat;
+    compDesc.SampleDesc.Count = 1;
+    compDesc.Usage            = D3D11_USAGE_DEFAULT;
+    compDesc.BindFlags        = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+
+    HRESULT hr = device_->CreateTexture2D(&compDesc, nullptr, &slot.tex);
+    if (FAILED(hr)) return false;
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
+    uavDesc.Format             = kCompositeFormat;
+    uavDesc.ViewDimension      = D3D11_UAV_DIMENSION_TEXTURE2D;
+    uavDesc.Texture2D.MipSlice = 0;
+
+    hr = device_->CreateUnorderedAccessView(slot.tex.Get(), &uavDesc, &slot.uav);
+    if (FAILED(hr)) { slot = {}; return false; }
+
+    // Touch the memory now so the driver commits it here rather than on
+    // the first capture.
+    const float black[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+    ctx_->ClearUnorderedAccessViewFloat(slot.uav.Get(), black);
+    return true;
+}
+
+DesktopDuplicator::CompositeSlot* DesktopDuplicator::AcquireCompositeSlot()
+{
+    for (auto& slot : composites_) {
+        if (slot.lease.expired()) {
+            return &slot;
+        }
+    }
+
+    // Every pooled composite is still referenced by an earlier frame.
+    if (composites_.size() < kMaxCompositeSlots) {
+        CompositeSlot slot;
+        if (CreateCompositeSlot(slot)) {
+            composites_.push_back(std::move(slot));
+            return &composites_.back();
+        }
+    }
+    return nullptr;
+}
 
 // ── Init: enumerate outputs, set up duplications ─────────────────────
 
 bool DesktopDuplicator::Init(ID3D11Device* device)
 {
+    const std::lock_guard lock(mutex_);
+    return InitLocked(device);
+}
+
+bool DesktopDuplicator::InitLocked(ID3D11Device* device)
+{
+    // The shaders only depend on the device; a layout change keeps them.
+    if (device != device_.Get()) {
+        convertCS_.Reset();
+        cursorCS_.Reset();
+    }
+
     ready_ = false;
+    frozenAt_ = 0;
+    deviceRemoved_ = false;
+    layoutStale_ = false;
     dupls_.clear();
+    layout_.clear();
+    composites_.clear();
+    live_ = {};
+    pointer_ = {};
+    adapters_.clear();
     device_.Reset();
     ctx_.Reset();
-    convertCS_.Reset();
+    compositeTimer_.Reset();
 
     if (!device) return false;
     device_ = device;
     device_->GetImmediateContext(&ctx_);
+    EnableMultithreadProtection(device_.Get());
 
     // Pre-compile the format-conversion compute shader.
-    convertCS_ = CompileConvertCS(device_.Get());
     // Not fatal if it fails — we just won't handle mixed HDR/SDR setups.
+    if (!convertCS_) convertCS_ = CreateConvertCS(device_.Get());
+
+    // Likewise; captures then come without the pointer.
+    if (!cursorCS_) {
+        (void)device_->CreateComputeShader(kCursorOverlayCS, sizeof(kCursorOverlayCS), nullptr, &cursorCS_);
+    }
 
     HRESULT hr{};
     ComPtr<IDXGIDevice> dxgiDevice;
@@ -247,23 +408,49 @@ bool DesktopDuplicator::Init(ID3D11Device* device)
     ComPtr<IDXGIAdapter> adapter;
     if (FAILED(dxgiDevice->GetAdapter(&adapter))) return false;
 
-    // Enumerate attached outputs.
-    struct OutputInfo {
-        ComPtr<IDXGIOutput1> output;
-        DXGI_OUTPUT_DESC     desc{};
-    };
-    std::vector<OutputInfo> outputs;
-    for (UINT i = 0; ; ++i) {
-        ComPtr<IDXGIOutput> output;
-        hr = adapter->EnumOutputs(i, &output);
-        if (hr == DXGI_ERROR_NOT_FOUND) break;
-        if (FAILED(hr)) continue;
+    DXGI_ADAPTER_DESC adapterDesc{};
+    adapter->GetDesc(&adapterDesc);
+    adapters_.push_back({adapterDesc.AdapterLuid, device_, ctx_});
+
+    ComPtr<IDXGIFactory1> factory;
+    if (FAILED(adapter->GetParent(IID_PPV_ARGS(&factory)))) return false;
+
+    std::vector<OutputInfo> outputs = EnumerateOutputs(factory.Get(), adapterDesc.AdapterLuid);
+    for (const auto& oi : outputs) {
+        layout_.push_back({oi.desc.DeviceName, oi.desc.DesktopCoordinates, oi.adapterLuid});
+    }
+
+    // Every other adapter that drives a monitor gets a device of its own.
+    // Outputs whose adapter has none are dropped.
+    std::vector<size_t> adapterOf(outputs.size(), 0);
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        const LUID luid = outputs[i].adapterLuid;
+        const auto known = std::find_if(adapters_.begin(), adapters_.end(), [&luid](const AdapterDevice& ad) {
+            return SameLuid(ad.luid, luid);
+        });
+        if (known != adapters_.end()) {
+            adapterOf[i] = static_cast<size_t>(known - adapters_.begin());
+            continue;
+        }
 
-        OutputInfo oi;
-        output->GetDesc(&oi.desc);
-        if (!oi.desc.AttachedToDesktop) continue;
-        if (SUCCEEDED(output.As(&oi.output))) {
-            outputs.push_back(std::move(oi));
+        AdapterDevice ad;
+        ad.luid = luid;
+        hr = ::D3D11CreateDevice(
+            outputs[i].adapter.Get(), D3D_DRIVER_TYPE_UNKNOWN, nullptr,
+            D3D11_CREATE_DEVICE_BGRA_SUPPORT, nullptr, 0,
+            D3D11_SDK_VERSION, &ad.device, nullptr, &ad.ctx);
+        if (FAILED(hr)) {
+            adapterOf[i] = SIZE_MAX;
+            continue;
+        }
+        EnableMultithreadProtection(ad.device.Get());
+        adapterOf[i] = adapters_.size();
+        adapters_.push_back(std::move(ad));
+    }
+    for (size_t i = outputs.size(); i-- > 0;) {
+        if (adapterOf[i] == SIZE_MAX) {
+            outputs.erase(outputs.begin() + static_cast<ptrdiff_t>(i));
+            adapterOf.erase(adapterOf.begin() + static_cast<ptrdiff_t>(i));
         }
     }
     if (outputs.empty()) return false;
@@ -283,75 +470,761 @@ bool DesktopDuplicator::Init(ID3D11Device* device)
         }
     }
 
-    // Create output duplications.
+    // Create output duplications, each on its own adapter's device.  One
+    // that fails (routine right after a hotplug, during a mode switch or
+    // on the secure desktop) is kept as lost, so Recover() retries it.
     dupls_.reserve(outputs.size());
-    for (auto& oi : outputs) {
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        auto& oi = outputs[i];
         ComPtr<IDXGIOutputDuplication> dupl;
-        ComPtr<IDXGIOutput5> out5;
-        if (SUCCEEDED(oi.output.As(&out5)) && out5) {
-            const DXGI_FORMAT formats[] = {DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_B8G8R8A8_UNORM};
-            hr = out5->DuplicateOutput1(device_.Get(), 0, static_cast<UINT>(std::size(formats)), formats, &dupl);
-        } else {
-            hr = oi.output->DuplicateOutput(device_.Get(), &dupl);
+        hr = CreateDuplication(oi.output.Get(), adapters_[adapterOf[i]].device.Get(), dupl);
+        DuplInfo di;
+        di.dupl       = std::move(dupl);
+        di.output     = std::move(oi.output);
+        di.desc       = oi.desc;
+        di.colorSpace = oi.colorSpace;
+        di.sdrWhiteNits = oi.sdrWhiteNits;
+        di.peakNits   = oi.peakNits;
+        di.adapter    = adapterOf[i];
+        if (FAILED(hr)) NoteFailure(di, hr);
+        dupls_.push_back(std::move(di));
+    }
+    if (std::none_of(dupls_.begin(), dupls_.end(), [](const DuplInfo& di) { return di.dupl != nullptr; })) {
+        return false;
+    }
+
+    // Build the resource pool for this layout.  Outputs duplicated in a
+    // non-FP16 format get their blit resources up front, and outputs on
+    // other adapters their mirror; the mode reported by the duplication
+    // matches the textures AcquireNextFrame returns.
+    for (auto& di : dupls_) PrepareOutput(di);
+    RebuildWhiteRegions();
+
+    CompositeSlot slot;
+    if (!CreateCompositeSlot(slot)) return false;
+    composites_.push_back(std::move(slot));
+
+    if (continuous_ && !CreateCompositeSlot(live_)) return false;
+    ++liveVersion_;
+
+    ready_ = true;
+    return true;
+}
+
+void DesktopDuplicator::PrepareOutput(DuplInfo& di)
+{
+    if (!di.dupl) return;   // lost; Recover() prepares it
+    DXGI_OUTDUPL_DESC dd{};
+    di.dupl->GetDesc(&dd);
+
+    D3D11_TEXTURE2D_DESC srcDesc{};
+    srcDesc.Width  = dd.ModeDesc.Width;
+    srcDesc.Height = dd.ModeDesc.Height;
+    srcDesc.Format = dd.ModeDesc.Format;
+
+    // Not fatal — retried on the first frame from this output.
+    if (di.adapter != 0) {
+        (void)EnsureMirror(di, srcDesc);
+    }
+    if (dd.ModeDesc.Format != kCompositeFormat && convertCS_) {
+        (void)EnsureConvertResources(di.convert, srcDesc);
+    }
+}
+
+std::vector<RECT> DesktopDuplicator::OutputRects() const
+{
+    std::vector<RECT> rects;
+    rects.reserve(dupls_.size());
+    for (const auto& di : dupls_) rects.push_back(di.desc.DesktopCoordinates);
+    return rects;
+}
+
+void DesktopDuplicator::RebuildWhiteRegions()
+{
+    whiteRegions_.clear();
+    for (const auto& di : dupls_) {
+        RECT r = di.desc.DesktopCoordinates;
+        ::OffsetRect(&r, -bounds_.left, -bounds_.top);
+        whiteRegions_.push_back({r, di.sdrWhiteNits, di.peakNits});
+    }
+}
+
+// ── Recovery: display changes, lost outputs, removed devices ────────
+
+void DesktopDuplicator::NotifyDisplayChange() noexcept
+{
+    const std::lock_guard lock(mutex_);
+    layoutStale_ = true;
+}
+
+bool DesktopDuplicator::NeedsRecovery() noexcept
+{
+    const std::lock_guard lock(mutex_);
+    return !ready_ || layoutStale_ || deviceRemoved_ ||
+           std::any_of(dupls_.begin(), dupls_.end(), [](const DuplInfo& di) { return di.lost; });
+}
+
+void DesktopDuplicator::NoteFailure(DuplInfo& di, HRESULT hr) noexcept
+{
+    if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET || hr == DXGI_ERROR_DEVICE_HUNG ||
+        FAILED(device_->GetDeviceRemovedReason())) {
+        deviceRemoved_ = true;
+    }
+    // Access lost (mode change, HDR toggle, full-screen switch, secure
+    // desktop) and anything else: the duplication has to be re-created.
+    di.lost = true;
+}
+
+DesktopDuplicator::RecoverResult DesktopDuplicator::Recover()
+{
+    const std::lock_guard lock(mutex_);
+    if (!device_) return RecoverResult::Failed;
+    if (deviceRemoved_ || FAILED(device_->GetDeviceRemovedReason())) {
+        deviceRemoved_ = true;
+        return RecoverResult::DeviceLost;
+    }
+    if (!ready_) {
+        return InitLocked(device_.Get()) ? RecoverResult::Reinitialised : RecoverResult::Failed;
+    }
+
+    const bool anyLost = std::any_of(dupls_.begin(), dupls_.end(), [](const DuplInfo& di) { return di.lost; });
+    if (!layoutStale_ && !anyLost) return RecoverResult::Ok;
+
+    // A fresh factory: one made before the change keeps reporting the old
+    // layout.
+    ComPtr<IDXGIFactory1> factory;
+    if (FAILED(::CreateDXGIFactory1(IID_PPV_ARGS(&factory)))) return RecoverResult::Failed;
+    const std::vector<OutputInfo> outputs = EnumerateOutputs(factory.Get(), adapters_[0].luid);
+
+    // Monitors added, removed or moved: the composites change size, so
+    // only a full re-init will do.
+    const bool sameLayout = outputs.size() == layout_.size() &&
+        std::equal(outputs.begin(), outputs.end(), layout_.begin(), [](const OutputInfo& oi, const OutputKey& key) {
+            return key.name == oi.desc.DeviceName && ::EqualRect(&key.coordinates, &oi.desc.DesktopCoordinates) &&
+                   SameLuid(key.adapter, oi.adapterLuid);
+        });
+    if (!sameLayout) {
+        return InitLocked(device_.Get()) ? RecoverResult::Reinitialised : RecoverResult::Failed;
+    }
+
+    // Same layout: re-create only the duplications that were lost or whose
+    // colour space changed (HDR toggled, which also changes the format).
+    // White levels are refreshed for all.
+    bool ok = true;
+    for (auto& di : dupls_) {
+        const auto oi = std::find_if(outputs.begin(), outputs.end(), [&di](const OutputInfo& o) {
+            return std::wcscmp(o.desc.DeviceName, di.desc.DeviceName) == 0;
+        });
+        if (oi == outputs.end()) continue;
+        di.sdrWhiteNits = oi->sdrWhiteNits;
+        di.peakNits     = oi->peakNits;
+        if (!di.lost && oi->colorSpace == di.colorSpace) continue;
+
+        // Any frame held for a freeze goes with the old duplication.
+        di.acquired = {};
+        di.dupl.Reset();
+        di.live = false;
+
+        ComPtr<IDXGIOutputDuplication> dupl;
+        const HRESULT hr = CreateDuplication(oi->output.Get(), adapters_[di.adapter].device.Get(), dupl);
+        if (FAILED(hr)) {
+            NoteFailure(di, hr);
+            ok = false;
+            continue;
         }
-        if (SUCCEEDED(hr) && dupl) {
-            dupls_.push_back({std::move(dupl), oi.desc});
+        di.dupl       = std::move(dupl);
+        di.output     = oi->output;
+        di.desc       = oi->desc;
+        di.colorSpace = oi->colorSpace;
+        di.lost       = false;
+        PrepareOutput(di);
+    }
+    RebuildWhiteRegions();
+    if (ok) layoutStale_ = false;
+    if (deviceRemoved_) return RecoverResult::DeviceLost;
+    return ok ? RecoverResult::Ok : RecoverResult::Failed;
+}
+
+void DesktopDuplicator::SetContinuous(bool enabled)
+{
+    const std::lock_guard lock(mutex_);
+    if (continuous_ == enabled) return;
+    frozenAt_ = 0;
+    continuous_ = enabled;
+
+    // Outputs must be re-blitted in full into a fresh live composite.
+    for (auto& di : dupls_) di.live = false;
+    live_ = {};
+    if (enabled && ready_ && !CreateCompositeSlot(live_)) {
+        continuous_ = false;
+    }
+    ++liveVersion_;
+}
+
+// ── Cross-adapter mirrors ────────────────────────────────────────────
+
+bool DesktopDuplicator::EnsureMirror(DuplInfo& di, const D3D11_TEXTURE2D_DESC& srcDesc)
+{
+    auto& m = di.mirror;
+    if (m.local &&
+        m.desc.Width  == srcDesc.Width &&
+        m.desc.Height == srcDesc.Height &&
+        m.desc.Format == srcDesc.Format) {
+        return true;
+    }
+
+    m = {};
+    ID3D11Device* remoteDevice = adapters_[di.adapter].device.Get();
+
+    D3D11_TEXTURE2D_DESC desc{};
+    desc.Width            = srcDesc.Width;
+    desc.Height           = srcDesc.Height;
+    desc.MipLevels        = 1;
+    desc.ArraySize        = 1;
+    desc.Format           = srcDesc.Format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_DEFAULT;
+    desc.BindFlags        = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    desc.MiscFlags        = D3D11_RESOURCE_MISC_SHARED_KEYEDMUTEX;
+
+    // Preferred: a keyed-mutex texture shared between the two devices.
+    ComPtr<IDXGIResource> shared;
+    HANDLE handle{};
+    if (SUCCEEDED(remoteDevice->CreateTexture2D(&desc, nullptr, &m.remote)) &&
+        SUCCEEDED(m.remote.As(&shared)) &&
+        SUCCEEDED(shared->GetSharedHandle(&handle)) &&
+        SUCCEEDED(device_->OpenSharedResource(handle, IID_PPV_ARGS(&m.local))) &&
+        SUCCEEDED(m.remote.As(&m.remoteMutex)) &&
+        SUCCEEDED(m.local.As(&m.localMutex))) {
+        m.desc = desc;
+        return true;
+    }
+
+    // Many driver pairs can't open each other's resources: bounce through
+    // a staging texture and system memory instead.
+    m = {};
+    desc.Usage          = D3D11_USAGE_STAGING;
+    desc.BindFlags      = 0;
+    desc.MiscFlags      = 0;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    HRESULT hr = remoteDevice->CreateTexture2D(&desc, nullptr, &m.remote);
+    if (FAILED(hr)) { m = {}; return false; }
+
+    desc.Usage          = D3D11_USAGE_DEFAULT;
+    desc.CPUAccessFlags = 0;
+    hr = device_->CreateTexture2D(&desc, nullptr, &m.local);
+    if (FAILED(hr)) { m = {}; return false; }
+
+    m.desc   = desc;
+    m.staged = true;
+    return true;
+}
+
+ID3D11Texture2D* DesktopDuplicator::UpdateMirror(DuplInfo& di, ID3D11Texture2D* tex,
+                                                 const std::vector<RECT>& rects)
+{
+    D3D11_TEXTURE2D_DESC texDesc{};
+    tex->GetDesc(&texDesc);
+    if (!EnsureMirror(di, texDesc)) return nullptr;
+
+    auto& m = di.mirror;
+    ID3D11DeviceContext* remoteCtx = adapters_[di.adapter].ctx.Get();
+
+    const auto toBox = [](const RECT& r) {
+        D3D11_BOX box{};
+        box.left   = static_cast<UINT>(r.left);
+        box.top    = static_cast<UINT>(r.top);
+        box.right  = static_cast<UINT>(r.right);
+        box.bottom = static_cast<UINT>(r.bottom);
+        box.back   = 1;
+        return box;
+    };
+
+    if (!m.staged) {
+        // A handover that times out (easy while a dGPU wakes from D3)
+        // leaves the key where neither side expects it, and every later
+        // frame would time out too: start over with a fresh pair, made
+        // by EnsureMirror() on the next frame.
+        if (m.remoteMutex->AcquireSync(0, kMirrorSyncMs) != S_OK) {
+            m = {};
+            return nullptr;
+        }
+        for (const auto& r : rects) {
+            const D3D11_BOX box = toBox(r);
+            remoteCtx->CopySubresourceRegion(m.remote.Get(), 0, box.left, box.top, 0, tex, 0, &box);
         }
+        (void)m.remoteMutex->ReleaseSync(1);
+        remoteCtx->Flush();
+
+        // Held until the caller's blits are queued; released with key 0.
+        if (m.localMutex->AcquireSync(1, kMirrorSyncMs) != S_OK) {
+            m = {};
+            return nullptr;
+        }
+        return m.local.Get();
     }
-    if (dupls_.empty()) return false;
 
-    ready_ = true;
+    for (const auto& r : rects) {
+        const D3D11_BOX box = toBox(r);
+        remoteCtx->CopySubresourceRegion(m.remote.Get(), 0, box.left, box.top, 0, tex, 0, &box);
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mapped{};
+    if (FAILED(remoteCtx->Map(m.remote.Get(), 0, D3D11_MAP_READ, 0, &mapped))) return nullptr;
+
+    const uint32_t bpp = BytesPerPixel(texDesc.Format);
+    const auto* base = static_cast<const uint8_t*>(mapped.pData);
+    for (const auto& r : rects) {
+        const D3D11_BOX box = toBox(r);
+        const uint8_t* src = base + static_cast<size_t>(box.top) * mapped.RowPitch +
+                             static_cast<size_t>(box.left) * bpp;
+        ctx_->UpdateSubresource(m.local.Get(), 0, &box, src, mapped.RowPitch, 0);
+    }
+    remoteCtx->Unmap(m.remote.Get(), 0);
+    return m.local.Get();
+}
+
+// ── Per-output frame acquisition ─────────────────────────────────────
+
+void DesktopDuplicator::AcquireFrames(ThreadPool* pool, bool incremental)
+{
+    // One output per chunk, so per-output vsync waits overlap.
+    ParallelFor(pool, dupls_.size(), 1, [this, incremental](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            auto& di = dupls_[i];
+            if (di.acquired.frozen) continue;
+            di.acquired = {};
+            // Lost, and Recover() could not re-create it yet.
+            if (!di.dupl) {
+                di.acquired.hr = DXGI_ERROR_ACCESS_LOST;
+                continue;
+            }
+            const UINT timeout = (incremental && di.live) ? 0 : kAcquireTimeoutMs;
+            const ScopedTrace trace(TraceStage::Acquire, static_cast<uint32_t>(i));
+            di.acquired.hr = di.dupl->AcquireNextFrame(timeout, &di.acquired.info, &di.acquired.resource);
+        }
+    });
+}
+
+bool DesktopDuplicator::GetChangedRects(DuplInfo& di, const DXGI_OUTDUPL_FRAME_INFO& info,
+                                        std::vector<RECT>& rects)
+{
+    rects.clear();
+    if (info.TotalMetadataBufferSize == 0) return true;
+    if (metadata_.size() < info.TotalMetadataBufferSize) {
+        metadata_.resize(info.TotalMetadataBufferSize);
+    }
+
+    // Move rects first: the acquired image already holds the moved pixels
+    // at their destination, so copying each destination rect from it is
+    // equivalent to replaying the move on the live composite (and avoids
+    // an overlapping same-texture copy).
+    UINT used = 0;
+    HRESULT hr = di.dupl->GetFrameMoveRects(
+        static_cast<UINT>(metadata_.size()),
+        reinterpret_cast<DXGI_OUTDUPL_MOVE_RECT*>(metadata_.data()), &used);
+    if (FAILED(hr)) return false;
+
+    const auto* moves = reinterpret_cast<const DXGI_OUTDUPL_MOVE_RECT*>(metadata_.data());
+    for (UINT i = 0; i < used / sizeof(DXGI_OUTDUPL_MOVE_RECT); ++i) {
+        rects.push_back(moves[i].DestinationRect);
+    }
+
+    hr = di.dupl->GetFrameDirtyRects(
+        static_cast<UINT>(metadata_.size()),
+        reinterpret_cast<RECT*>(metadata_.data()), &used);
+    if (FAILED(hr)) return false;
+
+    const auto* dirty = reinterpret_cast<const RECT*>(metadata_.data());
+    rects.insert(rects.end(), dirty, dirty + used / sizeof(RECT));
     return true;
 }
 
-// ── CaptureFullDesktop: GPU-composited frame ─────────────────────────
+void DesktopDuplicator::BlitRect(const DuplInfo& di, ID3D11Texture2D* tex, bool converted,
+                                 const RECT& rect, const CompositeSlot& slot)
+{
+    // Calculate clamped blit region.
+    const auto compW = static_cast<int>(bounds_.Width());
+    const auto compH = static_cast<int>(bounds_.Height());
 
-std::optional<FrameData> DesktopDuplicator::CaptureFullDesktop()
+    int srcX = rect.left, srcY = rect.top;
+    int dstX = di.desc.DesktopCoordinates.left - bounds_.left + srcX;
+    int dstY = di.desc.DesktopCoordinates.top  - bounds_.top  + srcY;
+    int blitW = rect.right - rect.left;
+    int blitH = rect.bottom - rect.top;
+
+    if (dstX < 0) { srcX -= dstX; blitW += dstX; dstX = 0; }
+    if (dstY < 0) { srcY -= dstY; blitH += dstY; dstY = 0; }
+    if (dstX + blitW > compW) { blitW = compW - dstX; }
+    if (dstY + blitH > compH) { blitH = compH - dstY; }
+
+    if (blitW <= 0 || blitH <= 0) return;
+
+    if (!converted) {
+        // Fast path — direct GPU blit (same format, no conversion).
+        D3D11_BOX box{};
+        box.left   = static_cast<UINT>(srcX);
+        box.top    = static_cast<UINT>(srcY);
+        box.front  = 0;
+        box.right  = static_cast<UINT>(srcX + blitW);
+        box.bottom = static_cast<UINT>(srcY + blitH);
+        box.back   = 1;
+
+        ctx_->CopySubresourceRegion(
+            slot.tex.Get(), 0,
+            static_cast<UINT>(dstX), static_cast<UINT>(dstY), 0,
+            tex, 0, &box);
+    } else {
+        // Compute-shader path — GPU format conversion (BGRA8 → FP16).
+        BlitConvertedGPU(ctx_.Get(), convertCS_.Get(),
+                         di.convert.srv.Get(), di.convert.params.Get(), slot.uav.Get(),
+                         srcX, srcY, dstX, dstY, blitW, blitH);
+    }
+}
+
+bool DesktopDuplicator::BlitOutputToComposite(DuplInfo& di, const CompositeSlot& slot, bool incremental)
 {
-    if (!ready_) return std::nullopt;
+    // Once an output is live there is nothing to wait for: a timeout just
+    // means nothing changed.
+    const bool patch = incremental && di.live;
+    const AcquiredFrame acquired = std::move(di.acquired);
+    di.acquired = {};
+    if (patch && acquired.hr == DXGI_ERROR_WAIT_TIMEOUT) {
+        return true;
+    }
+    if (FAILED(acquired.hr) || !acquired.resource) {
+        // A non-live output timing out only has nothing to show yet.
+        if (acquired.hr != DXGI_ERROR_WAIT_TIMEOUT) NoteFailure(di, acquired.hr);
+        return false;
+    }
+    UpdatePointer(di, acquired.info);
 
-    const uint32_t totalW = bounds_.Width();
-    const uint32_t totalH = bounds_.Height();
+    // Pointer-only update: the desktop image is unchanged.
+    if (patch && acquired.info.LastPresentTime.QuadPart == 0) {
+        di.dupl->ReleaseFrame();
+        return true;
+    }
 
-    // Always composite into FP16 (linear scRGB).
-    constexpr DXGI_FORMAT compositeFormat = DXGI_FORMAT_R16G16B16A16_FLOAT;
+    ComPtr<ID3D11Texture2D> tex;
+    HRESULT hr = acquired.resource.As(&tex);
+    if (FAILED(hr)) {
+        di.dupl->ReleaseFrame();
+        return false;
+    }
 
-    // Create the composite GPU texture.
-    // BIND_UNORDERED_ACCESS is needed for the compute-shader conversion path.
-    D3D11_TEXTURE2D_DESC compDesc{};
-    compDesc.Width            = totalW;
-    compDesc.Height           = totalH;
-    compDesc.MipLevels        = 1;
-    compDesc.ArraySize        = 1;
-    compDesc.Format           = compositeFormat;
-    compDesc.SampleDesc.Count = 1;
-    compDesc.Usage            = D3D11_USAGE_DEFAULT;
-    compDesc.BindFlags        = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+    D3D11_TEXTURE2D_DESC texDesc{};
+    tex->GetDesc(&texDesc);
+
+    // Rectangles to refresh: only the changed ones once the output is live.
+    if (!patch || !GetChangedRects(di, acquired.info, changed_)) {
+        changed_.assign(1, RECT{0, 0, static_cast<LONG>(texDesc.Width), static_cast<LONG>(texDesc.Height)});
+    }
+    for (auto& r : changed_) {
+        r = ClampRect(r, texDesc.Width, texDesc.Height);
+    }
+    changed_.erase(std::remove_if(changed_.begin(), changed_.end(), [](const RECT& r) {
+        return r.right <= r.left || r.bottom <= r.top;
+    }), changed_.end());
+
+    // Outputs on other adapters are read through their mirror.  The copy
+    // into it is queued, so the frame can go back to DWM right after.
+    ID3D11Texture2D* src = tex.Get();
+    const bool mirrored = (di.adapter != 0);
+    if (mirrored) {
+        src = UpdateMirror(di, tex.Get(), changed_);
+        if (!src) {
+            // This frame's changes never reached the composite; the next
+            // one is copied in full.
+            di.live = false;
+            di.dupl->ReleaseFrame();
+            return false;
+        }
+    }
 
-    ComPtr<ID3D11Texture2D> composite;
-    HRESULT hr = device_->CreateTexture2D(&compDesc, nullptr, &composite);
-    if (FAILED(hr)) return std::nullopt;
+    // Check format compatibility for a direct GPU copy.
+    const bool formatMatch = (texDesc.Format == kCompositeFormat);
+    const bool converted = !formatMatch && convertCS_ && EnsureConvertResources(di.convert, texDesc);
 
-    // Blit each monitor into the composite.
-    bool anyCaptured = false;
+    if (formatMatch || converted) {
+        // DD textures are DWM-owned and don't support SRV; the conversion
+        // reads a persistent copy.
+        if (converted) {
+            ctx_->CopyResource(di.convert.srcCopy.Get(), src);
+        }
+        for (const auto& r : changed_) {
+            BlitRect(di, src, converted, r, slot);
+        }
+        if (incremental && !changed_.empty()) ++liveVersion_;
+    }
+    // Even an output we can't convert counts as live, so later updates
+    // don't keep waiting on it.
+    if (incremental) di.live = true;
+
+    if (mirrored && di.mirror.localMutex) {
+        (void)di.mirror.localMutex->ReleaseSync(0);
+    }
+    di.dupl->ReleaseFrame();
+    return true;
+}
+
+bool DesktopDuplicator::Update(ThreadPool* pool)
+{
+    const std::lock_guard lock(mutex_);
+
+    // Frozen: the live composite stays at the key press until the capture.
+    if (frozenAt_) return true;
+    return UpdateLocked(pool);
+}
+
+bool DesktopDuplicator::UpdateLocked(ThreadPool* pool)
+{
+    if (!ready_ || !continuous_ || !live_.tex) return false;
+
+    AcquireFrames(pool, true);
+
+    // Any failure (access lost, mode change) leaves that output's part of
+    // the live composite stale, so report it and let the caller Recover().
+    bool ok = true;
+    compositeTimer_.Begin(ctx_.Get());
     for (auto& di : dupls_) {
-        if (BlitOutputToComposite(device_.Get(), ctx_.Get(), convertCS_.Get(),
-                                  di.dupl.Get(), bounds_, di.desc,
-                                  composite.Get(), compositeFormat)) {
-            anyCaptured = true;
+        if (!BlitOutputToComposite(di, live_, true)) {
+            di.live = false;
+            ok = false;
         }
     }
+    compositeTimer_.End(ctx_.Get());
+    return ok;
+}
+
+std::optional<FrameData> DesktopDuplicator::LiveFrame() const
+{
+    if (!ready_ || !continuous_ || !live_.tex) return std::nullopt;
+
+    FrameData frame;
+    frame.gpuTexture    = live_.tex;
+    frame.width         = bounds_.Width();
+    frame.height        = bounds_.Height();
+    frame.format        = static_cast<uint32_t>(kCompositeFormat);
+    frame.bytesPerPixel = BytesPerPixel(kCompositeFormat);
+    frame.whiteRegions  = whiteRegions_;
+    return frame;
+}
+
+bool DesktopDuplicator::Freeze(int64_t keyDownAt)
+{
+    const std::lock_guard lock(mutex_);
+    if (!ready_ || !continuous_ || !live_.tex) return false;
 
-    if (!anyCaptured) {
-        return std::nullopt;
+    // An earlier key press is still waiting for its capture.
+    if (frozenAt_) return true;
+
+    // Live outputs are polled, so each holds what DWM accumulated up to now
+    // (a timeout: unchanged since the live composite) and no monitor waits
+    // on another.  Outputs without a full frame yet are acquired by the
+    // capture as usual.
+    bool any = false;
+    for (size_t i = 0; i < dupls_.size(); ++i) {
+        auto& di = dupls_[i];
+        if (!di.live) continue;
+        di.acquired = {};
+        const ScopedTrace trace(TraceStage::Acquire, static_cast<uint32_t>(i));
+        di.acquired.hr = di.dupl->AcquireNextFrame(0, &di.acquired.info, &di.acquired.resource);
+        di.acquired.frozen = true;
+        any = true;
+    }
+    if (!any) return false;
+
+    frozenAt_ = keyDownAt;
+    TraceRecord(TraceStage::KeyToAcquire, keyDownAt);
+    return true;
+}
+
+// ── Mouse pointer overlay ───────────────────────────────────────────
+
+void DesktopDuplicator::UpdatePointer(DuplInfo& di, const DXGI_OUTDUPL_FRAME_INFO& info)
+{
+    // Zero: neither position nor shape changed with this frame.
+    if (info.LastMouseUpdateTime.QuadPart == 0) return;
+
+    // Every output reports the pointer hidden while it is on another one;
+    // only the output that has it can hide it.
+    auto& p = pointer_;
+    if (info.PointerPosition.Visible) {
+        p.visible  = true;
+        p.monitor  = di.desc.Monitor;
+        p.sdrWhiteNits = di.sdrWhiteNits;
+        p.position = {di.desc.DesktopCoordinates.left + info.PointerPosition.Position.x,
+                      di.desc.DesktopCoordinates.top  + info.PointerPosition.Position.y};
+    } else if (p.monitor == di.desc.Monitor) {
+        p.visible = false;
+    }
+
+    // The shape only comes when it changes.
+    if (info.PointerShapeBufferSize == 0) return;
+    if (p.raw.size() < info.PointerShapeBufferSize) {
+        p.raw.resize(info.PointerShapeBufferSize);
+    }
+    UINT used = 0;
+    if (FAILED(di.dupl->GetFramePointerShape(static_cast<UINT>(p.raw.size()), p.raw.data(),
+                                             &used, &p.info))) {
+        return;
+    }
+    (void)BuildPointerImage(p.raw.data(), p.info, p.image, p.width, p.height);
+    p.imageDirty = true;
+}
+
+void DesktopDuplicator::DrawPointer(const CompositeSlot& slot)
+{
+    auto& p = pointer_;
+    if (!cursorCS_ || !p.visible || p.image.empty()) return;
+
+    // Textures are only recreated when the shape changes size.
+    if (p.imageDirty) {
+        D3D11_TEXTURE2D_DESC desc{};
+        if (p.tex) p.tex->GetDesc(&desc);
+        if (!p.tex || desc.Width != p.width || desc.Height != p.height) {
+            p.tex.Reset();
+            p.srv.Reset();
+            p.background.Reset();
+            p.backgroundSrv.Reset();
+
+            desc = {};
+            desc.Width            = p.width;
+            desc.Height           = p.height;
+            desc.MipLevels        = 1;
+            desc.ArraySize        = 1;
+            desc.Format           = DXGI_FORMAT_B8G8R8A8_UNORM;
+            desc.SampleDesc.Count = 1;
+            desc.Usage            = D3D11_USAGE_DEFAULT;
+            desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+            if (FAILED(device_->CreateTexture2D(&desc, nullptr, &p.tex)) ||
+                FAILED(device_->CreateShaderResourceView(p.tex.Get(), nullptr, &p.srv))) {
+                p.tex.Reset();
+                return;
+            }
+            desc.Format = kCompositeFormat;
+            if (FAILED(device_->CreateTexture2D(&desc, nullptr, &p.background)) ||
+                FAILED(device_->CreateShaderResourceView(p.background.Get(), nullptr, &p.backgroundSrv))) {
+                p.tex.Reset();
+                return;
+            }
+        }
+        ctx_->UpdateSubresource(p.tex.Get(), 0, nullptr, p.image.data(), p.width * 4, 0);
+        p.imageDirty = false;
+    }
+    if (!p.tex) return;
+
+    if (!p.params) {
+        D3D11_BUFFER_DESC cbDesc{};
+        cbDesc.ByteWidth = sizeof(CursorParams);
+        cbDesc.Usage     = D3D11_USAGE_DEFAULT;
+        cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+        if (FAILED(device_->CreateBuffer(&cbDesc, nullptr, &p.params))) return;
+    }
+
+    // Clip the shape to the virtual desktop.  Rotated outputs get the
+    // shape unrotated.
+    const int left = p.position.x - bounds_.left;
+    const int top  = p.position.y - bounds_.top;
+    const int x0 = (std::max)(0, -left);
+    const int y0 = (std::max)(0, -top);
+    const int x1 = (std::min)(static_cast<int>(p.width),  static_cast<int>(bounds_.Width())  - left);
+    const int y1 = (std::min)(static_cast<int>(p.height), static_cast<int>(bounds_.Height()) - top);
+    if (x1 <= x0 || y1 <= y0) return;
+
+    // The shader reads a copy of what the pointer covers and only writes
+    // the composite.
+    D3D11_BOX box{};
+    box.left   = static_cast<UINT>(left + x0);
+    box.top    = static_cast<UINT>(top + y0);
+    box.right  = static_cast<UINT>(left + x1);
+    box.bottom = static_cast<UINT>(top + y1);
+    box.back   = 1;
+    ctx_->CopySubresourceRegion(p.background.Get(), 0, 0, 0, 0, slot.tex.Get(), 0, &box);
+
+    // Drawn at the pointer monitor's SDR white, as the DWM does.
+    const CursorParams params{left + x0, top + y0, x1 - x0, y1 - y0, x0, y0,
+                              p.sdrWhiteNits / 80.0f, 0.0f};
+    ctx_->UpdateSubresource(p.params.Get(), 0, nullptr, &params, 0, 0);
+
+    ID3D11ShaderResourceView* srvs[] = {p.backgroundSrv.Get(), p.srv.Get()};
+    ID3D11UnorderedAccessView* uav = slot.uav.Get();
+    ctx_->CSSetShader(cursorCS_.Get(), nullptr, 0);
+    ctx_->CSSetShaderResources(0, 2, srvs);
+    ctx_->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
+    ctx_->CSSetConstantBuffers(0, 1, p.params.GetAddressOf());
+    ctx_->Dispatch((static_cast<UINT>(x1 - x0) + 15u) / 16u, (static_cast<UINT>(y1 - y0) + 15u) / 16u, 1);
+
+    ID3D11ShaderResourceView* nullSRVs[2] = {};
+    ID3D11UnorderedAccessView* nullUAV = nullptr;
+    ID3D11Buffer* nullCB = nullptr;
+    ctx_->CSSetShaderResources(0, 2, nullSRVs);
+    ctx_->CSSetUnorderedAccessViews(0, 1, &nullUAV, nullptr);
+    ctx_->CSSetConstantBuffers(0, 1, &nullCB);
+    ctx_->CSSetShader(nullptr, nullptr, 0);
+}
+
+// ── CaptureFullDesktop: GPU-composited frame ─────────────────────────
+
+std::optional<FrameData> DesktopDuplicator::CaptureFullDesktop(ThreadPool* pool)
+{
+    const std::lock_guard lock(mutex_);
+    if (!ready_) return std::nullopt;
+
+    // Frozen frames show the key press; they are composed below.
+    const int64_t capturedAt = frozenAt_ ? frozenAt_ : TraceNow();
+    frozenAt_ = 0;
+
+    // Use a pooled composite; only if every slot is still held by an
+    // earlier frame and the pool is full do we fall back to a fresh one.
+    CompositeSlot transient;
+    CompositeSlot* slot = AcquireCompositeSlot();
+    if (!slot) {
+        if (!CreateCompositeSlot(transient)) return std::nullopt;
+        slot = &transient;
     }
 
+    if (continuous_) {
+        // Bring the live composite up to date, then snapshot it so later
+        // updates don't show through the returned frame.
+        if (!UpdateLocked(pool)) return std::nullopt;
+        ctx_->CopyResource(slot->tex.Get(), live_.tex.Get());
+    } else {
+        // Areas no output covers (or whose output timed out) must not show
+        // a previous capture.
+        const float black[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        ctx_->ClearUnorderedAccessViewFloat(slot->uav.Get(), black);
+
+        // Acquire all monitors at once, then blit each into the composite.
+        AcquireFrames(pool, false);
+        bool anyCaptured = false;
+        compositeTimer_.Begin(ctx_.Get());
+        for (auto& di : dupls_) {
+            if (BlitOutputToComposite(di, *slot, false)) {
+                anyCaptured = true;
+            }
+        }
+        compositeTimer_.End(ctx_.Get());
+
+        if (!anyCaptured) {
+            return std::nullopt;
+        }
+    }
+
+    if (cursorOverlay_) DrawPointer(*slot);
+
     FrameData frame;
-    frame.gpuTexture    = std::move(composite);
-    frame.width         = totalW;
-    frame.height        = totalH;
-    frame.format        = static_cast<uint32_t>(compositeFormat);
-    frame.bytesPerPixel = BytesPerPixel(compositeFormat);
+    frame.gpuTexture    = slot->tex;
+    if (slot != &transient) {
+        frame.lease = std::make_shared<char>();
+        slot->lease = frame.lease;
+    }
+    frame.width         = bounds_.Width();
+    frame.height        = bounds_.Height();
+    frame.format        = static_cast<uint32_t>(kCompositeFormat);
+    frame.bytesPerPixel = BytesPerPixel(kCompositeFormat);
+    frame.whiteRegions  = whiteRegions_;
+    frame.capturedAt    = capturedAt;
     // pixels left empty — read back lazily via ReadbackPixels() when needed.
     return frame;
 }
@@ -1,20 +1,35 @@
 #pragma once
 
 #include "capture/FrameData.h"
+#include "capture/Trace.h"
 
 #include <d3d11.h>
 #include <dxgi1_2.h>
 #include <dxgi1_5.h>
 #include <wrl/client.h>
 
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
 #include <vector>
 
 namespace screencap::capture {
 
+class ThreadPool;
+
 // Persistent Desktop Duplication engine.
 // Initialise once at startup; CaptureFullDesktop() then acquires frames
-// with near-zero latency (no device / output re-creation).
+// with near-zero latency (no device / output re-creation).  All GPU
+// resources (composites, blit textures, views, constant buffers) are
+// pooled and built in Init(), so a capture performs no D3D allocation.
+//
+// Outputs on every adapter are captured: those on the shared device's
+// adapter directly, others through a device of their own whose frames are
+// mirrored into a texture the shared device can read.
+//
+// Freeze() may be called from another thread; everything else belongs to
+// the thread that owns the device's immediate context.
 class DesktopDuplicator final {
 public:
     DesktopDuplicator() = default;
@@ -22,16 +37,80 @@ public:
 
     DesktopDuplicator(const DesktopDuplicator&) = delete;
     DesktopDuplicator& operator=(const DesktopDuplicator&) = delete;
-    DesktopDuplicator(DesktopDuplicator&&) = default;
-    DesktopDuplicator& operator=(DesktopDuplicator&&) = default;
+    DesktopDuplicator(DesktopDuplicator&&) = delete;
+    DesktopDuplicator& operator=(DesktopDuplicator&&) = delete;
 
-    // Enumerate outputs and set up duplications using a shared device.
-    // Returns false on fatal failure (no outputs, etc.).
+    // Enumerate outputs on all adapters, set up duplications (using the
+    // shared device where possible) and build the resource pool for the
+    // current layout.  Compiled shaders are kept when the device is the
+    // same.  Returns false on fatal failure (no outputs, etc.).
     [[nodiscard]] bool Init(ID3D11Device* device);
 
-    // Acquire the current desktop frame from all monitors.
+    enum class RecoverResult {
+        Ok,             // nothing to do, or lost outputs re-duplicated
+        Reinitialised,  // the layout changed: full Init() on the same device
+        DeviceLost,     // the shared device was removed: Init() with a new one
+        Failed,         // try again later (e.g. the secure desktop is up)
+    };
+
+    // Repair what a capture or Update() ran into (access lost on an
+    // output, removed device) or what NotifyDisplayChange() flagged.  With
+    // the same monitors in the same places, only the outputs that were lost
+    // or changed colour space (HDR toggle) are duplicated again, keeping
+    // the composites, mirrors and shaders; anything else re-initialises.
+    // Meant to run when a display change settles, before the next capture.
+    [[nodiscard]] RecoverResult Recover();
+
+    // WM_DISPLAYCHANGE: the next Recover() compares the layout.
+    void NotifyDisplayChange() noexcept;
+
+    // A failure or display change is waiting for Recover().
+    [[nodiscard]] bool NeedsRecovery() noexcept;
+
+    // Acquire the current desktop frame from all monitors.  With a pool,
+    // outputs are acquired concurrently so latency is the slowest
+    // monitor's, not the sum; composition stays on the calling thread.
+    // The returned gpuTexture is a pooled composite; it is not reused until
+    // the FrameData (and any copies of its ComPtr) have been released.
     // Returns std::nullopt on failure (DEVICE_LOST, no frames, etc.).
-    [[nodiscard]] std::optional<FrameData> CaptureFullDesktop();
+    [[nodiscard]] std::optional<FrameData> CaptureFullDesktop(ThreadPool* pool = nullptr);
+
+    // Continuous mode keeps a live composite that is patched with only the
+    // dirty and moved rectangles of each desktop update, so a capture never
+    // waits for DWM to present a new frame (a static desktop returns the
+    // live composite immediately instead of timing out).  Persists across
+    // Init().
+    void SetContinuous(bool enabled);
+    [[nodiscard]] bool IsContinuous() const noexcept { return continuous_; }
+
+    // Continuous mode: apply any pending desktop updates to the live
+    // composite without blocking.  CaptureFullDesktop() calls this itself;
+    // DXGI accumulates updates in between.  Returns false if any output
+    // could not be updated, e.g. access lost (call Recover()).
+    [[nodiscard]] bool Update(ThreadPool* pool = nullptr);
+
+    // Continuous mode: bumped whenever Update() (or a re-Init()) changes
+    // the live composite, so consumers can skip an unchanged desktop.
+    [[nodiscard]] uint64_t LiveVersion() const noexcept { return liveVersion_; }
+
+    // Continuous mode: the live composite itself, without the snapshot
+    // copy CaptureFullDesktop() makes.  Only for reading right away: the
+    // next Update() patches it in place.
+    [[nodiscard]] std::optional<FrameData> LiveFrame() const;
+
+    // Continuous mode, any thread: hold every output's pending desktop
+    // update as of now (`keyDownAt`, TraceNow() ticks) without touching
+    // the device context.  Until the next CaptureFullDesktop() composes
+    // exactly those frames, Update() leaves the live composite alone, so
+    // the capture shows the desktop at the key press however late the
+    // owning thread gets to it.  Returns false if nothing was frozen.
+    bool Freeze(int64_t keyDownAt);
+
+    // Draw the mouse pointer into frames CaptureFullDesktop() returns.
+    // Shape and position come from the frame info of the same acquisitions,
+    // so this costs no extra round trip.  The live composite stays clean.
+    void SetCursorOverlay(bool enabled) noexcept { cursorOverlay_ = enabled; }
+    [[nodiscard]] bool CursorOverlay() const noexcept { return cursorOverlay_; }
 
     // Virtual-desktop bounding rect (union of all monitors).
     struct Bounds {
@@ -43,17 +122,185 @@ public:
         [[nodiscard]] uint32_t Height() const noexcept { return static_cast<uint32_t>(bottom - top); }
     };
 
+    // As of the last Init() / Recover(): the area captured frames cover
+    // (frame pixel (0, 0) is its top-left), and each duplicated output's
+    // desktop rectangle, in the order of a frame's whiteRegions.
+    [[nodiscard]] Bounds DesktopBounds() const noexcept { return bounds_; }
+    [[nodiscard]] std::vector<RECT> OutputRects() const;
+
 private:
+    // Persistent BGRA8 → FP16 blit resources for one output, keyed on the
+    // duplication texture's size and format.  Only used for outputs whose
+    // duplication format differs from the composite's.
+    struct ConvertResources {
+        D3D11_TEXTURE2D_DESC                             desc{};
+        Microsoft::WRL::ComPtr<ID3D11Texture2D>          srcCopy;  // SRV-capable copy of the DD texture
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+        Microsoft::WRL::ComPtr<ID3D11Buffer>             params;   // BlitParams
+    };
+
+    // A device on one adapter.  adapters_[0] is the shared device.
+    struct AdapterDevice {
+        LUID                                        luid{};
+        Microsoft::WRL::ComPtr<ID3D11Device>        device;
+        Microsoft::WRL::ComPtr<ID3D11DeviceContext> ctx;
+    };
+
+    // Copy of a secondary-adapter output's duplication texture that the
+    // shared device can read: a keyed-mutex shared texture when the
+    // drivers allow opening it, otherwise a staging bounce through system
+    // memory into a local texture.
+    struct CrossAdapterMirror {
+        D3D11_TEXTURE2D_DESC                    desc{};
+        Microsoft::WRL::ComPtr<ID3D11Texture2D> remote;       // on the output's adapter
+        Microsoft::WRL::ComPtr<IDXGIKeyedMutex> remoteMutex;
+        Microsoft::WRL::ComPtr<ID3D11Texture2D> local;        // on the shared device
+        Microsoft::WRL::ComPtr<IDXGIKeyedMutex> localMutex;
+        bool                                    staged{false};
+    };
+
+    // Result of AcquireNextFrame, taken in the parallel phase and consumed
+    // by the serial composition.
+    struct AcquiredFrame {
+        HRESULT                                hr{E_PENDING};
+        DXGI_OUTDUPL_FRAME_INFO                info{};
+        Microsoft::WRL::ComPtr<IDXGIResource>  resource;
+        bool                                   frozen{false};  // taken by Freeze(), kept for composition
+    };
+
     struct DuplInfo {
-        Microsoft::WRL::ComPtr<IDXGIOutputDuplication> dupl;
-        DXGI_OUTPUT_DESC desc{};
+        Microsoft::WRL::ComPtr<IDXGIOutputDuplication> dupl;        // null while lost
+        Microsoft::WRL::ComPtr<IDXGIOutput1>           output;
+        DXGI_OUTPUT_DESC   desc{};
+        DXGI_COLOR_SPACE_TYPE colorSpace{};                         // at duplication time
+        float              sdrWhiteNits{80.0f};   // refreshed by Init() / Recover() only
+        float              peakNits{0.0f};
+        size_t             adapter{0};  // index into adapters_
+        ConvertResources   convert;
+        CrossAdapterMirror mirror;      // secondary adapters only
+        AcquiredFrame      acquired;
+        bool               live{false}; // live composite holds a full frame of this output
+        bool               lost{false}; // acquisition failed; Recover() re-duplicates
     };
 
+    // An output as enumerated by Init(), to tell a changed layout from one
+    // where only modes or colour spaces changed.
+    struct OutputKey {
+        std::wstring name;
+        RECT         coordinates{};
+        LUID         adapter{};
+    };
+
+    // One pooled FP16 composite.  A slot is free once every FrameData
+    // handed out with it has been released (its FrameData::lease expired).
+    // Other references to the texture (views, caches) don't keep it.
+    struct CompositeSlot {
+        Microsoft::WRL::ComPtr<ID3D11Texture2D>           tex;
+        Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav;
+        std::weak_ptr<void>                               lease;
+    };
+
+    // Latest pointer from the frame info, and its shape as BGRA8 sRGB with
+    // straight alpha (XOR pixels: alpha 0, colour = channels to invert).
+    struct PointerState {
+        std::vector<uint8_t>                             raw;      // GetFramePointerShape scratch
+        DXGI_OUTDUPL_POINTER_SHAPE_INFO                  info{};
+        std::vector<uint32_t>                            image;
+        UINT                                             width{}, height{};
+        bool                                             imageDirty{false};
+        HMONITOR                                         monitor{};  // output the pointer is on
+        POINT                                            position{}; // shape top-left, desktop coordinates
+        float                                            sdrWhiteNits{80.0f};  // of that output
+        bool                                             visible{false};
+        Microsoft::WRL::ComPtr<ID3D11Texture2D>          tex;        // image, uploaded on change
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+        Microsoft::WRL::ComPtr<ID3D11Texture2D>          background; // composite under the pointer
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> backgroundSrv;
+        Microsoft::WRL::ComPtr<ID3D11Buffer>             params;     // CursorParams
+    };
+
+    // (Re)create the blit resources if the DD texture no longer matches.
+    [[nodiscard]] bool EnsureConvertResources(ConvertResources& res, const D3D11_TEXTURE2D_DESC& srcDesc);
+
+    // Create a composite texture + UAV sized to the virtual desktop.
+    [[nodiscard]] bool CreateCompositeSlot(CompositeSlot& slot);
+
+    // Find a composite no FrameData still holds, growing the pool if needed.
+    // Returns nullptr when all kMaxCompositeSlots are held, or when a new
+    // slot's texture can't be created.
+    [[nodiscard]] CompositeSlot* AcquireCompositeSlot();
+
+    // Acquire every output's next frame into DuplInfo::acquired, in
+    // parallel on `pool`.  Live outputs are polled when incremental.
+    void AcquireFrames(ThreadPool* pool, bool incremental);
+
+    // Blit one output's acquired frame into the composite and release it.
+    // Incremental blits only the changed rectangles once the output is live
+    // and treats "no new frame" as success.
+    [[nodiscard]] bool BlitOutputToComposite(DuplInfo& di, const CompositeSlot& slot, bool incremental);
+
+    // (Re)create the cross-adapter mirror if it no longer matches `srcDesc`.
+    [[nodiscard]] bool EnsureMirror(DuplInfo& di, const D3D11_TEXTURE2D_DESC& srcDesc);
+
+    // Copy `rects` of a secondary-adapter frame into the mirror.  Returns
+    // the shared-device texture to blit from (with localMutex held for the
+    // shared path), or nullptr on failure.
+    [[nodiscard]] ID3D11Texture2D* UpdateMirror(DuplInfo& di, ID3D11Texture2D* tex,
+                                                const std::vector<RECT>& rects);
+
+    // Blit one rectangle (duplication-texture coordinates) of an acquired
+    // frame into the composite, clamped to the virtual desktop.  Converted
+    // blits read from di.convert.srcCopy, which the caller has filled.
+    void BlitRect(const DuplInfo& di, ID3D11Texture2D* tex, bool converted,
+                  const RECT& rect, const CompositeSlot& slot);
+
+    // Dirty + move-destination rectangles of the acquired frame.
+    // Returns false if the metadata is unavailable.
+    [[nodiscard]] bool GetChangedRects(DuplInfo& di, const DXGI_OUTDUPL_FRAME_INFO& info,
+                                       std::vector<RECT>& rects);
+
+    // Init() / Update(), with mutex_ held.
+    [[nodiscard]] bool InitLocked(ID3D11Device* device);
+    [[nodiscard]] bool UpdateLocked(ThreadPool* pool);
+
+    // Blit resources and mirror for a new duplication's mode.
+    void PrepareOutput(DuplInfo& di);
+
+    // whiteRegions_ from the outputs' cached white levels.
+    void RebuildWhiteRegions();
+
+    // Record why an acquisition failed, for Recover().
+    void NoteFailure(DuplInfo& di, HRESULT hr) noexcept;
+
+    // Take the pointer position and any new shape from the acquired
+    // frame's info.  Before the frame is released.
+    void UpdatePointer(DuplInfo& di, const DXGI_OUTDUPL_FRAME_INFO& info);
+
+    // Blend the pointer into `slot` (after composition).
+    void DrawPointer(const CompositeSlot& slot);
+
     Microsoft::WRL::ComPtr<ID3D11Device>        device_;
     Microsoft::WRL::ComPtr<ID3D11DeviceContext>  ctx_;
+    std::vector<AdapterDevice>                   adapters_;
     Microsoft::WRL::ComPtr<ID3D11ComputeShader> convertCS_;
     std::vector<DuplInfo>                        dupls_;
+    std::vector<OutputKey>                       layout_;     // as of Init()
+    std::vector<WhiteRegion>                     whiteRegions_;  // handed to every frame
+    std::vector<CompositeSlot>                   composites_;
+    CompositeSlot                                live_;       // continuous mode only
+    PointerState                                 pointer_;
+    Microsoft::WRL::ComPtr<ID3D11ComputeShader> cursorCS_;
+    std::vector<uint8_t>                         metadata_;   // frame metadata scratch
+    std::vector<RECT>                            changed_;    // changed-rect scratch
+    GpuTimer                                     compositeTimer_{TraceStage::CompositeGpu};
     Bounds                                       bounds_{};
+    uint64_t                                     liveVersion_{0};
+    std::mutex                                   mutex_;      // dupls_ acquisition state vs Freeze()
+    int64_t                                      frozenAt_{0}; // keyDownAt of held frames, 0 = none
+    bool                                         continuous_{false};
+    bool                                         cursorOverlay_{false};
+    bool                                         layoutStale_{false};   // NotifyDisplayChange()
+    bool                                         deviceRemoved_{false};
     bool                                         ready_{false};
 };
 
@@ -1,6 +1,8 @@
 #include "capture/FrameData.h"
 #include "capture/PixelFormats.h"
+#include "capture/Trace.h"
 
+#include <algorithm>
 #include <cstring>
 
 using Microsoft::WRL::ComPtr;
@@ -11,6 +13,7 @@ bool ReadbackPixels(FrameData& frame, ID3D11DeviceContext* ctx)
 {
     if (!frame.pixels.empty()) return true;          // Already populated.
     if (!frame.gpuTexture || !ctx) return false;
+    const ScopedTrace trace(TraceStage::Readback);
 
     D3D11_TEXTURE2D_DESC desc{};
     frame.gpuTexture->GetDesc(&desc);
@@ -55,4 +58,169 @@ bool ReadbackPixels(FrameData& frame, ID3D11DeviceContext* ctx)
     return true;
 }
 
+bool ReadbackRegion(const FrameData& frame, const D3D11_BOX& region,
+                    ID3D11DeviceContext* ctx, FrameData& out)
+{
+    if (!frame.gpuTexture || !ctx) return false;
+
+    D3D11_TEXTURE2D_DESC desc{};
+    frame.gpuTexture->GetDesc(&desc);
+
+    D3D11_BOX box{};
+    box.left   = (std::min)(region.left,   desc.Width);
+    box.top    = (std::min)(region.top,    desc.Height);
+    box.right  = (std::min)(region.right,  desc.Width);
+    box.bottom = (std::min)(region.bottom, desc.Height);
+    box.front  = 0;
+    box.back   = 1;
+    if (box.right <= box.left || box.bottom <= box.top) return false;
+
+    const uint32_t w = box.right - box.left;
+    const uint32_t h = box.bottom - box.top;
+
+    ComPtr<ID3D11Device> device;
+    ctx->GetDevice(&device);
+
+    // Staging texture sized to the region only.
+    D3D11_TEXTURE2D_DESC stagingDesc{};
+    stagingDesc.Width          = w;
+    stagingDesc.Height         = h;
+    stagingDesc.MipLevels      = 1;
+    stagingDesc.ArraySize      = 1;
+    stagingDesc.Format         = desc.Format;
+    stagingDesc.SampleDesc.Count = 1;
+    stagingDesc.Usage          = D3D11_USAGE_STAGING;
+    stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+    ComPtr<ID3D11Texture2D> staging;
+    HRESULT hr = device->CreateTexture2D(&stagingDesc, nullptr, &staging);
+    if (FAILED(hr)) return false;
+
+    ctx->CopySubresourceRegion(staging.Get(), 0, 0, 0, 0, frame.gpuTexture.Get(), 0, &box);
+
+    D3D11_MAPPED_SUBRESOURCE mapped{};
+    hr = ctx->Map(staging.Get(), 0, D3D11_MAP_READ, 0, &mapped);
+    if (FAILED(hr)) return false;
+
+    const uint32_t bpp       = BytesPerPixel(desc.Format);
+    const uint32_t dstStride = w * bpp;
+
+    out = {};
+    out.width         = w;
+    out.height        = h;
+    out.format        = static_cast<uint32_t>(desc.Format);
+    out.bytesPerPixel = bpp;
+    out.capturedAt    = frame.capturedAt;
+    out.whiteRegions  = CropWhiteRegions(frame.whiteRegions,
+                                         RECT{static_cast<LONG>(box.left), static_cast<LONG>(box.top),
+                                              static_cast<LONG>(box.right), static_cast<LONG>(box.bottom)});
+    out.pixels.resize(static_cast<size_t>(dstStride) * h);
+
+    const auto* src = static_cast<const uint8_t*>(mapped.pData);
+    for (uint32_t row = 0; row < h; ++row) {
+        std::memcpy(
+            out.pixels.data() + static_cast<size_t>(row) * dstStride,
+            src + static_cast<size_t>(row) * mapped.RowPitch,
+            dstStride);
+    }
+
+    ctx->Unmap(staging.Get(), 0);
+    return true;
+}
+
+FrameData CropFrame(const FrameData& src, RECT sel)
+{
+    const LONG w = static_cast<LONG>(src.width);
+    const LONG h = static_cast<LONG>(src.height);
+    sel.left   = (std::clamp)(sel.left,   0L, w);
+    sel.top    = (std::clamp)(sel.top,    0L, h);
+    sel.right  = (std::clamp)(sel.right,  sel.left, w);
+    sel.bottom = (std::clamp)(sel.bottom, sel.top,  h);
+
+    const uint32_t cropW = static_cast<uint32_t>(sel.right - sel.left);
+    const uint32_t cropH = static_cast<uint32_t>(sel.bottom - sel.top);
+
+    FrameData out;
+    out.width = cropW;
+    out.height = cropH;
+    out.format = src.format;
+    out.bytesPerPixel = src.bytesPerPixel;
+    out.capturedAt = src.capturedAt;
+    out.whiteRegions = CropWhiteRegions(src.whiteRegions, sel);
+    out.pixels.resize(static_cast<size_t>(cropW) * src.bytesPerPixel * cropH);
+
+    const uint32_t srcStride = src.width * src.bytesPerPixel;
+    const uint32_t dstStride = cropW * src.bytesPerPixel;
+
+    for (uint32_t row = 0; row < cropH; ++row) {
+        const size_t srcOff = static_cast<size_t>(sel.top + row) * srcStride + static_cast<size_t>(sel.left) * src.bytesPerPixel;
+        const size_t dstOff = static_cast<size_t>(row) * dstStride;
+        std::memcpy(out.pixels.data() + dstOff, src.pixels.data() + srcOff, dstStride);
+    }
+
+    return out;
+}
+
+bool CopyRegion(const FrameData& frame, const D3D11_BOX& region,
+                ID3D11DeviceContext* ctx, FrameData& out)
+{
+    if (!frame.gpuTexture || !ctx) return false;
+
+    D3D11_TEXTURE2D_DESC desc{};
+    frame.gpuTexture->GetDesc(&desc);
+
+    D3D11_BOX box{};
+    box.left   = (std::min)(region.left,   desc.Width);
+    box.top    = (std::min)(region.top,    desc.Height);
+    box.right  = (std::min)(region.right,  desc.Width);
+    box.bottom = (std::min)(region.bottom, desc.Height);
+    box.front  = 0;
+    box.back   = 1;
+    if (box.right <= box.left || box.bottom <= box.top) return false;
+
+    const uint32_t w = box.right - box.left;
+    const uint32_t h = box.bottom - box.top;
+
+    ComPtr<ID3D11Device> device;
+    ctx->GetDevice(&device);
+
+    D3D11_TEXTURE2D_DESC copyDesc{};
+    copyDesc.Width            = w;
+    copyDesc.Height           = h;
+    copyDesc.MipLevels        = 1;
+    copyDesc.ArraySize        = 1;
+    copyDesc.Format           = desc.Format;
+    copyDesc.SampleDesc.Count = 1;
+    copyDesc.Usage            = D3D11_USAGE_DEFAULT;
+
+    ComPtr<ID3D11Texture2D> copy;
+    if (FAILED(device->CreateTexture2D(&copyDesc, nullptr, &copy))) return false;
+
+    ctx->CopySubresourceRegion(copy.Get(), 0, 0, 0, 0, frame.gpuTexture.Get(), 0, &box);
+
+    out = {};
+    out.gpuTexture    = std::move(copy);
+    out.width         = w;
+    out.height        = h;
+    out.format        = static_cast<uint32_t>(desc.Format);
+    out.bytesPerPixel = BytesPerPixel(desc.Format);
+    out.capturedAt    = frame.capturedAt;
+    out.whiteRegions  = CropWhiteRegions(frame.whiteRegions,
+                                         RECT{static_cast<LONG>(box.left), static_cast<LONG>(box.top),
+                                              static_cast<LONG>(box.right), static_cast<LONG>(box.bottom)});
+    return true;
+}
+
+std::vector<WhiteRegion> CropWhiteRegions(const std::vector<WhiteRegion>& regions, const RECT& crop)
+{
+    std::vector<WhiteRegion> out;
+    for (const auto& r : regions) {
+        RECT clipped{};
+        if (!::IntersectRect(&clipped, &r.rect, &crop)) continue;
+        ::OffsetRect(&clipped, -crop.left, -crop.top);
+        out.push_back({clipped, r.sdrWhiteNits, r.peakNits});
+    }
+    return out;
+}
+
 } // namespace screencap::capture
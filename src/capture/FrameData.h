@@ -1,26 +1,57 @@
 #pragma once
 
+#include "capture/PixelBuffer.h"
+
 #include <d3d11.h>
 #include <wrl/client.h>
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace screencap::capture {
 
+// Paper white and peak luminance of one monitor's part of a desktop frame.
+struct WhiteRegion {
+    RECT  rect{};               // frame pixels
+    float sdrWhiteNits{80.0f};
+    float peakNits{0.0f};       // MaxLuminance with HDR on, else paper white; 0 = unknown
+};
+
 struct FrameData {
     // CPU pixel buffer (may be empty when gpuTexture is set).
     // - SDR: format = DXGI_FORMAT_B8G8R8A8_UNORM, bytesPerPixel = 4, pixels are BGRA8.
     // - HDR/scRGB: format = DXGI_FORMAT_R16G16B16A16_FLOAT, bytesPerPixel = 8, pixels are RGBA16F (linear).
-    std::vector<uint8_t> pixels;
+    // Pooled; resize() does not zero (see PixelBuffer.h).
+    PixelBuffer pixels;
 
     // GPU-resident texture (may be null for CPU-only frames such as crops).
     Microsoft::WRL::ComPtr<ID3D11Texture2D> gpuTexture;
 
+    // Set when gpuTexture belongs to a pool (DesktopDuplicator's
+    // composites): the texture is not reused while any copy holds this.
+    std::shared_ptr<void> lease;
+
     uint32_t width{};
     uint32_t height{};
     uint32_t format{};        // DXGI_FORMAT
     uint32_t bytesPerPixel{}; // 4 or 8
+
+    // TraceNow() ticks of the moment the image shows (0 = unknown): the
+    // key press for a frozen capture, otherwise the acquisition.
+    int64_t capturedAt{};
+
+    // FP16 desktop frames: each monitor's white level, cached by the
+    // DesktopDuplicator until a display change.  Empty: one level for the
+    // whole frame (SdrWhiteNitsForFrame() falls back to the primary
+    // monitor's).
+    std::vector<WhiteRegion> whiteRegions;
+
+    // SDR BGRA8 rendition of FP16 pixels, made on first use by whichever
+    // output (save, clipboard, thumbnail) needs it and shared by copies of
+    // the frame, so one capture is tone-mapped once.  Not synchronised:
+    // fill it from one thread.  Anything that replaces pixels resets it.
+    mutable std::shared_ptr<PixelBuffer> sdrCache;
 };
 
 // Ensure frame.pixels is populated.  If pixels are already present this is
@@ -28,4 +59,26 @@ struct FrameData {
 // Returns true when CPU pixels are available afterwards.
 [[nodiscard]] bool ReadbackPixels(FrameData& frame, ID3D11DeviceContext* ctx);
 
+// Read back only `region` of frame.gpuTexture (front/back ignored) via a
+// staging texture the size of the region, so cost scales with the region
+// rather than the whole frame.  The result is a CPU-only frame.
+// Returns false if the frame has no GPU texture, the region is empty, or on error.
+[[nodiscard]] bool ReadbackRegion(const FrameData& frame, const D3D11_BOX& region,
+                                  ID3D11DeviceContext* ctx, FrameData& out);
+
+// Copy of `sel` (frame pixels, clamped to the frame) of a CPU frame.
+[[nodiscard]] FrameData CropFrame(const FrameData& src, RECT sel);
+
+// Copy only `region` of frame.gpuTexture (front/back ignored) into a new
+// GPU texture sized to it.  Only records the copy: the result is a
+// GPU-only frame for ReadbackPixels() or StreamGpuFrameToFile().
+// Returns false if the frame has no GPU texture, the region is empty, or on error.
+[[nodiscard]] bool CopyRegion(const FrameData& frame, const D3D11_BOX& region,
+                              ID3D11DeviceContext* ctx, FrameData& out);
+
+// White regions of a crop at `crop` (frame pixels): clipped to it and
+// moved to its origin.
+[[nodiscard]] std::vector<WhiteRegion> CropWhiteRegions(const std::vector<WhiteRegion>& regions,
+                                                        const RECT& crop);
+
 } // namespace screencap::capture
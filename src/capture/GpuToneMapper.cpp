@@ -0,0 +1,384 @@
+#include "capture/GpuToneMapper.h"
+#include "capture/ConvertShader.h"
+#include "capture/PixelFormats.h"
+
+#include <algorithm>
+
+using Microsoft::WRL::ComPtr;
+
+namespace screencap::capture {
+namespace {
+
+// Constant buffer layout matching the compute shader's ToneMapParams
+// (also the histogram pass's).
+struct ToneMapParams {
+    int   srcX, srcY;
+    int   width, height;
+};
+
+// Constant buffer layout matching the compute shader's DownsampleParams.
+struct DownsampleParams {
+    int   srcWidth, srcHeight;
+    int   dstWidth, dstHeight;
+    int   srgbSource;
+    int   pad0, pad1, pad2;   // Align to 16-byte boundary.
+};
+
+// Constant buffer layout matching ToneMap.hlsli's WhiteParams: per-monitor
+// paper white and peak.  Each array element takes a full 16-byte register.
+struct WhiteParams {
+    float fallbackScale;
+    float fallbackPeak;
+    int   regionCount;
+    float pad0;
+    int   rect[kMaxGpuWhiteRegions][4];    // left, top, right, bottom (frame pixels)
+    float white[kMaxGpuWhiteRegions][4];   // scale, peak, unused, unused
+};
+
+// Assumed for sources whose monitor didn't report its peak.
+constexpr float kUnknownPeakNits = 1000.0f;
+
+template <size_t N>
+ComPtr<ID3D11ComputeShader> CreateCS(ID3D11Device* device, const BYTE (&bytecode)[N])
+{
+    ComPtr<ID3D11ComputeShader> cs;
+    if (FAILED(device->CreateComputeShader(bytecode, N, nullptr, &cs))) return nullptr;
+    return cs;
+}
+
+ComPtr<ID3D11Buffer> CreateConstantBuffer(ID3D11Device* device, UINT size)
+{
+    D3D11_BUFFER_DESC cbDesc{};
+    cbDesc.ByteWidth = size;
+    cbDesc.Usage     = D3D11_USAGE_DEFAULT;
+    cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+
+    ComPtr<ID3D11Buffer> cb;
+    if (FAILED(device->CreateBuffer(&cbDesc, nullptr, &cb))) return nullptr;
+    return cb;
+}
+
+float PaperWhiteScale(float sdrWhiteNits) noexcept
+{
+    // scRGB value of SDR white → 1.0.
+    return 80.0f / ((sdrWhiteNits > 0.0f) ? sdrWhiteNits : 80.0f);
+}
+
+float PeakOverWhite(float peakNits, float sdrWhiteNits) noexcept
+{
+    const float white = (sdrWhiteNits > 0.0f) ? sdrWhiteNits : 80.0f;
+    return (std::max)(((peakNits > 0.0f) ? peakNits : kUnknownPeakNits) / white, 1.0f);
+}
+
+WhiteParams MakeWhiteParams(const std::vector<WhiteRegion>& regions, float sdrWhiteNits) noexcept
+{
+    WhiteParams params{};
+    params.fallbackScale = PaperWhiteScale(sdrWhiteNits);
+    params.fallbackPeak  = PeakOverWhite(0.0f, sdrWhiteNits);
+
+    // Beyond the limit the fallback applies.
+    params.regionCount = static_cast<int>((std::min)(regions.size(), kMaxGpuWhiteRegions));
+    for (int i = 0; i < params.regionCount; ++i) {
+        const auto& r = regions[i];
+        params.rect[i][0]  = r.rect.left;
+        params.rect[i][1]  = r.rect.top;
+        params.rect[i][2]  = r.rect.right;
+        params.rect[i][3]  = r.rect.bottom;
+        params.white[i][0] = PaperWhiteScale(r.sdrWhiteNits);
+        params.white[i][1] = PeakOverWhite(r.peakNits, r.sdrWhiteNits);
+    }
+    return params;
+}
+
+} // namespace
+
+bool GpuToneMapper::Init(ID3D11Device* device)
+{
+    ready_ = false;
+    device_.Reset();
+    ctx_.Reset();
+    cs_ = {};
+    params_.Reset();
+    downsampleCs_ = {};
+    downsampleParams_.Reset();
+    whiteParams_.Reset();
+    histogramCs_.Reset();
+    exposureCs_.Reset();
+    histogram_.Reset();
+    histogramUav_.Reset();
+    histogramSrv_.Reset();
+    exposure_.Reset();
+    exposureUav_.Reset();
+    exposureSrv_.Reset();
+    timer_.Reset();
+
+    if (!device) return false;
+
+    // Typed UAV stores to BGRA8 are optional in D3D11; without them the
+    // CPU conversion path is used instead.
+    UINT support = 0;
+    if (FAILED(device->CheckFormatSupport(DXGI_FORMAT_B8G8R8A8_UNORM, &support)) ||
+        !(support & D3D11_FORMAT_SUPPORT_TYPED_UNORDERED_ACCESS_VIEW)) {
+        return false;
+    }
+
+    device_ = device;
+    device_->GetImmediateContext(&ctx_);
+
+    // In ToneMapOperator order.
+    cs_ = {CreateCS(device_.Get(), kScRgbToBgra8CS),
+           CreateCS(device_.Get(), kScRgbToBgra8ReinhardCS),
+           CreateCS(device_.Get(), kScRgbToBgra8Bt2390CS),
+           CreateCS(device_.Get(), kScRgbToBgra8AcesCS)};
+    downsampleCs_ = {CreateCS(device_.Get(), kDownsampleToBgra8CS),
+                     CreateCS(device_.Get(), kDownsampleToBgra8ReinhardCS),
+                     CreateCS(device_.Get(), kDownsampleToBgra8Bt2390CS),
+                     CreateCS(device_.Get(), kDownsampleToBgra8AcesCS)};
+    const auto missing = [](const ComPtr<ID3D11ComputeShader>& cs) { return !cs; };
+    if (std::any_of(cs_.begin(), cs_.end(), missing) ||
+        std::any_of(downsampleCs_.begin(), downsampleCs_.end(), missing)) {
+        return false;
+    }
+
+    params_ = CreateConstantBuffer(device_.Get(), sizeof(ToneMapParams));
+    if (!params_) return false;
+    downsampleParams_ = CreateConstantBuffer(device_.Get(), sizeof(DownsampleParams));
+    if (!downsampleParams_) return false;
+    whiteParams_ = CreateConstantBuffer(device_.Get(), sizeof(WhiteParams));
+    if (!whiteParams_) return false;
+
+    histogramCs_ = CreateCS(device_.Get(), kLuminanceHistogramCS);
+    exposureCs_  = CreateCS(device_.Get(), kAutoExposureCS);
+    if (!histogramCs_ || !exposureCs_ || !CreateExposureBuffers()) return false;
+
+    ready_ = true;
+    return true;
+}
+
+std::optional<FrameData> GpuToneMapper::ToneMapToBgra8(const FrameData& frame, float sdrWhiteNits,
+                                                       const D3D11_BOX* region)
+{
+    if (!ready_ || !frame.gpuTexture) return std::nullopt;
+    if (static_cast<DXGI_FORMAT>(frame.format) != DXGI_FORMAT_R16G16B16A16_FLOAT) return std::nullopt;
+
+    D3D11_BOX box{0, 0, 0, frame.width, frame.height, 1};
+    if (region) {
+        box.left   = (std::min)(region->left,   frame.width);
+        box.top    = (std::min)(region->top,    frame.height);
+        box.right  = (std::min)(region->right,  frame.width);
+        box.bottom = (std::min)(region->bottom, frame.height);
+    }
+    if (box.right <= box.left || box.bottom <= box.top) return std::nullopt;
+
+    const uint32_t outW = box.right - box.left;
+    const uint32_t outH = box.bottom - box.top;
+
+    // SRV on the FP16 source (composites are created with SRV binding).
+    ComPtr<ID3D11ShaderResourceView> srv = CreateSourceView(frame);
+    if (!srv) return std::nullopt;
+
+    ComPtr<ID3D11Texture2D> out;
+    ComPtr<ID3D11UnorderedAccessView> uav;
+    if (!CreateBgra8Target(outW, outH, out, uav)) return std::nullopt;
+
+    const ToneMapParams params{static_cast<int>(box.left), static_cast<int>(box.top),
+                               static_cast<int>(outW), static_cast<int>(outH)};
+    const WhiteParams white = MakeWhiteParams(frame.whiteRegions, sdrWhiteNits);
+    ctx_->UpdateSubresource(params_.Get(), 0, nullptr, &params, 0, 0);
+    ctx_->UpdateSubresource(whiteParams_.Get(), 0, nullptr, &white, 0, 0);
+
+    timer_.Begin(ctx_.Get());
+    Expose(srv.Get(), outW, outH, autoExposure_);
+    Dispatch(cs_[static_cast<size_t>(operator_)].Get(), params_.Get(), srv.Get(), uav.Get(), outW, outH);
+    timer_.End(ctx_.Get());
+    return MakeBgra8Frame(std::move(out), outW, outH);
+}
+
+std::optional<FrameData> GpuToneMapper::DownsampleToBgra8(const FrameData& frame, float sdrWhiteNits,
+                                                          uint32_t width, uint32_t height)
+{
+    if (!ready_ || !frame.gpuTexture) return std::nullopt;
+    if (width == 0 || height == 0 || width > frame.width || height > frame.height) return std::nullopt;
+
+    const auto format = static_cast<DXGI_FORMAT>(frame.format);
+    if (format != DXGI_FORMAT_R16G16B16A16_FLOAT && format != DXGI_FORMAT_B8G8R8A8_UNORM) return std::nullopt;
+    const bool srgbSource = (format == DXGI_FORMAT_B8G8R8A8_UNORM);
+
+    ComPtr<ID3D11ShaderResourceView> srv = CreateSourceView(frame);
+    if (!srv) return std::nullopt;
+
+    ComPtr<ID3D11Texture2D> out;
+    ComPtr<ID3D11UnorderedAccessView> uav;
+    if (!CreateBgra8Target(width, height, out, uav)) return std::nullopt;
+
+    DownsampleParams params{};
+    params.srcWidth   = static_cast<int>(frame.width);
+    params.srcHeight  = static_cast<int>(frame.height);
+    params.dstWidth   = static_cast<int>(width);
+    params.dstHeight  = static_cast<int>(height);
+    params.srgbSource = srgbSource ? 1 : 0;
+    ctx_->UpdateSubresource(downsampleParams_.Get(), 0, nullptr, &params, 0, 0);
+
+    // sRGB sources are already SDR: unit scale, no regions, exposure 1.
+    WhiteParams white{};
+    if (srgbSource) {
+        white.fallbackScale = 1.0f;
+        white.fallbackPeak  = 1.0f;
+    } else {
+        white = MakeWhiteParams(frame.whiteRegions, sdrWhiteNits);
+    }
+    ctx_->UpdateSubresource(whiteParams_.Get(), 0, nullptr, &white, 0, 0);
+
+    // The histogram pass reads params_: the whole frame.
+    const ToneMapParams whole{0, 0, static_cast<int>(frame.width), static_cast<int>(frame.height)};
+    ctx_->UpdateSubresource(params_.Get(), 0, nullptr, &whole, 0, 0);
+    Expose(srv.Get(), frame.width, frame.height, autoExposure_ && !srgbSource);
+
+    Dispatch(downsampleCs_[static_cast<size_t>(operator_)].Get(), downsampleParams_.Get(),
+             srv.Get(), uav.Get(), width, height);
+    return MakeBgra8Frame(std::move(out), width, height);
+}
+
+// ── Auto exposure ──────────────────────────────────────────────────────────
+
+bool GpuToneMapper::CreateExposureBuffers()
+{
+    // 64 bins, raw so the histogram pass can add to them atomically.
+    D3D11_BUFFER_DESC histDesc{};
+    histDesc.ByteWidth = 64 * sizeof(uint32_t);
+    histDesc.Usage     = D3D11_USAGE_DEFAULT;
+    histDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+    histDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+    if (FAILED(device_->CreateBuffer(&histDesc, nullptr, &histogram_))) return false;
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC histUav{};
+    histUav.Format              = DXGI_FORMAT_R32_TYPELESS;
+    histUav.ViewDimension       = D3D11_UAV_DIMENSION_BUFFER;
+    histUav.Buffer.NumElements  = 64;
+    histUav.Buffer.Flags        = D3D11_BUFFER_UAV_FLAG_RAW;
+    if (FAILED(device_->CreateUnorderedAccessView(histogram_.Get(), &histUav, &histogramUav_))) return false;
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC histSrv{};
+    histSrv.Format               = DXGI_FORMAT_R32_TYPELESS;
+    histSrv.ViewDimension        = D3D11_SRV_DIMENSION_BUFFEREX;
+    histSrv.BufferEx.NumElements = 64;
+    histSrv.BufferEx.Flags       = D3D11_BUFFEREX_SRV_FLAG_RAW;
+    if (FAILED(device_->CreateShaderResourceView(histogram_.Get(), &histSrv, &histogramSrv_))) return false;
+
+    // One float, written by the exposure pass or UpdateSubresource().
+    const float one = 1.0f;
+    const D3D11_SUBRESOURCE_DATA init{&one, 0, 0};
+    D3D11_BUFFER_DESC expDesc{};
+    expDesc.ByteWidth           = sizeof(float);
+    expDesc.Usage               = D3D11_USAGE_DEFAULT;
+    expDesc.BindFlags           = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+    expDesc.MiscFlags           = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    expDesc.StructureByteStride = sizeof(float);
+    if (FAILED(device_->CreateBuffer(&expDesc, &init, &exposure_))) return false;
+
+    return SUCCEEDED(device_->CreateUnorderedAccessView(exposure_.Get(), nullptr, &exposureUav_)) &&
+           SUCCEEDED(device_->CreateShaderResourceView(exposure_.Get(), nullptr, &exposureSrv_));
+}
+
+void GpuToneMapper::Expose(ID3D11ShaderResourceView* srv, uint32_t width, uint32_t height, bool enabled)
+{
+    if (!enabled) {
+        const float one = 1.0f;
+        ctx_->UpdateSubresource(exposure_.Get(), 0, nullptr, &one, 0, 0);
+        return;
+    }
+
+    const UINT zero[4] = {};
+    ctx_->ClearUnorderedAccessViewUint(histogramUav_.Get(), zero);
+    Dispatch(histogramCs_.Get(), params_.Get(), srv, histogramUav_.Get(), width, height);
+
+    // One group reduces the bins to the exposure; it stays on the GPU for
+    // the tone-map pass (t1).
+    ID3D11ShaderResourceView* bins = histogramSrv_.Get();
+    ID3D11UnorderedAccessView* target = exposureUav_.Get();
+    ctx_->CSSetShader(exposureCs_.Get(), nullptr, 0);
+    ctx_->CSSetShaderResources(0, 1, &bins);
+    ctx_->CSSetUnorderedAccessViews(0, 1, &target, nullptr);
+    ctx_->Dispatch(1, 1, 1);
+
+    ID3D11ShaderResourceView* nullSRV = nullptr;
+    ID3D11UnorderedAccessView* nullUAV = nullptr;
+    ctx_->CSSetShaderResources(0, 1, &nullSRV);
+    ctx_->CSSetUnorderedAccessViews(0, 1, &nullUAV, nullptr);
+    ctx_->CSSetShader(nullptr, nullptr, 0);
+}
+
+// ── Pass plumbing ──────────────────────────────────────────────────────────
+
+ComPtr<ID3D11ShaderResourceView> GpuToneMapper::CreateSourceView(const FrameData& frame)
+{
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+    srvDesc.Format              = static_cast<DXGI_FORMAT>(frame.format);
+    srvDesc.ViewDimension       = D3D11_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels = 1;
+
+    ComPtr<ID3D11ShaderResourceView> srv;
+    if (FAILED(device_->CreateShaderResourceView(frame.gpuTexture.Get(), &srvDesc, &srv))) return nullptr;
+    return srv;
+}
+
+bool GpuToneMapper::CreateBgra8Target(uint32_t width, uint32_t height,
+                                      ComPtr<ID3D11Texture2D>& out,
+                                      ComPtr<ID3D11UnorderedAccessView>& uav)
+{
+    D3D11_TEXTURE2D_DESC outDesc{};
+    outDesc.Width            = width;
+    outDesc.Height           = height;
+    outDesc.MipLevels        = 1;
+    outDesc.ArraySize        = 1;
+    outDesc.Format           = DXGI_FORMAT_B8G8R8A8_UNORM;
+    outDesc.SampleDesc.Count = 1;
+    outDesc.Usage            = D3D11_USAGE_DEFAULT;
+    outDesc.BindFlags        = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+
+    if (FAILED(device_->CreateTexture2D(&outDesc, nullptr, &out))) return false;
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
+    uavDesc.Format             = DXGI_FORMAT_B8G8R8A8_UNORM;
+    uavDesc.ViewDimension      = D3D11_UAV_DIMENSION_TEXTURE2D;
+    uavDesc.Texture2D.MipSlice = 0;
+
+    return SUCCEEDED(device_->CreateUnorderedAccessView(out.Get(), &uavDesc, &uav));
+}
+
+void GpuToneMapper::Dispatch(ID3D11ComputeShader* cs, ID3D11Buffer* params,
+                             ID3D11ShaderResourceView* srv, ID3D11UnorderedAccessView* uav,
+                             uint32_t width, uint32_t height)
+{
+    // t1 / b1: exposure and white levels, shared by every pass.
+    ID3D11ShaderResourceView* srvs[] = {srv, exposureSrv_.Get()};
+    ID3D11Buffer* cbs[] = {params, whiteParams_.Get()};
+    ctx_->CSSetShader(cs, nullptr, 0);
+    ctx_->CSSetShaderResources(0, 2, srvs);
+    ctx_->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
+    ctx_->CSSetConstantBuffers(0, 2, cbs);
+
+    // 16×16 thread groups.
+    ctx_->Dispatch((width + 15u) / 16u, (height + 15u) / 16u, 1);
+
+    ID3D11ShaderResourceView* nullSRVs[2] = {};
+    ID3D11UnorderedAccessView* nullUAV = nullptr;
+    ID3D11Buffer* nullCBs[2] = {};
+    ctx_->CSSetShaderResources(0, 2, nullSRVs);
+    ctx_->CSSetUnorderedAccessViews(0, 1, &nullUAV, nullptr);
+    ctx_->CSSetConstantBuffers(0, 2, nullCBs);
+    ctx_->CSSetShader(nullptr, nullptr, 0);
+}
+
+FrameData GpuToneMapper::MakeBgra8Frame(ComPtr<ID3D11Texture2D> texture, uint32_t width, uint32_t height)
+{
+    FrameData result;
+    result.gpuTexture    = std::move(texture);
+    result.width         = width;
+    result.height        = height;
+    result.format        = static_cast<uint32_t>(DXGI_FORMAT_B8G8R8A8_UNORM);
+    result.bytesPerPixel = BytesPerPixel(DXGI_FORMAT_B8G8R8A8_UNORM);
+    return result;
+}
+
+} // namespace screencap::capture
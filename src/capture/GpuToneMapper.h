@@ -0,0 +1,113 @@
+#pragma once
+
+#include "capture/FrameData.h"
+#include "capture/Trace.h"
+
+#include <d3d11.h>
+#include <wrl/client.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+namespace screencap::capture {
+
+// Monitors whose own paper white the GPU passes honour; pixels of any
+// further ones use the fallback level.
+inline constexpr size_t kMaxGpuWhiteRegions = 8;
+
+// What the GPU passes do with light above SDR white (see
+// capture/shaders/ToneMap.hlsli).  Each is its own shader permutation.
+enum class ToneMapOperator : uint32_t {
+    Clip,       // hard clip, as the CPU conversion does
+    Reinhard,   // extended Reinhard, white point at the monitor's peak
+    Bt2390,     // BT.2390 EETF: PQ-domain roll-off from the peak to SDR white
+    Aces,       // fitted ACES filmic curve
+};
+inline constexpr size_t kToneMapOperatorCount = 4;
+
+// GPU scRGB FP16 → sRGB BGRA8 conversion.
+// Runs the paper-white normalise / tone map / gamma / quantise pass as a
+// compute shader so only 4 bytes per pixel have to be read back, and the
+// encoders get BGRA8 pixels they can use directly.  With auto exposure a
+// histogram pass picks the exposure on the GPU first; nothing extra is
+// read back.
+class GpuToneMapper final {
+public:
+    GpuToneMapper() = default;
+    ~GpuToneMapper() = default;
+
+    GpuToneMapper(const GpuToneMapper&) = delete;
+    GpuToneMapper& operator=(const GpuToneMapper&) = delete;
+    GpuToneMapper(GpuToneMapper&&) = default;
+    GpuToneMapper& operator=(GpuToneMapper&&) = default;
+
+    // Compile the shader and check that the device can write BGRA8 UAVs.
+    // Returns false if unsupported; callers then fall back to the CPU path.
+    [[nodiscard]] bool Init(ID3D11Device* device);
+
+    [[nodiscard]] bool IsReady() const noexcept { return ready_; }
+
+    // For every following conversion; kept across Init().  The CPU
+    // fallback path always clips at a fixed exposure.
+    void SetOperator(ToneMapOperator op) noexcept { operator_ = op; }
+    [[nodiscard]] ToneMapOperator Operator() const noexcept { return operator_; }
+    void SetAutoExposure(bool enabled) noexcept { autoExposure_ = enabled; }
+    [[nodiscard]] bool AutoExposure() const noexcept { return autoExposure_; }
+
+    // Tone-map an FP16 frame's gpuTexture into a new BGRA8 GPU frame
+    // (pixels left empty — read back with ReadbackPixels()).
+    // If region is given (front/back ignored) only that sub-rectangle is
+    // converted and the result is sized to it.
+    // Pixels inside frame.whiteRegions use their monitor's white level;
+    // sdrWhiteNits is the fallback for the rest.
+    // Returns std::nullopt if the frame isn't a GPU FP16 frame or on error.
+    [[nodiscard]] std::optional<FrameData> ToneMapToBgra8(const FrameData& frame, float sdrWhiteNits,
+                                                          const D3D11_BOX* region = nullptr);
+
+    // Box-filter a GPU frame (FP16 scRGB or BGRA8) down to width×height and
+    // tone-map it to BGRA8 in the same pass — used for thumbnails so the
+    // full-size image is never scaled on the CPU.  width/height must not
+    // exceed the frame's size.  White levels and pixels as above; the
+    // exposure comes from the whole frame.
+    [[nodiscard]] std::optional<FrameData> DownsampleToBgra8(const FrameData& frame, float sdrWhiteNits,
+                                                             uint32_t width, uint32_t height);
+
+private:
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateSourceView(const FrameData& frame);
+    bool CreateBgra8Target(uint32_t width, uint32_t height,
+                           Microsoft::WRL::ComPtr<ID3D11Texture2D>& out,
+                           Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView>& uav);
+    bool CreateExposureBuffers();
+    // Exposure for the next pass: 1, or from the histogram of the
+    // width×height area that params_ (already uploaded) describes.
+    void Expose(ID3D11ShaderResourceView* srv, uint32_t width, uint32_t height, bool enabled);
+    void Dispatch(ID3D11ComputeShader* cs, ID3D11Buffer* params,
+                  ID3D11ShaderResourceView* srv, ID3D11UnorderedAccessView* uav,
+                  uint32_t width, uint32_t height);
+    static FrameData MakeBgra8Frame(Microsoft::WRL::ComPtr<ID3D11Texture2D> texture,
+                                    uint32_t width, uint32_t height);
+
+    Microsoft::WRL::ComPtr<ID3D11Device>        device_;
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext>  ctx_;
+    using Permutations = std::array<Microsoft::WRL::ComPtr<ID3D11ComputeShader>, kToneMapOperatorCount>;
+    Permutations                                 cs_;             // by ToneMapOperator
+    Microsoft::WRL::ComPtr<ID3D11Buffer>         params_;
+    Permutations                                 downsampleCs_;
+    Microsoft::WRL::ComPtr<ID3D11Buffer>         downsampleParams_;
+    Microsoft::WRL::ComPtr<ID3D11Buffer>         whiteParams_;    // b1 of every pass
+    Microsoft::WRL::ComPtr<ID3D11ComputeShader> histogramCs_;
+    Microsoft::WRL::ComPtr<ID3D11ComputeShader> exposureCs_;
+    Microsoft::WRL::ComPtr<ID3D11Buffer>         histogram_;      // 64 uint bins
+    Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> histogramUav_;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>  histogramSrv_;
+    Microsoft::WRL::ComPtr<ID3D11Buffer>         exposure_;       // one float
+    Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> exposureUav_;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>  exposureSrv_;
+    GpuTimer                                     timer_{TraceStage::ToneMapGpu};
+    ToneMapOperator                              operator_{ToneMapOperator::Clip};
+    bool                                         autoExposure_{false};
+    bool                                         ready_{false};
+};
+
+} // namespace screencap::capture
@@ -0,0 +1,83 @@
+#include "capture/KeydownCapture.h"
+#include "capture/DesktopDuplicator.h"
+
+namespace screencap::capture {
+
+KeydownCapture::~KeydownCapture()
+{
+    Stop();
+}
+
+bool KeydownCapture::Start(DesktopDuplicator* duplicator, Frozen onFrozen)
+{
+    if (IsRunning() || !duplicator || !onFrozen) return false;
+
+    wake_ = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    stop_ = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!wake_ || !stop_) {
+        Stop();
+        return false;
+    }
+
+    duplicator_ = duplicator;
+    onFrozen_ = std::move(onFrozen);
+    pending_ = false;
+    thread_ = std::thread([this] { Run(); });
+
+    // Ahead of the UI thread, so a busy desktop can't push the freeze
+    // back; the thread sleeps on its event otherwise.
+    (void)::SetThreadPriority(thread_.native_handle(), THREAD_PRIORITY_HIGHEST);
+    return true;
+}
+
+void KeydownCapture::Stop()
+{
+    if (stop_) ::SetEvent(stop_);
+    if (thread_.joinable()) thread_.join();
+
+    for (HANDLE* h : {&wake_, &stop_}) {
+        if (*h) {
+            ::CloseHandle(*h);
+            *h = nullptr;
+        }
+    }
+    duplicator_ = nullptr;
+    onFrozen_ = nullptr;
+}
+
+bool KeydownCapture::Trigger(uint32_t command, int64_t keyDownAt)
+{
+    if (!IsRunning()) return false;
+    {
+        std::lock_guard lock(mutex_);
+        // A second press before the first was handled replaces it.
+        command_ = command;
+        keyDownAt_ = keyDownAt;
+        pending_ = true;
+    }
+    ::SetEvent(wake_);
+    return true;
+}
+
+void KeydownCapture::Run()
+{
+    const HANDLE handles[] = {stop_, wake_};
+    while (::WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1) {
+        uint32_t command{};
+        int64_t keyDownAt{};
+        {
+            std::lock_guard lock(mutex_);
+            if (!pending_) continue;
+            command = command_;
+            keyDownAt = keyDownAt_;
+            pending_ = false;
+        }
+
+        // Not frozen (not continuous, no output live yet): the UI thread
+        // captures as it always did.
+        (void)duplicator_->Freeze(keyDownAt);
+        onFrozen_(command, keyDownAt);
+    }
+}
+
+} // namespace screencap::capture
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <windows.h>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace screencap::capture {
+
+class DesktopDuplicator;
+
+// ── Capture on key-down ─────────────────────────────────────────────
+//
+// The keyboard hook only wakes this thread; it runs above normal priority
+// and freezes the desktop (DesktopDuplicator::Freeze()) the moment the
+// hotkey goes down, before the UI thread has worked through whatever is
+// ahead of the capture in its queue.  The UI thread then composes exactly
+// those frames.  No device context is used here.
+class KeydownCapture final {
+public:
+    // Called on the capture thread after the freeze (whether or not
+    // anything was frozen): hand `command` to the UI thread.
+    using Frozen = std::function<void(uint32_t command, int64_t keyDownAt)>;
+
+    KeydownCapture() = default;
+    ~KeydownCapture();   // Stop()
+
+    KeydownCapture(const KeydownCapture&) = delete;
+    KeydownCapture& operator=(const KeydownCapture&) = delete;
+    KeydownCapture(KeydownCapture&&) = delete;
+    KeydownCapture& operator=(KeydownCapture&&) = delete;
+
+    // Start the thread for `duplicator`, which must outlive Stop().
+    [[nodiscard]] bool Start(DesktopDuplicator* duplicator, Frozen onFrozen);
+    void Stop();
+
+    [[nodiscard]] bool IsRunning() const noexcept { return thread_.joinable(); }
+
+    // From the keyboard hook: freeze now and report `command` when done.
+    // Never blocks on the capture.  Returns false if the thread is not
+    // running; the caller then hands the command over itself.
+    bool Trigger(uint32_t command, int64_t keyDownAt);
+
+private:
+    void Run();
+
+    DesktopDuplicator* duplicator_{};
+    Frozen             onFrozen_;
+    std::thread        thread_;
+    HANDLE             wake_{};      // auto-reset
+    HANDLE             stop_{};      // manual-reset
+    std::mutex         mutex_;       // pending command
+    uint32_t           command_{};
+    int64_t            keyDownAt_{};
+    bool               pending_{false};
+};
+
+} // namespace screencap::capture
@@ -0,0 +1,127 @@
+#include "capture/OutputQueue.h"
+#include "capture/ClipboardImage.h"
+#include "capture/Trace.h"
+
+#include <objbase.h>
+
+namespace screencap::capture {
+
+OutputQueue::OutputQueue(ThreadPool* pool, ClipboardImage* clipboard, Completion onDone)
+    : pool_(pool)
+    , clipboard_(clipboard)
+    , onDone_(std::move(onDone))
+{
+    convert_.thread = std::thread([this] {
+        Drain(convert_, [this](Job&& job) { Convert(std::move(job)); });
+    });
+    encode_.thread = std::thread([this] {
+        // WIC needs COM on this thread.
+        const HRESULT hr = ::CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        Drain(encode_, [this](Job&& job) { Encode(std::move(job)); });
+        if (SUCCEEDED(hr)) ::CoUninitialize();
+    });
+}
+
+OutputQueue::~OutputQueue()
+{
+    // Front to back, so every converted job still reaches the encoder.
+    Stop(convert_);
+    Stop(encode_);
+}
+
+void OutputQueue::Submit(Job job)
+{
+    job.submittedAt = TraceNow();
+    Push(convert_, std::move(job));
+}
+
+void OutputQueue::Push(Stage& stage, Job job)
+{
+    {
+        std::lock_guard lock(stage.mutex);
+        stage.jobs.push_back(std::move(job));
+    }
+    stage.wake.notify_one();
+}
+
+void OutputQueue::Stop(Stage& stage)
+{
+    {
+        std::lock_guard lock(stage.mutex);
+        stage.stop = true;
+    }
+    stage.wake.notify_one();
+    if (stage.thread.joinable()) {
+        stage.thread.join();
+    }
+}
+
+void OutputQueue::Drain(Stage& stage, const std::function<void(Job&&)>& fn)
+{
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock lock(stage.mutex);
+            stage.wake.wait(lock, [&] { return stage.stop || !stage.jobs.empty(); });
+            if (stage.jobs.empty()) return;   // stopped and drained
+            job = std::move(stage.jobs.front());
+            stage.jobs.pop_front();
+        }
+        fn(std::move(job));
+    }
+}
+
+void OutputQueue::Convert(Job&& job)
+{
+    // PNG and CF_DIB are SDR; the thumbnail reuses the same pixels.  The
+    // delayed-render clipboard converts only when a paste asks for it, and
+    // streamed GPU frames convert band by band while encoding.
+    // A failed conversion is left for the encoder to reject.
+    const bool toClipboard = job.path.empty();
+    const bool delayed = toClipboard && clipboard_ && clipboard_->IsReady();
+    const bool streamed = job.frame.pixels.empty();
+    if (!streamed && (toClipboard ? !delayed : !KeepsHdr(job.path))) {
+        (void)ConvertToBgra8(job.frame, pool_);
+    }
+    Push(encode_, std::move(job));
+}
+
+void OutputQueue::Encode(Job&& job)
+{
+    const bool toClipboard = job.path.empty();
+    std::wstring thumbnailPath;
+    const auto writeThumbnail = [&] {
+        if (job.onDone) return;
+        // The full frame still works (its SDR rendition is shared with the
+        // output); a GPU-downsampled thumbnail just skips the scaling.
+        thumbnailPath = WriteThumbnailPng(job.thumbnail.pixels.empty() ? job.frame : job.thumbnail, pool_);
+    };
+
+    bool ok = false;
+    if (toClipboard && clipboard_ && clipboard_->IsReady()) {
+        // The clipboard takes the frame, so the thumbnail goes first.
+        writeThumbnail();
+        ok = clipboard_->Offer(std::move(job.frame));
+    } else {
+        if (toClipboard) {
+            ok = CopyImageToClipboard(job.frame, pool_);
+        } else if (job.frame.pixels.empty()) {
+            // GPU-only frame (a save past ShouldStreamToFile() or a
+            // scripted capture's crop): encoded straight from mapped memory.
+            ok = StreamGpuFrameToFile(job.frame, job.path, pool_, job.pngPreset);
+        } else {
+            ok = SaveImageToFile(job.frame, job.path, pool_, job.pngPreset);
+        }
+        if (ok) {
+            writeThumbnail();
+        }
+    }
+    TraceRecord(TraceStage::Output, job.submittedAt);
+    if (job.onDone) {
+        job.onDone(ok);
+    } else if (onDone_) {
+        onDone_(ok, toClipboard, thumbnailPath);
+    }
+}
+
+} // namespace screencap::capture
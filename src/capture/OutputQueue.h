@@ -0,0 +1,88 @@
+#pragma once
+
+#include "capture/FrameData.h"
+#include "capture/SaveImage.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace screencap::capture {
+
+class ClipboardImage;
+class ThreadPool;
+
+// Background output pipeline.  Submitted jobs go through two queued stages,
+// each on its own thread:
+//   1. convert — FP16 → SDR BGRA8 (skipped for HDR files)
+//   2. encode  — PNG/JPEG XR to disk or the image to the clipboard, plus
+//                the toast thumbnail
+// so the preview closes as soon as a job is queued and consecutive captures
+// overlap (one converts while the previous one encodes).  GPU work (tone
+// map, readback) stays with the caller, which owns the immediate context;
+// jobs carry CPU pixels, except very large saves (ShouldStreamToFile())
+// and scripted captures, which carry the GPU frame and are streamed from a
+// mapped staging texture on the encode thread (the capture device is
+// multithread-protected).
+class OutputQueue final {
+public:
+    struct Job {
+        FrameData    frame;                       // CPU pixels (BGRA8 or FP16), or GPU-only to stream
+        std::wstring path;                        // empty → clipboard
+        PngPreset    pngPreset{PngPreset::Compact};
+        FrameData    thumbnail;                   // optional pre-scaled BGRA8 (GPU downsample)
+        int64_t      submittedAt{};               // set by Submit(), for TraceStage::Output
+        // Set: called instead of the queue's Completion (encode thread),
+        // and no toast thumbnail is written.  For scripted captures.
+        std::function<void(bool ok)> onDone;
+    };
+
+    // Runs on the encode thread after each job.  thumbnailPath is this
+    // job's toast thumbnail (WriteThumbnailPng()), empty if none was written.
+    using Completion = std::function<void(bool ok, bool toClipboard, const std::wstring& thumbnailPath)>;
+
+    // The pool (optional) parallelises the conversion and row copies.
+    // With a clipboard (optional) clipboard jobs are offered for delayed
+    // rendering and skip the convert stage; otherwise they are copied as
+    // CF_DIB right away.
+    OutputQueue(ThreadPool* pool, ClipboardImage* clipboard, Completion onDone);
+    ~OutputQueue();   // finishes every queued job, then joins
+
+    OutputQueue(const OutputQueue&) = delete;
+    OutputQueue& operator=(const OutputQueue&) = delete;
+    OutputQueue(OutputQueue&&) = delete;
+    OutputQueue& operator=(OutputQueue&&) = delete;
+
+    // Queue a job; never blocks on earlier jobs.
+    void Submit(Job job);
+
+private:
+    // One stage: a FIFO drained by a dedicated thread.
+    struct Stage {
+        std::mutex              mutex;
+        std::condition_variable wake;
+        std::deque<Job>         jobs;
+        bool                    stop{false};
+        std::thread             thread;
+    };
+
+    static void Push(Stage& stage, Job job);
+    static void Stop(Stage& stage);
+
+    // Run fn on each job of `stage` until stopped and drained.
+    static void Drain(Stage& stage, const std::function<void(Job&&)>& fn);
+
+    void Convert(Job&& job);
+    void Encode(Job&& job);
+
+    ThreadPool*     pool_{};
+    ClipboardImage* clipboard_{};
+    Completion      onDone_;
+    Stage           convert_;
+    Stage           encode_;
+};
+
+} // namespace screencap::capture
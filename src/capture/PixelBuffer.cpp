@@ -0,0 +1,258 @@
+#include "capture/PixelBuffer.h"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace screencap::capture {
+namespace {
+
+// Smaller buffers (thumbnails, small crops) come from the heap.
+constexpr size_t kPoolMinBytes = 1024 * 1024;
+
+// Pooled sizes round up to this, so frames of nearly the same size share
+// blocks.  Also the usual large-page size.
+constexpr size_t kGranule = 2 * 1024 * 1024;
+
+// Free blocks kept for reuse; beyond this the oldest are released at once.
+// Several FP16 frames of a three-monitor 4K desktop.
+constexpr size_t kMaxPooledBytes = 512 * 1024 * 1024;
+
+struct Block {
+    uint8_t* data{};
+    size_t   capacity{};
+    uint64_t freedAt{};   // GetTickCount64()
+};
+
+struct Pool {
+    std::mutex         mutex;
+    std::vector<Block> free;
+    size_t             pooledBytes{0};
+};
+
+Pool& ThePool()
+{
+    // Never destroyed: buffers may outlive static destruction order.
+    static Pool* const pool = new Pool;
+    return *pool;
+}
+
+// Large-page size if this process may use large pages, else 0.  That needs
+// SeLockMemoryPrivilege granted to the account; enabling it here only
+// switches on what is already granted.
+size_t LargePageSize() noexcept
+{
+    static const size_t size = []() -> size_t {
+        const size_t minimum = ::GetLargePageMinimum();
+        if (minimum == 0) return 0;
+
+        HANDLE token{};
+        if (!::OpenProcessToken(::GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) return 0;
+        TOKEN_PRIVILEGES tp{};
+        tp.PrivilegeCount = 1;
+        tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+        // Succeeds with ERROR_NOT_ALL_ASSIGNED when the account lacks it.
+        const bool enabled = ::LookupPrivilegeValueW(nullptr, SE_LOCK_MEMORY_NAME, &tp.Privileges[0].Luid) &&
+                             ::AdjustTokenPrivileges(token, FALSE, &tp, 0, nullptr, nullptr) &&
+                             ::GetLastError() == ERROR_SUCCESS;
+        ::CloseHandle(token);
+        return enabled ? minimum : 0;
+    }();
+    return size;
+}
+
+[[nodiscard]] size_t RoundUp(size_t size, size_t granule) noexcept
+{
+    return (size + granule - 1) / granule * granule;
+}
+
+[[nodiscard]] uint8_t* Commit(size_t capacity) noexcept
+{
+    // Large pages are physically contiguous and can fail on a fragmented
+    // system long after start-up; ordinary pages then.
+    if (LargePageSize() != 0) {
+        if (void* p = ::VirtualAlloc(nullptr, capacity, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE)) {
+            return static_cast<uint8_t*>(p);
+        }
+    }
+    return static_cast<uint8_t*>(::VirtualAlloc(nullptr, capacity, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+}
+
+void FreeBlocks(const std::vector<Block>& blocks) noexcept
+{
+    for (const auto& b : blocks) {
+        (void)::VirtualFree(b.data, 0, MEM_RELEASE);
+    }
+}
+
+// Take the blocks idle for `idleMs` (all for 0) out of the pool.
+[[nodiscard]] std::vector<Block> TakeIdle(Pool& pool, uint32_t idleMs)
+{
+    const uint64_t now = ::GetTickCount64();
+    std::vector<Block> idle;
+    std::lock_guard lock(pool.mutex);
+    for (size_t i = 0; i < pool.free.size();) {
+        if (now - pool.free[i].freedAt >= idleMs) {
+            pool.pooledBytes -= pool.free[i].capacity;
+            idle.push_back(pool.free[i]);
+            pool.free[i] = pool.free.back();
+            pool.free.pop_back();
+        } else {
+            ++i;
+        }
+    }
+    return idle;
+}
+
+// A block of at least `size` bytes.  Throws std::bad_alloc.
+[[nodiscard]] Block Allocate(size_t size)
+{
+    if (size < kPoolMinBytes) {
+        return {static_cast<uint8_t*>(::operator new(size)), size, 0};
+    }
+
+    const size_t capacity = RoundUp(size, (std::max)(kGranule, LargePageSize()));
+    Pool& pool = ThePool();
+    {
+        // Best fit, but not a block more than twice the size: that one
+        // is better kept for a frame that needs it.
+        std::lock_guard lock(pool.mutex);
+        size_t best = pool.free.size();
+        for (size_t i = 0; i < pool.free.size(); ++i) {
+            const size_t c = pool.free[i].capacity;
+            if (c >= capacity && c <= capacity * 2 &&
+                (best == pool.free.size() || c < pool.free[best].capacity)) {
+                best = i;
+            }
+        }
+        if (best != pool.free.size()) {
+            const Block block = pool.free[best];
+            pool.free[best] = pool.free.back();
+            pool.free.pop_back();
+            pool.pooledBytes -= block.capacity;
+            return block;
+        }
+    }
+
+    uint8_t* data = Commit(capacity);
+    if (!data) {
+        // Out of address space or commit: what the pool holds goes first.
+        FreeBlocks(TakeIdle(pool, 0));
+        data = Commit(capacity);
+    }
+    if (!data) throw std::bad_alloc();
+    return {data, capacity, 0};
+}
+
+void Release(uint8_t* data, size_t capacity) noexcept
+{
+    if (!data) return;
+    if (capacity < kPoolMinBytes) {
+        ::operator delete(data);
+        return;
+    }
+
+    Pool& pool = ThePool();
+    std::vector<Block> excess;
+    try {
+        std::lock_guard lock(pool.mutex);
+        pool.free.push_back({data, capacity, ::GetTickCount64()});
+        pool.pooledBytes += capacity;
+        // Over the limit: drop the longest-unused blocks.
+        while (pool.pooledBytes > kMaxPooledBytes) {
+            size_t oldest = 0;
+            for (size_t i = 1; i < pool.free.size(); ++i) {
+                if (pool.free[i].freedAt < pool.free[oldest].freedAt) oldest = i;
+            }
+            pool.pooledBytes -= pool.free[oldest].capacity;
+            excess.push_back(pool.free[oldest]);
+            pool.free[oldest] = pool.free.back();
+            pool.free.pop_back();
+        }
+    } catch (const std::bad_alloc&) {
+        // No room to track it: give it back instead.
+        (void)::VirtualFree(data, 0, MEM_RELEASE);
+    }
+    FreeBlocks(excess);
+}
+
+} // namespace
+
+PixelBuffer::~PixelBuffer()
+{
+    Release(data_, capacity_);
+}
+
+PixelBuffer::PixelBuffer(const PixelBuffer& other)
+{
+    resize(other.size_);
+    if (size_) std::memcpy(data_, other.data_, size_);
+}
+
+PixelBuffer& PixelBuffer::operator=(const PixelBuffer& other)
+{
+    if (this != &other) {
+        // Nothing of ours to keep: don't copy it into a larger block.
+        if (other.size_ > capacity_) clear();
+        resize(other.size_);
+        if (size_) std::memcpy(data_, other.data_, size_);
+    }
+    return *this;
+}
+
+PixelBuffer::PixelBuffer(PixelBuffer&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      capacity_(std::exchange(other.capacity_, 0))
+{
+}
+
+PixelBuffer& PixelBuffer::operator=(PixelBuffer&& other) noexcept
+{
+    if (this != &other) {
+        Release(data_, capacity_);
+        data_     = std::exchange(other.data_, nullptr);
+        size_     = std::exchange(other.size_, 0);
+        capacity_ = std::exchange(other.capacity_, 0);
+    }
+    return *this;
+}
+
+void PixelBuffer::resize(size_t size)
+{
+    if (size <= capacity_) {
+        size_ = size;
+        return;
+    }
+
+    const Block block = Allocate(size);
+    if (size_) std::memcpy(block.data, data_, size_);
+    Release(data_, capacity_);
+    data_     = block.data;
+    capacity_ = block.capacity;
+    size_     = size;
+}
+
+void PixelBuffer::clear() noexcept
+{
+    Release(data_, capacity_);
+    data_     = nullptr;
+    size_     = 0;
+    capacity_ = 0;
+}
+
+void TrimPixelPool(uint32_t idleMs) noexcept
+{
+    try {
+        FreeBlocks(TakeIdle(ThePool(), idleMs));
+    } catch (const std::bad_alloc&) {
+        // Nothing trimmed this time.
+    }
+}
+
+} // namespace screencap::capture
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace screencap::capture {
+
+// ── Frame pixel storage ─────────────────────────────────────────────
+//
+// FrameData::pixels and the other full-frame buffers.  Used like the
+// std::vector<uint8_t> it replaces (data / size / empty / resize / clear),
+// with two differences:
+//   - resize() leaves new bytes uninitialised: every writer fills the
+//     whole buffer, so zeroing hundreds of MB per capture was wasted.
+//   - Large buffers come from a process-wide pool of VirtualAlloc'd
+//     blocks (large pages if the account may lock memory) and go back to
+//     it when released, so repeated captures of one desktop reuse the
+//     same committed memory instead of faulting in fresh pages.
+// Copies are deep, as with vector.
+class PixelBuffer final {
+public:
+    PixelBuffer() = default;
+    ~PixelBuffer();   // block back to the pool
+
+    PixelBuffer(const PixelBuffer& other);
+    PixelBuffer& operator=(const PixelBuffer& other);
+    PixelBuffer(PixelBuffer&& other) noexcept;
+    PixelBuffer& operator=(PixelBuffer&& other) noexcept;
+
+    [[nodiscard]] uint8_t* data() noexcept { return data_; }
+    [[nodiscard]] const uint8_t* data() const noexcept { return data_; }
+    [[nodiscard]] size_t size() const noexcept { return size_; }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+    [[nodiscard]] size_t capacity() const noexcept { return capacity_; }
+
+    // Keeps the first min(size, size()) bytes; the rest are uninitialised.
+    // Throws std::bad_alloc when no memory is left, as vector does.
+    void resize(size_t size);
+
+    // Empty, with the block back to the pool.
+    void clear() noexcept;
+
+private:
+    uint8_t* data_{};
+    size_t   size_{};
+    size_t   capacity_{};
+};
+
+// Give pooled blocks nobody has reused for `idleMs` back to the system,
+// so a long-running instance doesn't keep a capture's worth of memory
+// committed between captures.
+void TrimPixelPool(uint32_t idleMs) noexcept;
+
+} // namespace screencap::capture
@@ -18,6 +18,7 @@ namespace screencap::capture {
     case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
     case DXGI_FORMAT_R8G8B8A8_UNORM:
     case DXGI_FORMAT_R10G10B10A2_UNORM:
+    case DXGI_FORMAT_R11G11B10_FLOAT:
         return 4;
     case DXGI_FORMAT_R16G16B16A16_FLOAT:
         return 8;
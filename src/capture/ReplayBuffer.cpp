@@ -0,0 +1,202 @@
+#include "capture/ReplayBuffer.h"
+#include "capture/ConvertShader.h"
+#include "capture/PixelFormats.h"
+#include "capture/Trace.h"
+
+#include <windows.h>
+
+#include <algorithm>
+
+using Microsoft::WRL::ComPtr;
+
+namespace screencap::capture {
+namespace {
+
+constexpr UINT kThreadGroupSize = 16;
+constexpr size_t kMinSlots = 2;
+
+// Constant buffer layout matching the compute shader's ResampleParams.
+struct ResampleParams {
+    int width, height;
+    int factor;
+    int pad0;                 // Align to 16-byte boundary.
+};
+
+// Packed float with HDR range at half the size of FP16; only scRGB's
+// negative (wide-gamut) values are lost.  FP16 where it can't be a UAV.
+DXGI_FORMAT StorageFormat(ID3D11Device* device) noexcept
+{
+    UINT support = 0;
+    if (SUCCEEDED(device->CheckFormatSupport(DXGI_FORMAT_R11G11B10_FLOAT, &support)) &&
+        (support & D3D11_FORMAT_SUPPORT_TYPED_UNORDERED_ACCESS_VIEW)) {
+        return DXGI_FORMAT_R11G11B10_FLOAT;
+    }
+    return DXGI_FORMAT_R16G16B16A16_FLOAT;
+}
+
+} // namespace
+
+bool ReplayBuffer::Init(ID3D11Device* device, uint32_t width, uint32_t height, const Options& options)
+{
+    Reset();
+    if (!device || width == 0 || height == 0) return false;
+
+    device_ = device;
+    device_->GetImmediateContext(&ctx_);
+    if (FAILED(device_->CreateComputeShader(kReplayResampleCS, sizeof(kReplayResampleCS), nullptr, &cs_))) {
+        Reset();
+        return false;
+    }
+
+    D3D11_BUFFER_DESC cbDesc{};
+    cbDesc.ByteWidth = sizeof(ResampleParams);
+    cbDesc.Usage     = D3D11_USAGE_DEFAULT;
+    cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    if (FAILED(device_->CreateBuffer(&cbDesc, nullptr, &params_))) {
+        Reset();
+        return false;
+    }
+
+    srcWidth_ = width;
+    srcHeight_ = height;
+    factor_ = static_cast<int>((std::max)(1u, options.downscale));
+    width_ = (width + factor_ - 1) / factor_;
+    height_ = (height + factor_ - 1) / factor_;
+
+    const DXGI_FORMAT format = StorageFormat(device_.Get());
+    const uint64_t slotBytes = uint64_t{width_} * height_ * BytesPerPixel(format);
+    const size_t wanted = (std::max<size_t>)(kMinSlots, size_t{options.seconds} * (std::max)(1u, options.fps));
+    const size_t affordable = static_cast<size_t>(options.budgetBytes / (std::max<uint64_t>)(slotBytes, 1));
+    const size_t slots = (std::clamp)(affordable, kMinSlots, wanted);
+
+    // A small budget keeps the same span of history at a lower rate.
+    intervalMs_ = static_cast<uint32_t>((std::max<uint64_t>)(
+        uint64_t{options.seconds} * 1000 / slots, 1000 / (std::max)(1u, options.fps)));
+
+    D3D11_TEXTURE2D_DESC desc{};
+    desc.Width            = width_;
+    desc.Height           = height_;
+    desc.MipLevels        = 1;
+    desc.ArraySize        = 1;
+    desc.Format           = format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_DEFAULT;
+    desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+
+    slots_.resize(slots);
+    for (auto& slot : slots_) {
+        if (FAILED(device_->CreateTexture2D(&desc, nullptr, &slot.tex)) ||
+            FAILED(device_->CreateUnorderedAccessView(slot.tex.Get(), nullptr, &slot.uav)) ||
+            FAILED(device_->CreateShaderResourceView(slot.tex.Get(), nullptr, &slot.srv))) {
+            Reset();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ReplayBuffer::Reset() noexcept
+{
+    slots_.clear();
+    next_ = 0;
+    count_ = 0;
+    sourceSrv_.Reset();
+    source_.Reset();
+    params_.Reset();
+    cs_.Reset();
+    ctx_.Reset();
+    device_.Reset();
+}
+
+size_t ReplayBuffer::IndexOf(size_t age) const noexcept
+{
+    return (next_ + slots_.size() - 1 - age) % slots_.size();
+}
+
+void ReplayBuffer::Resample(ID3D11ShaderResourceView* src, ID3D11UnorderedAccessView* dst, int factor)
+{
+    const ResampleParams params{static_cast<int>(width_), static_cast<int>(height_), factor, 0};
+    ctx_->UpdateSubresource(params_.Get(), 0, nullptr, &params, 0, 0);
+
+    ctx_->CSSetShader(cs_.Get(), nullptr, 0);
+    ctx_->CSSetConstantBuffers(0, 1, params_.GetAddressOf());
+    ctx_->CSSetShaderResources(0, 1, &src);
+    ctx_->CSSetUnorderedAccessViews(0, 1, &dst, nullptr);
+    ctx_->Dispatch((width_ + kThreadGroupSize - 1) / kThreadGroupSize,
+                   (height_ + kThreadGroupSize - 1) / kThreadGroupSize, 1);
+
+    ID3D11ShaderResourceView* nullSrv = nullptr;
+    ID3D11UnorderedAccessView* nullUav = nullptr;
+    ctx_->CSSetShaderResources(0, 1, &nullSrv);
+    ctx_->CSSetUnorderedAccessViews(0, 1, &nullUav, nullptr);
+}
+
+bool ReplayBuffer::Push(const FrameData& frame, int64_t capturedAt)
+{
+    if (!IsReady() || !frame.gpuTexture || frame.width != srcWidth_ || frame.height != srcHeight_ ||
+        static_cast<DXGI_FORMAT>(frame.format) != DXGI_FORMAT_R16G16B16A16_FLOAT) {
+        return false;
+    }
+
+    // The live composite is the same texture every time; its view is kept.
+    if (frame.gpuTexture != source_) {
+        sourceSrv_.Reset();
+        if (FAILED(device_->CreateShaderResourceView(frame.gpuTexture.Get(), nullptr, &sourceSrv_))) {
+            source_.Reset();
+            return false;
+        }
+        source_ = frame.gpuTexture;
+    }
+
+    Slot& slot = slots_[next_];
+    Resample(sourceSrv_.Get(), slot.uav.Get(), factor_);
+    slot.capturedAt = capturedAt;
+    // Assigned in place: the slot's capacity is reused frame to frame.
+    slot.whiteRegions.assign(frame.whiteRegions.begin(), frame.whiteRegions.end());
+    for (auto& r : slot.whiteRegions) {
+        r.rect = {r.rect.left / factor_, r.rect.top / factor_,
+                  (r.rect.right + factor_ - 1) / factor_, (r.rect.bottom + factor_ - 1) / factor_};
+    }
+    next_ = (next_ + 1) % slots_.size();
+    count_ = (std::min)(count_ + 1, slots_.size());
+    return true;
+}
+
+std::optional<FrameData> ReplayBuffer::Frame(size_t age)
+{
+    if (age >= count_) return std::nullopt;
+
+    D3D11_TEXTURE2D_DESC desc{};
+    desc.Width            = width_;
+    desc.Height           = height_;
+    desc.MipLevels        = 1;
+    desc.ArraySize        = 1;
+    desc.Format           = DXGI_FORMAT_R16G16B16A16_FLOAT;
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_DEFAULT;
+    desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+
+    FrameData frame;
+    ComPtr<ID3D11UnorderedAccessView> uav;
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &frame.gpuTexture)) ||
+        FAILED(device_->CreateUnorderedAccessView(frame.gpuTexture.Get(), nullptr, &uav))) {
+        return std::nullopt;
+    }
+    Resample(slots_[IndexOf(age)].srv.Get(), uav.Get(), 1);
+
+    frame.width         = width_;
+    frame.height        = height_;
+    frame.format        = static_cast<uint32_t>(DXGI_FORMAT_R16G16B16A16_FLOAT);
+    frame.bytesPerPixel = BytesPerPixel(DXGI_FORMAT_R16G16B16A16_FLOAT);
+    frame.whiteRegions  = slots_[IndexOf(age)].whiteRegions;
+    return frame;
+}
+
+double ReplayBuffer::AgeSeconds(size_t age, int64_t now) const noexcept
+{
+    if (age >= count_) return 0.0;
+    const int64_t ticks = now - slots_[IndexOf(age)].capturedAt;
+    return static_cast<double>((std::max)(ticks, int64_t{0})) / static_cast<double>(TraceFrequency());
+}
+
+} // namespace screencap::capture
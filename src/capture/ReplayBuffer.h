@@ -0,0 +1,98 @@
+#pragma once
+
+#include "capture/FrameData.h"
+
+#include <d3d11.h>
+#include <wrl/client.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace screencap::capture {
+
+// ── Instant replay ──────────────────────────────────────────────────
+//
+// The last few seconds of the desktop, kept on the GPU so a moment that
+// has already passed can still be captured.  The ring is a fixed set of
+// textures allocated in Init() — nothing is allocated per frame — at a
+// reduced resolution and in R11G11B10_FLOAT (HDR range, 4 bytes a
+// pixel), so its VRAM use is bounded by Options::budgetBytes.  Push() is
+// fed from the continuous-mode live composite and only called when the
+// desktop changed, so a static desktop costs nothing.
+class ReplayBuffer final {
+public:
+    struct Options {
+        uint32_t seconds{5};                   // history to keep
+        uint32_t fps{10};                      // at most; fewer if the budget is small
+        uint32_t downscale{2};                 // 1 = full resolution
+        uint64_t budgetBytes{256ull << 20};    // VRAM for the whole ring
+    };
+
+    ReplayBuffer() = default;
+    ~ReplayBuffer() = default;
+
+    ReplayBuffer(const ReplayBuffer&) = delete;
+    ReplayBuffer& operator=(const ReplayBuffer&) = delete;
+    ReplayBuffer(ReplayBuffer&&) = default;
+    ReplayBuffer& operator=(ReplayBuffer&&) = default;
+
+    // Allocate the ring for a width×height desktop.  Drops any history.
+    [[nodiscard]] bool Init(ID3D11Device* device, uint32_t width, uint32_t height,
+                            const Options& options = {});
+
+    // Free the ring.
+    void Reset() noexcept;
+
+    [[nodiscard]] bool IsReady() const noexcept { return !slots_.empty(); }
+    [[nodiscard]] bool Matches(uint32_t width, uint32_t height) const noexcept
+    {
+        return IsReady() && width == srcWidth_ && height == srcHeight_;
+    }
+
+    // Time between pushes that spreads the ring over Options::seconds.
+    [[nodiscard]] uint32_t IntervalMs() const noexcept { return intervalMs_; }
+
+    // Store a GPU FP16 desktop frame captured at `capturedAt` (TraceNow()
+    // ticks), overwriting the oldest entry once full.  The frame is only
+    // read during the call.
+    bool Push(const FrameData& frame, int64_t capturedAt);
+
+    // Number of stored frames; age 0 is the newest.
+    [[nodiscard]] size_t Count() const noexcept { return count_; }
+
+    // A stored frame as a new GPU FP16 frame at the ring's resolution,
+    // for the preview and the usual output path.
+    [[nodiscard]] std::optional<FrameData> Frame(size_t age);
+
+    // How long before `now` (TraceNow() ticks) that frame was captured.
+    [[nodiscard]] double AgeSeconds(size_t age, int64_t now) const noexcept;
+
+private:
+    struct Slot {
+        Microsoft::WRL::ComPtr<ID3D11Texture2D>           tex;
+        Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav;
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>  srv;
+        int64_t                                           capturedAt{};
+        std::vector<WhiteRegion>                          whiteRegions;  // in slot pixels
+    };
+
+    [[nodiscard]] size_t IndexOf(size_t age) const noexcept;
+    void Resample(ID3D11ShaderResourceView* src, ID3D11UnorderedAccessView* dst, int factor);
+
+    Microsoft::WRL::ComPtr<ID3D11Device>             device_;
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext>      ctx_;
+    Microsoft::WRL::ComPtr<ID3D11ComputeShader>      cs_;
+    Microsoft::WRL::ComPtr<ID3D11Buffer>             params_;   // ResampleParams
+    Microsoft::WRL::ComPtr<ID3D11Texture2D>          source_;   // last pushed texture (live composite)
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> sourceSrv_;
+    std::vector<Slot> slots_;
+    size_t   next_{0};              // slot the next Push() writes
+    size_t   count_{0};
+    uint32_t srcWidth_{}, srcHeight_{};
+    uint32_t width_{}, height_{};   // stored resolution
+    int      factor_{1};
+    uint32_t intervalMs_{100};
+};
+
+} // namespace screencap::capture
@@ -1,5 +1,9 @@
 #include "capture/SaveImage.h"
+#include "capture/ConvertCpu.h"
 #include "capture/PixelFormats.h"
+#include "capture/ThreadPool.h"
+#include "capture/Trace.h"
+#include "capture/WhiteLevel.h"
 
 #include <nfd.h>
 
@@ -9,7 +13,13 @@
 #include <wincodec.h>
 #include <wrl/client.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -18,88 +28,6 @@ using Microsoft::WRL::ComPtr;
 namespace screencap::capture {
 namespace {
 
-// ── Per-monitor SDR white level ─────────────────────────────────────
-//
-// On an HDR desktop, the DWM composes everything into linear scRGB where
-// 1.0 = 80 nits.  The user's "SDR content brightness" slider (paper white)
-// boosts SDR white content in the captured buffer:
-//
-//   scRGB_value_of_SDR_white = paperWhiteNits / 80
-//
-// To produce a correct SDR PNG we simply divide by that ratio so SDR white
-// maps back to 1.0 (linear) → 255 (sRGB 8-bit).
-// HDR highlights above 1.0 after normalisation are clipped, which is the
-// same thing an SDR display does.
-
-[[nodiscard]] float GetSdrWhiteNitsForMonitor(HMONITOR mon) noexcept
-{
-    if (!mon) {
-        return 80.0f;
-    }
-
-    MONITORINFOEXW mi{};
-    mi.cbSize = sizeof(mi);
-    if (!::GetMonitorInfoW(mon, &mi)) {
-        return 80.0f;
-    }
-
-    UINT32 pathCount = 0;
-    UINT32 modeCount = 0;
-    LONG st = ::GetDisplayConfigBufferSizes(QDC_ONLY_ACTIVE_PATHS, &pathCount, &modeCount);
-    if (st != ERROR_SUCCESS || pathCount == 0) {
-        return 80.0f;
-    }
-
-    std::vector<DISPLAYCONFIG_PATH_INFO> paths(pathCount);
-    std::vector<DISPLAYCONFIG_MODE_INFO> modes(modeCount);
-    st = ::QueryDisplayConfig(QDC_ONLY_ACTIVE_PATHS, &pathCount, paths.data(), &modeCount, modes.data(), nullptr);
-    if (st != ERROR_SUCCESS) {
-        return 80.0f;
-    }
-
-    for (UINT32 i = 0; i < pathCount; ++i) {
-        const auto& p = paths[i];
-
-        DISPLAYCONFIG_SOURCE_DEVICE_NAME srcName{};
-        srcName.header.type = DISPLAYCONFIG_DEVICE_INFO_GET_SOURCE_NAME;
-        srcName.header.size = sizeof(srcName);
-        srcName.header.adapterId = p.sourceInfo.adapterId;
-        srcName.header.id = p.sourceInfo.id;
-
-        if (::DisplayConfigGetDeviceInfo(&srcName.header) != ERROR_SUCCESS) {
-            continue;
-        }
-
-        if (::lstrcmpiW(srcName.viewGdiDeviceName, mi.szDevice) != 0) {
-            continue;
-        }
-
-        DISPLAYCONFIG_SDR_WHITE_LEVEL sdr{};
-        sdr.header.type = DISPLAYCONFIG_DEVICE_INFO_GET_SDR_WHITE_LEVEL;
-        sdr.header.size = sizeof(sdr);
-        sdr.header.adapterId = p.targetInfo.adapterId;
-        sdr.header.id = p.targetInfo.id;
-
-        if (::DisplayConfigGetDeviceInfo(&sdr.header) != ERROR_SUCCESS) {
-            return 80.0f;
-        }
-
-        // SDRWhiteLevel is "a multiplier of 80 nits, multiplied by 1000".
-        // nits = (SDRWhiteLevel / 1000.0) * 80
-        const float nits = (static_cast<float>(sdr.SDRWhiteLevel) / 1000.0f) * 80.0f;
-        return (nits > 0.0f) ? nits : 80.0f;
-    }
-
-    return 80.0f;
-}
-
-[[nodiscard]] float GetSdrWhiteNitsForPrimaryMonitor() noexcept
-{
-    // Use the primary monitor (where the tray icon lives) as the reference.
-    const HMONITOR mon = ::MonitorFromPoint({0, 0}, MONITOR_DEFAULTTOPRIMARY);
-    return GetSdrWhiteNitsForMonitor(mon);
-}
-
 // ── scRGB FP16 → BGRA8 for PNG ─────────────────────────────────────
 //
 // The captured scRGB buffer has:
@@ -111,9 +39,53 @@ namespace {
 //   2. Clamp to [0, 1]  (clips HDR highlights — same as an SDR display)
 //   3. Apply sRGB gamma
 //   4. Quantise to 8-bit
+//
+// The image is split into row bands; with a pool they run on all cores.
 
-[[nodiscard]] bool ScRgb16fToBgra8(const FrameData& in, std::vector<uint8_t>& outBgra8) noexcept
+// Target work per band: large enough to amortise scheduling, small enough
+// that 16+ cores all get several bands on a 4K frame.
+constexpr size_t kPixelsPerBand = 256 * 1024;
+
+[[nodiscard]] size_t RowsPerBand(uint32_t width) noexcept
 {
+    return (std::max)(size_t{1}, kPixelsPerBand / (std::max)(width, 1u));
+}
+
+[[nodiscard]] float ScaleFor(float sdrWhiteNits) noexcept
+{
+    return 80.0f / ((sdrWhiteNits > 0.0f) ? sdrWhiteNits : 80.0f);
+}
+
+// Row y of an FP16 frame, each run of pixels at its own monitor's white
+// level (the first region containing it, as on the GPU) and `fallback`
+// outside them.  Monitors are rectangles, so a row is a few runs.
+void ToneMapRow(const uint16_t* src, uint8_t* dst, uint32_t width, uint32_t y,
+                const std::vector<WhiteRegion>& regions, float fallback) noexcept
+{
+    const LONG row = static_cast<LONG>(y);
+    LONG x = 0;
+    while (x < static_cast<LONG>(width)) {
+        float scale = fallback;
+        bool  found = false;
+        LONG  end = static_cast<LONG>(width);
+        for (const auto& r : regions) {
+            if (row < r.rect.top || row >= r.rect.bottom) continue;
+            if (r.rect.left > x) end = (std::min)(end, r.rect.left);
+            if (r.rect.right > x) end = (std::min)(end, r.rect.right);
+            if (!found && x >= r.rect.left && x < r.rect.right) {
+                scale = ScaleFor(r.sdrWhiteNits);
+                found = true;
+            }
+        }
+        ScRgb16fToBgra8Pixels(src + static_cast<size_t>(x) * 4, dst + static_cast<size_t>(x) * 4,
+                              static_cast<size_t>(end - x), scale);
+        x = end;
+    }
+}
+
+[[nodiscard]] bool ScRgb16fToBgra8(const FrameData& in, PixelBuffer& outBgra8, ThreadPool* pool)
+{
+    const ScopedTrace trace(TraceStage::ToneMapCpu);
     if (in.width == 0 || in.height == 0) {
         return false;
     }
@@ -121,7 +93,7 @@ namespace {
         return false;
     }
 
-    const float paperWhite = GetSdrWhiteNitsForPrimaryMonitor();
+    const float paperWhite = SdrWhiteNitsForFrame(in);  // outside in.whiteRegions
     // scRGB value that corresponds to SDR white on this monitor:
     const float sdrWhiteScRgb = paperWhite / 80.0f;
     // We divide by this to bring SDR white back to 1.0 linear.
@@ -131,137 +103,312 @@ namespace {
 
     const auto* src = reinterpret_cast<const uint16_t*>(in.pixels.data());
     auto* dst = outBgra8.data();
-
-    for (uint32_t y = 0; y < in.height; ++y) {
-        for (uint32_t x = 0; x < in.width; ++x) {
-            const size_t si = (static_cast<size_t>(y) * in.width + x) * 4;
-
-            // Read linear scRGB, normalise by paper white, clamp negatives + HDR.
-            float r = (std::max)(0.0f, HalfToFloat(src[si + 0]) * scale);
-            float g = (std::max)(0.0f, HalfToFloat(src[si + 1]) * scale);
-            float b = (std::max)(0.0f, HalfToFloat(src[si + 2]) * scale);
-
-            r = (std::min)(1.0f, r);
-            g = (std::min)(1.0f, g);
-            b = (std::min)(1.0f, b);
-
-            // Linear → sRGB gamma → 8-bit.  Note: output is BGRA order.
-            const size_t di = (static_cast<size_t>(y) * in.width + x) * 4;
-            dst[di + 0] = FloatToUNorm8(LinearToSrgb(b));
-            dst[di + 1] = FloatToUNorm8(LinearToSrgb(g));
-            dst[di + 2] = FloatToUNorm8(LinearToSrgb(r));
-            dst[di + 3] = 255;
+    const size_t width = in.width;
+
+    // SIMD kernel when the CPU supports it, scalar reference otherwise.
+    ParallelFor(pool, in.height, RowsPerBand(in.width), [&](size_t rowBegin, size_t rowEnd) {
+        if (in.whiteRegions.empty()) {
+            ScRgb16fToBgra8Pixels(
+                src + rowBegin * width * 4,
+                dst + rowBegin * width * 4,
+                (rowEnd - rowBegin) * width,
+                scale);
+            return;
         }
-    }
+        for (size_t y = rowBegin; y < rowEnd; ++y) {
+            ToneMapRow(src + y * width * 4, dst + y * width * 4, in.width,
+                       static_cast<uint32_t>(y), in.whiteRegions, scale);
+        }
+    });
 
     return true;
 }
 
 // ── WIC PNG writer ──────────────────────────────────────────────────
 
-bool WritePng(const FrameData& frame, const wchar_t* path)
+// Create a PNG frame with the preset's encoder options applied.
+[[nodiscard]] HRESULT CreatePngFrame(IWICBitmapEncoder* encoder, PngPreset preset,
+                                     ComPtr<IWICBitmapFrameEncode>& frameEncode)
+{
+    ComPtr<IPropertyBag2> props;
+    HRESULT hr = encoder->CreateNewFrame(&frameEncode, &props);
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    PROPBAG2 option{};
+    option.pstrName = const_cast<LPOLESTR>(L"FilterOption");
+    VARIANT value{};
+    value.vt   = VT_UI1;
+    value.bVal = static_cast<BYTE>(preset == PngPreset::Fast ? WICPngFilterNone : WICPngFilterAdaptive);
+    // Not fatal — the encoder's default filter is still a valid PNG.
+    (void)props->Write(1, &option, &value);
+
+    return frameEncode->Initialize(props.Get());
+}
+
+// WIC stream writing to `path`.
+[[nodiscard]] ComPtr<IWICStream> OpenFileStream(IWICImagingFactory* factory, const wchar_t* path)
+{
+    ComPtr<IWICStream> stream;
+    if (FAILED(factory->CreateStream(&stream)) ||
+        FAILED(stream->InitializeFromFilename(path, GENERIC_WRITE))) {
+        return nullptr;
+    }
+    return stream;
+}
+
+[[nodiscard]] ComPtr<IWICImagingFactory> CreateWicFactory()
 {
     ComPtr<IWICImagingFactory> factory;
-    HRESULT hr = ::CoCreateInstance(
+    (void)::CoCreateInstance(
         CLSID_WICImagingFactory,
         nullptr,
         CLSCTX_INPROC_SERVER,
         IID_PPV_ARGS(&factory));
-    if (FAILED(hr)) {
+    return factory;
+}
+
+// ── Row sources ─────────────────────────────────────────────────────
+//
+// The encoders take rows with an arbitrary pitch, so a mapped staging
+// texture can be encoded in place as well as a tightly packed CPU buffer.
+
+struct RowSource {
+    const uint8_t* data{};
+    size_t         rowPitch{};
+    uint32_t       width{};
+    uint32_t       height{};
+    DXGI_FORMAT    format{};
+    const std::vector<WhiteRegion>* regions{};   // FP16 only; may be null
+    float          sdrWhiteNits{80.0f};          // FP16, outside the regions
+};
+
+[[nodiscard]] RowSource RowsOf(const FrameData& frame) noexcept
+{
+    return {frame.pixels.data(), static_cast<size_t>(frame.width) * frame.bytesPerPixel,
+            frame.width, frame.height, static_cast<DXGI_FORMAT>(frame.format), &frame.whiteRegions,
+            SdrWhiteNitsForFrame(frame)};
+}
+
+// Rows per WritePixels call when converting on the fly: keeps the scratch
+// band at a few MB however wide the frame is.
+constexpr size_t kStreamBandBytes = 4 * 1024 * 1024;
+
+[[nodiscard]] HRESULT WriteRows(IWICBitmapFrameEncode* frameEncode, const RowSource& src, ThreadPool* pool)
+{
+    if (src.format == DXGI_FORMAT_B8G8R8A8_UNORM) {
+        // Already what the encoder wants: hand it the rows in place.
+        return frameEncode->WritePixels(
+            src.height,
+            static_cast<UINT>(src.rowPitch),
+            static_cast<UINT>(src.rowPitch * src.height),
+            const_cast<BYTE*>(src.data));
+    }
+    if (src.format != DXGI_FORMAT_R16G16B16A16_FLOAT) {
+        return E_INVALIDARG;
+    }
+
+    // FP16: tone-map one band at a time into a reused scratch buffer.
+    const float scale = ScaleFor(src.sdrWhiteNits);
+    const bool perMonitor = src.regions && !src.regions->empty();
+    const size_t dstStride = static_cast<size_t>(src.width) * 4;
+    const size_t bandRows = (std::max)(size_t{1}, kStreamBandBytes / dstStride);
+    PixelBuffer band;
+    band.resize(dstStride * (std::min)(bandRows, size_t{src.height}));
+
+    for (size_t row = 0; row < src.height; row += bandRows) {
+        const size_t rows = (std::min)(bandRows, src.height - row);
+        ParallelFor(pool, rows, RowsPerBand(src.width), [&](size_t rowBegin, size_t rowEnd) {
+            for (size_t y = rowBegin; y < rowEnd; ++y) {
+                const auto* in = reinterpret_cast<const uint16_t*>(src.data + (row + y) * src.rowPitch);
+                if (perMonitor) {
+                    ToneMapRow(in, band.data() + y * dstStride, src.width,
+                               static_cast<uint32_t>(row + y), *src.regions, scale);
+                } else {
+                    ScRgb16fToBgra8Pixels(in, band.data() + y * dstStride, src.width, scale);
+                }
+            }
+        });
+        const HRESULT hr = frameEncode->WritePixels(
+            static_cast<UINT>(rows),
+            static_cast<UINT>(dstStride),
+            static_cast<UINT>(dstStride * rows),
+            band.data());
+        if (FAILED(hr)) {
+            return hr;
+        }
+    }
+    return S_OK;
+}
+
+[[nodiscard]] bool EncodePngRows(const RowSource& src, IStream* stream, ThreadPool* pool, PngPreset preset)
+{
+    const ComPtr<IWICImagingFactory> factory = CreateWicFactory();
+    if (!factory) {
         return false;
     }
 
-    ComPtr<IWICStream> stream;
-    hr = factory->CreateStream(&stream);
+    ComPtr<IWICBitmapEncoder> encoder;
+    HRESULT hr = factory->CreateEncoder(GUID_ContainerFormatPng, nullptr, &encoder);
     if (FAILED(hr)) {
         return false;
     }
 
-    hr = stream->InitializeFromFilename(path, GENERIC_WRITE);
+    hr = encoder->Initialize(stream, WICBitmapEncoderNoCache);
     if (FAILED(hr)) {
         return false;
     }
 
-    ComPtr<IWICBitmapEncoder> encoder;
-    hr = factory->CreateEncoder(GUID_ContainerFormatPng, nullptr, &encoder);
+    ComPtr<IWICBitmapFrameEncode> frameEncode;
+    hr = CreatePngFrame(encoder.Get(), preset, frameEncode);
     if (FAILED(hr)) {
         return false;
     }
 
-    hr = encoder->Initialize(stream.Get(), WICBitmapEncoderNoCache);
+    hr = frameEncode->SetSize(src.width, src.height);
     if (FAILED(hr)) {
         return false;
     }
 
-    ComPtr<IWICBitmapFrameEncode> frameEncode;
-    hr = encoder->CreateNewFrame(&frameEncode, nullptr);
+    WICPixelFormatGUID pixelFormat = GUID_WICPixelFormat32bppBGRA;
+    hr = frameEncode->SetPixelFormat(&pixelFormat);
     if (FAILED(hr)) {
         return false;
     }
 
-    hr = frameEncode->Initialize(nullptr);
+    hr = WriteRows(frameEncode.Get(), src, pool);
     if (FAILED(hr)) {
         return false;
     }
 
-    hr = frameEncode->SetSize(frame.width, frame.height);
+    hr = frameEncode->Commit();
     if (FAILED(hr)) {
         return false;
     }
 
-    WICPixelFormatGUID pixelFormat = GUID_WICPixelFormat32bppBGRA;
-    hr = frameEncode->SetPixelFormat(&pixelFormat);
+    hr = encoder->Commit();
     if (FAILED(hr)) {
         return false;
     }
 
-    // Convert to 8-bit BGRA for WIC.
-    std::vector<uint8_t> bgra8;
-    const auto fmt = static_cast<DXGI_FORMAT>(frame.format);
-    if (fmt == DXGI_FORMAT_R16G16B16A16_FLOAT && frame.bytesPerPixel == 8) {
-        if (!ScRgb16fToBgra8(frame, bgra8)) {
-            return false;
-        }
-    } else if (fmt == DXGI_FORMAT_B8G8R8A8_UNORM && frame.bytesPerPixel == 4) {
-        // Already BGRA8 — use directly.
-        bgra8 = frame.pixels;
-    } else {
+    return true;
+}
+
+// ── WIC JPEG XR writer (HDR) ────────────────────────────────────────
+
+// Rows handed to WIC per WritePixels call; the encoder streams to disk.
+constexpr UINT kJxrRowsPerWrite = 256;
+
+[[nodiscard]] bool EncodeJxrRows(const RowSource& src, IStream* stream)
+{
+    if (src.width == 0 || src.height == 0 || !src.data) {
         return false;
     }
 
-    const UINT stride = frame.width * 4;
-    const UINT bufferSize = stride * frame.height;
-    hr = frameEncode->WritePixels(
-        frame.height,
-        stride,
-        bufferSize,
-        const_cast<BYTE*>(bgra8.data()));
-    if (FAILED(hr)) {
+    // FP16 scRGB maps 1:1 onto 64bppRGBAHalf; BGRA8 is stored as is too.
+    WICPixelFormatGUID pixelFormat{};
+    if (src.format == DXGI_FORMAT_R16G16B16A16_FLOAT) {
+        pixelFormat = GUID_WICPixelFormat64bppRGBAHalf;
+    } else if (src.format == DXGI_FORMAT_B8G8R8A8_UNORM) {
+        pixelFormat = GUID_WICPixelFormat32bppBGRA;
+    } else {
         return false;
     }
+    const WICPixelFormatGUID requested = pixelFormat;
+
+    const ComPtr<IWICImagingFactory> factory = CreateWicFactory();
+    if (!factory) return false;
+
+    ComPtr<IWICBitmapEncoder> encoder;
+    HRESULT hr = factory->CreateEncoder(GUID_ContainerFormatWmp, nullptr, &encoder);
+    if (FAILED(hr)) return false;
+
+    hr = encoder->Initialize(stream, WICBitmapEncoderNoCache);
+    if (FAILED(hr)) return false;
+
+    ComPtr<IWICBitmapFrameEncode> frameEncode;
+    ComPtr<IPropertyBag2> props;
+    hr = encoder->CreateNewFrame(&frameEncode, &props);
+    if (FAILED(hr)) return false;
+
+    // Archival copy: lossless.
+    PROPBAG2 option{};
+    option.pstrName = const_cast<LPOLESTR>(L"Lossless");
+    VARIANT value{};
+    value.vt      = VT_BOOL;
+    value.boolVal = VARIANT_TRUE;
+    (void)props->Write(1, &option, &value);
+
+    hr = frameEncode->Initialize(props.Get());
+    if (FAILED(hr)) return false;
+
+    hr = frameEncode->SetSize(src.width, src.height);
+    if (FAILED(hr)) return false;
+
+    // The encoder may substitute a format; we don't convert, so refuse.
+    hr = frameEncode->SetPixelFormat(&pixelFormat);
+    if (FAILED(hr) || !::IsEqualGUID(pixelFormat, requested)) return false;
+
+    const auto stride = static_cast<UINT>(src.rowPitch);
+    for (UINT row = 0; row < src.height; row += kJxrRowsPerWrite) {
+        const UINT rows = (std::min)(kJxrRowsPerWrite, src.height - row);
+        hr = frameEncode->WritePixels(
+            rows, stride, stride * rows,
+            const_cast<BYTE*>(src.data + static_cast<size_t>(row) * stride));
+        if (FAILED(hr)) return false;
+    }
 
     hr = frameEncode->Commit();
-    if (FAILED(hr)) {
+    if (FAILED(hr)) return false;
+
+    hr = encoder->Commit();
+    return SUCCEEDED(hr);
+}
+
+} // namespace
+
+bool EncodePng(const FrameData& frame, IStream* stream, ThreadPool* pool, PngPreset preset)
+{
+    // 8-bit BGRA for WIC.
+    const uint8_t* bgra8 = SdrBgra8(frame, pool);
+    if (!bgra8) {
         return false;
     }
+    return EncodePngRows({bgra8, static_cast<size_t>(frame.width) * 4, frame.width, frame.height,
+                          DXGI_FORMAT_B8G8R8A8_UNORM},
+                         stream, pool, preset);
+}
 
-    hr = encoder->Commit();
-    if (FAILED(hr)) {
+bool EncodeJxr(const FrameData& frame, IStream* stream)
+{
+    if (frame.pixels.empty() || (frame.bytesPerPixel != 4 && frame.bytesPerPixel != 8)) {
         return false;
     }
+    return EncodeJxrRows(RowsOf(frame), stream);
+}
 
-    return true;
+namespace {
+
+// Case-insensitive "path ends with ext" (ext includes the dot).
+[[nodiscard]] bool HasExtension(const std::wstring& path, const wchar_t* ext)
+{
+    const size_t len = std::wcslen(ext);
+    return path.size() >= len && ::_wcsicmp(path.c_str() + path.size() - len, ext) == 0;
 }
 
 } // namespace
 
-bool SaveImageInteractive(const FrameData& frame)
+std::optional<std::wstring> PromptSavePath(const FrameData& frame, HdrFormat hdr)
 {
+    const bool hdrFrame = static_cast<DXGI_FORMAT>(frame.format) == DXGI_FORMAT_R16G16B16A16_FLOAT;
+    const bool jxrDefault = hdrFrame && hdr == HdrFormat::Jxr;
+
     nfdchar_t* outPath = nullptr;
-    const nfdresult_t result = NFD_SaveDialog("png", nullptr, &outPath);
+    const nfdresult_t result = NFD_SaveDialog(jxrDefault ? "jxr;png" : "png;jxr", nullptr, &outPath);
 
     if (result != NFD_OKAY || !outPath) {
-        return false;
+        return std::nullopt;
     }
 
     // NFD returns a narrow (UTF-8/ANSI) path; convert to wide for WIC.
@@ -269,49 +416,184 @@ bool SaveImageInteractive(const FrameData& frame)
     std::wstring widePath(static_cast<size_t>(wideLen), L'\0');
     ::MultiByteToWideChar(CP_UTF8, 0, outPath, -1, widePath.data(), wideLen);
     std::free(outPath);
+    while (!widePath.empty() && widePath.back() == L'\0') {
+        widePath.pop_back();
+    }
 
-    // Append .png if the user didn't type an extension.
-    if (widePath.size() >= 5) {
-        auto ext = widePath.substr(widePath.size() - 5);
-        while (!ext.empty() && ext.back() == L'\0') {
-            ext.pop_back();
-        }
-        if (ext.size() < 4 ||
-            (ext[ext.size()-4] != L'.' ||
-             (ext[ext.size()-3] != L'p' && ext[ext.size()-3] != L'P') ||
-             (ext[ext.size()-2] != L'n' && ext[ext.size()-2] != L'N') ||
-             (ext[ext.size()-1] != L'g' && ext[ext.size()-1] != L'G'))) {
-            while (!widePath.empty() && widePath.back() == L'\0') {
-                widePath.pop_back();
-            }
-            widePath += L".png";
+    // Append the default extension if the user didn't type a known one.
+    if (!HasExtension(widePath, L".png") && !HasExtension(widePath, L".jxr")) {
+        widePath += jxrDefault ? L".jxr" : L".png";
+    }
+    return widePath;
+}
+
+bool KeepsHdr(const std::wstring& path)
+{
+    return HasExtension(path, L".jxr");
+}
+
+bool SaveImageToFile(const FrameData& frame, const std::wstring& path, ThreadPool* pool, PngPreset preset)
+{
+    const ScopedTrace trace(TraceStage::Encode, KeepsHdr(path) ? 1 : 0);
+    const ComPtr<IWICImagingFactory> factory = CreateWicFactory();
+    if (!factory) {
+        return false;
+    }
+    const ComPtr<IWICStream> stream = OpenFileStream(factory.Get(), path.c_str());
+    if (!stream) {
+        return false;
+    }
+    if (KeepsHdr(path)) {
+        return EncodeJxr(frame, stream.Get());
+    }
+    return EncodePng(frame, stream.Get(), pool, preset);
+}
+
+// ── Streaming GPU save ──────────────────────────────────────────────
+
+namespace {
+
+// Maps `staging` for reading without holding the (multithread-protected)
+// context while the GPU finishes the copy.
+[[nodiscard]] HRESULT MapWhenReady(ID3D11DeviceContext* ctx, ID3D11Texture2D* staging,
+                                   D3D11_MAPPED_SUBRESOURCE& mapped)
+{
+    for (;;) {
+        const HRESULT hr = ctx->Map(staging, 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+        if (hr != DXGI_ERROR_WAS_STILL_DRAWING) {
+            return hr;
         }
-    } else {
-        while (!widePath.empty() && widePath.back() == L'\0') {
-            widePath.pop_back();
+        ::Sleep(1);
+    }
+}
+
+} // namespace
+
+bool ShouldStreamToFile(const FrameData& frame) noexcept
+{
+    return frame.pixels.empty() && frame.gpuTexture &&
+           static_cast<uint64_t>(frame.width) * frame.height >= kStreamToFilePixels;
+}
+
+bool StreamGpuFrameToFile(const FrameData& frame, const std::wstring& path, ThreadPool* pool, PngPreset preset)
+{
+    const ScopedTrace trace(TraceStage::Encode, KeepsHdr(path) ? 1 : 0);
+    if (!frame.gpuTexture || frame.width == 0 || frame.height == 0) {
+        return false;
+    }
+
+    D3D11_TEXTURE2D_DESC desc{};
+    frame.gpuTexture->GetDesc(&desc);
+    if (desc.Format != DXGI_FORMAT_B8G8R8A8_UNORM && desc.Format != DXGI_FORMAT_R16G16B16A16_FLOAT) {
+        return false;
+    }
+
+    ComPtr<ID3D11Device> device;
+    frame.gpuTexture->GetDevice(&device);
+    ComPtr<ID3D11DeviceContext> ctx;
+    device->GetImmediateContext(&ctx);
+
+    D3D11_TEXTURE2D_DESC stagingDesc{};
+    stagingDesc.Width            = desc.Width;
+    stagingDesc.Height           = desc.Height;
+    stagingDesc.MipLevels        = 1;
+    stagingDesc.ArraySize        = 1;
+    stagingDesc.Format           = desc.Format;
+    stagingDesc.SampleDesc.Count = 1;
+    stagingDesc.Usage            = D3D11_USAGE_STAGING;
+    stagingDesc.CPUAccessFlags   = D3D11_CPU_ACCESS_READ;
+
+    ComPtr<ID3D11Texture2D> staging;
+    if (FAILED(device->CreateTexture2D(&stagingDesc, nullptr, &staging))) {
+        return false;
+    }
+    ctx->CopyResource(staging.Get(), frame.gpuTexture.Get());
+
+    D3D11_MAPPED_SUBRESOURCE mapped{};
+    if (FAILED(MapWhenReady(ctx.Get(), staging.Get(), mapped))) {
+        return false;
+    }
+
+    // The encoder reads the mapped rows directly; FP16 PNG rows are
+    // tone-mapped band by band on the way in.
+    const RowSource src{static_cast<const uint8_t*>(mapped.pData), mapped.RowPitch,
+                        desc.Width, desc.Height, desc.Format, &frame.whiteRegions,
+                        SdrWhiteNitsForFrame(frame)};
+
+    bool ok = false;
+    const ComPtr<IWICImagingFactory> factory = CreateWicFactory();
+    if (factory) {
+        const ComPtr<IWICStream> stream = OpenFileStream(factory.Get(), path.c_str());
+        if (stream) {
+            ok = KeepsHdr(path)
+                ? EncodeJxrRows(src, stream.Get())
+                : EncodePngRows(src, stream.Get(), pool, preset);
         }
-        widePath += L".png";
     }
 
-    return WritePng(frame, widePath.c_str());
+    ctx->Unmap(staging.Get(), 0);
+    return ok;
 }
 
-bool CopyImageToClipboard(const FrameData& frame)
+bool SaveImageInteractive(const FrameData& frame, ThreadPool* pool, PngPreset preset, HdrFormat hdr)
 {
-    if (frame.width == 0 || frame.height == 0) {
+    const auto path = PromptSavePath(frame, hdr);
+    if (!path) {
         return false;
     }
+    return SaveImageToFile(frame, *path, pool, preset);
+}
 
-    // Convert to BGRA8 if needed.
-    std::vector<uint8_t> bgra8;
+const uint8_t* SdrBgra8(const FrameData& frame, ThreadPool* pool)
+{
+    if (frame.pixels.empty()) {
+        return nullptr;
+    }
     const auto fmt = static_cast<DXGI_FORMAT>(frame.format);
-    if (fmt == DXGI_FORMAT_R16G16B16A16_FLOAT && frame.bytesPerPixel == 8) {
-        if (!ScRgb16fToBgra8(frame, bgra8)) {
-            return false;
+    if (fmt == DXGI_FORMAT_B8G8R8A8_UNORM && frame.bytesPerPixel == 4) {
+        return frame.pixels.data();
+    }
+    if (!frame.sdrCache) {
+        auto bgra8 = std::make_shared<PixelBuffer>();
+        if (!ScRgb16fToBgra8(frame, *bgra8, pool)) {
+            return nullptr;
         }
-    } else if (fmt == DXGI_FORMAT_B8G8R8A8_UNORM && frame.bytesPerPixel == 4) {
-        bgra8 = frame.pixels;
-    } else {
+        frame.sdrCache = std::move(bgra8);
+    }
+    return frame.sdrCache->data();
+}
+
+bool ConvertToBgra8(FrameData& frame, ThreadPool* pool)
+{
+    const auto fmt = static_cast<DXGI_FORMAT>(frame.format);
+    if (fmt == DXGI_FORMAT_B8G8R8A8_UNORM && frame.bytesPerPixel == 4) {
+        return true;
+    }
+
+    // Reuse an SDR rendition an earlier output already made.
+    PixelBuffer bgra8;
+    if (frame.sdrCache && frame.sdrCache.use_count() == 1) {
+        bgra8 = std::move(*frame.sdrCache);
+    } else if (!ScRgb16fToBgra8(frame, bgra8, pool)) {
+        return false;
+    }
+    frame.pixels        = std::move(bgra8);
+    frame.sdrCache.reset();
+    frame.gpuTexture.Reset();
+    frame.format        = static_cast<uint32_t>(DXGI_FORMAT_B8G8R8A8_UNORM);
+    frame.bytesPerPixel = 4;
+    return true;
+}
+
+bool CopyImageToClipboard(const FrameData& frame, ThreadPool* pool)
+{
+    const ScopedTrace trace(TraceStage::Clipboard);
+    if (frame.width == 0 || frame.height == 0) {
+        return false;
+    }
+
+    const uint8_t* bgra8 = SdrBgra8(frame, pool);
+    if (!bgra8) {
         return false;
     }
 
@@ -344,13 +626,15 @@ bool CopyImageToClipboard(const FrameData& frame)
 
     // Copy rows in reverse order (top-down source -> bottom-up DIB).
     auto* dst = ptr + sizeof(BITMAPINFOHEADER);
-    for (uint32_t y = 0; y < frame.height; ++y) {
-        const uint32_t srcRow = frame.height - 1 - y;
-        std::memcpy(
-            dst + static_cast<size_t>(y) * stride,
-            bgra8.data() + static_cast<size_t>(srcRow) * stride,
-            stride);
-    }
+    ParallelFor(pool, frame.height, RowsPerBand(frame.width), [&](size_t rowBegin, size_t rowEnd) {
+        for (size_t y = rowBegin; y < rowEnd; ++y) {
+            const size_t srcRow = frame.height - 1 - y;
+            std::memcpy(
+                dst + y * stride,
+                bgra8 + srcRow * stride,
+                stride);
+        }
+    });
 
     ::GlobalUnlock(hMem);
 
@@ -375,54 +659,62 @@ bool CopyImageToClipboard(const FrameData& frame)
 
 // ── Toast thumbnail ─────────────────────────────────────────────────
 
-std::wstring GetThumbnailTempPath()
+void ThumbnailSize(uint32_t width, uint32_t height, uint32_t& thumbW, uint32_t& thumbH) noexcept
 {
+    thumbW = width;
+    thumbH = height;
+    if (thumbW > kThumbnailMaxDim || thumbH > kThumbnailMaxDim) {
+        if (thumbW >= thumbH) {
+            thumbH = static_cast<uint32_t>(uint64_t{thumbH} * kThumbnailMaxDim / thumbW);
+            thumbW = kThumbnailMaxDim;
+        } else {
+            thumbW = static_cast<uint32_t>(uint64_t{thumbW} * kThumbnailMaxDim / thumbH);
+            thumbH = kThumbnailMaxDim;
+        }
+    }
+    if (thumbW == 0) thumbW = 1;
+    if (thumbH == 0) thumbH = 1;
+}
+
+namespace {
+
+// Thumbnail files in rotation: far more than the output queue ever has in
+// flight, and few enough that %TEMP% doesn't fill up.
+constexpr uint32_t kThumbnailFiles = 8;
+
+std::wstring NextThumbnailPath()
+{
+    static std::atomic<uint32_t> next{0};
     wchar_t tempDir[MAX_PATH]{};
     ::GetTempPathW(MAX_PATH, tempDir);
-    return std::wstring(tempDir) + L"ScreenCap_thumb.png";
+    return std::wstring(tempDir) + L"ScreenCap_thumb_" +
+           std::to_wstring(next.fetch_add(1) % kThumbnailFiles) + L".png";
 }
 
-bool WriteThumbnailPng(const FrameData& frame)
+} // namespace
+
+std::wstring WriteThumbnailPng(const FrameData& frame, ThreadPool* pool)
 {
-    // Delete any stale thumbnail from a previous capture.
-    const auto path = GetThumbnailTempPath();
+    const ScopedTrace trace(TraceStage::Thumbnail);
+    // Delete the slot's thumbnail from an earlier capture.
+    const auto path = NextThumbnailPath();
     (void)::DeleteFileW(path.c_str());
 
-    if (frame.width == 0 || frame.height == 0 || frame.pixels.empty()) {
-        return false;
+    if (frame.width == 0 || frame.height == 0) {
+        return {};
     }
 
-    // Get BGRA8 pixels.
-    std::vector<uint8_t> bgra8;
-    const auto fmt = static_cast<DXGI_FORMAT>(frame.format);
-    if (fmt == DXGI_FORMAT_R16G16B16A16_FLOAT && frame.bytesPerPixel == 8) {
-        if (!ScRgb16fToBgra8(frame, bgra8)) return false;
-    } else if (fmt == DXGI_FORMAT_B8G8R8A8_UNORM && frame.bytesPerPixel == 4) {
-        bgra8 = frame.pixels;
-    } else {
-        return false;
-    }
+    const uint8_t* bgra8 = SdrBgra8(frame, pool);
+    if (!bgra8) return {};
 
-    // Calculate scaled dimensions (max 360px on longest edge).
-    constexpr uint32_t kMaxDim = 360;
-    uint32_t thumbW = frame.width;
-    uint32_t thumbH = frame.height;
-    if (thumbW > kMaxDim || thumbH > kMaxDim) {
-        if (thumbW >= thumbH) {
-            thumbH = thumbH * kMaxDim / thumbW;
-            thumbW = kMaxDim;
-        } else {
-            thumbW = thumbW * kMaxDim / thumbH;
-            thumbH = kMaxDim;
-        }
-    }
-    if (thumbW == 0) thumbW = 1;
-    if (thumbH == 0) thumbH = 1;
+    uint32_t thumbW = 0;
+    uint32_t thumbH = 0;
+    ThumbnailSize(frame.width, frame.height, thumbW, thumbH);
 
     ComPtr<IWICImagingFactory> factory;
     HRESULT hr = ::CoCreateInstance(
         CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory));
-    if (FAILED(hr)) return false;
+    if (FAILED(hr)) return {};
 
     // Create WIC bitmap from the full-size BGRA8 data.
     ComPtr<IWICBitmap> bitmap;
@@ -430,58 +722,59 @@ bool WriteThumbnailPng(const FrameData& frame)
         frame.width, frame.height,
         GUID_WICPixelFormat32bppBGRA,
         frame.width * 4,
-        static_cast<UINT>(bgra8.size()),
-        bgra8.data(),
+        frame.width * 4 * frame.height,
+        const_cast<BYTE*>(bgra8),
         &bitmap);
-    if (FAILED(hr)) return false;
+    if (FAILED(hr)) return {};
 
-    // Scale down.
-    ComPtr<IWICBitmapScaler> scaler;
-    hr = factory->CreateBitmapScaler(&scaler);
-    if (FAILED(hr)) return false;
+    // Scale down, unless the caller already did (GPU downsample).
+    ComPtr<IWICBitmapSource> source = bitmap;
+    if (thumbW != frame.width || thumbH != frame.height) {
+        ComPtr<IWICBitmapScaler> scaler;
+        hr = factory->CreateBitmapScaler(&scaler);
+        if (FAILED(hr)) return {};
 
-    hr = scaler->Initialize(bitmap.Get(), thumbW, thumbH, WICBitmapInterpolationModeFant);
-    if (FAILED(hr)) return false;
+        hr = scaler->Initialize(bitmap.Get(), thumbW, thumbH, WICBitmapInterpolationModeFant);
+        if (FAILED(hr)) return {};
+        source = scaler;
+    }
 
     // Encode to PNG.
     ComPtr<IWICStream> stream;
     hr = factory->CreateStream(&stream);
-    if (FAILED(hr)) return false;
+    if (FAILED(hr)) return {};
 
     hr = stream->InitializeFromFilename(path.c_str(), GENERIC_WRITE);
-    if (FAILED(hr)) return false;
+    if (FAILED(hr)) return {};
 
     ComPtr<IWICBitmapEncoder> encoder;
     hr = factory->CreateEncoder(GUID_ContainerFormatPng, nullptr, &encoder);
-    if (FAILED(hr)) return false;
+    if (FAILED(hr)) return {};
 
     hr = encoder->Initialize(stream.Get(), WICBitmapEncoderNoCache);
-    if (FAILED(hr)) return false;
+    if (FAILED(hr)) return {};
 
     ComPtr<IWICBitmapFrameEncode> frameEncode;
-    hr = encoder->CreateNewFrame(&frameEncode, nullptr);
-    if (FAILED(hr)) return false;
-
-    hr = frameEncode->Initialize(nullptr);
-    if (FAILED(hr)) return false;
+    hr = CreatePngFrame(encoder.Get(), PngPreset::Fast, frameEncode);
+    if (FAILED(hr)) return {};
 
     hr = frameEncode->SetSize(thumbW, thumbH);
-    if (FAILED(hr)) return false;
+    if (FAILED(hr)) return {};
 
     WICPixelFormatGUID pixelFormat = GUID_WICPixelFormat32bppBGRA;
     hr = frameEncode->SetPixelFormat(&pixelFormat);
-    if (FAILED(hr)) return false;
+    if (FAILED(hr)) return {};
 
-    hr = frameEncode->WriteSource(scaler.Get(), nullptr);
-    if (FAILED(hr)) return false;
+    hr = frameEncode->WriteSource(source.Get(), nullptr);
+    if (FAILED(hr)) return {};
 
     hr = frameEncode->Commit();
-    if (FAILED(hr)) return false;
+    if (FAILED(hr)) return {};
 
     hr = encoder->Commit();
-    if (FAILED(hr)) return false;
+    if (FAILED(hr)) return {};
 
-    return true;
+    return path;
 }
 
 } // namespace screencap::capture
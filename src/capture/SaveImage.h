@@ -2,23 +2,101 @@
 
 #include "capture/FrameData.h"
 
+#include <objidl.h>
+
+#include <optional>
 #include <string>
 
 namespace screencap::capture {
 
-// Shows a Save dialog (NFD) and writes the frame as PNG via WIC.
+class ThreadPool;
+
+// The optional pool spreads pixel conversion and row copies across cores;
+// without one everything runs on the calling thread.
+
+// PNG encoder tuning (WIC FilterOption).  Fast skips per-row filter
+// selection, which dominates encode time on large captures, at the cost
+// of bigger files; Compact (the default for saves) lets the encoder pick
+// the best filter per row.
+enum class PngPreset {
+    Fast,
+    Compact,
+};
+
+// Lossless HDR file format offered for FP16 frames.  JPEG XR stores the
+// scRGB buffer as-is (64bppRGBAHalf): no tone map, no per-pixel work.
+enum class HdrFormat {
+    None,   // always PNG (FP16 frames are tone-mapped to SDR)
+    Jxr,
+};
+
+// Shows a Save dialog (NFD) and writes the frame via WIC: PNG by default,
+// JPEG XR if the chosen path ends in .jxr.  With HdrFormat::Jxr, FP16
+// frames default to .jxr.
 // Returns true if saved successfully, false if cancelled or error.
-[[nodiscard]] bool SaveImageInteractive(const FrameData& frame);
+[[nodiscard]] bool SaveImageInteractive(const FrameData& frame, ThreadPool* pool = nullptr,
+                                        PngPreset preset = PngPreset::Compact,
+                                        HdrFormat hdr = HdrFormat::None);
+
+// The two halves of SaveImageInteractive(), for callers that write the
+// file elsewhere (e.g. OutputQueue).  PromptSavePath returns the chosen
+// path with a .png or .jxr extension, or std::nullopt if cancelled.
+// SaveImageToFile writes JPEG XR for .jxr paths and PNG otherwise.
+[[nodiscard]] std::optional<std::wstring> PromptSavePath(const FrameData& frame,
+                                                         HdrFormat hdr = HdrFormat::None);
+[[nodiscard]] bool SaveImageToFile(const FrameData& frame, const std::wstring& path,
+                                   ThreadPool* pool = nullptr, PngPreset preset = PngPreset::Compact);
+
+// The encoders behind SaveImageToFile(), writing to any stream (file,
+// HGLOBAL for the clipboard, ...).  EncodePng tone-maps FP16 frames to SDR;
+// EncodeJxr stores the pixels as-is.
+[[nodiscard]] bool EncodePng(const FrameData& frame, IStream* stream,
+                             ThreadPool* pool = nullptr, PngPreset preset = PngPreset::Compact);
+[[nodiscard]] bool EncodeJxr(const FrameData& frame, IStream* stream);
 
-// Copies the frame to the Windows clipboard as a CF_DIB bitmap.
+// Frames at least this large (about 8K × 4K) are saved by streaming from
+// the GPU instead of being read back into a CPU buffer first.
+inline constexpr uint64_t kStreamToFilePixels = 32ull * 1024 * 1024;
+
+// True for GPU-only frames of kStreamToFilePixels or more.
+[[nodiscard]] bool ShouldStreamToFile(const FrameData& frame) noexcept;
+
+// SaveImageToFile() for a GPU frame without a CPU copy: the texture goes to
+// a staging texture whose mapped rows are fed to the encoder directly (FP16
+// PNG rows are tone-mapped through a small band buffer), so peak memory is
+// the staging texture plus a few MB.  Uses the device's immediate context,
+// so call it from one thread at a time or on a multithread-protected device.
+[[nodiscard]] bool StreamGpuFrameToFile(const FrameData& frame, const std::wstring& path,
+                                        ThreadPool* pool = nullptr, PngPreset preset = PngPreset::Compact);
+
+// True if SaveImageToFile() stores `path` with the FP16 pixels as-is.
+[[nodiscard]] bool KeepsHdr(const std::wstring& path);
+
+// BGRA8 pixels of the frame: its own for BGRA8 frames, otherwise the SDR
+// rendition in frame.sdrCache, converted on first call.  Returns nullptr
+// for frames without CPU pixels or in other formats.
+[[nodiscard]] const uint8_t* SdrBgra8(const FrameData& frame, ThreadPool* pool = nullptr);
+
+// Tone-map an FP16 frame's CPU pixels to SDR BGRA8 in place (no-op for
+// BGRA8 frames).  Returns false for other formats.
+[[nodiscard]] bool ConvertToBgra8(FrameData& frame, ThreadPool* pool = nullptr);
+
+// Copies the frame to the Windows clipboard as a CF_DIB bitmap, rendered
+// immediately (see ClipboardImage for delayed rendering).
 // Returns true on success.
-[[nodiscard]] bool CopyImageToClipboard(const FrameData& frame);
+[[nodiscard]] bool CopyImageToClipboard(const FrameData& frame, ThreadPool* pool = nullptr);
+
+// Longest edge of the toast thumbnail, in pixels.
+inline constexpr uint32_t kThumbnailMaxDim = 360;
 
-// Write a small thumbnail PNG to %TEMP% for toast notifications.
-// Returns true on success.  The output path is GetThumbnailTempPath().
-bool WriteThumbnailPng(const FrameData& frame);
+// Thumbnail size for a width×height frame: aspect kept, never upscaled.
+void ThumbnailSize(uint32_t width, uint32_t height, uint32_t& thumbW, uint32_t& thumbH) noexcept;
 
-// Deterministic temp path for the toast thumbnail.
-[[nodiscard]] std::wstring GetThumbnailTempPath();
+// Write a small thumbnail PNG to %TEMP% for toast notifications
+// (always PngPreset::Fast).  A frame already at ThumbnailSize() (e.g. from
+// GpuToneMapper::DownsampleToBgra8) is encoded without rescaling.
+// Each call gets its own file, so overlapping jobs never share one; the
+// names rotate through a few slots.  Returns the path, or empty on failure.
+[[nodiscard]] std::wstring WriteThumbnailPng(const FrameData& frame, ThreadPool* pool = nullptr);
 
 } // namespace screencap::capture
@@ -0,0 +1,111 @@
+#include "capture/ThreadPool.h"
+
+#include <algorithm>
+
+namespace screencap::capture {
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+    if (threadCount == 0) {
+        const unsigned hw = std::thread::hardware_concurrency();
+        threadCount = (hw > 1) ? hw - 1 : 0;
+    }
+
+    workers_.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers_.emplace_back([this] { WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& t : workers_) {
+        t.join();
+    }
+}
+
+void ThreadPool::RunChunks(Job& job)
+{
+    for (;;) {
+        const size_t begin = job.next.fetch_add(job.grain);
+        if (begin >= job.count) return;
+        const size_t end = (std::min)(job.count, begin + job.grain);
+
+        (*job.fn)(begin, end);
+
+        if (job.done.fetch_add(end - begin) + (end - begin) == job.count) {
+            std::lock_guard lock(mutex_);
+            finished_.notify_all();
+        }
+    }
+}
+
+void ThreadPool::WorkerLoop()
+{
+    uint64_t seen = 0;
+    for (;;) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock lock(mutex_);
+            wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+            job = job_;
+        }
+        // A late wake-up may find the job already drained (or gone), in
+        // which case RunChunks returns without touching fn.
+        if (job) {
+            RunChunks(*job);
+        }
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn)
+{
+    if (count == 0) return;
+    grain = (std::max)(grain, size_t{1});
+
+    // Not worth waking anyone for a single chunk.
+    if (workers_.empty() || count <= grain) {
+        fn(0, count);
+        return;
+    }
+
+    std::lock_guard run(runMutex_);
+
+    auto job = std::make_shared<Job>();
+    job->fn    = &fn;
+    job->count = count;
+    job->grain = grain;
+
+    {
+        std::lock_guard lock(mutex_);
+        job_ = job;
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    // The calling thread works too rather than sitting idle.
+    RunChunks(*job);
+
+    std::unique_lock lock(mutex_);
+    finished_.wait(lock, [&] { return job->done.load() == job->count; });
+    job_.reset();
+}
+
+void ParallelFor(ThreadPool* pool, size_t count, size_t grain,
+                 const std::function<void(size_t, size_t)>& fn)
+{
+    if (pool) {
+        pool->ParallelFor(count, grain, fn);
+    } else if (count > 0) {
+        fn(0, count);
+    }
+}
+
+} // namespace screencap::capture
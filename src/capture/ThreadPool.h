@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace screencap::capture {
+
+// Small persistent worker pool for data-parallel image work (conversion,
+// row flips).  Create once and keep it alive between captures so no
+// threads are spawned on the capture path.
+//
+// ParallelFor() splits [0, count) into chunks; idle workers and the calling
+// thread keep taking the next unclaimed chunk until none are left, so a
+// slow band never holds the others back.
+class ThreadPool final {
+public:
+    // threadCount = 0 → one worker per hardware thread, minus the caller.
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    // Run fn(begin, end) over [0, count) in chunks of at most `grain` items
+    // and block until all chunks are done.  Calls from several threads are
+    // serialised.  fn must not throw and must not call back into the pool.
+    void ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+    [[nodiscard]] unsigned WorkerCount() const noexcept { return static_cast<unsigned>(workers_.size()); }
+
+private:
+    struct Job {
+        const std::function<void(size_t, size_t)>* fn{};
+        size_t              count{};
+        size_t              grain{};
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+    };
+
+    void WorkerLoop();
+    void RunChunks(Job& job);
+
+    std::vector<std::thread>  workers_;
+    std::mutex                runMutex_;   // one ParallelFor at a time
+    std::mutex                mutex_;
+    std::condition_variable   wake_;
+    std::condition_variable   finished_;
+    std::shared_ptr<Job>      job_;
+    uint64_t                  generation_{0};
+    bool                      stop_{false};
+};
+
+// ParallelFor on `pool`, or inline on the calling thread if pool is null.
+void ParallelFor(ThreadPool* pool, size_t count, size_t grain,
+                 const std::function<void(size_t, size_t)>& fn);
+
+} // namespace screencap::capture
@@ -0,0 +1,219 @@
+#include "capture/Trace.h"
+
+#include <windows.h>
+#include <TraceLoggingProvider.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+TRACELOGGING_DEFINE_PROVIDER(
+    g_screenCapProvider,
+    "ScreenCap",
+    // {7c2f4a91-5d3e-4b8a-9e16-0f2c8d4b7a35}
+    (0x7c2f4a91, 0x5d3e, 0x4b8a, 0x9e, 0x16, 0x0f, 0x2c, 0x8d, 0x4b, 0x7a, 0x35));
+
+namespace screencap::capture {
+namespace {
+
+constexpr size_t kStageCount = static_cast<size_t>(TraceStage::Count);
+constexpr size_t kWindow = 256;   // samples kept per stage
+
+// The last kWindow durations of one stage.
+struct StageWindow {
+    std::mutex mutex;
+    std::array<uint64_t, kWindow> us{};
+    size_t next{0};
+    size_t filled{0};
+    uint64_t total{0};
+};
+
+std::array<StageWindow, kStageCount> g_stats;
+std::atomic<bool> g_statsEnabled{false};
+
+void AddSample(TraceStage stage, uint64_t us) noexcept
+{
+    auto& w = g_stats[static_cast<size_t>(stage)];
+    std::lock_guard lock(w.mutex);
+    w.us[w.next] = us;
+    w.next = (w.next + 1) % kWindow;
+    w.filled = (std::min)(w.filled + 1, kWindow);
+    ++w.total;
+}
+
+} // namespace
+
+const wchar_t* TraceStageName(TraceStage stage) noexcept
+{
+    switch (stage) {
+    case TraceStage::HotkeyToPreview: return L"HotkeyToPreview";
+    case TraceStage::KeyToAcquire:    return L"KeyToAcquire";
+    case TraceStage::Acquire:         return L"Acquire";
+    case TraceStage::CompositeGpu:    return L"CompositeGpu";
+    case TraceStage::ToneMapGpu:      return L"ToneMapGpu";
+    case TraceStage::Readback:        return L"Readback";
+    case TraceStage::ToneMapCpu:      return L"ToneMapCpu";
+    case TraceStage::Encode:          return L"Encode";
+    case TraceStage::Clipboard:       return L"Clipboard";
+    case TraceStage::Thumbnail:       return L"Thumbnail";
+    case TraceStage::Output:          return L"Output";
+    case TraceStage::Count:           break;
+    }
+    return L"?";
+}
+
+void TraceRegister() noexcept
+{
+    (void)TraceLoggingRegister(g_screenCapProvider);
+}
+
+void TraceUnregister() noexcept
+{
+    TraceLoggingUnregister(g_screenCapProvider);
+}
+
+bool TraceActive() noexcept
+{
+    return g_statsEnabled.load(std::memory_order_relaxed) ||
+           TraceLoggingProviderEnabled(g_screenCapProvider, 0, 0);
+}
+
+void SetTraceStatsEnabled(bool enabled) noexcept
+{
+    g_statsEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool TraceStatsEnabled() noexcept
+{
+    return g_statsEnabled.load(std::memory_order_relaxed);
+}
+
+std::wstring TraceStatsReport()
+{
+    std::wstring report;
+    std::vector<uint64_t> sorted;
+    for (size_t i = 0; i < kStageCount; ++i) {
+        auto& w = g_stats[i];
+        uint64_t total = 0;
+        {
+            std::lock_guard lock(w.mutex);
+            sorted.assign(w.us.begin(), w.us.begin() + w.filled);
+            total = w.total;
+        }
+        if (sorted.empty()) continue;
+        std::sort(sorted.begin(), sorted.end());
+
+        const auto ms = [&](size_t idx) { return static_cast<double>(sorted[idx]) / 1000.0; };
+        wchar_t line[160];
+        swprintf_s(line, L"%-16s n=%-5llu p50 %8.2f  p95 %8.2f  max %8.2f ms\n",
+                   TraceStageName(static_cast<TraceStage>(i)),
+                   static_cast<unsigned long long>(total),
+                   ms(sorted.size() / 2), ms(sorted.size() * 95 / 100), ms(sorted.size() - 1));
+        report += line;
+    }
+    return report;
+}
+
+int64_t TraceNow() noexcept
+{
+    LARGE_INTEGER t{};
+    ::QueryPerformanceCounter(&t);
+    return t.QuadPart;
+}
+
+int64_t TraceFrequency() noexcept
+{
+    static const int64_t freq = [] {
+        LARGE_INTEGER f{};
+        ::QueryPerformanceFrequency(&f);
+        return f.QuadPart;
+    }();
+    return freq;
+}
+
+void TraceRecord(TraceStage stage, int64_t start, uint32_t index) noexcept
+{
+    if (!TraceActive()) return;
+    const int64_t ticks = TraceNow() - start;
+    TraceRecordDuration(stage, static_cast<uint64_t>((std::max)(ticks, int64_t{0})) * 1000000 / TraceFrequency(),
+                        index);
+}
+
+void TraceRecordDuration(TraceStage stage, uint64_t microseconds, uint32_t index) noexcept
+{
+    TraceLoggingWrite(
+        g_screenCapProvider,
+        "Stage",
+        TraceLoggingWideString(TraceStageName(stage), "Stage"),
+        TraceLoggingUInt32(index, "Index"),
+        TraceLoggingUInt64(microseconds, "DurationUs"));
+
+    if (g_statsEnabled.load(std::memory_order_relaxed)) {
+        AddSample(stage, microseconds);
+    }
+}
+
+// ── GpuTimer ────────────────────────────────────────────────────────
+
+void GpuTimer::Begin(ID3D11DeviceContext* ctx)
+{
+    Collect(ctx);
+    if (pending_ || !TraceActive()) return;   // previous one still in flight
+
+    if (!disjoint_) {
+        Microsoft::WRL::ComPtr<ID3D11Device> device;
+        ctx->GetDevice(&device);
+        D3D11_QUERY_DESC desc{D3D11_QUERY_TIMESTAMP_DISJOINT, 0};
+        if (FAILED(device->CreateQuery(&desc, &disjoint_))) return;
+        desc.Query = D3D11_QUERY_TIMESTAMP;
+        if (FAILED(device->CreateQuery(&desc, &begin_)) || FAILED(device->CreateQuery(&desc, &end_))) {
+            Reset();
+            return;
+        }
+    }
+
+    ctx->Begin(disjoint_.Get());
+    ctx->End(begin_.Get());
+    running_ = true;
+}
+
+void GpuTimer::End(ID3D11DeviceContext* ctx)
+{
+    if (!running_) return;
+    ctx->End(end_.Get());
+    ctx->End(disjoint_.Get());
+    running_ = false;
+    pending_ = true;
+}
+
+void GpuTimer::Collect(ID3D11DeviceContext* ctx)
+{
+    if (!pending_) return;
+
+    D3D11_QUERY_DATA_TIMESTAMP_DISJOINT dj{};
+    if (ctx->GetData(disjoint_.Get(), &dj, sizeof(dj), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) return;
+    UINT64 t0 = 0, t1 = 0;
+    if (ctx->GetData(begin_.Get(), &t0, sizeof(t0), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+        ctx->GetData(end_.Get(), &t1, sizeof(t1), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+        return;
+    }
+    pending_ = false;
+
+    // Disjoint: the GPU clock changed frequency mid-measurement.
+    if (dj.Disjoint || dj.Frequency == 0 || t1 < t0) return;
+    TraceRecordDuration(stage_, (t1 - t0) * 1000000 / dj.Frequency);
+}
+
+void GpuTimer::Reset() noexcept
+{
+    disjoint_.Reset();
+    begin_.Reset();
+    end_.Reset();
+    running_ = false;
+    pending_ = false;
+}
+
+} // namespace screencap::capture
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+
+#include <cstdint>
+#include <string>
+
+namespace screencap::capture {
+
+// ── Hot-path latency tracing ────────────────────────────────────────
+//
+// Each stage below is written as a TraceLogging event for WPA: provider
+// "ScreenCap" {7c2f4a91-5d3e-4b8a-9e16-0f2c8d4b7a35}, event "Stage",
+// fields Stage / Index / DurationUs.  For example:
+//
+//   tracelog -start sc -f sc.etl -guid #7c2f4a91-5d3e-4b8a-9e16-0f2c8d4b7a35
+//
+// and, when enabled from the tray menu, kept in a rolling per-stage window
+// for TraceStatsReport().  With neither a listener nor the stats enabled a
+// stage costs one QueryPerformanceCounter.  GPU stages are measured with
+// timestamp queries and reported a capture later, so they never stall.
+
+enum class TraceStage : uint32_t {
+    HotkeyToPreview,  // PrtScn / menu → preview on screen
+    KeyToAcquire,     // PrtScn → desktop frozen on the key-down capture thread
+    Acquire,          // AcquireNextFrame, Index = output
+    CompositeGpu,     // blits / BlitConvertedGPU into the composite (GPU time)
+    ToneMapGpu,       // GpuToneMapper pass (GPU time)
+    Readback,         // ReadbackPixels (copy + map + rows)
+    ToneMapCpu,       // ScRgb16fToBgra8
+    Encode,           // WIC encode + write of a saved file, Index = 1 for JPEG XR, 2 = a video frame
+    Clipboard,        // clipboard copy / offer, or building one delayed format (Index = format)
+    Thumbnail,        // toast thumbnail PNG
+    Output,           // OutputQueue submit → completion
+    Count
+};
+
+[[nodiscard]] const wchar_t* TraceStageName(TraceStage stage) noexcept;
+
+// Provider registration, once per process.
+void TraceRegister() noexcept;
+void TraceUnregister() noexcept;
+
+// True while an ETW session listens or the stats are enabled.
+[[nodiscard]] bool TraceActive() noexcept;
+
+// The rolling per-stage window (tray menu); off by default.
+void SetTraceStatsEnabled(bool enabled) noexcept;
+[[nodiscard]] bool TraceStatsEnabled() noexcept;
+
+// Count, median, 95th percentile and max per stage, one line each.
+[[nodiscard]] std::wstring TraceStatsReport();
+
+// QueryPerformanceCounter ticks.
+[[nodiscard]] int64_t TraceNow() noexcept;
+
+// TraceNow() ticks per second.
+[[nodiscard]] int64_t TraceFrequency() noexcept;
+
+// Record a stage that started at `start` (TraceNow()) and ends now, or one
+// that took `microseconds`.
+void TraceRecord(TraceStage stage, int64_t start, uint32_t index = 0) noexcept;
+void TraceRecordDuration(TraceStage stage, uint64_t microseconds, uint32_t index = 0) noexcept;
+
+// Records its stage when it goes out of scope.
+class ScopedTrace final {
+public:
+    explicit ScopedTrace(TraceStage stage, uint32_t index = 0) noexcept
+        : stage_(stage), index_(index), start_(TraceNow()) {}
+    ~ScopedTrace() { TraceRecord(stage_, start_, index_); }
+
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+private:
+    TraceStage stage_;
+    uint32_t   index_;
+    int64_t    start_;
+};
+
+// GPU time of the commands between Begin() and End(), via a disjoint /
+// timestamp query pair.  The result is collected without waiting at the
+// next Begin() (or Collect()); a measurement still in flight then is
+// skipped rather than waited for.  Use from one thread at a time.
+class GpuTimer final {
+public:
+    explicit GpuTimer(TraceStage stage) noexcept : stage_(stage) {}
+
+    void Begin(ID3D11DeviceContext* ctx);
+    void End(ID3D11DeviceContext* ctx);
+    void Collect(ID3D11DeviceContext* ctx);
+
+    // Drop the queries (device change).
+    void Reset() noexcept;
+
+private:
+    TraceStage stage_;
+    Microsoft::WRL::ComPtr<ID3D11Query> disjoint_;
+    Microsoft::WRL::ComPtr<ID3D11Query> begin_;
+    Microsoft::WRL::ComPtr<ID3D11Query> end_;
+    bool running_{false};
+    bool pending_{false};
+};
+
+} // namespace screencap::capture
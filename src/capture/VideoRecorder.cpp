@@ -0,0 +1,527 @@
+#include "capture/VideoRecorder.h"
+#include "capture/ConvertShader.h"
+#include "capture/Trace.h"
+
+#include <objbase.h>
+#include <codecapi.h>
+#include <mfapi.h>
+#include <mfidl.h>
+#include <mfreadwrite.h>
+
+#include <algorithm>
+#include <chrono>
+
+using Microsoft::WRL::ComPtr;
+
+namespace screencap::capture {
+namespace {
+
+constexpr UINT kThreadGroupSize = 16;
+
+// How long Stop() waits for the encoder to give the samples back.
+constexpr auto kSampleDrainTimeout = std::chrono::seconds(2);
+
+// Largest frame the hardware encoders take (H.264 level 5.1 / HEVC level 6).
+constexpr uint32_t kMaxH264Width  = 4096;
+constexpr uint32_t kMaxH264Height = 2304;
+constexpr uint32_t kMaxHevcWidth  = 8192;
+constexpr uint32_t kMaxHevcHeight = 4320;
+
+// Constant buffer layout matching the compute shader's VideoParams.
+struct VideoParams {
+    int      width, height;
+    float    scale;
+    uint32_t hdr10;
+};
+
+// Fit width×height into the codec's limit, keeping the aspect ratio;
+// 4:2:0 chroma needs even sizes.
+void EncodedSize(uint32_t width, uint32_t height, VideoCodec codec, uint32_t& outW, uint32_t& outH)
+{
+    const bool hevc = codec == VideoCodec::Hevc;
+    const double maxW = hevc ? kMaxHevcWidth : kMaxH264Width;
+    const double maxH = hevc ? kMaxHevcHeight : kMaxH264Height;
+    const double fit = (std::min)({1.0, maxW / width, maxH / height});
+    outW = (std::max)(2u, static_cast<uint32_t>(width * fit) & ~1u);
+    outH = (std::max)(2u, static_cast<uint32_t>(height * fit) & ~1u);
+}
+
+uint32_t DefaultBitrate(uint32_t width, uint32_t height, uint32_t fps, VideoCodec codec) noexcept
+{
+    // Bits per pixel per frame; screen content compresses well.
+    const double bpp = codec == VideoCodec::Hevc ? 0.07 : 0.1;
+    const double bps = static_cast<double>(width) * height * fps * bpp;
+    return static_cast<uint32_t>((std::clamp)(bps, 2.0e6, 150.0e6));
+}
+
+// Colour description shared by the input and output types.
+void SetColorAttributes(IMFMediaType* type, bool hdr10)
+{
+    (void)type->SetUINT32(MF_MT_VIDEO_PRIMARIES, hdr10 ? MFVideoPrimaries_BT2020 : MFVideoPrimaries_BT709);
+    (void)type->SetUINT32(MF_MT_TRANSFER_FUNCTION, hdr10 ? MFVideoTransFunc_2084 : MFVideoTransFunc_sRGB);
+    (void)type->SetUINT32(MF_MT_YUV_MATRIX, hdr10 ? MFVideoTransferMatrix_BT2020_10 : MFVideoTransferMatrix_BT709);
+    (void)type->SetUINT32(MF_MT_VIDEO_NOMINAL_RANGE, MFNominalRange_16_235);
+}
+
+ComPtr<IMFMediaType> CreateVideoType(const GUID& subtype, uint32_t width, uint32_t height, uint32_t fps,
+                                     bool hdr10)
+{
+    ComPtr<IMFMediaType> type;
+    if (FAILED(::MFCreateMediaType(&type))) return nullptr;
+    (void)type->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
+    (void)type->SetGUID(MF_MT_SUBTYPE, subtype);
+    (void)type->SetUINT32(MF_MT_INTERLACE_MODE, MFVideoInterlace_Progressive);
+    (void)::MFSetAttributeSize(type.Get(), MF_MT_FRAME_SIZE, width, height);
+    (void)::MFSetAttributeRatio(type.Get(), MF_MT_FRAME_RATE, fps, 1);
+    (void)::MFSetAttributeRatio(type.Get(), MF_MT_PIXEL_ASPECT_RATIO, 1, 1);
+    SetColorAttributes(type.Get(), hdr10);
+    return type;
+}
+
+} // namespace
+
+// ── Sample tracking ─────────────────────────────────────────────────
+//
+// A tracked sample whose reference count drops to zero is not destroyed:
+// it hands itself to this callback instead, on whichever thread or work
+// queue let go of it last.  Media Foundation and the encoder may keep the
+// sample, and views of its texture, for as long as they need; the surface
+// is reused only once they are done.
+class VideoRecorder::SampleTracker final : public IMFAsyncCallback {
+public:
+    explicit SampleTracker(VideoRecorder* owner) noexcept : owner_(owner) {}
+
+    // Samples that come back after this are simply released.
+    void Detach()
+    {
+        std::lock_guard lock(mutex_);
+        owner_ = nullptr;
+    }
+
+    STDMETHODIMP QueryInterface(REFIID iid, void** out) override
+    {
+        if (!out) return E_POINTER;
+        if (iid == __uuidof(IUnknown) || iid == __uuidof(IMFAsyncCallback)) {
+            *out = static_cast<IMFAsyncCallback*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *out = nullptr;
+        return E_NOINTERFACE;
+    }
+    STDMETHODIMP_(ULONG) AddRef() override { return ++refs_; }
+    STDMETHODIMP_(ULONG) Release() override
+    {
+        const ULONG refs = --refs_;
+        if (refs == 0) delete this;
+        return refs;
+    }
+
+    STDMETHODIMP GetParameters(DWORD*, DWORD*) override { return E_NOTIMPL; }
+    STDMETHODIMP Invoke(IMFAsyncResult* result) override
+    {
+        ComPtr<IUnknown> object;
+        ComPtr<IMFSample> sample;
+        if (FAILED(result->GetObject(&object)) || FAILED(object.As(&sample))) return S_OK;
+        std::lock_guard lock(mutex_);
+        if (owner_) owner_->OnSampleFree(sample.Get());
+        return S_OK;
+    }
+
+private:
+    std::mutex         mutex_;
+    VideoRecorder*     owner_;
+    std::atomic<ULONG> refs_{1};
+};
+
+VideoRecorder::~VideoRecorder()
+{
+    (void)Stop();
+}
+
+bool VideoRecorder::Start(ID3D11Device* device, const std::wstring& path,
+                          uint32_t width, uint32_t height, const Options& options, Tick onTick)
+{
+    if (IsRecording() || !device || width < 2 || height < 2) return false;
+
+    options_ = options;
+    options_.fps = (std::clamp)(options_.fps, 1u, 240u);
+    if (options_.codec == VideoCodec::H264) options_.hdr10 = false;
+
+    device_ = device;
+    device_->GetImmediateContext(&ctx_);
+    srcWidth_ = width;
+    srcHeight_ = height;
+    EncodedSize(width, height, options_.codec, width_, height_);
+
+    // Wrap the GPU surfaces in samples: the encoder's colour conversion
+    // has to run on this device.  The capture device is multithread-
+    // protected, which the DXGI device manager requires.
+    if (FAILED(device_->CreateComputeShader(kScRgbToVideoCS, sizeof(kScRgbToVideoCS), nullptr, &cs_)) ||
+        !CreateSurfaces()) {
+        (void)Stop();
+        return false;
+    }
+
+    if (FAILED(::MFStartup(MF_VERSION, MFSTARTUP_LITE))) {
+        (void)Stop();
+        return false;
+    }
+    mfStarted_ = true;
+
+    if (!CreateSamples() || !CreateWriter(path)) {
+        (void)Stop();
+        return false;
+    }
+    path_ = path;
+
+    firstFrameAt_ = 0;
+    lastTime_ = -1;
+    written_ = 0;
+    dropped_ = 0;
+    stop_ = false;
+    onTick_ = std::move(onTick);
+    tickPending_ = false;
+    paceStop_ = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+    encodeThread_ = std::thread([this] {
+        // The sink writer needs COM on this thread.
+        const HRESULT hr = ::CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        Encode();
+        if (SUCCEEDED(hr)) ::CoUninitialize();
+    });
+    if (paceStop_ && onTick_) {
+        paceThread_ = std::thread([this] { Pace(); });
+    }
+    return true;
+}
+
+bool VideoRecorder::Stop()
+{
+    if (paceStop_) ::SetEvent(paceStop_);
+    if (paceThread_.joinable()) paceThread_.join();
+    if (paceStop_) {
+        ::CloseHandle(paceStop_);
+        paceStop_ = nullptr;
+    }
+
+    // The encoder drains the queue before it sees stop_.
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    if (encodeThread_.joinable()) encodeThread_.join();
+
+    bool ok = false;
+    if (writer_) {
+        ok = written_ > 0 && SUCCEEDED(writer_->Finalize());
+        writer_.Reset();
+        if (!ok) (void)::DeleteFileW(path_.c_str());
+    }
+
+    // Releasing the writer gives the samples back; don't wait forever on
+    // one that is stuck somewhere in the pipeline.
+    if (tracker_) {
+        {
+            std::unique_lock lock(mutex_);
+            (void)freed_.wait_for(lock, kSampleDrainTimeout, [&] {
+                return std::none_of(surfaces_.begin(), surfaces_.end(), [](const Surface& s) { return s.busy; });
+            });
+        }
+        tracker_->Detach();
+        tracker_.Reset();
+    }
+
+    queue_.clear();
+    for (auto& s : surfaces_) s = {};
+    manager_.Reset();
+    sampler_.Reset();
+    params_.Reset();
+    cs_.Reset();
+    ctx_.Reset();
+    device_.Reset();
+    onTick_ = nullptr;
+
+    if (mfStarted_) {
+        (void)::MFShutdown();
+        mfStarted_ = false;
+    }
+    return ok;
+}
+
+bool VideoRecorder::CreateSurfaces()
+{
+    const DXGI_FORMAT format = options_.hdr10 ? DXGI_FORMAT_R10G10B10A2_UNORM : DXGI_FORMAT_B8G8R8A8_UNORM;
+
+    // Typed UAV stores to BGRA8 are optional in D3D11 (see GpuToneMapper).
+    UINT support = 0;
+    if (FAILED(device_->CheckFormatSupport(format, &support)) ||
+        !(support & D3D11_FORMAT_SUPPORT_TYPED_UNORDERED_ACCESS_VIEW)) {
+        return false;
+    }
+
+    D3D11_TEXTURE2D_DESC desc{};
+    desc.Width = width_;
+    desc.Height = height_;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    // Render target: the video processor reads DXGI surfaces as input views.
+    desc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+
+    for (auto& s : surfaces_) {
+        if (FAILED(device_->CreateTexture2D(&desc, nullptr, &s.tex)) ||
+            FAILED(device_->CreateUnorderedAccessView(s.tex.Get(), nullptr, &s.uav))) {
+            return false;
+        }
+    }
+
+    D3D11_BUFFER_DESC cbDesc{};
+    cbDesc.ByteWidth = sizeof(VideoParams);
+    cbDesc.Usage = D3D11_USAGE_DEFAULT;
+    cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    if (FAILED(device_->CreateBuffer(&cbDesc, nullptr, &params_))) return false;
+
+    D3D11_SAMPLER_DESC sd{};
+    sd.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    sd.AddressU = sd.AddressV = sd.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    sd.MaxLOD = D3D11_FLOAT32_MAX;
+    if (FAILED(device_->CreateSamplerState(&sd, &sampler_))) return false;
+
+    // Constant for the whole recording.
+    const VideoParams params{
+        static_cast<int>(width_), static_cast<int>(height_),
+        options_.hdr10 ? 80.0f / 10000.0f
+                       : 80.0f / ((options_.sdrWhiteNits > 0.0f) ? options_.sdrWhiteNits : 80.0f),
+        options_.hdr10 ? 1u : 0u};
+    ctx_->UpdateSubresource(params_.Get(), 0, nullptr, &params, 0, 0);
+    return true;
+}
+
+bool VideoRecorder::CreateSamples()
+{
+    tracker_.Attach(new SampleTracker(this));
+    for (auto& s : surfaces_) {
+        ComPtr<IMFMediaBuffer> buffer;
+        ComPtr<IMF2DBuffer> buffer2d;
+        ComPtr<IMFTrackedSample> tracked;
+        DWORD length = 0;
+        if (FAILED(::MFCreateDXGISurfaceBuffer(__uuidof(ID3D11Texture2D), s.tex.Get(), 0, FALSE, &buffer)) ||
+            FAILED(buffer.As(&buffer2d)) ||
+            FAILED(buffer2d->GetContiguousLength(&length)) ||
+            FAILED(buffer->SetCurrentLength(length)) ||
+            FAILED(::MFCreateTrackedSample(&tracked)) ||
+            FAILED(tracked.As(&s.sample)) ||
+            FAILED(s.sample->AddBuffer(buffer.Get()))) {
+            return false;
+        }
+        s.tracked = s.sample.Get();
+    }
+    return true;
+}
+
+void VideoRecorder::OnSampleFree(IMFSample* sample)
+{
+    {
+        std::lock_guard lock(mutex_);
+        for (auto& s : surfaces_) {
+            if (s.tracked == sample) {
+                s.sample = sample;
+                s.busy = false;
+                break;
+            }
+        }
+    }
+    freed_.notify_all();
+}
+
+bool VideoRecorder::CreateWriter(const std::wstring& path)
+{
+    UINT token = 0;
+    if (FAILED(::MFCreateDXGIDeviceManager(&token, &manager_)) ||
+        FAILED(manager_->ResetDevice(device_.Get(), token))) {
+        return false;
+    }
+
+    ComPtr<IMFAttributes> attrs;
+    if (FAILED(::MFCreateAttributes(&attrs, 3))) return false;
+    (void)attrs->SetUINT32(MF_READWRITE_ENABLE_HARDWARE_TRANSFORMS, TRUE);
+    (void)attrs->SetUnknown(MF_SINK_WRITER_D3D_MANAGER, manager_.Get());
+    (void)attrs->SetGUID(MF_TRANSCODE_CONTAINERTYPE, MFTranscodeContainerType_MPEG4);
+
+    if (FAILED(::MFCreateSinkWriterFromURL(path.c_str(), nullptr, attrs.Get(), &writer_))) return false;
+
+    const bool hevc = options_.codec == VideoCodec::Hevc;
+    auto output = CreateVideoType(hevc ? MFVideoFormat_HEVC : MFVideoFormat_H264,
+                                  width_, height_, options_.fps, options_.hdr10);
+    auto input = CreateVideoType(options_.hdr10 ? MFVideoFormat_A2R10G10B10 : MFVideoFormat_ARGB32,
+                                 width_, height_, options_.fps, options_.hdr10);
+    if (!output || !input) return false;
+
+    const uint32_t bitrate = options_.bitrateKbps
+        ? options_.bitrateKbps * 1000
+        : DefaultBitrate(width_, height_, options_.fps, options_.codec);
+    (void)output->SetUINT32(MF_MT_AVG_BITRATE, bitrate);
+    (void)output->SetUINT32(MF_MT_MPEG2_PROFILE,
+                            !hevc ? static_cast<UINT32>(eAVEncH264VProfile_High)
+                            : options_.hdr10 ? static_cast<UINT32>(eAVEncH265VProfile_Main_420_10)
+                                             : static_cast<UINT32>(eAVEncH265VProfile_Main_420_8));
+    // Top-down rows.
+    (void)input->SetUINT32(MF_MT_DEFAULT_STRIDE, width_ * 4);
+    (void)input->SetUINT32(MF_MT_VIDEO_NOMINAL_RANGE, MFNominalRange_0_255);
+
+    if (FAILED(writer_->AddStream(output.Get(), &stream_)) ||
+        FAILED(writer_->SetInputMediaType(stream_, input.Get(), nullptr)) ||
+        FAILED(writer_->BeginWriting())) {
+        writer_.Reset();
+        (void)::DeleteFileW(path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// ── Capture side ────────────────────────────────────────────────────
+
+bool VideoRecorder::SubmitFrame(const FrameData& frame, int64_t capturedAt)
+{
+    tickPending_ = false;
+    if (!writer_ || !frame.gpuTexture || frame.width != srcWidth_ || frame.height != srcHeight_ ||
+        static_cast<DXGI_FORMAT>(frame.format) != DXGI_FORMAT_R16G16B16A16_FLOAT) {
+        return false;
+    }
+
+    ComPtr<ID3D11ShaderResourceView> srv;
+    if (FAILED(device_->CreateShaderResourceView(frame.gpuTexture.Get(), nullptr, &srv))) return false;
+
+    // A free surface, never waiting for one: the queue is bounded by the
+    // pool, so a slow encoder costs frames, not capture latency.
+    Surface* surface = nullptr;
+    size_t index = 0;
+    {
+        std::lock_guard lock(mutex_);
+        for (; index < surfaces_.size(); ++index) {
+            auto& s = surfaces_[index];
+            if (!s.busy && s.sample) {
+                s.busy = true;
+                surface = &s;
+                break;
+            }
+        }
+    }
+    if (!surface) {
+        ++dropped_;
+        return false;
+    }
+
+    ctx_->CSSetShader(cs_.Get(), nullptr, 0);
+    ctx_->CSSetConstantBuffers(0, 1, params_.GetAddressOf());
+    ctx_->CSSetSamplers(0, 1, sampler_.GetAddressOf());
+    ctx_->CSSetShaderResources(0, 1, srv.GetAddressOf());
+    ctx_->CSSetUnorderedAccessViews(0, 1, surface->uav.GetAddressOf(), nullptr);
+    ctx_->Dispatch((width_ + kThreadGroupSize - 1) / kThreadGroupSize,
+                   (height_ + kThreadGroupSize - 1) / kThreadGroupSize, 1);
+
+    // Unbind so the composite can be reused and the surface read.
+    ID3D11ShaderResourceView* nullSrv = nullptr;
+    ID3D11UnorderedAccessView* nullUav = nullptr;
+    ctx_->CSSetShaderResources(0, 1, &nullSrv);
+    ctx_->CSSetUnorderedAccessViews(0, 1, &nullUav, nullptr);
+    ctx_->CSSetShader(nullptr, nullptr, 0);
+
+    // Sample times from the capture clock, so dropped frames show as a
+    // longer previous frame instead of speeding the video up.
+    if (!firstFrameAt_) firstFrameAt_ = capturedAt;
+    const int64_t ticks = (std::max)(capturedAt - firstFrameAt_, int64_t{0});
+    int64_t time = static_cast<int64_t>(static_cast<double>(ticks) * 1.0e7 / static_cast<double>(TraceFrequency()));
+    if (time <= lastTime_) time = lastTime_ + 1;
+    lastTime_ = time;
+
+    {
+        std::lock_guard lock(mutex_);
+        queue_.push_back({index, time});
+    }
+    wake_.notify_one();
+    return true;
+}
+
+void VideoRecorder::Pace()
+{
+    // High-resolution timer where available (Windows 10 1803+); the
+    // default one rounds to the 15.6 ms system tick.
+    HANDLE timer = ::CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+                                            TIMER_ALL_ACCESS);
+    if (!timer) timer = ::CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+    if (!timer) return;
+
+    // Absolute schedule in 100 ns units, so waits do not drift.
+    const int64_t period = 10'000'000 / options_.fps;
+    const auto now100ns = [] {
+        return static_cast<int64_t>(static_cast<double>(TraceNow()) * 1.0e7 / static_cast<double>(TraceFrequency()));
+    };
+    int64_t next = now100ns();
+
+    const HANDLE handles[] = {paceStop_, timer};
+    for (;;) {
+        next += period;
+        const int64_t now = now100ns();
+        if (next < now) next = now + period;   // fell behind: resync rather than burst
+
+        LARGE_INTEGER due{};
+        due.QuadPart = -(next - now);          // relative
+        if (!::SetWaitableTimer(timer, &due, 0, nullptr, nullptr, FALSE)) break;
+        if (::WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0 + 1) break;
+
+        if (!tickPending_.exchange(true)) onTick_();
+    }
+    ::CloseHandle(timer);
+}
+
+// ── Encode thread ───────────────────────────────────────────────────
+
+void VideoRecorder::Encode()
+{
+    const int64_t duration = 10'000'000 / options_.fps;
+    for (;;) {
+        Queued q{};
+        {
+            std::unique_lock lock(mutex_);
+            wake_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) return;   // stopped and drained
+            q = queue_.front();
+            queue_.pop_front();
+        }
+
+        Surface& surface = surfaces_[q.surface];
+        ComPtr<IMFSample> sample;
+        {
+            std::lock_guard lock(mutex_);
+            sample = std::move(surface.sample);
+        }
+        ComPtr<IMFTrackedSample> tracked;
+        const bool handedOut = SUCCEEDED(sample->SetSampleTime(q.time)) &&
+                               SUCCEEDED(sample->SetSampleDuration(duration)) &&
+                               SUCCEEDED(sample.As(&tracked)) &&
+                               SUCCEEDED(tracked->SetAllocatedTracker(tracker_.Get(), nullptr));
+        tracked.Reset();
+        if (!handedOut) {
+            std::lock_guard lock(mutex_);
+            surface.sample = std::move(sample);
+            surface.busy = false;
+            continue;
+        }
+
+        // The encoder may keep the sample (and so the surface) for a few
+        // frames; the tracker frees the surface once the last reference,
+        // ours included, is gone.
+        {
+            const ScopedTrace trace(TraceStage::Encode, 2);
+            if (SUCCEEDED(writer_->WriteSample(stream_, sample.Get()))) ++written_;
+        }
+        sample.Reset();
+    }
+}
+
+} // namespace screencap::capture
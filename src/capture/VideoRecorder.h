@@ -0,0 +1,153 @@
+#pragma once
+
+#include "capture/FrameData.h"
+
+#include <d3d11.h>
+#include <wrl/client.h>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct IMFSample;
+struct IMFSinkWriter;
+struct IMFDXGIDeviceManager;
+
+namespace screencap::capture {
+
+enum class VideoCodec {
+    H264,
+    Hevc,
+};
+
+// ── Video recording (Media Foundation, hardware encode) ─────────────
+//
+// Continuous-capture composites go straight from the GPU to the encoder:
+// SubmitFrame() converts the FP16 scRGB frame — SDR tone map, or HDR10
+// (BT.2020, PQ) — into one of a few pooled encoder surfaces and queues it;
+// an encode thread wraps each surface in a DXGI sample for the sink
+// writer, whose hardware H.264 / HEVC encoder scales it to NV12 / P010 on
+// the GPU.  No pixel is read back.
+//
+// The queue is bounded by the surface pool: when every surface is still
+// with the encoder the frame is dropped, so encoding never stalls capture.
+// Like the rest of the GPU work, SubmitFrame() runs on the thread that owns
+// the immediate context; the tick callback only paces it.
+class VideoRecorder final {
+public:
+    struct Options {
+        VideoCodec codec{VideoCodec::H264};
+        bool       hdr10{false};           // HEVC Main10, BT.2020 PQ; H.264 is always SDR
+        uint32_t   fps{60};
+        uint32_t   bitrateKbps{0};         // 0 = from size and frame rate
+        float      sdrWhiteNits{80.0f};    // SDR only: paper white → 1.0 (HDR10 keeps absolute nits)
+    };
+
+    // Called on the pacing thread once per frame interval.  Ticks do not
+    // queue up: while one is outstanding (no SubmitFrame() yet) the next
+    // ones are skipped, so answer every tick, with an empty frame if the
+    // capture failed.
+    using Tick = std::function<void()>;
+
+    VideoRecorder() = default;
+    ~VideoRecorder();   // Stop()
+
+    VideoRecorder(const VideoRecorder&) = delete;
+    VideoRecorder& operator=(const VideoRecorder&) = delete;
+    VideoRecorder(VideoRecorder&&) = delete;
+    VideoRecorder& operator=(VideoRecorder&&) = delete;
+
+    // Open `path` (.mp4) for a desktop of width×height and start ticking.
+    // The encoded size is the desktop's, scaled down to fit the codec's
+    // limit if needed.  Returns false if Media Foundation, the encoder or
+    // the conversion shader is unavailable.
+    [[nodiscard]] bool Start(ID3D11Device* device, const std::wstring& path,
+                             uint32_t width, uint32_t height, const Options& options, Tick onTick);
+
+    // Finish the queued frames, finalise the file and stop ticking.
+    // Returns false if nothing could be written.
+    bool Stop();
+
+    [[nodiscard]] bool IsRecording() const noexcept { return writer_ != nullptr; }
+    [[nodiscard]] const std::wstring& Path() const noexcept { return path_; }
+
+    // Encode a GPU FP16 frame captured at `capturedAt` (TraceNow() ticks).
+    // Never blocks on the encoder.  Empty frames and frames of another
+    // size (layout change) are ignored.  Returns false if the frame was
+    // not queued.
+    bool SubmitFrame(const FrameData& frame, int64_t capturedAt);
+
+    [[nodiscard]] uint64_t FramesWritten() const noexcept { return written_.load(); }
+    [[nodiscard]] uint64_t FramesDropped() const noexcept { return dropped_.load(); }
+
+private:
+    static constexpr size_t kSurfaces = 4;
+
+    // Media Foundation's notice that a tracked sample's last reference
+    // has gone (VideoRecorder.cpp).
+    class SampleTracker;
+
+    // One encoder input surface: BGRA8 (SDR) or R10G10B10A2 (HDR10),
+    // wrapped once in a tracked sample.  Busy from SubmitFrame() until the
+    // encoder has let go of the sample; the sample is held here only
+    // while it is free.
+    struct Surface {
+        Microsoft::WRL::ComPtr<ID3D11Texture2D>           tex;
+        Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav;
+        Microsoft::WRL::ComPtr<IMFSample>                 sample;
+        IMFSample*                                        tracked{};   // identifies the sample once handed out
+        bool                                              busy{false};
+    };
+
+    struct Queued {
+        size_t  surface;
+        int64_t time;       // 100 ns since the first frame
+    };
+
+    [[nodiscard]] bool CreateWriter(const std::wstring& path);
+    [[nodiscard]] bool CreateSurfaces();
+    [[nodiscard]] bool CreateSamples();
+    // SampleTracker: `sample` is back from the encoder.
+    void OnSampleFree(IMFSample* sample);
+    void Pace();
+    void Encode();
+
+    Microsoft::WRL::ComPtr<ID3D11Device>              device_;
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext>       ctx_;
+    Microsoft::WRL::ComPtr<ID3D11ComputeShader>       cs_;
+    Microsoft::WRL::ComPtr<ID3D11Buffer>              params_;
+    Microsoft::WRL::ComPtr<ID3D11SamplerState>        sampler_;
+    Microsoft::WRL::ComPtr<IMFDXGIDeviceManager>      manager_;
+    Microsoft::WRL::ComPtr<IMFSinkWriter>             writer_;
+    Microsoft::WRL::ComPtr<SampleTracker>             tracker_;
+    DWORD                                             stream_{};
+    std::array<Surface, kSurfaces>                    surfaces_;
+    Options                                           options_;
+    std::wstring                                      path_;
+    uint32_t srcWidth_{}, srcHeight_{};     // desktop
+    uint32_t width_{}, height_{};           // encoded
+    int64_t  firstFrameAt_{};               // TraceNow() ticks, 0 = none yet
+    int64_t  lastTime_{-1};                 // 100 ns, last queued sample time
+
+    std::mutex                                        mutex_;
+    std::condition_variable                           wake_;
+    std::condition_variable                           freed_;     // a surface's sample came back
+    std::deque<Queued>                                queue_;
+    bool                                              stop_{false};
+    std::thread                                       encodeThread_;
+    std::thread                                       paceThread_;
+    HANDLE                                            paceStop_{};   // manual-reset event
+    Tick                                              onTick_;
+    std::atomic<bool>                                 tickPending_{false};
+    std::atomic<uint64_t>                             written_{0};
+    std::atomic<uint64_t>                             dropped_{0};
+    bool                                              mfStarted_{false};
+};
+
+} // namespace screencap::capture
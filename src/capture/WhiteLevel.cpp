@@ -0,0 +1,91 @@
+#include "capture/WhiteLevel.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace screencap::capture {
+
+float GetSdrWhiteNitsForMonitor(HMONITOR mon) noexcept
+{
+    if (!mon) {
+        return 80.0f;
+    }
+
+    MONITORINFOEXW mi{};
+    mi.cbSize = sizeof(mi);
+    if (!::GetMonitorInfoW(mon, &mi)) {
+        return 80.0f;
+    }
+
+    UINT32 pathCount = 0;
+    UINT32 modeCount = 0;
+    LONG st = ::GetDisplayConfigBufferSizes(QDC_ONLY_ACTIVE_PATHS, &pathCount, &modeCount);
+    if (st != ERROR_SUCCESS || pathCount == 0) {
+        return 80.0f;
+    }
+
+    std::vector<DISPLAYCONFIG_PATH_INFO> paths(pathCount);
+    std::vector<DISPLAYCONFIG_MODE_INFO> modes(modeCount);
+    st = ::QueryDisplayConfig(QDC_ONLY_ACTIVE_PATHS, &pathCount, paths.data(), &modeCount, modes.data(), nullptr);
+    if (st != ERROR_SUCCESS) {
+        return 80.0f;
+    }
+
+    for (UINT32 i = 0; i < pathCount; ++i) {
+        const auto& p = paths[i];
+
+        DISPLAYCONFIG_SOURCE_DEVICE_NAME srcName{};
+        srcName.header.type = DISPLAYCONFIG_DEVICE_INFO_GET_SOURCE_NAME;
+        srcName.header.size = sizeof(srcName);
+        srcName.header.adapterId = p.sourceInfo.adapterId;
+        srcName.header.id = p.sourceInfo.id;
+
+        if (::DisplayConfigGetDeviceInfo(&srcName.header) != ERROR_SUCCESS) {
+            continue;
+        }
+
+        if (::lstrcmpiW(srcName.viewGdiDeviceName, mi.szDevice) != 0) {
+            continue;
+        }
+
+        DISPLAYCONFIG_SDR_WHITE_LEVEL sdr{};
+        sdr.header.type = DISPLAYCONFIG_DEVICE_INFO_GET_SDR_WHITE_LEVEL;
+        sdr.header.size = sizeof(sdr);
+        sdr.header.adapterId = p.targetInfo.adapterId;
+        sdr.header.id = p.targetInfo.id;
+
+        if (::DisplayConfigGetDeviceInfo(&sdr.header) != ERROR_SUCCESS) {
+            return 80.0f;
+        }
+
+        // SDRWhiteLevel is "a multiplier of 80 nits, multiplied by 1000".
+        // nits = (SDRWhiteLevel / 1000.0) * 80
+        const float nits = (static_cast<float>(sdr.SDRWhiteLevel) / 1000.0f) * 80.0f;
+        return (nits > 0.0f) ? nits : 80.0f;
+    }
+
+    return 80.0f;
+}
+
+float GetSdrWhiteNitsForPrimaryMonitor() noexcept
+{
+    const HMONITOR mon = ::MonitorFromPoint({0, 0}, MONITOR_DEFAULTTOPRIMARY);
+    return GetSdrWhiteNitsForMonitor(mon);
+}
+
+float SdrWhiteNitsForFrame(const FrameData& frame) noexcept
+{
+    const auto area = [](const WhiteRegion& r) {
+        return int64_t{r.rect.right - r.rect.left} * (r.rect.bottom - r.rect.top);
+    };
+    const auto largest = std::max_element(frame.whiteRegions.begin(), frame.whiteRegions.end(),
+                                          [&area](const WhiteRegion& a, const WhiteRegion& b) {
+                                              return area(a) < area(b);
+                                          });
+    if (largest != frame.whiteRegions.end() && largest->sdrWhiteNits > 0.0f) {
+        return largest->sdrWhiteNits;
+    }
+    return GetSdrWhiteNitsForPrimaryMonitor();
+}
+
+} // namespace screencap::capture
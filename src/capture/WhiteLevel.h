@@ -0,0 +1,33 @@
+#pragma once
+
+#include "capture/FrameData.h"
+
+#include <windows.h>
+
+namespace screencap::capture {
+
+// ── Per-monitor SDR white level ─────────────────────────────────────
+//
+// On an HDR desktop, the DWM composes everything into linear scRGB where
+// 1.0 = 80 nits.  The user's "SDR content brightness" slider (paper white)
+// boosts SDR white content in the captured buffer:
+//
+//   scRGB_value_of_SDR_white = paperWhiteNits / 80
+//
+// To produce a correct SDR PNG we simply divide by that ratio so SDR white
+// maps back to 1.0 (linear) → 255 (sRGB 8-bit).
+// HDR highlights above 1.0 after normalisation are clipped, which is the
+// same thing an SDR display does.
+
+// Returns the monitor's SDR white level in nits (80 if unknown).
+[[nodiscard]] float GetSdrWhiteNitsForMonitor(HMONITOR mon) noexcept;
+
+// Same, for the primary monitor (where the tray icon lives).
+[[nodiscard]] float GetSdrWhiteNitsForPrimaryMonitor() noexcept;
+
+// One white level for a whole frame: that of the white region covering
+// most of it (no display-config lookup), else the primary monitor's.
+// Per-pixel passes use the regions and fall back to this outside them.
+[[nodiscard]] float SdrWhiteNitsForFrame(const FrameData& frame) noexcept;
+
+} // namespace screencap::capture
@@ -15,8 +15,9 @@
 #include <winrt/Windows.Graphics.DirectX.h>
 #include <winrt/Windows.Graphics.DirectX.Direct3D11.h>
 
-#include <atomic>
-#include <cstring>
+#include <algorithm>
+#include <mutex>
+#include <utility>
 
 using Microsoft::WRL::ComPtr;
 
@@ -27,6 +28,12 @@ namespace winrt_d3d  = winrt::Windows::Graphics::DirectX::Direct3D11;
 namespace screencap::capture {
 namespace {
 
+// Sessions kept running at once while the user hovers over candidates.
+constexpr size_t kMaxSessions = 4;
+
+// Pool depth: one frame held by the cache, one being filled by DWM.
+constexpr int32_t kPoolBuffers = 2;
+
 // ── Helpers ─────────────────────────────────────────────────────────
 
 // Wrap a raw IDXGIDevice as a WinRT IDirect3DDevice.
@@ -54,8 +61,10 @@ namespace {
     return item;
 }
 
-// Copy a D3D11 texture to CPU-accessible FrameData, respecting the actual
-// texture format (BGRA8, RGBA16F, etc.) rather than assuming a fixed format.
+// Copy a WGC surface into a GPU frame of our own (pixels left empty, like
+// CaptureFullDesktop), respecting the actual texture format (BGRA8,
+// RGBA16F, etc.).  The surface goes back to the pool right after; the
+// copy is bindable so the preview and the GPU tone-map pass can read it.
 [[nodiscard]] bool CopyTextureToFrame(
     ID3D11Device* device,
     ID3D11DeviceContext* ctx,
@@ -68,135 +77,168 @@ namespace {
     const uint32_t bpp = BytesPerPixel(desc.Format);
     if (bpp == 0) return false; // Unsupported format.
 
-    D3D11_TEXTURE2D_DESC stagingDesc{};
-    stagingDesc.Width = desc.Width;
-    stagingDesc.Height = desc.Height;
-    stagingDesc.MipLevels = 1;
-    stagingDesc.ArraySize = 1;
-    stagingDesc.Format = desc.Format;
-    stagingDesc.SampleDesc.Count = 1;
-    stagingDesc.Usage = D3D11_USAGE_STAGING;
-    stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
-
-    ComPtr<ID3D11Texture2D> staging;
-    HRESULT hr = device->CreateTexture2D(&stagingDesc, nullptr, &staging);
+    D3D11_TEXTURE2D_DESC copyDesc{};
+    copyDesc.Width = desc.Width;
+    copyDesc.Height = desc.Height;
+    copyDesc.MipLevels = 1;
+    copyDesc.ArraySize = 1;
+    copyDesc.Format = desc.Format;
+    copyDesc.SampleDesc.Count = 1;
+    copyDesc.Usage = D3D11_USAGE_DEFAULT;
+    copyDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    ComPtr<ID3D11Texture2D> copy;
+    HRESULT hr = device->CreateTexture2D(&copyDesc, nullptr, &copy);
     if (FAILED(hr)) return false;
 
-    ctx->CopyResource(staging.Get(), srcTex);
-    ctx->Flush();
-
-    D3D11_MAPPED_SUBRESOURCE mapped{};
-    hr = ctx->Map(staging.Get(), 0, D3D11_MAP_READ, 0, &mapped);
-    if (FAILED(hr)) return false;
+    ctx->CopyResource(copy.Get(), srcTex);
 
+    frame = {};
+    frame.gpuTexture = std::move(copy);
     frame.width = desc.Width;
     frame.height = desc.Height;
     frame.format = static_cast<uint32_t>(desc.Format);
     frame.bytesPerPixel = bpp;
-    frame.pixels.resize(static_cast<size_t>(desc.Width) * bpp * desc.Height);
-
-    const auto* src = static_cast<const uint8_t*>(mapped.pData);
-    const uint32_t dstStride = desc.Width * bpp;
-    for (uint32_t row = 0; row < desc.Height; ++row) {
-        std::memcpy(
-            frame.pixels.data() + static_cast<size_t>(row) * dstStride,
-            src + static_cast<size_t>(row) * mapped.RowPitch,
-            dstStride);
-    }
-
-    ctx->Unmap(staging.Get(), 0);
+    // pixels left empty — read back lazily via ReadbackPixels() when needed.
     return true;
 }
 
-} // namespace
-
-std::optional<FrameData> CaptureWindow(HWND hwnd, ID3D11Device* device)
-{
-    if (!hwnd || !::IsWindow(hwnd) || !device) {
-        return std::nullopt;
+// Newest frame of one session, shared with the FrameArrived handler
+// (which runs on a WinRT worker thread).
+struct FrameSlot {
+    std::mutex                        mutex;
+    winrt_cap::Direct3D11CaptureFrame latest{nullptr};
+    winrt::Windows::Graphics::SizeInt32 poolSize{};
+    HANDLE                            arrived{};   // manual-reset, set on the first frame
+
+    FrameSlot() : arrived(::CreateEventW(nullptr, TRUE, FALSE, nullptr)) {}
+    ~FrameSlot()
+    {
+        if (latest) latest.Close();
+        if (arrived) ::CloseHandle(arrived);
     }
+    FrameSlot(const FrameSlot&) = delete;
+    FrameSlot& operator=(const FrameSlot&) = delete;
+};
 
-    try {
-        ComPtr<ID3D11DeviceContext> d3dCtx;
-        device->GetImmediateContext(&d3dCtx);
+} // namespace
 
-        ComPtr<IDXGIDevice> dxgiDevice;
-        if (FAILED(device->QueryInterface(IID_PPV_ARGS(&dxgiDevice)))) return std::nullopt;
+// ── WindowCaptureCache ──────────────────────────────────────────────
 
-        auto winrtDevice = CreateWinRTDevice(dxgiDevice.Get());
+struct WindowCaptureCache::DeviceState {
+    ComPtr<ID3D11Device>        device;
+    ComPtr<ID3D11DeviceContext> ctx;
+    winrt_d3d::IDirect3DDevice  winrtDevice{nullptr};
+};
 
-        // ── Create capture item from HWND ───────────────────────────
-        auto item = CreateCaptureItemForWindow(hwnd);
-        auto itemSize = item.Size();
-        if (itemSize.Width <= 0 || itemSize.Height <= 0) {
-            return std::nullopt;
-        }
+struct WindowCaptureCache::Session {
+    HWND                                  hwnd{};
+    winrt_cap::GraphicsCaptureItem        item{nullptr};
+    winrt_cap::Direct3D11CaptureFramePool framePool{nullptr};
+    winrt_cap::GraphicsCaptureSession     session{nullptr};
+    winrt::event_token                    token{};
+    std::shared_ptr<FrameSlot>            slot;
+
+    Session() = default;
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
 
-        // ── Frame pool + session ────────────────────────────────────
-        // Try R16G16B16A16_FLOAT first (preserves HDR content from windows
-        // like Edge/Chrome that use scRGB float swapchains).  Fall back to
-        // B8G8R8A8_UNORM if the driver/OS doesn't support FP16 pools.
-        winrt_cap::Direct3D11CaptureFramePool framePool{nullptr};
+    ~Session()
+    {
         try {
-            framePool = winrt_cap::Direct3D11CaptureFramePool::CreateFreeThreaded(
-                winrtDevice,
-                winrt_dx::DirectXPixelFormat::R16G16B16A16Float,
-                1,   // single buffer
-                itemSize);
+            if (framePool) framePool.FrameArrived(token);
+            if (session) session.Close();
+            if (framePool) framePool.Close();
         } catch (...) {
-            framePool = nullptr;
-        }
-        if (!framePool) {
-            framePool = winrt_cap::Direct3D11CaptureFramePool::CreateFreeThreaded(
-                winrtDevice,
-                winrt_dx::DirectXPixelFormat::B8G8R8A8UIntNormalized,
-                1,
-                itemSize);
+            // Already torn down by the OS (window closed).
         }
+    }
+};
 
-        auto session = framePool.CreateCaptureSession(item);
+WindowCaptureCache::WindowCaptureCache() = default;
 
-        // Suppress the yellow capture border and cursor (requires Windows 11 / 10 2104+).
-        try {
-            session.IsBorderRequired(false);
-        } catch (...) { /* Not available on this OS version. */ }
+WindowCaptureCache::~WindowCaptureCache() = default;
 
-        try {
-            session.IsCursorCaptureEnabled(false);
-        } catch (...) { /* Not available on this OS version. */ }
+bool WindowCaptureCache::Init(ID3D11Device* device)
+{
+    Clear();
+    device_.reset();
+    if (!device) return false;
 
-        // ── Wait for one frame via event ────────────────────────────
-        HANDLE frameEvent = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
-        if (!frameEvent) return std::nullopt;
+    try {
+        if (!winrt_cap::GraphicsCaptureSession::IsSupported()) return false;
+
+        auto state = std::make_unique<DeviceState>();
+        state->device = device;
+        device->GetImmediateContext(&state->ctx);
 
-        std::atomic<bool> gotFrame{false};
+        ComPtr<IDXGIDevice> dxgiDevice;
+        if (FAILED(device->QueryInterface(IID_PPV_ARGS(&dxgiDevice)))) return false;
+        state->winrtDevice = CreateWinRTDevice(dxgiDevice.Get());
 
-        auto token = framePool.FrameArrived(
-            [&](winrt_cap::Direct3D11CaptureFramePool const&, winrt::Windows::Foundation::IInspectable const&) {
-                if (!gotFrame.exchange(true)) {
-                    ::SetEvent(frameEvent);
-                }
-            });
+        device_ = std::move(state);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
 
-        session.StartCapture();
+WindowCaptureCache::Session* WindowCaptureCache::FindOrStart(HWND hwnd)
+{
+    // Drop sessions whose window has gone away.
+    sessions_.erase(std::remove_if(sessions_.begin(), sessions_.end(), [](const auto& s) {
+        return !::IsWindow(s->hwnd);
+    }), sessions_.end());
+
+    auto it = std::find_if(sessions_.begin(), sessions_.end(), [hwnd](const auto& s) {
+        return s->hwnd == hwnd;
+    });
+    if (it != sessions_.end()) {
+        std::rotate(sessions_.begin(), it, it + 1);
+        return sessions_.front().get();
+    }
 
-        // Wait up to 2 seconds for the first frame.
-        ::WaitForSingleObject(frameEvent, 2000);
-        ::CloseHandle(frameEvent);
+    auto session = StartSession(hwnd);
+    if (!session) return nullptr;
+    sessions_.insert(sessions_.begin(), std::move(session));
+    if (sessions_.size() > kMaxSessions) {
+        sessions_.pop_back();
+    }
+    return sessions_.front().get();
+}
 
-        if (!gotFrame.load()) {
-            session.Close();
-            framePool.Close();
+void WindowCaptureCache::Warm(HWND hwnd)
+{
+    if (!device_ || !hwnd || !::IsWindow(hwnd)) return;
+    try {
+        (void)FindOrStart(hwnd);
+    } catch (...) {
+        // Not capturable (e.g. protected content); Capture() will fail too.
+    }
+}
+
+std::optional<FrameData> WindowCaptureCache::Capture(HWND hwnd, DWORD timeoutMs)
+{
+    if (!device_ || !hwnd || !::IsWindow(hwnd)) {
+        return std::nullopt;
+    }
+
+    try {
+        Session* s = FindOrStart(hwnd);
+        if (!s) return std::nullopt;
+
+        // Warm sessions have a frame already; cold ones wait for the first.
+        if (::WaitForSingleObject(s->slot->arrived, timeoutMs) != WAIT_OBJECT_0) {
             return std::nullopt;
         }
 
-        // ── Read the captured frame ─────────────────────────────────
-        auto frame = framePool.TryGetNextFrame();
-        if (!frame) {
-            session.Close();
-            framePool.Close();
-            return std::nullopt;
+        // Take the frame so the handler can't close it under us.
+        winrt_cap::Direct3D11CaptureFrame frame{nullptr};
+        {
+            std::lock_guard lock(s->slot->mutex);
+            frame = std::exchange(s->slot->latest, nullptr);
         }
+        if (!frame) return std::nullopt;
 
         auto surface = frame.Surface();
 
@@ -212,16 +254,21 @@ std::optional<FrameData> CaptureWindow(HWND hwnd, ID3D11Device* device)
         winrt::check_hresult(access->GetInterface(IID_PPV_ARGS(&surfaceTex)));
 
         FrameData result;
-        bool ok = CopyTextureToFrame(device, d3dCtx.Get(), surfaceTex.Get(), result);
-
-        frame.Close();
-        session.Close();
-        framePool.Close();
+        const bool ok = CopyTextureToFrame(device_->device.Get(), device_->ctx.Get(), surfaceTex.Get(), result);
+
+        // Hand the frame back unless a newer one arrived meanwhile, so a
+        // window that stops presenting can still be captured again.
+        {
+            std::lock_guard lock(s->slot->mutex);
+            if (!s->slot->latest) {
+                s->slot->latest = std::move(frame);
+            }
+        }
+        if (frame) frame.Close();
 
         if (!ok || result.width == 0 || result.height == 0) {
             return std::nullopt;
         }
-
         return result;
     }
     catch (...) {
@@ -230,4 +277,98 @@ std::optional<FrameData> CaptureWindow(HWND hwnd, ID3D11Device* device)
     }
 }
 
+void WindowCaptureCache::Clear()
+{
+    sessions_.clear();
+}
+
+std::unique_ptr<WindowCaptureCache::Session> WindowCaptureCache::StartSession(HWND hwnd)
+{
+    const auto& winrtDevice = device_->winrtDevice;
+
+    auto s = std::make_unique<Session>();
+    s->hwnd = hwnd;
+    s->slot = std::make_shared<FrameSlot>();
+    if (!s->slot->arrived) return nullptr;
+
+    // ── Create capture item from HWND ───────────────────────────────
+    s->item = CreateCaptureItemForWindow(hwnd);
+    const auto itemSize = s->item.Size();
+    if (itemSize.Width <= 0 || itemSize.Height <= 0) {
+        return nullptr;
+    }
+    s->slot->poolSize = itemSize;
+
+    // ── Frame pool + session ────────────────────────────────────────
+    // Try R16G16B16A16_FLOAT first (preserves HDR content from windows
+    // like Edge/Chrome that use scRGB float swapchains).  Fall back to
+    // B8G8R8A8_UNORM if the driver/OS doesn't support FP16 pools.
+    auto pixelFormat = winrt_dx::DirectXPixelFormat::R16G16B16A16Float;
+    try {
+        s->framePool = winrt_cap::Direct3D11CaptureFramePool::CreateFreeThreaded(
+            winrtDevice, pixelFormat, kPoolBuffers, itemSize);
+    } catch (...) {
+        s->framePool = nullptr;
+    }
+    if (!s->framePool) {
+        pixelFormat = winrt_dx::DirectXPixelFormat::B8G8R8A8UIntNormalized;
+        s->framePool = winrt_cap::Direct3D11CaptureFramePool::CreateFreeThreaded(
+            winrtDevice, pixelFormat, kPoolBuffers, itemSize);
+    }
+
+    s->session = s->framePool.CreateCaptureSession(s->item);
+
+    // Suppress the yellow capture border and cursor (requires Windows 11 / 10 2104+).
+    try {
+        s->session.IsBorderRequired(false);
+    } catch (...) { /* Not available on this OS version. */ }
+
+    try {
+        s->session.IsCursorCaptureEnabled(false);
+    } catch (...) { /* Not available on this OS version. */ }
+
+    // ── Keep only the newest frame ──────────────────────────────────
+    // The handler holds the slot (not the Session) so it stays valid even
+    // if it runs while the session is being torn down.
+    s->token = s->framePool.FrameArrived(
+        [slot = s->slot, winrtDevice, pixelFormat](
+            winrt_cap::Direct3D11CaptureFramePool const& sender,
+            winrt::Windows::Foundation::IInspectable const&) {
+            auto frame = sender.TryGetNextFrame();
+            if (!frame) return;
+
+            winrt_cap::Direct3D11CaptureFrame previous{nullptr};
+            bool resized = false;
+            {
+                std::lock_guard lock(slot->mutex);
+                const auto size = frame.ContentSize();
+                resized = size.Width != slot->poolSize.Width || size.Height != slot->poolSize.Height;
+                if (resized) slot->poolSize = size;
+                previous = std::exchange(slot->latest, frame);
+            }
+            if (previous) previous.Close();
+
+            // The window was resized: later frames use buffers of the new size.
+            if (resized) {
+                sender.Recreate(winrtDevice, pixelFormat, kPoolBuffers, frame.ContentSize());
+            }
+            ::SetEvent(slot->arrived);
+        });
+
+    s->session.StartCapture();
+    return s;
+}
+
+std::optional<FrameData> CaptureWindow(HWND hwnd, ID3D11Device* device)
+{
+    if (!hwnd || !::IsWindow(hwnd) || !device) {
+        return std::nullopt;
+    }
+
+    // One-shot: a cold cache sets up the session and waits for its frame.
+    WindowCaptureCache cache;
+    if (!cache.Init(device)) return std::nullopt;
+    return cache.Capture(hwnd);
+}
+
 } // namespace screencap::capture
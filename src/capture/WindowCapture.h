@@ -4,7 +4,9 @@
 
 #include <windows.h>
 
+#include <memory>
 #include <optional>
+#include <vector>
 
 struct ID3D11Device;
 
@@ -12,7 +14,55 @@ namespace screencap::capture {
 
 // Capture a single window using the Windows Graphics Capture API.
 // Works even when the target window is occluded by other windows.
+// The frame is GPU-resident (pixels empty); read back with ReadbackPixels().
 // Returns std::nullopt on failure (unsupported OS, window closed, etc.).
 [[nodiscard]] std::optional<FrameData> CaptureWindow(HWND hwnd, ID3D11Device* device);
 
+// Keeps Windows Graphics Capture sessions alive per HWND so a capture can
+// use a frame that has already arrived instead of setting up a session and
+// waiting for DWM.  Warm() candidates while the user is still choosing;
+// Capture() is then effectively instant.  Running sessions copy every
+// frame their window presents, so Clear() once a capture is done.
+// Not thread-safe; use from one thread.
+class WindowCaptureCache final {
+public:
+    WindowCaptureCache();
+    ~WindowCaptureCache();
+
+    WindowCaptureCache(const WindowCaptureCache&) = delete;
+    WindowCaptureCache& operator=(const WindowCaptureCache&) = delete;
+    WindowCaptureCache(WindowCaptureCache&&) = delete;
+    WindowCaptureCache& operator=(WindowCaptureCache&&) = delete;
+
+    // Create the WinRT device wrapper once.  Returns false if WGC is
+    // unavailable on this OS.
+    [[nodiscard]] bool Init(ID3D11Device* device);
+
+    // Start a session for hwnd if none is running.  Cheap when warm; the
+    // least recently used session is dropped past a small limit.
+    void Warm(HWND hwnd);
+
+    // Latest frame of hwnd as a GPU frame, starting a session (and
+    // waiting up to timeoutMs for its first frame) if it wasn't warmed.
+    [[nodiscard]] std::optional<FrameData> Capture(HWND hwnd, DWORD timeoutMs = 2000);
+
+    // Stop and drop every session (the device is kept).
+    void Clear();
+
+private:
+    struct Session;
+    struct DeviceState;
+
+    // Session for hwnd, created if needed and moved to the front (MRU).
+    // Throws on WinRT failure.
+    Session* FindOrStart(HWND hwnd);
+
+    // Create the pool and session for hwnd and start capturing.
+    // Returns nullptr for an empty window; throws on WinRT failure.
+    [[nodiscard]] std::unique_ptr<Session> StartSession(HWND hwnd);
+
+    std::unique_ptr<DeviceState>          device_;
+    std::vector<std::unique_ptr<Session>> sessions_;   // most recent first
+};
+
 } // namespace screencap::capture
@@ -0,0 +1,48 @@
+// Luminance histogram -> exposure, one group of 64 threads.  See
+// ConvertShader.h.
+
+ByteAddressBuffer         histogram : register(t0);   // LuminanceHistogram's bins
+RWStructuredBuffer<float> exposure  : register(u0);
+
+// Same binning as LuminanceHistogram.hlsl.
+static const float kMinLog2     = -10.0;
+static const float kBinsPerStop = 4.0;
+
+// At most this share of the counted pixels is left above SDR white; the
+// exposure never brightens and darkens by at most 3 stops.
+static const float kHighlightShare = 0.02;
+static const float kMinExposure    = 0.125;
+
+groupshared uint prefix[64];
+
+[numthreads(64, 1, 1)]
+void CSMain(uint gi : SV_GroupIndex)
+{
+    prefix[gi] = histogram.Load(gi * 4);
+    GroupMemoryBarrierWithGroupSync();
+
+    // Inclusive prefix sum (Hillis-Steele), 6 steps for 64 bins.
+    [unroll]
+    for (uint offset = 1; offset < 64; offset <<= 1) {
+        const uint add = gi >= offset ? prefix[gi - offset] : 0;
+        GroupMemoryBarrierWithGroupSync();
+        prefix[gi] += add;
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    const uint total = prefix[63];
+    if (total == 0) {
+        if (gi == 0)
+            exposure[0] = 1.0;
+        return;
+    }
+
+    // The first bin at which the bins so far hold all but the highlight
+    // share: its lower edge is mapped to SDR white.
+    const uint keep = (uint)ceil(total * (1.0 - kHighlightShare));
+    const uint before = gi > 0 ? prefix[gi - 1] : 0;
+    if (prefix[gi] >= keep && before < keep) {
+        const float level = exp2(gi / kBinsPerStop + kMinLog2);
+        exposure[0] = clamp(1.0 / level, kMinExposure, 1.0);
+    }
+}
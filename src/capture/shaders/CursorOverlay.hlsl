@@ -0,0 +1,49 @@
+// Mouse pointer shape -> FP16 composite, blended in linear light.
+// See ConvertShader.h.
+
+Texture2D<float4>   background : register(t0);   // composite under the pointer (copy)
+Texture2D<float4>   shape      : register(t1);   // BGRA8 pointer image, see below
+RWTexture2D<float4> dstTex     : register(u0);
+
+cbuffer CursorParams : register(b0) {
+    int2  dstOffset;    // composite pixel of shape (0, 0)
+    int2  size;         // visible part of the shape
+    int2  srcOffset;    // first visible shape pixel
+    float whiteScale;   // scRGB value of SDR white (paper white / 80 nits)
+    float pad0;
+};
+
+float3 SrgbToLinear(float3 c)
+{
+    return c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+}
+
+float3 LinearToSrgb(float3 c)
+{
+    return c <= 0.0031308 ? c * 12.92 : 1.055 * pow(c, 1.0 / 2.4) - 0.055;
+}
+
+[numthreads(16, 16, 1)]
+void CSMain(uint3 dtid : SV_DispatchThreadID)
+{
+    if ((int)dtid.x >= size.x || (int)dtid.y >= size.y)
+        return;
+
+    const float4 bg = background[int2(dtid.xy)];
+    const float4 s  = shape[srcOffset + int2(dtid.xy)];
+
+    // Alpha > 0: sRGB colour over the desktop.  Alpha 0 with colour set:
+    // invert those channels (monochrome and masked-colour XOR pixels),
+    // in sRGB like the DWM's 8-bit XOR.
+    float3 rgb;
+    if (s.a > 0.0) {
+        rgb = lerp(bg.rgb, SrgbToLinear(s.rgb) * whiteScale, s.a);
+    } else if (any(s.rgb > 0.5)) {
+        const float3 inv = SrgbToLinear(1.0 - LinearToSrgb(saturate(bg.rgb / whiteScale))) * whiteScale;
+        rgb = s.rgb > 0.5 ? inv : bg.rgb;
+    } else {
+        return;
+    }
+
+    dstTex[dstOffset + int2(dtid.xy)] = float4(rgb, 1.0);
+}
@@ -0,0 +1,59 @@
+// Box-filter downsample + tone map -> BGRA8 (sRGB).  See ConvertShader.h.
+
+#include "ToneMap.hlsli"
+
+Texture2D<float4>         srcTex : register(t0);
+RWTexture2D<unorm float4> dstTex : register(u0);
+
+cbuffer DownsampleParams : register(b0) {
+    int2   srcSize;
+    int2   dstSize;
+    int    srgbSource;  // source stores sRGB-encoded values
+    int3   pad0;
+};
+
+float SrgbToLinear(float c) {
+    return (c <= 0.04045) ? (c / 12.92) : pow((c + 0.055) / 1.055, 2.4);
+}
+
+float LinearToSrgb(float c) {
+    return (c <= 0.0031308) ? (c * 12.92) : (1.055 * pow(c, 1.0 / 2.4) - 0.055);
+}
+
+[numthreads(16, 16, 1)]
+void CSMain(uint3 dtid : SV_DispatchThreadID)
+{
+    if ((int)dtid.x >= dstSize.x || (int)dtid.y >= dstSize.y)
+        return;
+
+    // Source footprint of this output pixel (at least one texel).
+    int2 begin = (int2(dtid.xy) * srcSize) / dstSize;
+    int2 end   = max(((int2(dtid.xy) + 1) * srcSize) / dstSize, begin + 1);
+
+    // One level per footprint, from its centre: thumbnails are too small
+    // for a monitor edge inside a footprint to show.
+    const float2 white = WhiteAt((begin + end) / 2);
+    const float  e     = exposure[0];
+    const float  scale = white.x * e;
+    const float  peak  = max(white.y * e, 1.0);
+
+    float3 sum = 0.0;
+    for (int y = begin.y; y < end.y; ++y) {
+        for (int x = begin.x; x < end.x; ++x) {
+            float3 c = srcTex[int2(x, y)].rgb;
+            // Per texel, as the full-size tone map does; sRGB sources are
+            // already SDR and only clip.
+            if (srgbSource != 0)
+                sum += saturate(float3(SrgbToLinear(c.r), SrgbToLinear(c.g), SrgbToLinear(c.b)));
+            else
+                sum += ToneMap(c * scale, white.x, peak);
+        }
+    }
+    float3 c = sum / float((end.x - begin.x) * (end.y - begin.y));
+
+    dstTex[int2(dtid.xy)] = float4(
+        LinearToSrgb(c.r),
+        LinearToSrgb(c.g),
+        LinearToSrgb(c.b),
+        1.0);
+}
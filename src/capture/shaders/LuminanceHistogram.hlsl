@@ -0,0 +1,41 @@
+// scRGB -> log2 luminance histogram, for auto exposure.  See ConvertShader.h.
+
+#include "ToneMap.hlsli"
+
+Texture2D<float4>   srcTex    : register(t0);
+RWByteAddressBuffer histogram : register(u0);   // 64 uint bins, cleared first
+
+cbuffer ToneMapParams : register(b0) {
+    int2  srcOffset;
+    int2  size;
+};
+
+// Bins cover log2 luminance [-10, 6) relative to SDR white, 4 per stop;
+// darker pixels (black backgrounds, letterboxing) are not counted.
+static const float kMinLog2      = -10.0;
+static const float kBinsPerStop  = 4.0;
+
+groupshared uint bins[64];
+
+[numthreads(16, 16, 1)]
+void CSMain(uint3 dtid : SV_DispatchThreadID, uint gi : SV_GroupIndex)
+{
+    // One group-local histogram, merged once per group, so the global
+    // atomics are 64 per 256 pixels rather than one per pixel.
+    if (gi < 64)
+        bins[gi] = 0;
+    GroupMemoryBarrierWithGroupSync();
+
+    if ((int)dtid.x < size.x && (int)dtid.y < size.y) {
+        const int2 p = srcOffset + int2(dtid.xy);
+        const float l = Luminance(max(srcTex[p].rgb, 0.0)) * WhiteAt(p).x;
+        const float bin = (log2(max(l, 1e-9)) - kMinLog2) * kBinsPerStop;
+        if (bin >= 0.0) {
+            InterlockedAdd(bins[min((uint)bin, 63u)], 1);
+        }
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (gi < 64 && bins[gi] != 0)
+        histogram.InterlockedAdd(gi * 4, bins[gi]);
+}
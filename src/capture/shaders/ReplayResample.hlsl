@@ -0,0 +1,38 @@
+// Float texture -> float texture box-filter resample (instant replay).
+// See ConvertShader.h.
+
+Texture2D<float4>   srcTex : register(t0);
+RWTexture2D<float4> dstTex : register(u0);
+
+cbuffer ResampleParams : register(b0) {
+    int2 dstSize;
+    int  factor;     // source pixels per destination pixel, each axis
+    int  pad0;
+};
+
+[numthreads(16, 16, 1)]
+void CSMain(uint3 dtid : SV_DispatchThreadID)
+{
+    if ((int)dtid.x >= dstSize.x || (int)dtid.y >= dstSize.y)
+        return;
+
+    uint srcW, srcH;
+    srcTex.GetDimensions(srcW, srcH);
+
+    // Average the footprint in linear light; edge pixels average what
+    // lies inside the source.
+    const int2 base = int2(dtid.xy) * factor;
+    float3 sum = 0.0;
+    float n = 0.0;
+    for (int y = 0; y < factor; ++y) {
+        for (int x = 0; x < factor; ++x) {
+            const int2 p = base + int2(x, y);
+            if (p.x < (int)srcW && p.y < (int)srcH) {
+                sum += srcTex[p].rgb;
+                n += 1.0;
+            }
+        }
+    }
+
+    dstTex[int2(dtid.xy)] = float4(n > 0.0 ? sum / n : 0.0, 1.0);
+}
@@ -0,0 +1,33 @@
+// RGBA16F (linear scRGB) -> BGRA8 (sRGB).  See ConvertShader.h.
+
+#include "ToneMap.hlsli"
+
+Texture2D<float4>         srcTex : register(t0);
+RWTexture2D<unorm float4> dstTex : register(u0);
+
+cbuffer ToneMapParams : register(b0) {
+    int2  srcOffset;
+    int2  size;
+};
+
+float LinearToSrgb(float c) {
+    return (c <= 0.0031308) ? (c * 12.92) : (1.055 * pow(c, 1.0 / 2.4) - 0.055);
+}
+
+[numthreads(16, 16, 1)]
+void CSMain(uint3 dtid : SV_DispatchThreadID)
+{
+    if ((int)dtid.x >= size.x || (int)dtid.y >= size.y)
+        return;
+
+    // Normalise SDR white to 1.0, then clip or roll off highlights.
+    const int2 p = srcOffset + int2(dtid.xy);
+    float3 c = ToneMapAt(srcTex[p].rgb, p);
+
+    // UAV writes RGBA; the BGRA8 format swizzles to memory order.
+    dstTex[int2(dtid.xy)] = float4(
+        LinearToSrgb(c.r),
+        LinearToSrgb(c.g),
+        LinearToSrgb(c.b),
+        1.0);
+}
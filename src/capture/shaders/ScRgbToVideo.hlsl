@@ -0,0 +1,56 @@
+// RGBA16F (linear scRGB) -> video encoder input.  See ConvertShader.h.
+
+Texture2D<float4>         srcTex : register(t0);
+SamplerState              linearClamp : register(s0);
+RWTexture2D<unorm float4> dstTex : register(u0);
+
+cbuffer VideoParams : register(b0) {
+    int2  size;      // encoded size
+    float scale;     // SDR: 80 / paperWhiteNits; HDR10: 80 / 10000 (scRGB -> PQ range)
+    uint  hdr10;     // 0 = sRGB BGRA8, 1 = BT.2020 PQ R10G10B10A2
+};
+
+float LinearToSrgb(float c) {
+    return (c <= 0.0031308) ? (c * 12.92) : (1.055 * pow(c, 1.0 / 2.4) - 0.055);
+}
+
+// SMPTE ST 2084 inverse EOTF; y = luminance / 10000 nits.
+float3 LinearToPq(float3 y) {
+    const float m1 = 0.1593017578125;
+    const float m2 = 78.84375;
+    const float c1 = 0.8359375;
+    const float c2 = 18.8515625;
+    const float c3 = 18.6875;
+    float3 p = pow(max(y, 0.0), m1);
+    return pow((c1 + c2 * p) / (1.0 + c3 * p), m2);
+}
+
+// BT.709 -> BT.2020 primaries (linear light).
+static const float3x3 kRec709ToRec2020 = {
+    0.6274040, 0.3292820, 0.0433136,
+    0.0690970, 0.9195400, 0.0113612,
+    0.0163916, 0.0880132, 0.8955950,
+};
+
+[numthreads(16, 16, 1)]
+void CSMain(uint3 dtid : SV_DispatchThreadID)
+{
+    if ((int)dtid.x >= size.x || (int)dtid.y >= size.y)
+        return;
+
+    // Bilinear in linear light, so a desktop larger than the codec allows
+    // is scaled down on the way.
+    const float2 uv = (float2(dtid.xy) + 0.5) / float2(size);
+    const float3 c = srcTex.SampleLevel(linearClamp, uv, 0).rgb * scale;
+
+    float3 o;
+    if (hdr10) {
+        o = LinearToPq(saturate(mul(kRec709ToRec2020, c)));
+    } else {
+        const float3 s = saturate(c);
+        o = float3(LinearToSrgb(s.r), LinearToSrgb(s.g), LinearToSrgb(s.b));
+    }
+
+    // UAV writes RGBA; BGRA8 / R10G10B10A2 swizzle to memory order.
+    dstTex[int2(dtid.xy)] = float4(o, 1.0);
+}
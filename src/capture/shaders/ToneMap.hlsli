@@ -0,0 +1,112 @@
+// Shared by the scRGB -> SDR passes: per-monitor white levels (b1), the
+// auto-exposure result (t1) and the tone-map operators.  See ConvertShader.h.
+//
+// TONEMAP_OPERATOR selects the operator at compile time; CMakeLists.txt
+// builds one permutation of each pass per operator.
+//   0  clip         everything above SDR white clips (the default)
+//   1  Reinhard     extended Reinhard on luminance, white point = peak
+//   2  BT.2390      ITU-R BT.2390 EETF: PQ-domain roll-off, peak -> SDR white
+//   3  ACES         Narkowicz's fit of the ACES filmic curve, per channel,
+//                   rescaled so that peak -> SDR white
+
+#ifndef TONEMAP_OPERATOR
+#define TONEMAP_OPERATOR 0
+#endif
+
+cbuffer WhiteParams : register(b1) {
+    float  fallbackScale;   // 80 / paperWhiteNits outside the regions (1 for sRGB sources)
+    float  fallbackPeak;    // source peak / paper white outside them
+    int    regionCount;
+    float  whitePad0;
+    int4   regionRect[8];   // per monitor: left, top, right, bottom
+    float4 regionWhite[8];  // per monitor: .x scale, .y peak (as above)
+};
+
+// Exposure for the SDR-white-relative values: 1, or the auto-exposure
+// pass's pick.
+StructuredBuffer<float> exposure : register(t1);
+
+// (scale, peak) of the monitor showing frame pixel p.
+float2 WhiteAt(int2 p)
+{
+    for (int i = 0; i < regionCount; ++i) {
+        const int4 r = regionRect[i];
+        if (p.x >= r.x && p.y >= r.y && p.x < r.z && p.y < r.w)
+            return regionWhite[i].xy;
+    }
+    return float2(fallbackScale, fallbackPeak);
+}
+
+float Luminance(float3 c)
+{
+    return dot(c, float3(0.2126, 0.7152, 0.0722));   // BT.709
+}
+
+// SMPTE ST 2084, normalised to 10 000 nits.
+float PqFromNits(float nits)
+{
+    const float m1 = 0.1593017578125, m2 = 78.84375;
+    const float c1 = 0.8359375, c2 = 18.8515625, c3 = 18.6875;
+    const float y = pow(saturate(nits / 10000.0), m1);
+    return pow((c1 + c2 * y) / (1.0 + c3 * y), m2);
+}
+
+float NitsFromPq(float e)
+{
+    const float m1 = 0.1593017578125, m2 = 78.84375;
+    const float c1 = 0.8359375, c2 = 18.8515625, c3 = 18.6875;
+    const float p = pow(saturate(e), 1.0 / m2);
+    return 10000.0 * pow(max(p - c1, 0.0) / (c2 - c3 * p), 1.0 / m1);
+}
+
+// BT.2390 EETF from [0, peak] to [0, 1] (SDR white), on luminance l.
+float Bt2390(float l, float peak, float paperWhite)
+{
+    const float srcMax = PqFromNits(peak * paperWhite);
+    const float maxLum = PqFromNits(paperWhite) / srcMax;
+    const float ks = max(1.5 * maxLum - 0.5, 0.0);
+
+    float e = min(PqFromNits(l * paperWhite) / srcMax, 1.0);
+    if (e > ks) {
+        // Hermite spline from the knee to the target maximum.
+        const float t = (e - ks) / (1.0 - ks);
+        const float t2 = t * t, t3 = t2 * t;
+        e = (2.0 * t3 - 3.0 * t2 + 1.0) * ks + (t3 - 2.0 * t2 + t) * (1.0 - ks) + (-2.0 * t3 + 3.0 * t2) * maxLum;
+    }
+    return NitsFromPq(e * srcMax) / paperWhite;
+}
+
+// Narkowicz's fit.  On its own it maps 1 to about 0.8; ToneMap divides by
+// its value at the peak so that peak (1 for SDR sources) lands on white.
+float3 AcesFilmic(float3 c)
+{
+    return (c * (2.51 * c + 0.03)) / (c * (2.43 * c + 0.59) + 0.14);
+}
+
+// SDR-white-relative linear colour -> [0, 1].  `peak` is the source's
+// brightest level on the same scale; `scale` its 80 / paperWhiteNits.
+float3 ToneMap(float3 c, float scale, float peak)
+{
+    c = max(c, 0.0);
+#if TONEMAP_OPERATOR == 1
+    const float l = Luminance(c);
+    if (l > 0.0)
+        c *= (1.0 + l / (peak * peak)) / (1.0 + l);
+#elif TONEMAP_OPERATOR == 2
+    const float l = Luminance(c);
+    if (l > 0.0 && peak > 1.0)
+        c *= Bt2390(l, peak, 80.0 / scale) / l;
+#elif TONEMAP_OPERATOR == 3
+    c = AcesFilmic(c) / AcesFilmic(peak).x;
+#endif
+    return saturate(c);
+}
+
+// scRGB texel at frame pixel p -> SDR [0, 1], with that monitor's white
+// level and the exposure applied.
+float3 ToneMapAt(float3 scRgb, int2 p)
+{
+    const float2 white = WhiteAt(p);
+    const float e = exposure[0];
+    return ToneMap(scRgb * (white.x * e), white.x, max(white.y * e, 1.0));
+}
@@ -1,6 +1,10 @@
 #include "preview/PreviewWindow.h"
 #include "preview/Shaders.h"
+#include "preview/WindowIndex.h"
+#include "capture/AsyncReadback.h"
 #include "capture/SaveImage.h"
+#include "capture/Trace.h"
+#include "capture/WhiteLevel.h"
 #include "capture/WindowCapture.h"
 
 #include <windows.h>
@@ -10,12 +14,12 @@
 #include <d2d1_1.h>
 #include <d2d1_1helper.h>
 #include <d3d11.h>
-#include <d3dcompiler.h>
 #include <dwrite.h>
 #include <dxgi1_4.h>
 #include <dxgi1_6.h>
 #include <wrl/client.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 
@@ -26,12 +30,11 @@ namespace {
 
 constexpr UINT kFrameCount = 2;
 
-// ── Helpers ─────────────────────────────────────────────────────────
+// Longest wait for the swap chain to take a frame; with every Present
+// paired with a slot it is at most a refresh, so this is a safety net.
+constexpr DWORD kFrameSlotWaitMs = 1000;
 
-struct WindowInfo {
-    HWND hwnd;
-    RECT rect; // DWM extended frame bounds (visible area, no shadow).
-};
+// ── Helpers ─────────────────────────────────────────────────────────
 
 struct PreviewState {
     capture::FrameData frame{};
@@ -50,9 +53,14 @@ struct PreviewState {
     // Window capture mode (only active when windowMode == true).
     bool windowMode{false};
     RECT desktopRect{};                 // virtual desktop origin for coord mapping
-    std::vector<WindowInfo> windows;    // pre-enumerated, in Z-order
-    int hoveredWindowIndex{-1};
-    HWND selectedHwnd{};                // HWND chosen by the user
+    WindowIndex windows;                // visible windows, built before the preview shows
+    WindowHit hovered;
+    POINT lastMouse{};                  // screen coordinates, for re-testing on Ctrl
+    HWND selectedHwnd{};                // top-level HWND chosen by the user (null on a child pick)
+
+    // Instant replay (only active when replayMode == true).
+    bool replayMode{false};
+    int replayStep{0};                  // pending steps, positive = older
 };
 
 RECT GetVirtualDesktopRect() noexcept
@@ -76,52 +84,24 @@ RECT NormaliseDragRect(POINT a, POINT b) noexcept
     return r;
 }
 
-// ── Window enumeration for window-capture mode ──────────────────────
+// ── Window hover (window-capture mode) ─────────────────────────────
 
-BOOL CALLBACK EnumWindowsCallback(HWND hwnd, LPARAM lParam)
+// Hold Ctrl to pick the child window under the cursor instead.
+void UpdateHover(PreviewState& state, POINT screenPt, bool children)
 {
-    auto* out = reinterpret_cast<std::vector<WindowInfo>*>(lParam);
-
-    if (!::IsWindowVisible(hwnd)) return TRUE;
-    if (::IsIconic(hwnd)) return TRUE;
-
-    // Skip cloaked windows (UWP background apps, etc.).
-    DWORD cloaked = 0;
-    if (SUCCEEDED(::DwmGetWindowAttribute(hwnd, DWMWA_CLOAKED, &cloaked, sizeof(cloaked))) && cloaked) {
-        return TRUE;
+    state.lastMouse = screenPt;
+    const WindowHit hit = state.windows.HitTest(screenPt, children);
+    if (!(hit == state.hovered)) {
+        state.hovered = hit;
+        state.needsRedraw = true;
     }
-
-    // Use DWM extended frame bounds (visible area without shadow).
-    RECT r{};
-    if (FAILED(::DwmGetWindowAttribute(hwnd, DWMWA_EXTENDED_FRAME_BOUNDS, &r, sizeof(r)))) {
-        if (!::GetWindowRect(hwnd, &r)) return TRUE;
-    }
-
-    if (r.right - r.left <= 1 || r.bottom - r.top <= 1) return TRUE;
-
-    out->push_back({hwnd, r});
-    return TRUE;
 }
 
-[[nodiscard]] std::vector<WindowInfo> EnumerateVisibleWindows()
+LPCWSTR CursorFor(const PreviewState& state) noexcept
 {
-    std::vector<WindowInfo> windows;
-    ::EnumWindows(EnumWindowsCallback, reinterpret_cast<LPARAM>(&windows));
-    return windows;
-}
-
-// Find the topmost window whose rect contains the given screen-space point.
-// EnumWindows enumerates in Z-order (front to back), so the first hit is topmost.
-[[nodiscard]] int FindWindowAtPoint(const std::vector<WindowInfo>& windows, POINT screenPt)
-{
-    for (int i = 0; i < static_cast<int>(windows.size()); ++i) {
-        const auto& r = windows[i].rect;
-        if (screenPt.x >= r.left && screenPt.x < r.right &&
-            screenPt.y >= r.top && screenPt.y < r.bottom) {
-            return i;
-        }
-    }
-    return -1;
+    if (state.regionMode) return IDC_CROSS;
+    if (state.windowMode) return IDC_HAND;
+    return IDC_ARROW;
 }
 
 // ── WndProc ─────────────────────────────────────────────────────────
@@ -140,15 +120,31 @@ LRESULT CALLBACK PreviewWndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp)
     case WM_KEYDOWN:
         if (wp == VK_ESCAPE && state) {
             state->done = true;
+        } else if (wp == VK_CONTROL && state && state->windowMode) {
+            UpdateHover(*state, state->lastMouse, true);
+        } else if (state && state->replayMode) {
+            if (wp == VK_LEFT) ++state->replayStep;
+            else if (wp == VK_RIGHT) --state->replayStep;
+            else if (wp == VK_RETURN) state->userClickedSave = state->done = true;
+        }
+        return 0;
+
+    case WM_MOUSEWHEEL:
+        // Wheel up (away from the user) goes back in time.
+        if (state && state->replayMode) {
+            state->replayStep += GET_WHEEL_DELTA_WPARAM(wp) > 0 ? 1 : -1;
+        }
+        return 0;
+
+    case WM_KEYUP:
+        if (wp == VK_CONTROL && state && state->windowMode) {
+            UpdateHover(*state, state->lastMouse, false);
         }
         return 0;
 
     case WM_SETCURSOR:
         if (LOWORD(lp) == HTCLIENT && state) {
-            LPCWSTR cur = IDC_ARROW;
-            if (state->regionMode) cur = IDC_CROSS;
-            else if (state->windowMode) cur = IDC_HAND;
-            ::SetCursor(::LoadCursorW(nullptr, cur));
+            ::SetCursor(::LoadCursorW(nullptr, CursorFor(*state)));
             return TRUE;
         }
         return ::DefWindowProcW(hwnd, msg, wp, lp);
@@ -169,11 +165,7 @@ LRESULT CALLBACK PreviewWndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp)
             POINT screenPt;
             screenPt.x = GET_X_LPARAM(lp) + state->desktopRect.left;
             screenPt.y = GET_Y_LPARAM(lp) + state->desktopRect.top;
-            const int idx = FindWindowAtPoint(state->windows, screenPt);
-            if (idx != state->hoveredWindowIndex) {
-                state->hoveredWindowIndex = idx;
-                state->needsRedraw = true;
-            }
+            UpdateHover(*state, screenPt, (wp & MK_CONTROL) != 0);
         } else if (state && state->regionMode && state->dragging) {
             state->dragEnd = {GET_X_LPARAM(lp), GET_Y_LPARAM(lp)};
             state->needsRedraw = true;
@@ -195,14 +187,16 @@ LRESULT CALLBACK PreviewWndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp)
             return 0;
         }
         // Window mode: select hovered window.
-        if (state && state->windowMode && state->hoveredWindowIndex >= 0) {
-            const auto& wi = state->windows[state->hoveredWindowIndex];
-            state->selectedHwnd = wi.hwnd;
-            // Also store the rect as fallback for CropFrame.
-            state->selection.left = wi.rect.left - state->desktopRect.left;
-            state->selection.top = wi.rect.top - state->desktopRect.top;
-            state->selection.right = wi.rect.right - state->desktopRect.left;
-            state->selection.bottom = wi.rect.bottom - state->desktopRect.top;
+        if (state && state->windowMode && state->hovered.window >= 0) {
+            const auto& hit = state->hovered;
+            // Child windows can't be captured on their own; they are cut
+            // from the desktop frame instead.
+            state->selectedHwnd = hit.child ? nullptr : hit.hwnd;
+            // Also store the rect as fallback for capture::CropFrame.
+            state->selection.left = hit.rect.left - state->desktopRect.left;
+            state->selection.top = hit.rect.top - state->desktopRect.top;
+            state->selection.right = hit.rect.right - state->desktopRect.left;
+            state->selection.bottom = hit.rect.bottom - state->desktopRect.top;
             state->selectionComplete = true;
             state->done = true;
             return 0;
@@ -225,6 +219,13 @@ LRESULT CALLBACK PreviewWndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp)
         }
         return 0;
 
+    // The window outlives each preview: Alt+F4 ends the preview only.
+    case WM_CLOSE:
+        if (state) {
+            state->done = true;
+        }
+        return 0;
+
     case WM_DESTROY:
         if (state) {
             state->done = true;
@@ -235,6 +236,25 @@ LRESULT CALLBACK PreviewWndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp)
     }
 }
 
+// ── Overlay state ───────────────────────────────────────────────────
+
+// What the region/window overlay shows: an undimmed hole (the selection or
+// the hovered window) outlined with a border and a W×H label, or — when
+// there is no hole — the whole screen dimmed.
+struct OverlayHole {
+    bool any{false};
+    RECT rect{};        // client coordinates, clamped to the screen
+    int  labelW{};      // dimensions printed on the label
+    int  labelH{};
+};
+
+bool operator==(const OverlayHole& a, const OverlayHole& b) noexcept
+{
+    if (a.any != b.any) return false;
+    if (!a.any) return true;
+    return ::EqualRect(&a.rect, &b.rect) && a.labelW == b.labelW && a.labelH == b.labelH;
+}
+
 // ── DX11 pipeline objects ───────────────────────────────────────────
 
 struct DX11Context {
@@ -247,8 +267,21 @@ struct DX11Context {
     ComPtr<ID3D11PixelShader> ps;
     ComPtr<ID3D11SamplerState> sampler;
     ComPtr<ID3D11ShaderResourceView> textureSRV;
+    ComPtr<ID3D11RasterizerState> scissorState;  // partial redraws
     DXGI_FORMAT backBufferFormat{DXGI_FORMAT_B8G8R8A8_UNORM};
     DXGI_COLOR_SPACE_TYPE swapChainColorSpace{DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_P709};
+
+    // Frame pacing: signalled when the swap chain can take another frame
+    // (max latency 1).  frameSlot means we consumed a signal and owe a Present.
+    HANDLE frameLatencyWait{};
+    bool   frameSlot{false};
+
+    // FLIP_SEQUENTIAL keeps each back buffer's contents, so a redraw only
+    // has to repaint what differs from what that buffer last showed.
+    OverlayHole shown[kFrameCount]{};
+    bool        shownValid[kFrameCount]{};
+    OverlayHole presented{};            // last frame handed to Present1
+    UINT        presentCount{};
 };
 
 // ── D2D overlay (native D3D11 interop) ──────────────────────────────
@@ -262,18 +295,64 @@ struct D2DOverlay {
     ComPtr<ID2D1Bitmap1> d2dRenderTarget;
 };
 
-bool CompileShader(const char* source, const char* target, const char* entry, ComPtr<ID3DBlob>& blob)
+// Render target view for the back buffer (again after ResizeBuffers).
+bool CreateBackBufferTarget(DX11Context& dx)
 {
-    ComPtr<ID3DBlob> errors;
-    HRESULT hr = ::D3DCompile(
-        source, std::strlen(source),
-        nullptr, nullptr, nullptr,
-        entry, target,
-        D3DCOMPILE_OPTIMIZATION_LEVEL3, 0,
-        &blob, &errors);
+    ComPtr<ID3D11Texture2D> backBuf;
+    HRESULT hr = dx.swapChain->GetBuffer(0, IID_PPV_ARGS(&backBuf));
+    if (FAILED(hr)) return false;
+    hr = dx.device->CreateRenderTargetView(backBuf.Get(), nullptr, &dx.rtv);
     return SUCCEEDED(hr);
 }
 
+// Forget what the back buffers show, so the next presents are full frames.
+void ResetPresentHistory(DX11Context& dx)
+{
+    for (UINT i = 0; i < kFrameCount; ++i) {
+        dx.shownValid[i] = false;
+    }
+    dx.presented = {};
+    dx.presentCount = 0;
+    // frameSlot stays: a consumed signal is still owed a Present.
+}
+
+// ── Frame pacing ────────────────────────────────────────────────────
+
+// True if the swap chain can take a frame (consumes the latency signal),
+// waiting up to timeoutMs for it.  A slot already held is kept.
+bool TakeFrameSlot(DX11Context& dx, DWORD timeoutMs = 0)
+{
+    if (!dx.frameLatencyWait || dx.frameSlot) return true;
+    dx.frameSlot = ::WaitForSingleObject(dx.frameLatencyWait, timeoutMs) == WAIT_OBJECT_0;
+    return dx.frameSlot;
+}
+
+// Present a fully drawn frame.  Every Present goes through a slot, so the
+// latency signal and our frameSlot never disagree.
+void PresentFrame(DX11Context& dx)
+{
+    (void)TakeFrameSlot(dx, kFrameSlotWaitMs);
+    dx.swapChain->Present(1, 0);
+    dx.frameSlot = false;
+}
+
+// Sleep until input arrives or, when a redraw is due, until the swap chain
+// can take the frame.  Mouse moves that arrive meanwhile are drained before
+// the next render, so they coalesce into one frame.
+void WaitForInputOrFrame(DX11Context& dx, bool frameDue)
+{
+    if (frameDue && dx.frameLatencyWait && !dx.frameSlot) {
+        HANDLE h = dx.frameLatencyWait;
+        if (::MsgWaitForMultipleObjects(1, &h, FALSE, INFINITE, QS_ALLINPUT) == WAIT_OBJECT_0) {
+            dx.frameSlot = true;
+        }
+        return;
+    }
+    if (!frameDue) {
+        ::WaitMessage();
+    }
+}
+
 bool InitDX11(DX11Context& dx, ID3D11Device* sharedDevice, HWND hwnd, UINT width, UINT height)
 {
     HRESULT hr{};
@@ -297,8 +376,9 @@ bool InitDX11(DX11Context& dx, ID3D11Device* sharedDevice, HWND hwnd, UINT width
     scDesc.Height = height;
     scDesc.Format = dx.backBufferFormat;
     scDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-    scDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+    scDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
     scDesc.SampleDesc.Count = 1;
+    scDesc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
 
     ComPtr<IDXGISwapChain1> sc1;
     hr = dx.factory->CreateSwapChainForHwnd(dx.device.Get(), hwnd, &scDesc, nullptr, nullptr, &sc1);
@@ -312,6 +392,12 @@ bool InitDX11(DX11Context& dx, ID3D11Device* sharedDevice, HWND hwnd, UINT width
     hr = sc1.As(&dx.swapChain);
     if (FAILED(hr)) return false;
 
+    // One frame in flight: the selection never trails the cursor by more
+    // than the frame being scanned out.
+    if (SUCCEEDED(dx.swapChain->SetMaximumFrameLatency(1))) {
+        dx.frameLatencyWait = dx.swapChain->GetFrameLatencyWaitableObject();
+    }
+
     {
         UINT support = 0;
         if (SUCCEEDED(dx.swapChain->CheckColorSpaceSupport(dx.swapChainColorSpace, &support)) &&
@@ -322,23 +408,12 @@ bool InitDX11(DX11Context& dx, ID3D11Device* sharedDevice, HWND hwnd, UINT width
 
     dx.factory->MakeWindowAssociation(hwnd, DXGI_MWA_NO_ALT_ENTER);
 
-    // Render target view for the back buffer.
-    ComPtr<ID3D11Texture2D> backBuf;
-    hr = dx.swapChain->GetBuffer(0, IID_PPV_ARGS(&backBuf));
-    if (FAILED(hr)) return false;
-    hr = dx.device->CreateRenderTargetView(backBuf.Get(), nullptr, &dx.rtv);
-    if (FAILED(hr)) return false;
-
-    // Compile and create shaders.
-    ComPtr<ID3DBlob> vsBlob, psBlob;
-    if (!CompileShader(kVertexShaderHLSL, "vs_5_0", "VSMain", vsBlob)) return false;
-    if (!CompileShader(kPixelShaderHLSL, "ps_5_0", "PSMain", psBlob)) return false;
+    if (!CreateBackBufferTarget(dx)) return false;
 
-    hr = dx.device->CreateVertexShader(
-        vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, &dx.vs);
+    // Shaders (bytecode compiled at build time).
+    hr = dx.device->CreateVertexShader(kPreviewVS, sizeof(kPreviewVS), nullptr, &dx.vs);
     if (FAILED(hr)) return false;
-    hr = dx.device->CreatePixelShader(
-        psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, &dx.ps);
+    hr = dx.device->CreatePixelShader(kPreviewPS, sizeof(kPreviewPS), nullptr, &dx.ps);
     if (FAILED(hr)) return false;
 
     // Sampler state (linear, clamp).
@@ -351,9 +426,32 @@ bool InitDX11(DX11Context& dx, ID3D11Device* sharedDevice, HWND hwnd, UINT width
     hr = dx.device->CreateSamplerState(&sampDesc, &dx.sampler);
     if (FAILED(hr)) return false;
 
+    D3D11_RASTERIZER_DESC rsDesc{};
+    rsDesc.FillMode = D3D11_FILL_SOLID;
+    rsDesc.CullMode = D3D11_CULL_NONE;
+    rsDesc.DepthClipEnable = TRUE;
+    rsDesc.ScissorEnable = TRUE;
+    hr = dx.device->CreateRasterizerState(&rsDesc, &dx.scissorState);
+    if (FAILED(hr)) return false;
+
     return true;
 }
 
+// D2D render target on the swap chain back buffer (again after ResizeBuffers).
+bool CreateOverlayTarget(D2DOverlay& ov, DX11Context& dx)
+{
+    ComPtr<IDXGISurface> surface;
+    HRESULT hr = dx.swapChain->GetBuffer(0, IID_PPV_ARGS(&surface));
+    if (FAILED(hr)) return false;
+
+    D2D1_BITMAP_PROPERTIES1 bmpProps = D2D1::BitmapProperties1(
+        D2D1_BITMAP_OPTIONS_TARGET | D2D1_BITMAP_OPTIONS_CANNOT_DRAW,
+        D2D1::PixelFormat(dx.backBufferFormat, D2D1_ALPHA_MODE_PREMULTIPLIED));
+
+    hr = ov.d2dCtx->CreateBitmapFromDxgiSurface(surface.Get(), &bmpProps, &ov.d2dRenderTarget);
+    return SUCCEEDED(hr);
+}
+
 bool InitD2DOverlay(D2DOverlay& ov, DX11Context& dx)
 {
     HRESULT hr{};
@@ -372,17 +470,7 @@ bool InitD2DOverlay(D2DOverlay& ov, DX11Context& dx)
     hr = ov.d2dDevice->CreateDeviceContext(D2D1_DEVICE_CONTEXT_OPTIONS_NONE, &ov.d2dCtx);
     if (FAILED(hr)) return false;
 
-    // Create a D2D render target from the swap chain back buffer.
-    ComPtr<IDXGISurface> surface;
-    hr = dx.swapChain->GetBuffer(0, IID_PPV_ARGS(&surface));
-    if (FAILED(hr)) return false;
-
-    D2D1_BITMAP_PROPERTIES1 bmpProps = D2D1::BitmapProperties1(
-        D2D1_BITMAP_OPTIONS_TARGET | D2D1_BITMAP_OPTIONS_CANNOT_DRAW,
-        D2D1::PixelFormat(dx.backBufferFormat, D2D1_ALPHA_MODE_PREMULTIPLIED));
-
-    hr = ov.d2dCtx->CreateBitmapFromDxgiSurface(surface.Get(), &bmpProps, &ov.d2dRenderTarget);
-    if (FAILED(hr)) return false;
+    if (!CreateOverlayTarget(ov, dx)) return false;
 
     // DWrite factory for dimension labels.
     hr = ::DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED,
@@ -426,7 +514,7 @@ bool UploadTexture(DX11Context& dx, const capture::FrameData& frame)
         return SUCCEEDED(hr);
     }
 
-    // Fallback: upload from CPU pixels (e.g. WindowCapture frames).
+    // Fallback: upload from CPU pixels (frames without a GPU texture).
     D3D11_TEXTURE2D_DESC texDesc{};
     texDesc.Width = frame.width;
     texDesc.Height = frame.height;
@@ -453,14 +541,23 @@ bool UploadTexture(DX11Context& dx, const capture::FrameData& frame)
 }
 
 // Render the desktop texture but do not present -- D2D draws on top next.
-void RenderFrameNoPresent(DX11Context& dx, UINT width, UINT height)
+// With `scissor` only those rects are redrawn; the rest of the back buffer
+// is kept (the quad covers the whole screen, so no clear is needed).
+void RenderFrameNoPresent(DX11Context& dx, UINT width, UINT height,
+                          const std::vector<D3D11_RECT>* scissor = nullptr)
 {
-    const float clearColor[] = {0.0f, 0.0f, 0.0f, 1.0f};
-    dx.ctx->ClearRenderTargetView(dx.rtv.Get(), clearColor);
+    if (!scissor) {
+        const float clearColor[] = {0.0f, 0.0f, 0.0f, 1.0f};
+        dx.ctx->ClearRenderTargetView(dx.rtv.Get(), clearColor);
+    }
     dx.ctx->OMSetRenderTargets(1, dx.rtv.GetAddressOf(), nullptr);
 
     D3D11_VIEWPORT vp{0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f, 1.0f};
     dx.ctx->RSSetViewports(1, &vp);
+    if (scissor) {
+        dx.ctx->RSSetState(dx.scissorState.Get());
+        dx.ctx->RSSetScissorRects(static_cast<UINT>(scissor->size()), scissor->data());
+    }
 
     dx.ctx->VSSetShader(dx.vs.Get(), nullptr, 0);
     dx.ctx->PSSetShader(dx.ps.Get(), nullptr, 0);
@@ -470,6 +567,10 @@ void RenderFrameNoPresent(DX11Context& dx, UINT width, UINT height)
     dx.ctx->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     dx.ctx->Draw(3, 0);
 
+    if (scissor) {
+        dx.ctx->RSSetState(nullptr);
+    }
+
     // Unbind the render target so D2D can draw on the back buffer.
     ID3D11RenderTargetView* nullRTV = nullptr;
     dx.ctx->OMSetRenderTargets(1, &nullRTV, nullptr);
@@ -493,7 +594,7 @@ void RenderFrame(DX11Context& dx, UINT width, UINT height)
     dx.ctx->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     dx.ctx->Draw(3, 0);
 
-    dx.swapChain->Present(1, 0);
+    PresentFrame(dx);
 }
 
 // ── Shared overlay building blocks ──────────────────────────────────
@@ -564,30 +665,35 @@ void DrawBorderAndLabel(ID2D1DeviceContext* ctx, const OverlayBrushes& br,
 
 // ── Overlay functions (thin wrappers around the shared primitives) ───
 
-void DrawSelectionOverlay(D2DOverlay& ov, const RECT& sel, UINT screenW, UINT screenH)
+OverlayHole SelectionHole(const RECT& sel)
 {
-    ov.d2dCtx->SetTarget(ov.d2dRenderTarget.Get());
-    ov.d2dCtx->BeginDraw();
-
-    const float sw = static_cast<float>(screenW);
-    const float sh = static_cast<float>(screenH);
-    const float l = static_cast<float>(sel.left);
-    const float t = static_cast<float>(sel.top);
-    const float r = static_cast<float>(sel.right);
-    const float b = static_cast<float>(sel.bottom);
-
-    auto br = CreateOverlayBrushes(ov.d2dCtx.Get());
-    DimAroundRect(ov.d2dCtx.Get(), br.dim.Get(), l, t, r, b, sw, sh);
-    DrawBorderAndLabel(ov.d2dCtx.Get(), br, ov.textFormat.Get(),
-                       l, t, r, b, sel.right - sel.left, sel.bottom - sel.top);
+    OverlayHole hole;
+    hole.any = true;
+    hole.rect = sel;
+    hole.labelW = sel.right - sel.left;
+    hole.labelH = sel.bottom - sel.top;
+    return hole;
+}
 
-    (void)ov.d2dCtx->EndDraw();
-    ov.d2dCtx->SetTarget(nullptr);
+OverlayHole WindowHole(const WindowHit& hovered, const RECT& desktopRect, UINT screenW, UINT screenH)
+{
+    OverlayHole hole;
+    if (hovered.window < 0) return hole;   // no window hovered -- dim everything
+
+    const auto& wr = hovered.rect;
+    hole.any = true;
+    hole.rect.left   = (std::max)(0L, wr.left - desktopRect.left);
+    hole.rect.top    = (std::max)(0L, wr.top - desktopRect.top);
+    hole.rect.right  = (std::min)(static_cast<LONG>(screenW), wr.right - desktopRect.left);
+    hole.rect.bottom = (std::min)(static_cast<LONG>(screenH), wr.bottom - desktopRect.top);
+    hole.labelW = wr.right - wr.left;
+    hole.labelH = wr.bottom - wr.top;
+    return hole;
 }
 
-void DrawWindowOverlay(D2DOverlay& ov,
-                       int hoveredIndex, const std::vector<WindowInfo>& windows,
-                       const RECT& desktopRect, UINT screenW, UINT screenH)
+// Draw the overlay for `hole`, restricted to `clips` (all of it if empty).
+void DrawHoleOverlay(D2DOverlay& ov, const OverlayHole& hole, UINT screenW, UINT screenH,
+                     const std::vector<D3D11_RECT>& clips)
 {
     ov.d2dCtx->SetTarget(ov.d2dRenderTarget.Get());
     ov.d2dCtx->BeginDraw();
@@ -596,29 +702,148 @@ void DrawWindowOverlay(D2DOverlay& ov,
     const float sh = static_cast<float>(screenH);
     auto br = CreateOverlayBrushes(ov.d2dCtx.Get());
 
-    if (hoveredIndex < 0) {
-        // No window hovered -- dim the entire screen.
-        if (br.dim) {
-            ov.d2dCtx->FillRectangle(D2D1::RectF(0, 0, sw, sh), br.dim.Get());
+    const auto draw = [&] {
+        if (!hole.any) {
+            if (br.dim) ov.d2dCtx->FillRectangle(D2D1::RectF(0, 0, sw, sh), br.dim.Get());
+            return;
         }
-    } else {
-        const auto& wr = windows[hoveredIndex].rect;
-        float l = static_cast<float>(wr.left - desktopRect.left);
-        float t = static_cast<float>(wr.top - desktopRect.top);
-        float r = static_cast<float>(wr.right - desktopRect.left);
-        float b = static_cast<float>(wr.bottom - desktopRect.top);
-        l = (std::max)(0.0f, l);  t = (std::max)(0.0f, t);
-        r = (std::min)(sw, r);    b = (std::min)(sh, b);
-
+        const float l = static_cast<float>(hole.rect.left);
+        const float t = static_cast<float>(hole.rect.top);
+        const float r = static_cast<float>(hole.rect.right);
+        const float b = static_cast<float>(hole.rect.bottom);
         DimAroundRect(ov.d2dCtx.Get(), br.dim.Get(), l, t, r, b, sw, sh);
         DrawBorderAndLabel(ov.d2dCtx.Get(), br, ov.textFormat.Get(),
-                           l, t, r, b, wr.right - wr.left, wr.bottom - wr.top);
+                           l, t, r, b, hole.labelW, hole.labelH);
+    };
+
+    if (clips.empty()) {
+        draw();
+    } else {
+        for (const auto& c : clips) {
+            ov.d2dCtx->PushAxisAlignedClip(
+                D2D1::RectF(static_cast<float>(c.left), static_cast<float>(c.top),
+                            static_cast<float>(c.right), static_cast<float>(c.bottom)),
+                D2D1_ANTIALIAS_MODE_ALIASED);
+            draw();
+            ov.d2dCtx->PopAxisAlignedClip();
+        }
     }
 
     (void)ov.d2dCtx->EndDraw();
     ov.d2dCtx->SetTarget(nullptr);
 }
 
+// ── Partial redraw ──────────────────────────────────────────────────
+
+// How far the border strokes reach outside / inside the hole rect.
+constexpr LONG kBorderOutset = 4;
+constexpr LONG kBorderInset  = 8;
+
+// Screen area of the W×H label (matches DrawBorderAndLabel), padded.
+RECT LabelRect(const OverlayHole& hole) noexcept
+{
+    return {hole.rect.right - 10 - 200 - 6, hole.rect.bottom - 10 - 30 - 4,
+            hole.rect.right - 10 + 6,       hole.rect.bottom - 10 + 4};
+}
+
+void AddDirty(std::vector<D3D11_RECT>& out, RECT r, UINT screenW, UINT screenH)
+{
+    r.left   = (std::max)(0L, r.left);
+    r.top    = (std::max)(0L, r.top);
+    r.right  = (std::min)(static_cast<LONG>(screenW), r.right);
+    r.bottom = (std::min)(static_cast<LONG>(screenH), r.bottom);
+    if (r.right > r.left && r.bottom > r.top) {
+        out.push_back(r);
+    }
+}
+
+// Screen rects whose pixels differ between the overlay for `from` and for
+// `to`: the band between the two outlines, plus both labels.  Empty if
+// nothing changed.
+std::vector<D3D11_RECT> OverlayDiff(const OverlayHole& from, const OverlayHole& to,
+                                    UINT screenW, UINT screenH)
+{
+    std::vector<D3D11_RECT> dirty;
+    if (from == to) return dirty;
+
+    if (!from.any || !to.any) {
+        // Dimmed screen ↔ hole: only the hole (and its outline) changes,
+        // and the label, which sticks out of holes smaller than itself.
+        const OverlayHole& hole = from.any ? from : to;
+        RECT r = hole.rect;
+        ::InflateRect(&r, kBorderOutset, kBorderOutset);
+        AddDirty(dirty, r, screenW, screenH);
+        AddDirty(dirty, LabelRect(hole), screenW, screenH);
+        return dirty;
+    }
+
+    RECT a = from.rect, b = to.rect;
+    ::InflateRect(&a, kBorderOutset, kBorderOutset);
+    ::InflateRect(&b, kBorderOutset, kBorderOutset);
+    RECT outer{};
+    ::UnionRect(&outer, &a, &b);
+
+    // Interior both frames show undimmed and without border.
+    RECT ia = from.rect, ib = to.rect;
+    ::InflateRect(&ia, -kBorderInset, -kBorderInset);
+    ::InflateRect(&ib, -kBorderInset, -kBorderInset);
+    RECT inner{};
+    if (!::IntersectRect(&inner, &ia, &ib)) {
+        AddDirty(dirty, outer, screenW, screenH);
+        return dirty;
+    }
+
+    AddDirty(dirty, {outer.left, outer.top, outer.right, inner.top}, screenW, screenH);
+    AddDirty(dirty, {outer.left, inner.bottom, outer.right, outer.bottom}, screenW, screenH);
+    AddDirty(dirty, {outer.left, inner.top, inner.left, inner.bottom}, screenW, screenH);
+    AddDirty(dirty, {inner.right, inner.top, outer.right, inner.bottom}, screenW, screenH);
+    AddDirty(dirty, LabelRect(from), screenW, screenH);
+    AddDirty(dirty, LabelRect(to), screenW, screenH);
+    return dirty;
+}
+
+// Draw the desktop with the overlay for `hole` and present it.  Only the
+// parts of the back buffer that differ from what it last showed are
+// repainted, and Present1 is told what changed since the previous frame,
+// so a small drag costs a few strips instead of the whole virtual desktop.
+void PresentOverlay(DX11Context& dx, D2DOverlay& ov, const OverlayHole& hole, UINT screenW, UINT screenH)
+{
+    const UINT buffer = dx.swapChain->GetCurrentBackBufferIndex() % kFrameCount;
+
+    // The first frames on each buffer (and the first presents) are full.
+    const bool full = !dx.shownValid[buffer] || dx.presentCount < kFrameCount;
+    std::vector<D3D11_RECT> repaint;
+    if (!full) {
+        repaint = OverlayDiff(dx.shown[buffer], hole, screenW, screenH);
+    }
+
+    if (full) {
+        RenderFrameNoPresent(dx, screenW, screenH);
+        DrawHoleOverlay(ov, hole, screenW, screenH, {});
+    } else if (!repaint.empty()) {
+        RenderFrameNoPresent(dx, screenW, screenH, &repaint);
+        DrawHoleOverlay(ov, hole, screenW, screenH, repaint);
+    }
+    dx.shown[buffer] = hole;
+    dx.shownValid[buffer] = true;
+
+    std::vector<D3D11_RECT> changed;
+    if (!full) {
+        changed = OverlayDiff(dx.presented, hole, screenW, screenH);
+    }
+    (void)TakeFrameSlot(dx, kFrameSlotWaitMs);   // no-op for callers that took one
+    DXGI_PRESENT_PARAMETERS params{};
+    if (!changed.empty()) {
+        params.DirtyRectsCount = static_cast<UINT>(changed.size());
+        params.pDirtyRects = changed.data();
+    }
+    (void)dx.swapChain->Present1(1, 0, &params);
+
+    dx.presented = hole;
+    ++dx.presentCount;
+    dx.frameSlot = false;
+}
+
 // ── Monitor enumeration for full-desktop border overlay ─────────────
 
 BOOL CALLBACK MonitorEnumCallback(HMONITOR /*hmon*/, HDC /*hdc*/, LPRECT rect, LPARAM lParam)
@@ -657,40 +882,51 @@ void DrawMonitorBorders(D2DOverlay& ov, const std::vector<RECT>& monitors,
     ov.d2dCtx->SetTarget(nullptr);
 }
 
-// Crop a FrameData to a sub-rectangle.
-capture::FrameData CropFrame(const capture::FrameData& src, RECT sel)
+// "Instant replay −1.8 s (3 / 40)" banner, top centre.
+void DrawReplayLabel(D2DOverlay& ov, double ageSeconds, size_t index, size_t count, UINT screenW)
 {
-    // Clamp selection to frame bounds.
-    sel.left = (std::max)(0L, (std::min)(sel.left, static_cast<LONG>(src.width)));
-    sel.top = (std::max)(0L, (std::min)(sel.top, static_cast<LONG>(src.height)));
-    sel.right = (std::max)(0L, (std::min)(sel.right, static_cast<LONG>(src.width)));
-    sel.bottom = (std::max)(0L, (std::min)(sel.bottom, static_cast<LONG>(src.height)));
-
-    const uint32_t cropW = static_cast<uint32_t>(sel.right - sel.left);
-    const uint32_t cropH = static_cast<uint32_t>(sel.bottom - sel.top);
+    wchar_t buf[128]{};
+    (void)std::swprintf(buf, _countof(buf),
+                        L"Instant replay  \u2212%.1f s  (%zu / %zu)    \u2190 \u2192 step \u00B7 click to save",
+                        ageSeconds, index, count);
 
-    capture::FrameData out;
-    out.width = cropW;
-    out.height = cropH;
-    out.format = src.format;
-    out.bytesPerPixel = src.bytesPerPixel;
-    out.pixels.resize(static_cast<size_t>(cropW) * src.bytesPerPixel * cropH);
+    constexpr float labelW = 620.0f;
+    constexpr float labelH = 30.0f;
+    constexpr float pad = 10.0f;
+    const float labelX = (static_cast<float>(screenW) - labelW) * 0.5f;
 
-    const uint32_t srcStride = src.width * src.bytesPerPixel;
-    const uint32_t dstStride = cropW * src.bytesPerPixel;
-
-    for (uint32_t row = 0; row < cropH; ++row) {
-        const size_t srcOff = static_cast<size_t>(sel.top + row) * srcStride + static_cast<size_t>(sel.left) * src.bytesPerPixel;
-        const size_t dstOff = static_cast<size_t>(row) * dstStride;
-        std::memcpy(out.pixels.data() + dstOff, src.pixels.data() + srcOff, dstStride);
+    ov.d2dCtx->SetTarget(ov.d2dRenderTarget.Get());
+    ov.d2dCtx->BeginDraw();
+    auto br = CreateOverlayBrushes(ov.d2dCtx.Get());
+    if (br.black) {
+        ov.d2dCtx->FillRectangle(D2D1::RectF(labelX - 4.0f, pad - 2.0f, labelX + labelW + 4.0f, pad + labelH + 2.0f),
+                                 br.black.Get());
+    }
+    if (br.green && ov.textFormat) {
+        ov.textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
+        ov.d2dCtx->DrawText(buf, static_cast<UINT32>(wcslen(buf)), ov.textFormat.Get(),
+                            D2D1::RectF(labelX, pad, labelX + labelW, pad + labelH), br.green.Get());
     }
+    (void)ov.d2dCtx->EndDraw();
+    ov.d2dCtx->SetTarget(nullptr);
+}
 
-    return out;
+// Clamp a selection rectangle to the frame bounds.
+RECT ClampToFrame(RECT sel, const capture::FrameData& frame)
+{
+    sel.left = (std::max)(0L, (std::min)(sel.left, static_cast<LONG>(frame.width)));
+    sel.top = (std::max)(0L, (std::min)(sel.top, static_cast<LONG>(frame.height)));
+    sel.right = (std::max)(0L, (std::min)(sel.right, static_cast<LONG>(frame.width)));
+    sel.bottom = (std::max)(0L, (std::min)(sel.bottom, static_cast<LONG>(frame.height)));
+    return sel;
 }
 
-// ── Shared window creation helper ───────────────────────────────────
+// ── Surface window ──────────────────────────────────────────────────
 
-HWND CreatePreviewWindow(PreviewState& state, UINT& winW, UINT& winH)
+// The persistent preview window: topmost, covering the virtual desktop,
+// kept out of Alt+Tab.  GWLP_USERDATA points at the current PreviewState
+// while a preview is up and is null otherwise.
+HWND CreateSurfaceWindow(const RECT& desk)
 {
     const auto hinst = ::GetModuleHandleW(nullptr);
 
@@ -698,34 +934,40 @@ HWND CreatePreviewWindow(PreviewState& state, UINT& winW, UINT& winH)
     wc.cbSize = sizeof(wc);
     wc.lpfnWndProc = PreviewWndProc;
     wc.hInstance = hinst;
-    wc.hCursor = ::LoadCursorW(nullptr, state.regionMode ? IDC_CROSS : IDC_ARROW);
+    wc.hCursor = ::LoadCursorW(nullptr, IDC_ARROW);
     wc.lpszClassName = L"ScreenCap.Preview";
 
     if (!::RegisterClassExW(&wc) && ::GetLastError() != ERROR_CLASS_ALREADY_EXISTS) {
         return nullptr;
     }
 
-    const RECT desk = GetVirtualDesktopRect();
-    winW = static_cast<UINT>(desk.right - desk.left);
-    winH = static_cast<UINT>(desk.bottom - desk.top);
-
-    HWND hwnd = ::CreateWindowExW(
-        WS_EX_TOPMOST,
+    return ::CreateWindowExW(
+        WS_EX_TOPMOST | WS_EX_TOOLWINDOW,
         wc.lpszClassName,
         L"ScreenCap Preview",
         WS_POPUP,
         desk.left, desk.top,
-        static_cast<int>(winW), static_cast<int>(winH),
+        static_cast<int>(desk.right - desk.left), static_cast<int>(desk.bottom - desk.top),
         nullptr,
         nullptr,
         hinst,
-        &state);
+        nullptr);
+}
 
-    return hwnd;
+// A cloaked window is composed by DWM but never shown, so its swap chain
+// can be presented to before it appears.
+void SetCloaked(HWND hwnd, bool cloaked)
+{
+    const BOOL value = cloaked ? TRUE : FALSE;
+    (void)::DwmSetWindowAttribute(hwnd, DWMWA_CLOAK, &value, sizeof(value));
 }
 
 void TeardownDX11(DX11Context& dx)
 {
+    if (dx.frameLatencyWait) {
+        ::CloseHandle(dx.frameLatencyWait);
+        dx.frameLatencyWait = nullptr;
+    }
     if (dx.ctx) {
         dx.ctx->ClearState();
         dx.ctx->Flush();
@@ -734,90 +976,470 @@ void TeardownDX11(DX11Context& dx)
 
 } // namespace
 
+// ── Persistent surface ──────────────────────────────────────────────
+
+struct PreviewWindow::Surface {
+    HWND        hwnd{};
+    RECT        desk{};
+    UINT        width{};
+    UINT        height{};
+    DX11Context dx;
+    D2DOverlay  ov;
+    bool        hasOverlay{false};
+    bool        active{false};      // between Begin() and End()
+
+    Surface() = default;
+    Surface(const Surface&) = delete;
+    Surface& operator=(const Surface&) = delete;
+
+    ~Surface()
+    {
+        ov.d2dRenderTarget.Reset();
+        ov.d2dCtx.Reset();
+        ov.d2dDevice.Reset();
+        ov.d2dFactory.Reset();
+        TeardownDX11(dx);
+        if (hwnd) ::DestroyWindow(hwnd);
+    }
+
+    bool Build(ID3D11Device* device)
+    {
+        desk = GetVirtualDesktopRect();
+        width = static_cast<UINT>(desk.right - desk.left);
+        height = static_cast<UINT>(desk.bottom - desk.top);
+
+        hwnd = CreateSurfaceWindow(desk);
+        if (!hwnd) return false;
+        SetCloaked(hwnd, true);
+
+        if (!InitDX11(dx, device, hwnd, width, height)) return false;
+        // Only region/window mode need it; the full-desktop preview works without.
+        hasOverlay = InitD2DOverlay(ov, dx);
+        return true;
+    }
+
+    // Follow the virtual desktop; the swap chain keeps its format and flags.
+    bool Resize()
+    {
+        // A display change during a preview is picked up by the next one.
+        if (active) return true;
+
+        const RECT now = GetVirtualDesktopRect();
+        if (::EqualRect(&now, &desk)) return true;
+
+        desk = now;
+        width = static_cast<UINT>(desk.right - desk.left);
+        height = static_cast<UINT>(desk.bottom - desk.top);
+        ::SetWindowPos(hwnd, HWND_TOPMOST, desk.left, desk.top,
+                       static_cast<int>(width), static_cast<int>(height), SWP_NOACTIVATE);
+
+        // Every reference to the back buffers must go before ResizeBuffers.
+        ov.d2dRenderTarget.Reset();
+        dx.rtv.Reset();
+        dx.ctx->ClearState();
+        dx.ctx->Flush();
+        if (FAILED(dx.swapChain->ResizeBuffers(0, width, height, DXGI_FORMAT_UNKNOWN,
+                                               DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT))) {
+            return false;
+        }
+        if (!CreateBackBufferTarget(dx)) return false;
+        if (hasOverlay) hasOverlay = CreateOverlayTarget(ov, dx);
+        ResetPresentHistory(dx);
+        return true;
+    }
+
+    // Bind this capture and map the window, still cloaked, so the first
+    // frame can be presented before anything appears.
+    bool Begin(PreviewState& state)
+    {
+        // One capture at a time: a nested preview would take over the
+        // window and leave the outer loop without input once it ends.
+        if (active) return false;
+        if (!UploadTexture(dx, state.frame)) return false;
+        ResetPresentHistory(dx);
+        ::SetWindowLongPtrW(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(&state));
+        ::ShowWindow(hwnd, SW_SHOWNA);
+        active = true;
+        return true;
+    }
+
+    // Uncloak once DWM has the first frame, so the previous capture never
+    // flashes up.
+    void Reveal(const PreviewState& state, int64_t requestedAt)
+    {
+        ::DwmFlush();
+        SetCloaked(hwnd, false);
+        ::SetForegroundWindow(hwnd);
+        ::SetFocus(hwnd);
+        ::SetCursor(::LoadCursorW(nullptr, CursorFor(state)));
+        if (requestedAt) {
+            capture::TraceRecord(capture::TraceStage::HotkeyToPreview, requestedAt);
+        }
+    }
+
+    // Hide again and drop the capture's texture (the duplicator reuses it).
+    void End()
+    {
+        SetCloaked(hwnd, true);
+        if (::GetCapture() == hwnd) ::ReleaseCapture();
+        ::ShowWindow(hwnd, SW_HIDE);
+        ::SetWindowLongPtrW(hwnd, GWLP_USERDATA, 0);
+        dx.textureSRV.Reset();
+        dx.ctx->ClearState();
+        dx.ctx->Flush();
+        active = false;
+    }
+};
+
+PreviewWindow::PreviewWindow() = default;
+PreviewWindow::~PreviewWindow() = default;
+
+bool PreviewWindow::Init(ID3D11Device* device)
+{
+    device_ = device;
+    surface_.reset();
+    if (!device) return false;
+
+    auto surface = std::make_unique<Surface>();
+    if (!surface->Build(device)) return false;
+    surface_ = std::move(surface);
+    return true;
+}
+
+bool PreviewWindow::Resize()
+{
+    if (!surface_) return false;
+    if (surface_->Resize()) return true;
+    surface_.reset();   // rebuilt by the next Prepare()
+    return false;
+}
+
+PreviewWindow::Surface* PreviewWindow::Prepare()
+{
+    // Catches display changes that arrived while no message was pumped.
+    if (surface_ && !surface_->Resize()) {
+        surface_.reset();
+    }
+    if (!surface_ && device_) {
+        (void)Init(device_.Get());
+    }
+    return surface_.get();
+}
+
+namespace {
+
+// ── Helper: GPU frame → CPU pixels ──────────────────────────────────
+
+// The GPU frame to read back for output.  FP16 frames are tone-mapped to
+// BGRA8 on the GPU first, so readback moves 4 bytes per pixel instead of
+// 8 and the save/clipboard/thumbnail paths skip the CPU conversion.
+capture::FrameData PrepareForReadback(const capture::FrameData& frame, capture::GpuToneMapper* toneMapper)
+{
+    if (toneMapper && toneMapper->IsReady() &&
+        static_cast<DXGI_FORMAT>(frame.format) == DXGI_FORMAT_R16G16B16A16_FLOAT) {
+        auto sdr = toneMapper->ToneMapToBgra8(frame, capture::SdrWhiteNitsForFrame(frame));
+        if (sdr) {
+            return std::move(*sdr);
+        }
+        // On failure keep the FP16 frame; the encoders convert on the CPU.
+    }
+    return frame;
+}
+
+// Populate frame.pixels for the encoders (blocking readback).
+bool ResolvePixels(capture::FrameData& frame, ID3D11Device* device, capture::GpuToneMapper* toneMapper)
+{
+    if (!frame.pixels.empty()) return true;
+
+    frame = PrepareForReadback(frame, toneMapper);
+
+    ComPtr<ID3D11DeviceContext> readbackCtx;
+    device->GetImmediateContext(&readbackCtx);
+    return capture::ReadbackPixels(frame, readbackCtx.Get());
+}
+
+// ── Helper: background readback while the preview is up ─────────────
+
+// Readback of the whole frame, started as soon as the preview is shown so
+// the pixels are usually in system memory by the time the user clicks.
+struct Prefetch {
+    capture::AsyncReadback*        readback{};
+    capture::AsyncReadback::Ticket ticket{};
+    capture::FrameData             result;
+    bool                           ok{false};
+
+    Prefetch() = default;
+    Prefetch(const Prefetch&) = delete;
+    Prefetch& operator=(const Prefetch&) = delete;
+
+    // The callback points at this object; never let it outlive us.
+    ~Prefetch()
+    {
+        if (readback) readback->Cancel(ticket);
+    }
+};
+
+void StartPrefetch(Prefetch& pf, const capture::FrameData& frame, const OutputServices& services)
+{
+    if (!services.readback || !frame.gpuTexture || !frame.pixels.empty()) return;
+
+    pf.readback = services.readback;
+    pf.ticket = services.readback->Begin(
+        PrepareForReadback(frame, services.toneMapper),
+        [&pf](capture::FrameData&& done, bool ok) {
+            pf.result = std::move(done);
+            pf.ok = ok;
+        });
+}
+
+// Hand the prefetched pixels to `frame`, waiting only for whatever the GPU
+// hasn't finished yet.  Falls back to a blocking readback.
+bool FinishPrefetch(Prefetch& pf, capture::FrameData& frame, ID3D11Device* device, const OutputServices& services)
+{
+    if (pf.ticket != 0) {
+        pf.readback->Wait(pf.ticket);
+        pf.ticket = 0;
+        if (pf.ok) {
+            frame = std::move(pf.result);
+            return true;
+        }
+    }
+    return ResolvePixels(frame, device, services.toneMapper);
+}
+
+// Hand the prefetched pixels to `frame` only if they have already landed;
+// a copy still in flight is dropped.  Never waits.
+void TakeLandedPrefetch(Prefetch& pf, capture::FrameData& frame)
+{
+    if (pf.ticket == 0) return;
+    pf.readback->Poll();
+    if (pf.ok) frame = std::move(pf.result);
+    pf.readback->Cancel(pf.ticket);
+    pf.ticket = 0;
+}
+
+// Sleep until input arrives or a queued readback completes.
+void WaitForInputOrReadback(capture::AsyncReadback* readback)
+{
+    if (readback && readback->HasPending()) {
+        // Without a fence event, poll every couple of ms while a copy is in
+        // flight; with one, the timeout is only a safety net.
+        HANDLE ev = readback->CompletionEvent();
+        (void)::MsgWaitForMultipleObjects(ev ? 1 : 0, ev ? &ev : nullptr, FALSE,
+                                          ev ? 16 : 2, QS_ALLINPUT);
+        readback->Poll();
+        return;
+    }
+    ::WaitMessage();
+}
+
 // ── Helper: save or clipboard ───────────────────────────────────────
 
-bool OutputImage(const capture::FrameData& frame, bool copyToClipboard)
+// Services as used for this output.  An HDR save keeps the FP16 pixels,
+// so the GPU tone map before readback is skipped.  So does an HDR copy to
+// the delayed-render clipboard, which offers JPEG XR next to the SDR
+// formats; the immediate CF_DIB clipboard is SDR only.
+OutputServices ServicesForOutput(const OutputServices& requested, bool copyToClipboard)
 {
-    const bool ok = copyToClipboard
-        ? capture::CopyImageToClipboard(frame)
-        : capture::SaveImageInteractive(frame);
-    if (ok) {
-        capture::WriteThumbnailPng(frame);
+    OutputServices services = requested;
+    const bool keepsHdr = !copyToClipboard || (services.clipboard && services.clipboard->IsReady());
+    if (services.hdrFormat != capture::HdrFormat::None && keepsHdr) {
+        services.toneMapper = nullptr;
     }
-    return ok;
+    return services;
 }
 
-// ── Full-desktop preview (existing behavior) ────────────────────────
+// Toast thumbnail downsampled on the GPU from the frame's texture, so only
+// a thumbnail-sized image is read back and nothing is scaled on the CPU.
+// Returns an empty frame when that isn't possible (CPU-only frame, no tone
+// mapper, frame already small); WriteThumbnailPng() then scales on the CPU.
+capture::FrameData GpuThumbnail(const capture::FrameData& frame, capture::GpuToneMapper* toneMapper)
+{
+    capture::FrameData thumb;
+    if (!toneMapper || !toneMapper->IsReady() || !frame.gpuTexture) return thumb;
+
+    uint32_t thumbW = 0;
+    uint32_t thumbH = 0;
+    capture::ThumbnailSize(frame.width, frame.height, thumbW, thumbH);
+    if (thumbW == frame.width && thumbH == frame.height) return thumb;
+
+    auto small = toneMapper->DownsampleToBgra8(frame, capture::SdrWhiteNitsForFrame(frame), thumbW, thumbH);
+    if (!small) return thumb;
 
-bool Show(capture::FrameData frame, ID3D11Device* device, bool copyToClipboard)
+    ComPtr<ID3D11Device> device;
+    frame.gpuTexture->GetDevice(&device);
+    ComPtr<ID3D11DeviceContext> readbackCtx;
+    device->GetImmediateContext(&readbackCtx);
+    if (capture::ReadbackPixels(*small, readbackCtx.Get())) {
+        thumb = std::move(*small);
+        thumb.gpuTexture.Reset();
+    }
+    return thumb;
+}
+
+// With an output queue only the Save dialog runs here; conversion, encode
+// and thumbnail happen in the background and true means "queued".
+// thumbnailMapper is the caller's tone mapper even when `services` drops it
+// for an HDR save: the thumbnail is always SDR.
+bool OutputImage(capture::FrameData frame, const OutputServices& services,
+                 capture::GpuToneMapper* thumbnailMapper, bool copyToClipboard)
 {
-    PreviewState state;
-    state.frame = std::move(frame);
-    state.regionMode = false;
-    state.desktopRect = GetVirtualDesktopRect();
+    if (services.output) {
+        capture::OutputQueue::Job job;
+        if (!copyToClipboard) {
+            auto path = capture::PromptSavePath(frame, services.hdrFormat);
+            if (!path) {
+                return false;
+            }
+            job.path = std::move(*path);
+        }
+        // A streamed frame has no CPU pixels to scale a thumbnail from, so
+        // it needs the GPU one.  Without it (no tone mapper) read the frame
+        // back after all; streaming is then only the fallback.
+        job.thumbnail = GpuThumbnail(frame, thumbnailMapper);
+        if (frame.pixels.empty() && frame.gpuTexture && job.thumbnail.pixels.empty()) {
+            ComPtr<ID3D11Device> device;
+            frame.gpuTexture->GetDevice(&device);
+            (void)ResolvePixels(frame, device.Get(), services.toneMapper);
+        }
+        job.frame     = std::move(frame);
+        job.pngPreset = services.pngPreset;
+        // Unless the frame is streamed from the GPU, hand the pooled
+        // texture back now.
+        if (!job.frame.pixels.empty()) {
+            job.frame.gpuTexture.Reset();
+        }
+        services.output->Submit(std::move(job));
+        return true;
+    }
 
-    UINT winW{}, winH{};
-    HWND hwnd = CreatePreviewWindow(state, winW, winH);
-    if (!hwnd) {
-        return false;
+    // Without a queue nobody is told of a thumbnail, so none is written.
+    if (copyToClipboard && services.clipboard && services.clipboard->IsReady()) {
+        return services.clipboard->Offer(std::move(frame));
     }
+    return copyToClipboard
+        ? capture::CopyImageToClipboard(frame, services.workers)
+        : capture::SaveImageInteractive(frame, services.workers, services.pngPreset, services.hdrFormat);
+}
 
-    DX11Context dx;
-    if (!InitDX11(dx, device, hwnd, winW, winH)) {
-        ::DestroyWindow(hwnd);
+} // namespace
+
+// ── Helper: crop to a selection ─────────────────────────────────────
+
+// Pixels of `sel` only.  GPU frames are cropped on the GPU (tone-mapping
+// just the region for FP16 frames) so readback scales with the selection
+// instead of the whole virtual desktop; CPU frames are cropped in memory.
+bool ExtractRegion(const capture::FrameData& frame, RECT sel, ID3D11Device* device,
+                   capture::GpuToneMapper* toneMapper, capture::FrameData& out)
+{
+    sel = ClampToFrame(sel, frame);
+    if (sel.right <= sel.left || sel.bottom <= sel.top) return false;
+
+    if (!frame.pixels.empty() || !frame.gpuTexture) {
+        out = capture::CropFrame(frame, sel);
+        return true;
+    }
+
+    D3D11_BOX box{};
+    box.left   = static_cast<UINT>(sel.left);
+    box.top    = static_cast<UINT>(sel.top);
+    box.right  = static_cast<UINT>(sel.right);
+    box.bottom = static_cast<UINT>(sel.bottom);
+    box.back   = 1;
+
+    ComPtr<ID3D11DeviceContext> readbackCtx;
+    device->GetImmediateContext(&readbackCtx);
+
+    if (toneMapper && toneMapper->IsReady() &&
+        static_cast<DXGI_FORMAT>(frame.format) == DXGI_FORMAT_R16G16B16A16_FLOAT) {
+        auto sdr = toneMapper->ToneMapToBgra8(frame, capture::SdrWhiteNitsForFrame(frame), &box);
+        if (sdr && capture::ReadbackPixels(*sdr, readbackCtx.Get())) {
+            out = std::move(*sdr);
+            return true;
+        }
+        // Fall through to an FP16 region readback; the encoders convert on the CPU.
+    }
+
+    return capture::ReadbackRegion(frame, box, readbackCtx.Get(), out);
+}
+
+// ── Full-desktop preview (existing behavior) ────────────────────────
+
+bool PreviewWindow::Show(capture::FrameData frame, const OutputServices& requested, bool copyToClipboard)
+{
+    const OutputServices services = ServicesForOutput(requested, copyToClipboard);
+
+    Surface* surface = Prepare();
+    if (!surface) {
         return false;
     }
+    ID3D11Device* device = device_.Get();
+    DX11Context& dx = surface->dx;
+    D2DOverlay& ov = surface->ov;
+    const UINT winW = surface->width;
+    const UINT winH = surface->height;
 
-    if (!UploadTexture(dx, state.frame)) {
-        TeardownDX11(dx);
-        ::DestroyWindow(hwnd);
+    PreviewState state;
+    state.frame = std::move(frame);
+    state.regionMode = false;
+    state.desktopRect = surface->desk;
+
+    if (!surface->Begin(state)) {
         return false;
     }
 
-    // D2D overlay for monitor borders.
-    D2DOverlay ov;
-    const bool hasOverlay = InitD2DOverlay(ov, dx);
+    // Monitor border overlay.
     auto monitors = EnumerateMonitorRects();
 
-    ::ShowWindow(hwnd, SW_SHOW);
-    ::SetForegroundWindow(hwnd);
-    ::SetFocus(hwnd);
-
     // Render desktop texture + monitor border overlay.
     RenderFrameNoPresent(dx, winW, winH);
-    if (hasOverlay && !monitors.empty()) {
+    if (surface->hasOverlay && !monitors.empty()) {
         DrawMonitorBorders(ov, monitors, state.desktopRect);
     }
-    dx.swapChain->Present(1, 0);
+    PresentFrame(dx);
+    surface->Reveal(state, services.requestedAt);
+
+    // Start reading the frame back while the user looks at it — unless it
+    // is big enough to be streamed to disk from the GPU instead.
+    const bool streamToFile = !copyToClipboard && services.output &&
+                              capture::ShouldStreamToFile(state.frame);
+    Prefetch prefetch;
+    if (!streamToFile) {
+        StartPrefetch(prefetch, state.frame, services);
+    }
 
     MSG msg{};
     while (!state.done) {
-        const BOOL ret = ::GetMessageW(&msg, nullptr, 0, 0);
-        if (ret <= 0) {
+        while (::PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
+            if (msg.message == WM_QUIT) {
+                state.done = true;
+                break;
+            }
+            ::TranslateMessage(&msg);
+            ::DispatchMessageW(&msg);
+        }
+
+        if (state.done) {
             break;
         }
-        ::TranslateMessage(&msg);
-        ::DispatchMessageW(&msg);
-    }
 
-    if (hasOverlay) {
-        ov.d2dRenderTarget.Reset();
-        ov.d2dCtx.Reset();
-        ov.d2dDevice.Reset();
-        ov.d2dFactory.Reset();
+        WaitForInputOrReadback(services.readback);
     }
 
-    TeardownDX11(dx);
-    ::DestroyWindow(hwnd);
+    surface->End();
 
     if (state.userClickedSave) {
-        // Lazy readback: populate CPU pixels from the GPU texture.
-        ComPtr<ID3D11DeviceContext> readbackCtx;
-        device->GetImmediateContext(&readbackCtx);
-        if (!capture::ReadbackPixels(state.frame, readbackCtx.Get())) {
+        if (streamToFile) {
+            // Tone-map on the GPU first (unless saving HDR) so the staging
+            // copy is BGRA8; the encode thread maps and encodes it.
+            return OutputImage(PrepareForReadback(state.frame, services.toneMapper),
+                               services, requested.toneMapper, copyToClipboard);
+        }
+        // Usually already complete; otherwise waits for the GPU copy.
+        if (!FinishPrefetch(prefetch, state.frame, device, services)) {
             return false;
         }
-        return OutputImage(state.frame, copyToClipboard);
+        return OutputImage(std::move(state.frame), services, requested.toneMapper, copyToClipboard);
     }
 
     return false;
@@ -825,57 +1447,37 @@ bool Show(capture::FrameData frame, ID3D11Device* device, bool copyToClipboard)
 
 // ── Region selection preview ────────────────────────────────────────
 
-bool ShowRegion(capture::FrameData frame, ID3D11Device* device, bool copyToClipboard)
+bool PreviewWindow::ShowRegion(capture::FrameData frame, const OutputServices& requested, bool copyToClipboard)
 {
-    PreviewState state;
-    state.frame = std::move(frame);
-    state.regionMode = true;
+    const OutputServices services = ServicesForOutput(requested, copyToClipboard);
 
-    UINT winW{}, winH{};
-    HWND hwnd = CreatePreviewWindow(state, winW, winH);
-    if (!hwnd) {
+    Surface* surface = Prepare();
+    if (!surface || !surface->hasOverlay) {
         return false;
     }
+    ID3D11Device* device = device_.Get();
+    DX11Context& dx = surface->dx;
+    D2DOverlay& ov = surface->ov;
+    const UINT winW = surface->width;
+    const UINT winH = surface->height;
 
-    DX11Context dx;
-    if (!InitDX11(dx, device, hwnd, winW, winH)) {
-        ::DestroyWindow(hwnd);
-        return false;
-    }
-
-    if (!UploadTexture(dx, state.frame)) {
-        TeardownDX11(dx);
-        ::DestroyWindow(hwnd);
-        return false;
-    }
+    PreviewState state;
+    state.frame = std::move(frame);
+    state.regionMode = true;
 
-    D2DOverlay ov;
-    if (!InitD2DOverlay(ov, dx)) {
-        TeardownDX11(dx);
-        ::DestroyWindow(hwnd);
+    if (!surface->Begin(state)) {
         return false;
     }
 
-    ::ShowWindow(hwnd, SW_SHOW);
-    ::SetForegroundWindow(hwnd);
-    ::SetFocus(hwnd);
-
     // Initial render: desktop texture + full dim (no selection yet).
-    {
-        RenderFrameNoPresent(dx, winW, winH);
-        ov.d2dCtx->SetTarget(ov.d2dRenderTarget.Get());
-        ov.d2dCtx->BeginDraw();
-        ComPtr<ID2D1SolidColorBrush> dimBrush;
-        ov.d2dCtx->CreateSolidColorBrush(D2D1::ColorF(0.0f, 0.0f, 0.0f, 0.5f), &dimBrush);
-        if (dimBrush) {
-            ov.d2dCtx->FillRectangle(
-                D2D1::RectF(0, 0, static_cast<float>(winW), static_cast<float>(winH)),
-                dimBrush.Get());
-        }
-        (void)ov.d2dCtx->EndDraw();
-        ov.d2dCtx->SetTarget(nullptr);
-        dx.swapChain->Present(1, 0);
-    }
+    PresentOverlay(dx, ov, OverlayHole{}, winW, winH);
+    surface->Reveal(state, services.requestedAt);
+
+    // Read the whole frame back while the user drags: a selection made
+    // after it lands is cropped in memory.  One still in flight at
+    // mouse-up gives way to the smaller region readback.
+    Prefetch prefetch;
+    StartPrefetch(prefetch, state.frame, services);
 
     // ── PeekMessage loop: re-render when selection changes ──────────
 
@@ -894,42 +1496,29 @@ bool ShowRegion(capture::FrameData frame, ID3D11Device* device, bool copyToClipb
             break;
         }
 
-        if (state.needsRedraw && state.dragging) {
+        const bool frameDue = state.needsRedraw && state.dragging;
+        if (frameDue && TakeFrameSlot(dx)) {
             state.needsRedraw = false;
 
+            // Latest drag position only; older moves were coalesced.
             const RECT sel = NormaliseDragRect(state.dragStart, state.dragEnd);
-
-            // Render desktop texture, then overlay selection via D2D.
-            RenderFrameNoPresent(dx, winW, winH);
-            DrawSelectionOverlay(ov, sel, winW, winH);
-            dx.swapChain->Present(1, 0);
+            PresentOverlay(dx, ov, SelectionHole(sel), winW, winH);
         } else {
             // Avoid busy-wait when nothing is happening.
-            ::WaitMessage();
+            WaitForInputOrFrame(dx, frameDue);
         }
     }
 
-    // Release D2D resources before DX11 teardown.
-    ov.d2dRenderTarget.Reset();
-    ov.d2dCtx.Reset();
-    ov.d2dDevice.Reset();
-    ov.d2dFactory.Reset();
-
-    TeardownDX11(dx);
-    ::DestroyWindow(hwnd);
+    surface->End();
 
     // ── Save cropped region ────────────────────────────────────────
 
     if (state.selectionComplete) {
-        // Lazy readback: CropFrame needs CPU pixels.
-        ComPtr<ID3D11DeviceContext> readbackCtx;
-        device->GetImmediateContext(&readbackCtx);
-        if (!capture::ReadbackPixels(state.frame, readbackCtx.Get())) {
-            return false;
-        }
-        auto cropped = CropFrame(state.frame, state.selection);
-        if (cropped.width > 0 && cropped.height > 0) {
-            return OutputImage(cropped, copyToClipboard);
+        TakeLandedPrefetch(prefetch, state.frame);
+        capture::FrameData cropped;
+        if (ExtractRegion(state.frame, state.selection, device, services.toneMapper, cropped) &&
+            cropped.width > 0 && cropped.height > 0) {
+            return OutputImage(std::move(cropped), services, requested.toneMapper, copyToClipboard);
         }
     }
 
@@ -938,57 +1527,45 @@ bool ShowRegion(capture::FrameData frame, ID3D11Device* device, bool copyToClipb
 
 // ── Window capture preview ──────────────────────────────────────────
 
-bool ShowWindowCapture(capture::FrameData frame, ID3D11Device* device, bool copyToClipboard)
+bool PreviewWindow::ShowWindowCapture(capture::FrameData frame, const OutputServices& requested,
+                                      bool copyToClipboard)
 {
-    // Enumerate visible windows BEFORE creating the overlay so our own
-    // fullscreen window is not in the list.
-    auto windows = EnumerateVisibleWindows();
-    if (windows.empty()) {
+    const OutputServices services = ServicesForOutput(requested, copyToClipboard);
+
+    Surface* surface = Prepare();
+    if (!surface || !surface->hasOverlay) {
         return false;
     }
+    ID3D11Device* device = device_.Get();
+    DX11Context& dx = surface->dx;
+    D2DOverlay& ov = surface->ov;
+    const UINT winW = surface->width;
+    const UINT winH = surface->height;
 
     PreviewState state;
     state.frame = std::move(frame);
     state.windowMode = true;
-    state.desktopRect = GetVirtualDesktopRect();
-    state.windows = std::move(windows);
-
-    UINT winW{}, winH{};
-    HWND hwnd = CreatePreviewWindow(state, winW, winH);
-    if (!hwnd) {
-        return false;
-    }
-
-    DX11Context dx;
-    if (!InitDX11(dx, device, hwnd, winW, winH)) {
-        ::DestroyWindow(hwnd);
-        return false;
-    }
+    state.desktopRect = surface->desk;
 
-    if (!UploadTexture(dx, state.frame)) {
-        TeardownDX11(dx);
-        ::DestroyWindow(hwnd);
+    // Index visible windows while our own fullscreen window is still
+    // hidden, so it is not in the list.
+    state.windows.Build(state.desktopRect);
+    if (state.windows.Empty()) {
         return false;
     }
+    ::GetCursorPos(&state.lastMouse);
 
-    D2DOverlay ov;
-    if (!InitD2DOverlay(ov, dx)) {
-        TeardownDX11(dx);
-        ::DestroyWindow(hwnd);
+    if (!surface->Begin(state)) {
         return false;
     }
 
-    ::ShowWindow(hwnd, SW_SHOW);
-    ::SetForegroundWindow(hwnd);
-    ::SetFocus(hwnd);
-
     // Initial render: desktop texture + full grey dim (no window hovered yet).
-    RenderFrameNoPresent(dx, winW, winH);
-    DrawWindowOverlay(ov, -1, state.windows, state.desktopRect, winW, winH);
-    dx.swapChain->Present(1, 0);
+    PresentOverlay(dx, ov, OverlayHole{}, winW, winH);
+    surface->Reveal(state, services.requestedAt);
 
     // ── PeekMessage loop: re-render when hovered window changes ─────
 
+    int warmedIndex = -1;
     MSG msg{};
     while (!state.done) {
         while (::PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
@@ -1004,46 +1581,148 @@ bool ShowWindowCapture(capture::FrameData frame, ID3D11Device* device, bool copy
             break;
         }
 
-        if (state.needsRedraw) {
+        if (state.needsRedraw && TakeFrameSlot(dx)) {
             state.needsRedraw = false;
 
-            RenderFrameNoPresent(dx, winW, winH);
-            DrawWindowOverlay(ov, state.hoveredWindowIndex,
-                              state.windows, state.desktopRect, winW, winH);
-            dx.swapChain->Present(1, 0);
+            // Start capturing the hovered window now, so a click finds its
+            // frame already waiting.
+            if (services.windowCapture && state.hovered.window >= 0 && !state.hovered.child &&
+                state.hovered.window != warmedIndex) {
+                warmedIndex = state.hovered.window;
+                services.windowCapture->Warm(state.hovered.hwnd);
+            }
+
+            PresentOverlay(dx, ov, WindowHole(state.hovered, state.desktopRect, winW, winH), winW, winH);
         } else {
-            ::WaitMessage();
+            WaitForInputOrFrame(dx, state.needsRedraw);
         }
     }
 
-    // Release D2D resources before DX11 teardown.
-    ov.d2dRenderTarget.Reset();
-    ov.d2dCtx.Reset();
-    ov.d2dDevice.Reset();
-    ov.d2dFactory.Reset();
-
-    TeardownDX11(dx);
-    ::DestroyWindow(hwnd);
+    surface->End();
 
     // ── Capture the selected window via WinRT Graphics Capture ──────
 
-    if (state.selectionComplete && state.selectedHwnd) {
-        auto windowFrame = capture::CaptureWindow(state.selectedHwnd, device);
-        if (windowFrame && windowFrame->width > 0 && windowFrame->height > 0) {
-            return OutputImage(*windowFrame, copyToClipboard);
+    const bool picked = state.selectionComplete;
+    std::optional<capture::FrameData> windowFrame;
+    if (state.selectedHwnd) {
+        windowFrame = services.windowCapture
+            ? services.windowCapture->Capture(state.selectedHwnd)
+            : capture::CaptureWindow(state.selectedHwnd, device);
+    }
+    // Warm sessions copy every frame their window presents; stop them.
+    if (services.windowCapture) {
+        services.windowCapture->Clear();
+    }
+
+    if (picked) {
+        // The WGC frame is GPU-resident: FP16 windows are tone-mapped on the
+        // GPU, so only BGRA8 pixels cross the bus.
+        if (windowFrame && windowFrame->width > 0 && windowFrame->height > 0 &&
+            ResolvePixels(*windowFrame, device, services.toneMapper)) {
+            return OutputImage(std::move(*windowFrame), services, requested.toneMapper, copyToClipboard);
         }
-        // Fallback: crop from the desktop capture if WinRT capture failed.
-        ComPtr<ID3D11DeviceContext> readbackCtx;
-        device->GetImmediateContext(&readbackCtx);
-        if (!capture::ReadbackPixels(state.frame, readbackCtx.Get())) {
-            return false;
+        // Child picks, or WinRT capture failed: crop from the desktop capture.
+        capture::FrameData cropped;
+        if (ExtractRegion(state.frame, state.selection, device, services.toneMapper, cropped) &&
+            cropped.width > 0 && cropped.height > 0) {
+            return OutputImage(std::move(cropped), services, requested.toneMapper, copyToClipboard);
+        }
+    }
+
+    return false;
+}
+
+// ── Instant replay preview ──────────────────────────────────────────
+
+bool PreviewWindow::ShowReplay(capture::ReplayBuffer& replay, const OutputServices& requested,
+                               bool copyToClipboard)
+{
+    const OutputServices services = ServicesForOutput(requested, copyToClipboard);
+    const size_t count = replay.Count();
+    if (count == 0) {
+        return false;
+    }
+
+    Surface* surface = Prepare();
+    if (!surface) {
+        return false;
+    }
+    ID3D11Device* device = device_.Get();
+    DX11Context& dx = surface->dx;
+    D2DOverlay& ov = surface->ov;
+    const UINT winW = surface->width;
+    const UINT winH = surface->height;
+
+    auto newest = replay.Frame(0);
+    if (!newest) {
+        return false;
+    }
+
+    PreviewState state;
+    state.frame = std::move(*newest);
+    state.replayMode = true;
+    state.desktopRect = surface->desk;
+
+    if (!surface->Begin(state)) {
+        return false;
+    }
+
+    // Ages are shown relative to the key press, not to each redraw.
+    const int64_t now = requested.requestedAt ? requested.requestedAt : capture::TraceNow();
+    size_t age = 0;
+    const auto present = [&] {
+        // The ring's smaller frames are stretched over the screen by the
+        // full-screen quad.
+        RenderFrameNoPresent(dx, winW, winH);
+        if (surface->hasOverlay) {
+            DrawReplayLabel(ov, replay.AgeSeconds(age, now), count - age, count, winW);
+        }
+        PresentFrame(dx);
+    };
+    present();
+    surface->Reveal(state, services.requestedAt);
+
+    MSG msg{};
+    while (!state.done) {
+        while (::PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
+            if (msg.message == WM_QUIT) {
+                state.done = true;
+                break;
+            }
+            ::TranslateMessage(&msg);
+            ::DispatchMessageW(&msg);
+        }
+
+        if (state.done) {
+            break;
         }
-        auto cropped = CropFrame(state.frame, state.selection);
-        if (cropped.width > 0 && cropped.height > 0) {
-            return OutputImage(cropped, copyToClipboard);
+
+        if (state.replayStep != 0) {
+            // Steps queued meanwhile collapse into one decode.
+            const auto target = static_cast<size_t>((std::clamp)(
+                static_cast<long long>(age) + state.replayStep, 0LL, static_cast<long long>(count) - 1));
+            state.replayStep = 0;
+            if (target != age) {
+                if (auto frame = replay.Frame(target)) {
+                    dx.textureSRV.Reset();
+                    state.frame = std::move(*frame);
+                    age = target;
+                    if (UploadTexture(dx, state.frame)) {
+                        present();
+                    }
+                }
+            }
+        } else {
+            ::WaitMessage();
         }
     }
 
+    surface->End();
+
+    if (state.userClickedSave && ResolvePixels(state.frame, device, services.toneMapper)) {
+        return OutputImage(std::move(state.frame), services, requested.toneMapper, copyToClipboard);
+    }
+
     return false;
 }
 
@@ -1,22 +1,92 @@
 #pragma once
 
+#include "capture/AsyncReadback.h"
+#include "capture/ClipboardImage.h"
 #include "capture/FrameData.h"
+#include "capture/GpuToneMapper.h"
+#include "capture/OutputQueue.h"
+#include "capture/ReplayBuffer.h"
+#include "capture/SaveImage.h"
+#include "capture/ThreadPool.h"
+#include "capture/WindowCapture.h"
 
-struct ID3D11Device;
+#include <d3d11.h>
+#include <wrl/client.h>
+
+#include <memory>
 
 namespace screencap::preview {
 
-// Displays a captured frame in a borderless fullscreen DX11 window.
-// Blocks until the user clicks (save) or presses Esc (discard).
-// If copyToClipboard is true, the image goes to the clipboard; otherwise
-// a Save dialog is shown.
-[[nodiscard]] bool Show(capture::FrameData frame, ID3D11Device* device, bool copyToClipboard = false);
+// Long-lived helpers owned by the caller and used when producing output,
+// plus output settings.  All helpers are optional.
+struct OutputServices {
+    capture::GpuToneMapper* toneMapper{};   // FP16 → BGRA8 on the GPU before readback
+    capture::ThreadPool*    workers{};      // multi-core CPU conversion / row copies
+    capture::AsyncReadback* readback{};     // readback started while the preview is up
+    capture::WindowCaptureCache* windowCapture{}; // WGC sessions warmed while hovering
+    capture::OutputQueue*   output{};       // background encode; reports via its Completion
+    capture::PngPreset      pngPreset{capture::PngPreset::Compact};
+    capture::HdrFormat      hdrFormat{capture::HdrFormat::None}; // != None: saves keep FP16 pixels
+    capture::ClipboardImage* clipboard{};   // delayed-render clipboard (else CF_DIB right away)
+    int64_t                 requestedAt{};  // capture::TraceNow() at the hotkey / menu command
+};
+
+[[nodiscard]] bool ExtractRegion(const capture::FrameData& frame, RECT sel, ID3D11Device* device,
+                                 capture::GpuToneMapper* toneMapper, capture::FrameData& out);
+
+// The fullscreen preview.  The window, swap chain, shaders and D2D/DWrite
+// objects are created once (hidden and DWM-cloaked) and reused by every
+// Show*() call, so a capture is on screen one vsync after the first frame
+// is drawn instead of after window, swap-chain and shader setup.  Resize()
+// follows the virtual desktop on display changes.
+class PreviewWindow final {
+public:
+    PreviewWindow();
+    ~PreviewWindow();
+
+    PreviewWindow(const PreviewWindow&) = delete;
+    PreviewWindow& operator=(const PreviewWindow&) = delete;
+    PreviewWindow(PreviewWindow&&) = delete;
+    PreviewWindow& operator=(PreviewWindow&&) = delete;
+
+    // Build the surface up front.  Not fatal: Show*() retries on first use.
+    [[nodiscard]] bool Init(ID3D11Device* device);
+
+    // Match the virtual desktop (WM_DISPLAYCHANGE).  No-op if unchanged.
+    [[nodiscard]] bool Resize();
+
+    // Displays a captured frame fullscreen.
+    // Blocks until the user clicks (save) or presses Esc (discard).
+    // If copyToClipboard is true, the image goes to the clipboard; otherwise
+    // a Save dialog is shown.  With services.output the image is queued and
+    // true means it was handed off, not yet written.
+    [[nodiscard]] bool Show(capture::FrameData frame, const OutputServices& services,
+                            bool copyToClipboard = false);
+
+    // Same as Show(), but lets the user drag-select a region.
+    [[nodiscard]] bool ShowRegion(capture::FrameData frame, const OutputServices& services,
+                                  bool copyToClipboard = false);
+
+    // Shows the desktop with a window-picker overlay.
+    // Hovering highlights a window; clicking captures it.
+    [[nodiscard]] bool ShowWindowCapture(capture::FrameData frame, const OutputServices& services,
+                                         bool copyToClipboard = false);
+
+    // Steps back through the instant-replay ring, newest first: Left /
+    // Right or the mouse wheel pick a frame, a click or Enter outputs it
+    // (at the ring's resolution), Esc discards.  `replay` must not be
+    // pushed to meanwhile.
+    [[nodiscard]] bool ShowReplay(capture::ReplayBuffer& replay, const OutputServices& services,
+                                  bool copyToClipboard = false);
+
+private:
+    struct Surface;
 
-// Same as Show(), but lets the user drag-select a region.
-[[nodiscard]] bool ShowRegion(capture::FrameData frame, ID3D11Device* device, bool copyToClipboard = false);
+    // Surface ready for a show (built or resized as needed), or nullptr.
+    [[nodiscard]] Surface* Prepare();
 
-// Shows the desktop with a window-picker overlay.
-// Hovering highlights a window; clicking captures it.
-[[nodiscard]] bool ShowWindowCapture(capture::FrameData frame, ID3D11Device* device, bool copyToClipboard = false);
+    Microsoft::WRL::ComPtr<ID3D11Device> device_;
+    std::unique_ptr<Surface>             surface_;
+};
 
 } // namespace screencap::preview
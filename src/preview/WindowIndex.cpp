@@ -0,0 +1,188 @@
+#include "preview/WindowIndex.h"
+
+#include <dwmapi.h>
+
+#include <algorithm>
+
+namespace screencap::preview {
+namespace {
+
+constexpr int kCellSize = 128;  // grid cell edge, in pixels
+constexpr int kMaxChildDepth = 16;
+
+struct TopLevel {
+    HWND hwnd;
+    RECT rect;
+    bool candidate;   // selectable; the rest only hide what is behind them
+};
+
+BOOL CALLBACK EnumWindowsCallback(HWND hwnd, LPARAM lParam)
+{
+    auto* out = reinterpret_cast<std::vector<TopLevel>*>(lParam);
+
+    if (!::IsWindowVisible(hwnd)) return TRUE;
+    if (::IsIconic(hwnd)) return TRUE;
+
+    // Skip cloaked windows (UWP background apps, other virtual desktops).
+    DWORD cloaked = 0;
+    if (SUCCEEDED(::DwmGetWindowAttribute(hwnd, DWMWA_CLOAKED, &cloaked, sizeof(cloaked))) && cloaked) {
+        return TRUE;
+    }
+
+    // Click-through overlays neither receive the click nor hide anything.
+    const LONG_PTR exStyle = ::GetWindowLongPtrW(hwnd, GWL_EXSTYLE);
+    if ((exStyle & WS_EX_TRANSPARENT) && (exStyle & WS_EX_LAYERED)) return TRUE;
+
+    // Use DWM extended frame bounds (visible area without shadow).
+    RECT r{};
+    if (FAILED(::DwmGetWindowAttribute(hwnd, DWMWA_EXTENDED_FRAME_BOUNDS, &r, sizeof(r)))) {
+        if (!::GetWindowRect(hwnd, &r)) return TRUE;
+    }
+
+    if (r.right - r.left <= 1 || r.bottom - r.top <= 1) return TRUE;
+
+    // Tool windows (palettes, the taskbar) are not what "capture a window"
+    // means, but they still cover what is behind them.
+    const bool tool = (exStyle & WS_EX_TOOLWINDOW) && !(exStyle & WS_EX_APPWINDOW);
+
+    out->push_back({hwnd, r, !tool});
+    return TRUE;
+}
+
+// Deepest visible, non-transparent child of `top` under `screenPt`.
+HWND DeepestChildAt(HWND top, POINT screenPt)
+{
+    HWND found = nullptr;
+    HWND parent = top;
+    for (int depth = 0; depth < kMaxChildDepth; ++depth) {
+        POINT client = screenPt;
+        if (!::ScreenToClient(parent, &client)) break;
+        HWND child = ::ChildWindowFromPointEx(parent, client, CWP_SKIPINVISIBLE | CWP_SKIPTRANSPARENT);
+        if (!child || child == parent) break;
+        found = child;
+        parent = child;
+    }
+    return found;
+}
+
+} // namespace
+
+void WindowIndex::Build(const RECT& desktop)
+{
+    windows_.clear();
+    fragments_.clear();
+    cellStart_.clear();
+    cellItems_.clear();
+
+    // EnumWindows enumerates in Z-order (front to back).
+    std::vector<TopLevel> all;
+    ::EnumWindows(EnumWindowsCallback, reinterpret_cast<LPARAM>(&all));
+
+    // ── Occlusion: what of each window is not covered by those above ──
+    HRGN covered = ::CreateRectRgn(0, 0, 0, 0);
+    HRGN visible = ::CreateRectRgn(0, 0, 0, 0);
+    std::vector<uint8_t> regionData;
+
+    for (const auto& w : all) {
+        RECT r{};
+        if (!::IntersectRect(&r, &w.rect, &desktop)) continue;
+
+        if (w.candidate) {
+            ::SetRectRgn(visible, r.left, r.top, r.right, r.bottom);
+            const int kind = ::CombineRgn(visible, visible, covered, RGN_DIFF);
+            if (kind != NULLREGION && kind != ERROR) {
+                const DWORD size = ::GetRegionData(visible, 0, nullptr);
+                regionData.resize(size);
+                auto* rgn = reinterpret_cast<RGNDATA*>(regionData.data());
+                if (size && ::GetRegionData(visible, size, rgn)) {
+                    const auto index = static_cast<uint32_t>(windows_.size());
+                    const auto* rects = reinterpret_cast<const RECT*>(rgn->Buffer);
+                    for (DWORD i = 0; i < rgn->rdh.nCount; ++i) {
+                        fragments_.push_back({rects[i], index});
+                    }
+                    windows_.push_back({w.hwnd, w.rect});
+                }
+            }
+        }
+
+        ::SetRectRgn(visible, r.left, r.top, r.right, r.bottom);
+        ::CombineRgn(covered, covered, visible, RGN_OR);
+    }
+
+    ::DeleteObject(visible);
+    ::DeleteObject(covered);
+
+    // ── Grid: bucket each fragment into the cells it overlaps ─────────
+    grid_ = desktop;
+    cols_ = (std::max)(1, static_cast<int>((desktop.right - desktop.left + kCellSize - 1) / kCellSize));
+    rows_ = (std::max)(1, static_cast<int>((desktop.bottom - desktop.top + kCellSize - 1) / kCellSize));
+    cellStart_.assign(static_cast<size_t>(cols_) * rows_ + 1, 0);
+
+    const auto forEachCell = [this](const RECT& r, auto&& fn) {
+        const int cx0 = (r.left - grid_.left) / kCellSize;
+        const int cy0 = (r.top - grid_.top) / kCellSize;
+        const int cx1 = (std::min)(cols_ - 1, static_cast<int>((r.right - 1 - grid_.left) / kCellSize));
+        const int cy1 = (std::min)(rows_ - 1, static_cast<int>((r.bottom - 1 - grid_.top) / kCellSize));
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                fn(static_cast<size_t>(cy) * cols_ + cx);
+            }
+        }
+    };
+
+    for (const auto& f : fragments_) {
+        forEachCell(f.rect, [this](size_t cell) { ++cellStart_[cell + 1]; });
+    }
+    for (size_t i = 1; i < cellStart_.size(); ++i) {
+        cellStart_[i] += cellStart_[i - 1];
+    }
+    cellItems_.resize(cellStart_.back());
+    std::vector<uint32_t> fill(cellStart_.begin(), cellStart_.end() - 1);
+    for (uint32_t i = 0; i < fragments_.size(); ++i) {
+        forEachCell(fragments_[i].rect, [&](size_t cell) { cellItems_[fill[cell]++] = i; });
+    }
+}
+
+int WindowIndex::WindowAt(POINT screenPt) const noexcept
+{
+    if (screenPt.x < grid_.left || screenPt.x >= grid_.right ||
+        screenPt.y < grid_.top || screenPt.y >= grid_.bottom || cellStart_.empty()) {
+        return -1;
+    }
+    const size_t cell = static_cast<size_t>((screenPt.y - grid_.top) / kCellSize) * cols_ +
+                        static_cast<size_t>((screenPt.x - grid_.left) / kCellSize);
+
+    // Fragments are disjoint, so the first one containing the point wins.
+    for (uint32_t i = cellStart_[cell]; i < cellStart_[cell + 1]; ++i) {
+        const auto& f = fragments_[cellItems_[i]];
+        if (::PtInRect(&f.rect, screenPt)) {
+            return static_cast<int>(f.window);
+        }
+    }
+    return -1;
+}
+
+WindowHit WindowIndex::HitTest(POINT screenPt, bool children) const
+{
+    WindowHit hit;
+    hit.window = WindowAt(screenPt);
+    if (hit.window < 0) return hit;
+
+    const auto& w = windows_[hit.window];
+    hit.hwnd = w.hwnd;
+    hit.rect = w.rect;
+
+    if (children) {
+        if (HWND child = DeepestChildAt(w.hwnd, screenPt)) {
+            RECT cr{};
+            if (::GetWindowRect(child, &cr) && ::IntersectRect(&cr, &cr, &w.rect)) {
+                hit.hwnd = child;
+                hit.rect = cr;
+                hit.child = true;
+            }
+        }
+    }
+    return hit;
+}
+
+} // namespace screencap::preview
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <windows.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace screencap::preview {
+
+// A selectable top-level window.
+struct WindowInfo {
+    HWND hwnd;
+    RECT rect; // DWM extended frame bounds (visible area, no shadow).
+};
+
+// What the cursor is over in window-capture mode.
+struct WindowHit {
+    int  window{-1};    // index into WindowIndex::Windows(), -1 = nothing
+    HWND hwnd{};        // the top-level window, or the child on a child hit
+    RECT rect{};        // screen coordinates
+    bool child{false};
+
+    [[nodiscard]] bool operator==(const WindowHit& o) const noexcept
+    {
+        return window == o.window && hwnd == o.hwnd && child == o.child && ::EqualRect(&rect, &o.rect);
+    }
+};
+
+// ── Window hit-testing ──────────────────────────────────────────────
+//
+// Built once per window-capture preview from the z-ordered top-level
+// windows.  Windows are walked front to back and each one keeps only the
+// part not covered by those above it; fully covered windows, tool windows
+// and click-through windows never become candidates.  The visible parts
+// are disjoint rectangles, bucketed in a uniform grid, so a hover lookup
+// only looks at the few fragments in the cursor's cell.
+class WindowIndex final {
+public:
+    // Enumerate and index the windows on `desktop` (screen coordinates).
+    void Build(const RECT& desktop);
+
+    [[nodiscard]] bool Empty() const noexcept { return windows_.empty(); }
+    [[nodiscard]] const std::vector<WindowInfo>& Windows() const noexcept { return windows_; }
+
+    // Topmost candidate under `screenPt`.  With `children`, descends to the
+    // deepest visible child window there.
+    [[nodiscard]] WindowHit HitTest(POINT screenPt, bool children) const;
+
+private:
+    struct Fragment {
+        RECT     rect;
+        uint32_t window;
+    };
+
+    [[nodiscard]] int WindowAt(POINT screenPt) const noexcept;
+
+    std::vector<WindowInfo> windows_;     // candidates, front to back
+    std::vector<Fragment>   fragments_;   // visible parts, disjoint
+
+    // Grid: cell (cx, cy) holds cellItems_[cellStart_[i] .. cellStart_[i + 1]).
+    RECT                  grid_{};
+    int                   cols_{};
+    int                   rows_{};
+    std::vector<uint32_t> cellStart_;
+    std::vector<uint32_t> cellItems_;
+};
+
+} // namespace screencap::preview
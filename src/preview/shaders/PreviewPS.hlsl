@@ -0,0 +1,12 @@
+// Texture passthrough.  See Shaders.h.
+
+Texture2D    tex  : register(t0);
+SamplerState samp : register(s0);
+
+float4 PSMain(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target
+{
+    // Passthrough. Desktop capture produces pixels already in the intended space:
+    // - SDR preview: BGRA8 in display-referred space.
+    // - HDR preview: RGBA16F linear scRGB.
+    return tex.Sample(samp, uv);
+}
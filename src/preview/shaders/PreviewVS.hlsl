@@ -0,0 +1,9 @@
+// Fullscreen triangle via SV_VertexID.  See Shaders.h.
+
+void VSMain(uint id : SV_VertexID,
+            out float4 pos : SV_Position,
+            out float2 uv  : TEXCOORD)
+{
+    uv  = float2((id << 1) & 2, id & 2);
+    pos = float4(uv * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
@@ -0,0 +1,543 @@
+#include "win/AutomationServer.h"
+
+#include <sddl.h>
+
+#include <iterator>
+#include <utility>
+
+namespace screencap::win {
+namespace {
+
+// Longest request line accepted; the longest path plus a command fits.
+constexpr size_t kMaxLineBytes = 64 * 1024;
+// Requests a client may have unanswered; more are refused ("busy").
+constexpr size_t kMaxOutstanding = 256;
+// How long the client waits for a busy pipe (another client connected).
+constexpr DWORD kClientWaitMs = 10000;
+
+std::wstring PipeName()
+{
+    DWORD session = 0;
+    (void)::ProcessIdToSessionId(::GetCurrentProcessId(), &session);
+    return L"\\\\.\\pipe\\ScreenCap.Automation." + std::to_wstring(session);
+}
+
+// Security descriptor whose DACL grants read/write to this process's user
+// and nobody else (the default DACL also lets Everyone and anonymous
+// logons read).  LocalFree() it; null on failure.
+PSECURITY_DESCRIPTOR CurrentUserOnlyDescriptor()
+{
+    HANDLE token{};
+    if (!::OpenProcessToken(::GetCurrentProcess(), TOKEN_QUERY, &token)) return nullptr;
+    DWORD size = 0;
+    (void)::GetTokenInformation(token, TokenUser, nullptr, 0, &size);
+    std::vector<uint8_t> user(size);
+    LPWSTR sid = nullptr;
+    if (size && ::GetTokenInformation(token, TokenUser, user.data(), size, &size)) {
+        (void)::ConvertSidToStringSidW(reinterpret_cast<const TOKEN_USER*>(user.data())->User.Sid, &sid);
+    }
+    ::CloseHandle(token);
+    if (!sid) return nullptr;
+
+    // Protected (no inherited ACEs), one ACE: GENERIC_READ | GENERIC_WRITE.
+    const std::wstring sddl = L"D:P(A;;GRGW;;;" + std::wstring(sid) + L")";
+    ::LocalFree(sid);
+    PSECURITY_DESCRIPTOR descriptor = nullptr;
+    if (!::ConvertStringSecurityDescriptorToSecurityDescriptorW(sddl.c_str(), SDDL_REVISION_1,
+                                                                &descriptor, nullptr)) {
+        return nullptr;
+    }
+    return descriptor;
+}
+
+std::wstring FromUtf8(std::string_view text, bool& valid)
+{
+    valid = true;
+    if (text.empty()) return {};
+    const int n = ::MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, text.data(),
+                                        static_cast<int>(text.size()), nullptr, 0);
+    if (n <= 0) {
+        valid = false;
+        return {};
+    }
+    std::wstring wide(static_cast<size_t>(n), L'\0');
+    (void)::MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, text.data(),
+                                static_cast<int>(text.size()), wide.data(), n);
+    return wide;
+}
+
+std::string ToUtf8(std::wstring_view text)
+{
+    if (text.empty()) return {};
+    const int n = ::WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()),
+                                        nullptr, 0, nullptr, nullptr);
+    if (n <= 0) return {};
+    std::string narrow(static_cast<size_t>(n), '\0');
+    (void)::WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()),
+                                narrow.data(), n, nullptr, nullptr);
+    return narrow;
+}
+
+bool IsSpace(wchar_t c) noexcept
+{
+    return c == L' ' || c == L'\t';
+}
+
+std::wstring_view Trim(std::wstring_view s) noexcept
+{
+    while (!s.empty() && IsSpace(s.front())) s.remove_prefix(1);
+    while (!s.empty() && IsSpace(s.back())) s.remove_suffix(1);
+    return s;
+}
+
+// Next space-separated word of `rest`, which keeps what follows it.
+std::wstring_view NextWord(std::wstring_view& rest) noexcept
+{
+    rest = Trim(rest);
+    size_t end = 0;
+    while (end < rest.size() && !IsSpace(rest[end])) ++end;
+    const std::wstring_view word = rest.substr(0, end);
+    rest.remove_prefix(end);
+    return word;
+}
+
+bool Is(std::wstring_view word, std::wstring_view keyword) noexcept
+{
+    return ::CompareStringOrdinal(word.data(), static_cast<int>(word.size()),
+                                  keyword.data(), static_cast<int>(keyword.size()), TRUE) == CSTR_EQUAL;
+}
+
+// Decimal (optionally negative) or 0x hex.
+bool ParseInt(std::wstring_view word, int64_t& value) noexcept
+{
+    unsigned base = 10;
+    bool negative = false;
+    if (word.size() > 2 && word[0] == L'0' && (word[1] == L'x' || word[1] == L'X')) {
+        base = 16;
+        word.remove_prefix(2);
+    } else if (!word.empty() && word[0] == L'-') {
+        negative = true;
+        word.remove_prefix(1);
+    }
+    if (word.empty() || word.size() > 15) return false;
+
+    int64_t v = 0;
+    for (const wchar_t c : word) {
+        unsigned digit = 16;
+        if (c >= L'0' && c <= L'9')      digit = static_cast<unsigned>(c - L'0');
+        else if (c >= L'a' && c <= L'f') digit = static_cast<unsigned>(c - L'a' + 10);
+        else if (c >= L'A' && c <= L'F') digit = static_cast<unsigned>(c - L'A' + 10);
+        if (digit >= base) return false;
+        v = v * base + digit;
+    }
+    value = negative ? -v : v;
+    return true;
+}
+
+bool ParseCoordinate(std::wstring_view word, LONG& value) noexcept
+{
+    int64_t v = 0;
+    if (!ParseInt(word, v) || v < -(1 << 24) || v > (1 << 24)) return false;
+    value = static_cast<LONG>(v);
+    return true;
+}
+
+bool EndsWith(std::wstring_view s, std::wstring_view suffix) noexcept
+{
+    return s.size() >= suffix.size() && Is(s.substr(s.size() - suffix.size()), suffix);
+}
+
+// The rest of the line as an output path, or an error.
+bool ParsePath(std::wstring_view rest, std::wstring& path, std::string& error)
+{
+    rest = Trim(rest);
+    if (rest.size() >= 2 && rest.front() == L'"' && rest.back() == L'"') {
+        rest = rest.substr(1, rest.size() - 2);
+    }
+    // Drive-absolute or UNC; relative paths would resolve against the
+    // tray instance's directory, not the script's.
+    const bool drive = rest.size() >= 3 && rest[1] == L':' && (rest[2] == L'\\' || rest[2] == L'/');
+    const bool unc = rest.size() >= 3 && rest[0] == L'\\' && rest[1] == L'\\';
+    if (!drive && !unc) {
+        error = "path must be absolute";
+        return false;
+    }
+    if (!EndsWith(rest, L".png") && !EndsWith(rest, L".jxr")) {
+        error = "path must end in .png or .jxr";
+        return false;
+    }
+    path.assign(rest);
+    return true;
+}
+
+enum class Parsed { Ping, Request, Invalid };
+
+Parsed ParseRequest(std::wstring_view line, AutomationRequest& request, std::string& error)
+{
+    std::wstring_view rest = line;
+    const std::wstring_view verb = NextWord(rest);
+
+    if (Is(verb, L"ping") && Trim(rest).empty()) return Parsed::Ping;
+    if (Is(verb, L"outputs") && Trim(rest).empty()) {
+        request.command = AutomationCommand::Outputs;
+        return Parsed::Request;
+    }
+    if (!Is(verb, L"capture")) {
+        error = "unknown command";
+        return Parsed::Invalid;
+    }
+
+    const std::wstring_view target = NextWord(rest);
+    int64_t value = 0;
+    if (Is(target, L"desktop")) {
+        request.command = AutomationCommand::CaptureDesktop;
+    } else if (Is(target, L"output")) {
+        request.command = AutomationCommand::CaptureOutput;
+        if (!ParseInt(NextWord(rest), value) || value < 0 || value > 255) {
+            error = "expected an output index";
+            return Parsed::Invalid;
+        }
+        request.output = static_cast<uint32_t>(value);
+    } else if (Is(target, L"rect")) {
+        request.command = AutomationCommand::CaptureRect;
+        LONG x = 0, y = 0, w = 0, h = 0;
+        if (!ParseCoordinate(NextWord(rest), x) || !ParseCoordinate(NextWord(rest), y) ||
+            !ParseCoordinate(NextWord(rest), w) || !ParseCoordinate(NextWord(rest), h) ||
+            w <= 0 || h <= 0) {
+            error = "expected x y width height";
+            return Parsed::Invalid;
+        }
+        request.rect = {x, y, x + w, y + h};
+    } else if (Is(target, L"window")) {
+        request.command = AutomationCommand::CaptureWindow;
+        if (!ParseInt(NextWord(rest), value) || value <= 0) {
+            error = "expected a window handle";
+            return Parsed::Invalid;
+        }
+        request.window = reinterpret_cast<HWND>(static_cast<intptr_t>(value));
+    } else {
+        error = "expected desktop, output, rect or window";
+        return Parsed::Invalid;
+    }
+
+    return ParsePath(rest, request.path, error) ? Parsed::Request : Parsed::Invalid;
+}
+
+// Client output: stdout when redirected, else the console we were started
+// from (a GUI-subsystem process has neither by default).
+void Print(const std::string& text)
+{
+    HANDLE out = ::GetStdHandle(STD_OUTPUT_HANDLE);
+    HANDLE console = INVALID_HANDLE_VALUE;
+    if ((!out || out == INVALID_HANDLE_VALUE) && ::AttachConsole(ATTACH_PARENT_PROCESS)) {
+        console = ::CreateFileW(L"CONOUT$", GENERIC_WRITE, FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+        out = console;
+    }
+    if (out && out != INVALID_HANDLE_VALUE) {
+        DWORD written = 0;
+        (void)::WriteFile(out, text.data(), static_cast<DWORD>(text.size()), &written, nullptr);
+    }
+    if (console != INVALID_HANDLE_VALUE) ::CloseHandle(console);
+}
+
+} // namespace
+
+AutomationServer::~AutomationServer()
+{
+    Stop();
+}
+
+bool AutomationServer::Start(HWND notify, UINT message)
+{
+    if (thread_.joinable() || !notify) return false;
+
+    // One instance, so one client at a time and a squatter can't take the
+    // name first; local clients of this user only.
+    PSECURITY_DESCRIPTOR descriptor = CurrentUserOnlyDescriptor();
+    if (!descriptor) return false;
+    SECURITY_ATTRIBUTES security{sizeof(security), descriptor, FALSE};
+    pipe_ = ::CreateNamedPipeW(PipeName().c_str(),
+                               PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                               PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                               1, 4096, 4096, 0, &security);
+    ::LocalFree(descriptor);
+    stop_    = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    read_    = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    write_   = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    replied_ = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (pipe_ == INVALID_HANDLE_VALUE || !stop_ || !read_ || !write_ || !replied_) {
+        Stop();
+        return false;
+    }
+
+    notify_ = notify;
+    message_ = message;
+    thread_ = std::thread([this] { Run(); });
+    return true;
+}
+
+void AutomationServer::Stop()
+{
+    if (stop_) ::SetEvent(stop_);
+    if (thread_.joinable()) thread_.join();
+
+    if (pipe_ != INVALID_HANDLE_VALUE) {
+        ::CloseHandle(pipe_);
+        pipe_ = INVALID_HANDLE_VALUE;
+    }
+    // Late Reply()s (queued saves still encoding) check replied_ under the lock.
+    std::lock_guard lock(mutex_);
+    for (HANDLE* h : {&stop_, &read_, &write_, &replied_}) {
+        if (*h) {
+            ::CloseHandle(*h);
+            *h = nullptr;
+        }
+    }
+    requests_.clear();
+    replies_.clear();
+    notify_ = nullptr;
+}
+
+std::vector<AutomationRequest> AutomationServer::TakeRequests()
+{
+    std::lock_guard lock(mutex_);
+    std::vector<AutomationRequest> batch(std::make_move_iterator(requests_.begin()),
+                                         std::make_move_iterator(requests_.end()));
+    requests_.clear();
+    return batch;
+}
+
+bool AutomationServer::HasRequests()
+{
+    std::lock_guard lock(mutex_);
+    return !requests_.empty();
+}
+
+void AutomationServer::Reply(uint64_t id, bool ok, std::string_view detail)
+{
+    std::lock_guard lock(mutex_);
+    if (!replied_) return;
+    for (auto& pending : replies_) {
+        if (pending.id != id) continue;
+        pending.line = ok ? "ok" : "error";
+        if (!detail.empty()) {
+            pending.line += ' ';
+            pending.line += detail;
+        }
+        pending.done = true;
+        ::SetEvent(replied_);
+        return;
+    }
+}
+
+void AutomationServer::Run()
+{
+    while (::WaitForSingleObject(stop_, 0) == WAIT_TIMEOUT) {
+        if (Connect()) {
+            Serve();
+        } else {
+            // Don't spin on a pipe that keeps failing.
+            (void)::WaitForSingleObject(stop_, 100);
+        }
+        (void)::DisconnectNamedPipe(pipe_);
+        // Whatever is still running for that client finishes unanswered.
+        std::lock_guard lock(mutex_);
+        replies_.clear();
+    }
+}
+
+bool AutomationServer::Connect()
+{
+    OVERLAPPED ov{};
+    ov.hEvent = read_;
+    ::ResetEvent(read_);
+    if (::ConnectNamedPipe(pipe_, &ov)) return true;
+
+    switch (::GetLastError()) {
+    case ERROR_PIPE_CONNECTED:
+        return true;
+    case ERROR_IO_PENDING: {
+        const HANDLE handles[] = {stop_, read_};
+        DWORD n = 0;
+        if (::WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1) {
+            return ::GetOverlappedResult(pipe_, &ov, &n, FALSE) != FALSE;
+        }
+        (void)::CancelIoEx(pipe_, &ov);
+        (void)::GetOverlappedResult(pipe_, &ov, &n, TRUE);
+        return false;
+    }
+    default:
+        return false;
+    }
+}
+
+void AutomationServer::Serve()
+{
+    std::string inbox;
+    char buffer[4096];
+    OVERLAPPED ov{};
+    bool reading = false;
+
+    for (;;) {
+        if (!reading) {
+            ov = {};
+            ov.hEvent = read_;
+            ::ResetEvent(read_);
+            if (!::ReadFile(pipe_, buffer, sizeof(buffer), nullptr, &ov) &&
+                ::GetLastError() != ERROR_IO_PENDING) {
+                break;   // client gone
+            }
+            reading = true;
+        }
+
+        const HANDLE handles[] = {stop_, read_, replied_};
+        const DWORD woken = ::WaitForMultipleObjects(3, handles, FALSE, INFINITE);
+        if (woken == WAIT_OBJECT_0 + 1) {
+            reading = false;
+            DWORD n = 0;
+            if (!::GetOverlappedResult(pipe_, &ov, &n, FALSE)) break;
+            inbox.append(buffer, n);
+            if (!Accept(inbox)) {
+                (void)Flush();
+                break;
+            }
+        } else if (woken == WAIT_OBJECT_0 + 2) {
+            if (!Flush()) break;
+        } else {
+            break;
+        }
+    }
+
+    if (reading) {
+        DWORD n = 0;
+        (void)::CancelIoEx(pipe_, &ov);
+        (void)::GetOverlappedResult(pipe_, &ov, &n, TRUE);
+    }
+}
+
+bool AutomationServer::Accept(std::string& inbox)
+{
+    size_t start = 0;
+    for (size_t end; (end = inbox.find('\n', start)) != std::string::npos; start = end + 1) {
+        std::string_view line(inbox.data() + start, end - start);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (!line.empty()) Submit(line);
+    }
+    inbox.erase(0, start);
+
+    if (inbox.size() > kMaxLineBytes) {
+        std::lock_guard lock(mutex_);
+        replies_.push_back({++nextId_, true, "error line too long"});
+        return false;
+    }
+    return true;
+}
+
+void AutomationServer::Submit(std::string_view line)
+{
+    AutomationRequest request;
+    std::string error;
+    bool valid = false;
+    const std::wstring wide = FromUtf8(line, valid);
+    const Parsed parsed = valid ? ParseRequest(wide, request, error) : Parsed::Invalid;
+    if (!valid) error = "expected UTF-8";
+
+    std::lock_guard lock(mutex_);
+    const uint64_t id = ++nextId_;
+    if (replies_.size() >= kMaxOutstanding) {
+        replies_.push_back({id, true, "error busy"});
+    } else if (parsed == Parsed::Ping) {
+        replies_.push_back({id, true, "ok"});
+    } else if (parsed == Parsed::Invalid) {
+        replies_.push_back({id, true, "error " + error});
+    } else {
+        replies_.push_back({id, false, {}});
+        request.id = id;
+        requests_.push_back(std::move(request));
+        // One wake-up per batch; the UI thread takes everything queued.
+        if (requests_.size() == 1) ::PostMessageW(notify_, message_, 0, 0);
+        return;
+    }
+    ::SetEvent(replied_);
+}
+
+bool AutomationServer::Flush()
+{
+    for (;;) {
+        std::string line;
+        {
+            std::lock_guard lock(mutex_);
+            if (replies_.empty() || !replies_.front().done) return true;
+            line = std::move(replies_.front().line);
+            replies_.pop_front();
+        }
+        line += '\n';
+        if (!Write(line)) return false;
+    }
+}
+
+bool AutomationServer::Write(const std::string& data)
+{
+    OVERLAPPED ov{};
+    ov.hEvent = write_;
+    ::ResetEvent(write_);
+    DWORD n = 0;
+    if (!::WriteFile(pipe_, data.data(), static_cast<DWORD>(data.size()), nullptr, &ov)) {
+        if (::GetLastError() != ERROR_IO_PENDING) return false;
+        const HANDLE handles[] = {stop_, write_};
+        if (::WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0 + 1) {
+            (void)::CancelIoEx(pipe_, &ov);
+            (void)::GetOverlappedResult(pipe_, &ov, &n, TRUE);
+            return false;
+        }
+    }
+    return ::GetOverlappedResult(pipe_, &ov, &n, FALSE) && n == data.size();
+}
+
+// ── Client ──────────────────────────────────────────────────────────
+
+int RunAutomationClient(std::wstring_view requestLine)
+{
+    requestLine = Trim(requestLine);
+    if (requestLine.empty()) {
+        Print("error empty request\n");
+        return 1;
+    }
+
+    const std::wstring name = PipeName();
+    HANDLE pipe = INVALID_HANDLE_VALUE;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        // Identification only: the server has no business acting as us.
+        pipe = ::CreateFileW(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING,
+                             SECURITY_SQOS_PRESENT | SECURITY_IDENTIFICATION, nullptr);
+        if (pipe != INVALID_HANDLE_VALUE) break;
+        if (::GetLastError() != ERROR_PIPE_BUSY || !::WaitNamedPipeW(name.c_str(), kClientWaitMs)) break;
+    }
+    if (pipe == INVALID_HANDLE_VALUE) {
+        Print("error ScreenCap is not running\n");
+        return 2;
+    }
+
+    const std::string request = ToUtf8(requestLine) + '\n';
+    DWORD n = 0;
+    std::string reply;
+    if (::WriteFile(pipe, request.data(), static_cast<DWORD>(request.size()), &n, nullptr)) {
+        char buffer[512];
+        while (reply.find('\n') == std::string::npos && reply.size() < kMaxLineBytes &&
+               ::ReadFile(pipe, buffer, sizeof(buffer), &n, nullptr) && n > 0) {
+            reply.append(buffer, n);
+        }
+    }
+    ::CloseHandle(pipe);
+
+    const size_t end = reply.find('\n');
+    if (end == std::string::npos) {
+        Print("error no reply\n");
+        return 1;
+    }
+    reply.resize(end + 1);
+    Print(reply);
+    return reply.compare(0, 2, "ok") == 0 ? 0 : 1;
+}
+
+} // namespace screencap::win
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <windows.h>
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace screencap::win {
+
+// ── Scripted captures ───────────────────────────────────────────────
+//
+// A named pipe, \\.\pipe\ScreenCap.Automation.<session id>, local clients
+// of this session and user only, for batch jobs and test rigs.  One UTF-8
+// line per request, one reply line per request, in request order:
+//
+//   ping                                    ok
+//   outputs                                 ok <n> <l,t,r,b> ...
+//   capture desktop <path>                  ok | error <why>
+//   capture output <n> <path>               (n: index in the `outputs` list)
+//   capture rect <x> <y> <w> <h> <path>     (virtual-desktop coordinates)
+//   capture window <hwnd> <path>            (decimal or 0x hex)
+//
+// <path> is the rest of the line, optionally quoted: absolute, ending in
+// .png (SDR) or .jxr (FP16 kept).  "ok" means the file is written.
+// Requests that arrive together are handed to the UI thread as one
+// batch and share one desktop composite.  One client at a time; others
+// wait in WaitNamedPipe.
+
+enum class AutomationCommand {
+    Outputs,
+    CaptureDesktop,
+    CaptureOutput,
+    CaptureRect,
+    CaptureWindow,
+};
+
+struct AutomationRequest {
+    uint64_t          id{};        // for AutomationServer::Reply()
+    AutomationCommand command{AutomationCommand::Outputs};
+    uint32_t          output{};    // CaptureOutput
+    RECT              rect{};      // CaptureRect, desktop coordinates
+    HWND              window{};    // CaptureWindow
+    std::wstring      path;        // Capture*
+};
+
+class AutomationServer final {
+public:
+    AutomationServer() = default;
+    ~AutomationServer();   // Stop()
+
+    AutomationServer(const AutomationServer&) = delete;
+    AutomationServer& operator=(const AutomationServer&) = delete;
+    AutomationServer(AutomationServer&&) = delete;
+    AutomationServer& operator=(AutomationServer&&) = delete;
+
+    // Create the pipe and its thread.  `message` is posted to `notify`
+    // when requests are waiting.  False if the pipe exists already (a
+    // second instance) or can't be created.
+    [[nodiscard]] bool Start(HWND notify, UINT message);
+    void Stop();
+
+    // UI thread: every request not yet taken, oldest first.
+    [[nodiscard]] std::vector<AutomationRequest> TakeRequests();
+    [[nodiscard]] bool HasRequests();
+
+    // Any thread: answer request `id` with "ok[ detail]" or "error detail".
+    // Ignored once its client has gone.
+    void Reply(uint64_t id, bool ok, std::string_view detail = {});
+
+private:
+    // One line owed to the connected client.
+    struct Pending {
+        uint64_t    id{};
+        bool        done{false};
+        std::string line;
+    };
+
+    void Run();
+    [[nodiscard]] bool Connect();
+    void Serve();
+    // Queue the complete lines of `inbox`; false on an overlong line.
+    [[nodiscard]] bool Accept(std::string& inbox);
+    void Submit(std::string_view line);
+    // Write the finished replies at the head, in order.
+    [[nodiscard]] bool Flush();
+    [[nodiscard]] bool Write(const std::string& data);
+
+    HWND        notify_{};
+    UINT        message_{};
+    HANDLE      pipe_{INVALID_HANDLE_VALUE};
+    HANDLE      stop_{};      // manual-reset
+    HANDLE      read_{};      // manual-reset, overlapped connect / read
+    HANDLE      write_{};     // manual-reset, overlapped write
+    HANDLE      replied_{};   // auto-reset: a Pending became done
+    std::thread thread_;
+
+    std::mutex                    mutex_;
+    std::deque<AutomationRequest> requests_;   // not yet taken by the UI thread
+    std::deque<Pending>           replies_;    // current client's, in request order
+    uint64_t                      nextId_{0};
+};
+
+// Client side (winmain): send one request line to the running instance
+// and print its reply to stdout.  Exit code: 0 ok, 1 error, 2 no instance.
+[[nodiscard]] int RunAutomationClient(std::wstring_view requestLine);
+
+} // namespace screencap::win
@@ -1,7 +1,9 @@
 #include "TrayWindow.h"
 
+#include "capture/PixelBuffer.h"
 #include "capture/SaveImage.h"
-#include "preview/PreviewWindow.h"
+#include "capture/Trace.h"
+#include "capture/WhiteLevel.h"
 
 #include <d3d11.h>
 #include <dwmapi.h>
@@ -78,16 +80,59 @@ enum class MenuId : UINT {
     CaptureRegion = 1001,
     CaptureWindow = 1002,
     CaptureFullDesktop = 1003,
+    RecordVideo = 1004,
+    InstantReplay = 1005,
     CopyToClipboard = 1010,
+    FastPng = 1011,
+    SaveHdrJxr = 1012,
+    RecordTimings = 1013,
+    RecordHdrVideo = 1014,
+    KeepInstantReplay = 1015,
+    CaptureCursor = 1016,
+    AutoExposure = 1017,
+    ToneMapClip = 1030,         // + capture::ToneMapOperator
+    ToneMapReinhard = 1031,
+    ToneMapBt2390 = 1032,
+    ToneMapAces = 1033,
+    ShowTimings = 1020,
     Exit = 1099,
 };
 
-// Custom message posted by the low-level keyboard hook.
+// Custom message posted by the low-level keyboard hook: wParam = MenuId,
+// lParam = capture::TraceNow() at the key press.
 constexpr UINT kHookCaptureMsg = WM_APP + 200;
 
+// Posted by the output queue when a job finishes: wParam = kOutputOk |
+// kOutputToClipboard bits, lParam = new std::wstring thumbnail path (the
+// handler owns it).
+constexpr UINT kOutputDoneMsg = WM_APP + 300;
+constexpr WPARAM kOutputOk = 1;
+constexpr WPARAM kOutputToClipboard = 2;
+
+// Posted by the video recorder's pacing thread once per frame interval.
+constexpr UINT kRecordTickMsg = WM_APP + 400;
+
+// Posted by the automation pipe when requests are waiting.
+constexpr UINT kAutomationMsg = WM_APP + 500;
+
+// WM_TIMER ids: feeding the instant-replay ring, capture recovery, and
+// the idle check that notices lost outputs before the next capture.
+constexpr UINT_PTR kReplayTimerId = 1;
+constexpr UINT_PTR kRecoverTimerId = 2;
+constexpr UINT_PTR kHealthTimerId = 3;
+
+// Display changes come in bursts; recover once they settle.
+constexpr UINT kDisplaySettleMs = 250;
+// Retry interval while recovery fails (secure desktop, mode switch).
+constexpr UINT kRecoverRetryMs = 1000;
+constexpr UINT kHealthIntervalMs = 2000;
+// Pooled frame memory unused this long is given back (capture/PixelBuffer.h).
+constexpr uint32_t kPixelPoolIdleMs = 30000;
+
 // LL keyboard hook state (must be file-scoped for the callback).
 HWND  g_hookTargetHwnd = nullptr;
 HHOOK g_keyboardHook   = nullptr;
+capture::KeydownCapture* g_keydownCapture = nullptr;
 
 LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam)
 {
@@ -96,15 +141,25 @@ LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam)
         auto* kb = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
         if (kb->vkCode == VK_SNAPSHOT && g_hookTargetHwnd) {
             // Determine which capture mode based on modifier keys.
-            const bool alt  = (::GetAsyncKeyState(VK_MENU)    & 0x8000) != 0;
-            const bool ctrl = (::GetAsyncKeyState(VK_CONTROL) & 0x8000) != 0;
+            const bool alt   = (::GetAsyncKeyState(VK_MENU)    & 0x8000) != 0;
+            const bool ctrl  = (::GetAsyncKeyState(VK_CONTROL) & 0x8000) != 0;
+            const bool shift = (::GetAsyncKeyState(VK_SHIFT)   & 0x8000) != 0;
 
             UINT cmd{};
-            if (ctrl)     cmd = static_cast<UINT>(MenuId::CaptureFullDesktop);
-            else if (alt) cmd = static_cast<UINT>(MenuId::CaptureWindow);
-            else          cmd = static_cast<UINT>(MenuId::CaptureRegion);
-
-            ::PostMessageW(g_hookTargetHwnd, kHookCaptureMsg, cmd, 0);
+            if (shift)             cmd = static_cast<UINT>(MenuId::RecordVideo);
+            else if (ctrl && alt)  cmd = static_cast<UINT>(MenuId::InstantReplay);
+            else if (ctrl)         cmd = static_cast<UINT>(MenuId::CaptureFullDesktop);
+            else if (alt)          cmd = static_cast<UINT>(MenuId::CaptureWindow);
+            else                   cmd = static_cast<UINT>(MenuId::CaptureRegion);
+
+            // Stills freeze the desktop at the key press on the key-down
+            // thread, which then posts the command itself.
+            const int64_t now = capture::TraceNow();
+            const bool still = cmd != static_cast<UINT>(MenuId::RecordVideo) &&
+                               cmd != static_cast<UINT>(MenuId::InstantReplay);
+            if (!still || !g_keydownCapture || !g_keydownCapture->Trigger(cmd, now)) {
+                ::PostMessageW(g_hookTargetHwnd, kHookCaptureMsg, cmd, static_cast<LPARAM>(now));
+            }
             return 1; // Swallow the key — prevent Windows/Snipping Tool from handling it.
         }
     }
@@ -113,10 +168,47 @@ LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam)
 
 constexpr const wchar_t* kRegKey = L"Software\\ScreenCap";
 constexpr const wchar_t* kRegValueClipboard = L"CopyToClipboard";
+constexpr const wchar_t* kRegValueFastPng = L"FastPng";
+constexpr const wchar_t* kRegValueHdrJxr = L"SaveHdrJxr";
+constexpr const wchar_t* kRegValueRecordTimings = L"RecordTimings";
+constexpr const wchar_t* kRegValueRecordHdrVideo = L"RecordHdrVideo";
+constexpr const wchar_t* kRegValueInstantReplay = L"InstantReplay";
+constexpr const wchar_t* kRegValueCaptureCursor = L"CaptureCursor";
+constexpr const wchar_t* kRegValueToneMapOperator = L"ToneMapOperator";
+constexpr const wchar_t* kRegValueAutoExposure = L"AutoExposure";
+
+[[nodiscard]] UINT ToneMapMenuId(capture::ToneMapOperator op) noexcept
+{
+    return static_cast<UINT>(MenuId::ToneMapClip) + static_cast<UINT>(op);
+}
+
+// "<Videos>\ScreenCap yyyy-mm-dd hh-mm-ss.mp4", or empty if the folder is unknown.
+std::wstring NewVideoPath()
+{
+    PWSTR folder = nullptr;
+    if (FAILED(::SHGetKnownFolderPath(FOLDERID_Videos, KF_FLAG_CREATE, nullptr, &folder))) return {};
+    std::wstring path = folder;
+    ::CoTaskMemFree(folder);
+
+    SYSTEMTIME t{};
+    ::GetLocalTime(&t);
+    wchar_t name[64];
+    swprintf_s(name, L"\\ScreenCap %04u-%02u-%02u %02u-%02u-%02u.mp4",
+               t.wYear, t.wMonth, t.wDay, t.wHour, t.wMinute, t.wSecond);
+    return path + name;
+}
 
 } // namespace
 
 TrayWindow::TrayWindow()
+    : output_(&outputWorkers_, &clipboard_, [this](bool ok, bool toClipboard, const std::wstring& thumbnailPath) {
+          // Encode thread → UI thread for the toast.
+          auto path = std::make_unique<std::wstring>(thumbnailPath);
+          const WPARAM flags = (ok ? kOutputOk : 0) | (toClipboard ? kOutputToClipboard : 0);
+          if (::PostMessageW(hwnd_, kOutputDoneMsg, flags, reinterpret_cast<LPARAM>(path.get()))) {
+              (void)path.release();
+          }
+      })
 {
     taskbarCreatedMsg_ = ::RegisterWindowMessageW(L"TaskbarCreated");
     LoadSettings();
@@ -127,8 +219,9 @@ TrayWindow::~TrayWindow()
     icon_.reset();
 
     if (menu_) {
-        ::DestroyMenu(menu_);
+        ::DestroyMenu(menu_);   // and its submenus
         menu_ = nullptr;
+        toneMapMenu_ = nullptr;
     }
 
     if (hwnd_ && ::IsWindow(hwnd_)) {
@@ -140,13 +233,19 @@ TrayWindow::~TrayWindow()
 bool TrayWindow::InitD3D11()
 {
     const D3D_FEATURE_LEVEL requestedLevel = D3D_FEATURE_LEVEL_12_1;
-    HRESULT hr = ::D3D11CreateDevice(
-        nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr,
-        D3D11_CREATE_DEVICE_BGRA_SUPPORT,
-        &requestedLevel, 1,
-        D3D11_SDK_VERSION,
-        &d3dDevice_, nullptr, nullptr);
-    return SUCCEEDED(hr);
+    // Video support lets the recorder hand surfaces to the hardware
+    // encoder; drivers without it still capture stills.
+    for (const UINT flags : {D3D11_CREATE_DEVICE_BGRA_SUPPORT | D3D11_CREATE_DEVICE_VIDEO_SUPPORT,
+                             static_cast<UINT>(D3D11_CREATE_DEVICE_BGRA_SUPPORT)}) {
+        HRESULT hr = ::D3D11CreateDevice(
+            nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr,
+            flags,
+            &requestedLevel, 1,
+            D3D11_SDK_VERSION,
+            &d3dDevice_, nullptr, nullptr);
+        if (SUCCEEDED(hr)) return true;
+    }
+    return false;
 }
 
 int TrayWindow::Run()
@@ -163,11 +262,40 @@ int TrayWindow::Run()
         return 1;
     }
 
+    // Keep a live composite so captures never wait on DWM for a new frame.
+    duplicator_.SetContinuous(true);
+    duplicator_.SetCursorOverlay(captureCursor_);
+    toneMapper_.SetOperator(toneMapOperator_);
+    toneMapper_.SetAutoExposure(autoExposure_);
     if (!duplicator_.Init(d3dDevice_.Get())) {
         ::MessageBoxW(nullptr, L"Failed to initialize desktop capture.", L"ScreenCap", MB_OK | MB_ICONERROR);
         return 1;
     }
 
+    // Not fatal — hotkey captures then acquire on this thread.
+    (void)keydown_.Start(&duplicator_, [this](uint32_t cmd, int64_t keyDownAt) {
+        // Key-down thread → UI thread, as the hook would have.
+        ::PostMessageW(hwnd_, kHookCaptureMsg, cmd, static_cast<LPARAM>(keyDownAt));
+    });
+
+    // Not fatal — each has a slower fallback (CPU tone-map, blocking
+    // readback, one-shot window capture).
+    (void)toneMapper_.Init(d3dDevice_.Get());
+    (void)readback_.Init(d3dDevice_.Get());
+    (void)windowCapture_.Init(d3dDevice_.Get());
+
+    clipboard_.Init(hwnd_, &outputWorkers_);
+
+    // Window and swap chain up front, so a capture only uploads and presents.
+    // If this fails the first capture retries.
+    (void)preview_.Init(d3dDevice_.Get());
+
+    // Not fatal — only scripted captures need it.
+    (void)automation_.Start(hwnd_, kAutomationMsg);
+
+    StartReplay();
+    ::SetTimer(hwnd_, kHealthTimerId, kHealthIntervalMs, nullptr);
+
     EnsureTrayIcon();
     InstallKeyboardHook();
 
@@ -220,9 +348,41 @@ bool TrayWindow::CreateMenu()
     (void)::AppendMenuW(menu_, MF_STRING, static_cast<UINT_PTR>(MenuId::CaptureRegion), L"Capture Region...\tPrtScn");
     (void)::AppendMenuW(menu_, MF_STRING, static_cast<UINT_PTR>(MenuId::CaptureWindow), L"Capture Window...\tAlt+PrtScn");
     (void)::AppendMenuW(menu_, MF_STRING, static_cast<UINT_PTR>(MenuId::CaptureFullDesktop), L"Capture Full Desktop...\tCtrl+PrtScn");
+    (void)::AppendMenuW(menu_, MF_STRING, static_cast<UINT_PTR>(MenuId::InstantReplay), L"Instant Replay...\tCtrl+Alt+PrtScn");
+    (void)::AppendMenuW(menu_, MF_STRING, static_cast<UINT_PTR>(MenuId::RecordVideo), L"Start Recording\tShift+PrtScn");
     (void)::AppendMenuW(menu_, MF_SEPARATOR, 0, nullptr);
     (void)::AppendMenuW(menu_, MF_STRING | (copyToClipboard_ ? MF_CHECKED : MF_UNCHECKED),
                          static_cast<UINT_PTR>(MenuId::CopyToClipboard), L"Copy to Clipboard");
+    (void)::AppendMenuW(menu_, MF_STRING | (captureCursor_ ? MF_CHECKED : MF_UNCHECKED),
+                         static_cast<UINT_PTR>(MenuId::CaptureCursor), L"Include Mouse Pointer");
+    (void)::AppendMenuW(menu_, MF_STRING | (fastPng_ ? MF_CHECKED : MF_UNCHECKED),
+                         static_cast<UINT_PTR>(MenuId::FastPng), L"Faster PNG Saves (Larger Files)");
+    (void)::AppendMenuW(menu_, MF_STRING | (saveHdrJxr_ ? MF_CHECKED : MF_UNCHECKED),
+                         static_cast<UINT_PTR>(MenuId::SaveHdrJxr), L"Save HDR Captures as JPEG XR");
+    (void)::AppendMenuW(menu_, MF_STRING | (recordHdrVideo_ ? MF_CHECKED : MF_UNCHECKED),
+                         static_cast<UINT_PTR>(MenuId::RecordHdrVideo), L"Record HDR Video (HEVC)");
+    (void)::AppendMenuW(menu_, MF_STRING | (instantReplay_ ? MF_CHECKED : MF_UNCHECKED),
+                         static_cast<UINT_PTR>(MenuId::KeepInstantReplay), L"Keep Last Seconds for Instant Replay");
+
+    // HDR → SDR conversion of saved and copied captures.
+    toneMapMenu_ = ::CreatePopupMenu();
+    if (toneMapMenu_) {
+        (void)::AppendMenuW(toneMapMenu_, MF_STRING, static_cast<UINT_PTR>(MenuId::ToneMapClip), L"Clip Highlights");
+        (void)::AppendMenuW(toneMapMenu_, MF_STRING, static_cast<UINT_PTR>(MenuId::ToneMapReinhard), L"Reinhard");
+        (void)::AppendMenuW(toneMapMenu_, MF_STRING, static_cast<UINT_PTR>(MenuId::ToneMapBt2390), L"Roll Off to Display Peak (BT.2390)");
+        (void)::AppendMenuW(toneMapMenu_, MF_STRING, static_cast<UINT_PTR>(MenuId::ToneMapAces), L"Filmic (ACES)");
+        (void)::CheckMenuRadioItem(toneMapMenu_, ToneMapMenuId(capture::ToneMapOperator::Clip),
+                                   ToneMapMenuId(capture::ToneMapOperator::Aces), ToneMapMenuId(toneMapOperator_),
+                                   MF_BYCOMMAND);
+        (void)::AppendMenuW(toneMapMenu_, MF_SEPARATOR, 0, nullptr);
+        (void)::AppendMenuW(toneMapMenu_, MF_STRING | (autoExposure_ ? MF_CHECKED : MF_UNCHECKED),
+                             static_cast<UINT_PTR>(MenuId::AutoExposure), L"Auto Exposure");
+        (void)::AppendMenuW(menu_, MF_POPUP, reinterpret_cast<UINT_PTR>(toneMapMenu_), L"HDR to SDR");
+    }
+    (void)::AppendMenuW(menu_, MF_SEPARATOR, 0, nullptr);
+    (void)::AppendMenuW(menu_, MF_STRING | (recordTimings_ ? MF_CHECKED : MF_UNCHECKED),
+                         static_cast<UINT_PTR>(MenuId::RecordTimings), L"Record Capture Timings");
+    (void)::AppendMenuW(menu_, MF_STRING, static_cast<UINT_PTR>(MenuId::ShowTimings), L"Show Capture Timings...");
     (void)::AppendMenuW(menu_, MF_SEPARATOR, 0, nullptr);
     (void)::AppendMenuW(menu_, MF_STRING, static_cast<UINT_PTR>(MenuId::Exit), L"Exit");
 
@@ -258,16 +418,72 @@ LRESULT TrayWindow::WndProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
 
     switch (msg) {
     case WM_DESTROY:
+        keydown_.Stop();
+        automation_.Stop();
+        StopRecording();
+        StopReplay();
         icon_.reset();
         if (menu_) {
             ::DestroyMenu(menu_);
             menu_ = nullptr;
+            toneMapMenu_ = nullptr;
         }
         ::PostQuitMessage(0);
         return 0;
 
     case kHookCaptureMsg:
-        OnCommand(static_cast<UINT>(wparam));
+        OnCommand(static_cast<UINT>(wparam), static_cast<int64_t>(lparam));
+        return 0;
+
+    case kOutputDoneMsg: {
+        const std::unique_ptr<std::wstring> thumbnailPath(reinterpret_cast<std::wstring*>(lparam));
+        NotifyResult((wparam & kOutputOk) != 0, (wparam & kOutputToClipboard) != 0, *thumbnailPath);
+        return 0;
+    }
+
+    case kRecordTickMsg:
+        OnRecordTick();
+        return 0;
+
+    case kAutomationMsg:
+        OnAutomation();
+        return 0;
+
+    case WM_TIMER:
+        if (wparam == kReplayTimerId) {
+            OnReplayTick();
+            return 0;
+        }
+        if (wparam == kRecoverTimerId) {
+            ::KillTimer(hwnd_, kRecoverTimerId);
+            recoverPending_ = false;
+            (void)RecoverCapture();
+            return 0;
+        }
+        if (wparam == kHealthTimerId) {
+            OnHealthTick();
+            return 0;
+        }
+        break;
+
+    // Delayed-render clipboard: formats are built when a paste asks.
+    case WM_RENDERFORMAT:
+        clipboard_.Render(static_cast<UINT>(wparam));
+        return 0;
+
+    case WM_RENDERALLFORMATS:
+        clipboard_.RenderAll();
+        return 0;
+
+    case WM_DESTROYCLIPBOARD:
+        clipboard_.Release();
+        return 0;
+
+    case WM_DISPLAYCHANGE:
+        (void)preview_.Resize();
+        // Rebuild the duplications now rather than on the next capture.
+        duplicator_.NotifyDisplayChange();
+        ScheduleRecovery(kDisplaySettleMs, true);
         return 0;
 
     case kTrayCallbackMsg:
@@ -339,30 +555,37 @@ void TrayWindow::ShowContextMenu()
     }
 }
 
-void TrayWindow::NotifyResult(bool saved)
+void TrayWindow::NotifyResult(bool saved, bool toClipboard, const std::wstring& thumbnailPath)
 {
     if (!saved) return;
 
+    const wchar_t* message = toClipboard
+        ? L"Image copied to clipboard."
+        : L"Image saved to file.";
+    ShowToast(message, thumbnailPath);
+}
+
+void TrayWindow::ShowToast(const std::wstring& message, const std::wstring& imagePath)
+{
     try {
         namespace notif = winrt::Windows::UI::Notifications;
         namespace xml   = winrt::Windows::Data::Xml::Dom;
 
-        const wchar_t* message = copyToClipboard_
-            ? L"Image copied to clipboard."
-            : L"Image saved to file.";
-
-        // Build the image file URI (backslashes → forward slashes).
-        auto thumbPath = capture::GetThumbnailTempPath();
-        std::wstring imageUri = L"file:///";
-        for (wchar_t c : thumbPath) {
-            imageUri += (c == L'\\') ? L'/' : c;
+        std::wstring image;
+        if (!imagePath.empty()) {
+            // Build the image file URI (backslashes → forward slashes).
+            std::wstring imageUri = L"file:///";
+            for (wchar_t c : imagePath) {
+                imageUri += (c == L'\\') ? L'/' : c;
+            }
+            image = L"<image src=\"" + imageUri + L"\"/>";
         }
 
         std::wstring toastXml =
             L"<toast><visual><binding template=\"ToastGeneric\">"
             L"<text>ScreenCap</text>"
-            L"<text>" + std::wstring(message) + L"</text>"
-            L"<image src=\"" + imageUri + L"\"/>"
+            L"<text>" + message + L"</text>"
+            + image +
             L"</binding></visual></toast>";
 
         xml::XmlDocument doc;
@@ -378,26 +601,326 @@ void TrayWindow::NotifyResult(bool saved)
 
 std::optional<capture::FrameData> TrayWindow::CaptureDesktop()
 {
-    auto frame = duplicator_.CaptureFullDesktop();
+    auto frame = duplicator_.CaptureFullDesktop(&workers_);
     if (frame) return frame;
 
-    // Capture failed — the output duplications are likely stale
-    // (desktop format change, resolution change, monitor hotplug, etc.).
-    // Re-initialise and retry once.  DwmFlush() forces a composition
-    // so the new duplication has a real frame ready to acquire.
-    if (duplicator_.Init(d3dDevice_.Get())) {
+    // Capture failed — an output was lost (mode change, HDR toggle) or
+    // the layout changed before the background recovery got to it.
+    // Repair only what is broken and retry once.  DwmFlush() forces a
+    // composition so a new duplication has a real frame ready to acquire.
+    if (RecoverCapture()) {
         ::DwmFlush();
-        frame = duplicator_.CaptureFullDesktop();
+        frame = duplicator_.CaptureFullDesktop(&workers_);
         if (frame) return frame;
     }
 
     return std::nullopt;
 }
 
+// ── Video recording ─────────────────────────────────────────────────
+
+void TrayWindow::StartRecording()
+{
+    // One capture up front for the desktop size.
+    auto frame = CaptureDesktop();
+    const std::wstring path = NewVideoPath();
+    if (!frame || path.empty()) {
+        ::MessageBoxW(nullptr, L"Could not start recording.", L"ScreenCap", MB_OK | MB_ICONERROR);
+        return;
+    }
+
+    capture::VideoRecorder::Options options;
+    options.codec = recordHdrVideo_ ? capture::VideoCodec::Hevc : capture::VideoCodec::H264;
+    options.hdr10 = recordHdrVideo_;
+    options.sdrWhiteNits = capture::SdrWhiteNitsForFrame(*frame);
+
+    // Frames are converted here, on the UI thread that owns the immediate
+    // context; the tick only asks for the next one.
+    const auto onTick = [hwnd = hwnd_] { ::PostMessageW(hwnd, kRecordTickMsg, 0, 0); };
+
+    bool started = recorder_.Start(d3dDevice_.Get(), path, frame->width, frame->height, options, onTick);
+    if (!started && recordHdrVideo_) {
+        // No HEVC / Main10 encoder: record SDR H.264 instead.
+        options.codec = capture::VideoCodec::H264;
+        options.hdr10 = false;
+        started = recorder_.Start(d3dDevice_.Get(), path, frame->width, frame->height, options, onTick);
+    }
+    if (!started) {
+        ::MessageBoxW(nullptr, L"Video recording is not available on this system.", L"ScreenCap",
+                      MB_OK | MB_ICONERROR);
+        return;
+    }
+
+    (void)recorder_.SubmitFrame(*frame, capture::TraceNow());
+    (void)::ModifyMenuW(menu_, static_cast<UINT>(MenuId::RecordVideo), MF_BYCOMMAND | MF_STRING,
+                        static_cast<UINT_PTR>(MenuId::RecordVideo), L"Stop Recording\tShift+PrtScn");
+}
+
+void TrayWindow::StopRecording()
+{
+    if (!recorder_.IsRecording()) return;
+
+    const std::wstring path = recorder_.Path();
+    const bool saved = recorder_.Stop();
+    if (menu_) {
+        (void)::ModifyMenuW(menu_, static_cast<UINT>(MenuId::RecordVideo), MF_BYCOMMAND | MF_STRING,
+                            static_cast<UINT_PTR>(MenuId::RecordVideo), L"Start Recording\tShift+PrtScn");
+    }
+    if (saved) ShowToast(L"Video saved to " + path, {});
+}
+
+void TrayWindow::OnRecordTick()
+{
+    if (!recorder_.IsRecording()) return;
+
+    // The composite is copied out of the live one, so the recorder's
+    // conversion never races the next update.  A failed capture (layout
+    // change being re-initialised) just skips this frame.
+    auto frame = CaptureDesktop();
+    (void)recorder_.SubmitFrame(frame ? *frame : capture::FrameData{},
+                                frame ? frame->capturedAt : capture::TraceNow());
+}
+
+// ── Capture recovery ────────────────────────────────────────────────
+
+void TrayWindow::ScheduleRecovery(UINT delayMs, bool restart)
+{
+    // A pending attempt is left alone unless a new display change should
+    // push it back.
+    if (recoverPending_ && !restart) return;
+    recoverPending_ = true;
+    ::SetTimer(hwnd_, kRecoverTimerId, delayMs, nullptr);
+}
+
+bool TrayWindow::RecoverCapture()
+{
+    using Result = capture::DesktopDuplicator::RecoverResult;
+    switch (duplicator_.Recover()) {
+    case Result::Ok:
+    case Result::Reinitialised:
+        return true;
+    case Result::DeviceLost:
+        // Not under a preview still drawing with the old device.
+        if (!previewOpen_ && RecreateDevice()) return true;
+        break;
+    case Result::Failed:
+        break;
+    }
+    ScheduleRecovery(kRecoverRetryMs);
+    return false;
+}
+
+bool TrayWindow::RecreateDevice()
+{
+    // The recording and the replay ring live on the old device.
+    StopRecording();
+    StopReplay();
+
+    d3dDevice_.Reset();
+    if (!InitD3D11() || !duplicator_.Init(d3dDevice_.Get())) return false;
+
+    // Same fallbacks as at startup.
+    (void)toneMapper_.Init(d3dDevice_.Get());
+    (void)readback_.Init(d3dDevice_.Get());
+    (void)windowCapture_.Init(d3dDevice_.Get());
+    (void)preview_.Init(d3dDevice_.Get());
+    StartReplay();
+    return true;
+}
+
+void TrayWindow::OnHealthTick()
+{
+    capture::TrimPixelPool(kPixelPoolIdleMs);
+
+    // Recording and the replay ring update the duplicator themselves.
+    if (previewOpen_ || recorder_.IsRecording() || replay_.IsReady() || recoverPending_) return;
+
+    // Polls without waiting and keeps the live composite current, so a
+    // lost output is repaired ahead of the next capture.
+    if (!duplicator_.Update(&workers_) || duplicator_.NeedsRecovery()) {
+        ScheduleRecovery(0);
+    }
+}
+
+// ── Instant replay ──────────────────────────────────────────────────
+
+void TrayWindow::StartReplay()
+{
+    if (!instantReplay_ || !hwnd_) return;
+
+    // Sized on the first tick, from the live composite.
+    replay_.Reset();
+    replayVersion_ = 0;
+    ::SetTimer(hwnd_, kReplayTimerId, 1000 / capture::ReplayBuffer::Options{}.fps, nullptr);
+}
+
+void TrayWindow::StopReplay()
+{
+    if (hwnd_) ::KillTimer(hwnd_, kReplayTimerId);
+    replay_.Reset();
+}
+
+void TrayWindow::OnReplayTick()
+{
+    // The ring holds still while a past frame is being picked.
+    if (previewOpen_) return;
+
+    if (!duplicator_.Update(&workers_)) {
+        ScheduleRecovery(0);
+        return;
+    }
+
+    // Only changes are stored, so a static desktop costs nothing.
+    if (duplicator_.LiveVersion() == replayVersion_) return;
+    const auto live = duplicator_.LiveFrame();
+    if (!live) return;
+
+    if (!replay_.Matches(live->width, live->height)) {
+        if (!replay_.Init(d3dDevice_.Get(), live->width, live->height)) return;
+        // A smaller ring (large desktop) pushes less often.
+        ::SetTimer(hwnd_, kReplayTimerId, replay_.IntervalMs(), nullptr);
+    }
+    if (replay_.Push(*live, capture::TraceNow())) {
+        replayVersion_ = duplicator_.LiveVersion();
+    }
+}
+
+// ── Scripted captures ───────────────────────────────────────────────
+
+void TrayWindow::OnAutomation()
+{
+    // The preview owns the frozen desktop; OnCommand re-posts when it closes.
+    if (previewOpen_) return;
+
+    const std::vector<AutomationRequest> batch = automation_.TakeRequests();
+
+    // Desktop requests of one batch share a single composite.
+    std::optional<capture::FrameData> desktop;
+    bool desktopTaken = false;
+    bool windowsUsed = false;
+
+    for (const AutomationRequest& request : batch) {
+        if (request.command == AutomationCommand::Outputs) {
+            const auto rects = duplicator_.OutputRects();
+            std::string list = std::to_string(rects.size());
+            for (const RECT& r : rects) {
+                list += ' ' + std::to_string(r.left) + ',' + std::to_string(r.top) + ',' +
+                        std::to_string(r.right) + ',' + std::to_string(r.bottom);
+            }
+            automation_.Reply(request.id, true, list);
+            continue;
+        }
+
+        std::optional<capture::FrameData> window;
+        const capture::FrameData* source = nullptr;
+        RECT sel{};
+        if (request.command == AutomationCommand::CaptureWindow) {
+            if (!::IsWindow(request.window)) {
+                automation_.Reply(request.id, false, "no such window");
+                continue;
+            }
+            windowsUsed = true;
+            window = windowCapture_.Capture(request.window);
+            if (!window) {
+                automation_.Reply(request.id, false, "window capture failed");
+                continue;
+            }
+            source = &*window;
+            sel = {0, 0, static_cast<LONG>(window->width), static_cast<LONG>(window->height)};
+        } else {
+            if (!desktopTaken) {
+                desktop = CaptureDesktop();
+                desktopTaken = true;
+            }
+            if (!desktop) {
+                automation_.Reply(request.id, false, "desktop capture failed");
+                continue;
+            }
+            source = &*desktop;
+
+            // Frame pixels are desktop coordinates less the bounds' origin.
+            const auto bounds = duplicator_.DesktopBounds();
+            switch (request.command) {
+            case AutomationCommand::CaptureOutput: {
+                const auto rects = duplicator_.OutputRects();
+                if (request.output >= rects.size()) {
+                    automation_.Reply(request.id, false, "no such output");
+                    continue;
+                }
+                sel = rects[request.output];
+                break;
+            }
+            case AutomationCommand::CaptureRect:
+                sel = request.rect;
+                break;
+            default:
+                sel = {bounds.left, bounds.top, bounds.right, bounds.bottom};
+                break;
+            }
+            ::OffsetRect(&sel, -bounds.left, -bounds.top);
+        }
+
+        // .jxr keeps the FP16 pixels; everything else is tone-mapped here.
+        capture::FrameData image;
+        capture::GpuToneMapper* mapper = capture::KeepsHdr(request.path) ? nullptr : &toneMapper_;
+        if (!CropForOutput(*source, sel, mapper, image)) {
+            automation_.Reply(request.id, false, "region is outside the capture");
+            continue;
+        }
+
+        capture::OutputQueue::Job job;
+        job.frame = std::move(image);
+        job.path = request.path;
+        job.pngPreset = fastPng_ ? capture::PngPreset::Fast : capture::PngPreset::Compact;
+        job.onDone = [this, id = request.id](bool ok) {
+            automation_.Reply(id, ok, ok ? std::string_view{} : "could not write the file");
+        };
+        output_.Submit(std::move(job));
+    }
+
+    // Sessions keep copying frames until cleared.
+    if (windowsUsed) windowCapture_.Clear();
+}
+
+bool TrayWindow::CropForOutput(const capture::FrameData& source, RECT sel,
+                               capture::GpuToneMapper* toneMapper, capture::FrameData& out)
+{
+    const RECT frameRect{0, 0, static_cast<LONG>(source.width), static_cast<LONG>(source.height)};
+    if (!::IntersectRect(&sel, &sel, &frameRect)) return false;
+
+    // CPU frames are cropped in place.
+    if (!source.pixels.empty() || !source.gpuTexture) {
+        return preview::ExtractRegion(source, sel, d3dDevice_.Get(), toneMapper, out);
+    }
+
+    // GPU frames stay on the GPU: this thread only records the crop (and
+    // the tone map), and the encode thread streams the result to disk.
+    D3D11_BOX box{};
+    box.left   = static_cast<UINT>(sel.left);
+    box.top    = static_cast<UINT>(sel.top);
+    box.right  = static_cast<UINT>(sel.right);
+    box.bottom = static_cast<UINT>(sel.bottom);
+    box.back   = 1;
+
+    if (toneMapper && toneMapper->IsReady() &&
+        static_cast<DXGI_FORMAT>(source.format) == DXGI_FORMAT_R16G16B16A16_FLOAT) {
+        if (auto sdr = toneMapper->ToneMapToBgra8(source, capture::SdrWhiteNitsForFrame(source), &box)) {
+            out = std::move(*sdr);
+            return true;
+        }
+        // Fall through to an FP16 crop; the PNG encoder tone-maps the rows.
+    }
+
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext> ctx;
+    d3dDevice_->GetImmediateContext(&ctx);
+    return capture::CopyRegion(source, box, ctx.Get(), out);
+}
+
 void TrayWindow::InstallKeyboardHook()
 {
     if (g_keyboardHook) return;
     g_hookTargetHwnd = hwnd_;
+    g_keydownCapture = &keydown_;
     g_keyboardHook = ::SetWindowsHookExW(
         WH_KEYBOARD_LL,
         LowLevelKeyboardProc,
@@ -412,48 +935,158 @@ void TrayWindow::RemoveKeyboardHook()
         g_keyboardHook = nullptr;
     }
     g_hookTargetHwnd = nullptr;
+    g_keydownCapture = nullptr;
 }
 
-void TrayWindow::OnCommand(UINT cmd)
+void TrayWindow::OnCommand(UINT cmd, int64_t requestedAt)
 {
+    if (!requestedAt) requestedAt = capture::TraceNow();
+
     switch (static_cast<MenuId>(cmd)) {
     case MenuId::CaptureRegion:
     case MenuId::CaptureWindow:
     case MenuId::CaptureFullDesktop: {
+        // The preview's loop pumps messages, so a second PrtScn lands here
+        // while it is open; it already has the screen, so drop the key.
+        if (previewOpen_) break;
         auto frame = CaptureDesktop();
         if (!frame) {
             ::MessageBoxW(nullptr, L"Desktop capture failed.", L"ScreenCap", MB_OK | MB_ICONERROR);
             break;
         }
-        bool ok = false;
+        const preview::OutputServices services{
+            &toneMapper_, &workers_, &readback_, &windowCapture_,
+            fastPng_ ? capture::PngPreset::Fast : capture::PngPreset::Compact,
+            saveHdrJxr_ ? capture::HdrFormat::Jxr : capture::HdrFormat::None,
+            &output_, &clipboard_, requestedAt};
+        // The result only says whether output was queued; kOutputDoneMsg
+        // brings the outcome and the toast.
+        previewOpen_ = true;
         switch (static_cast<MenuId>(cmd)) {
         case MenuId::CaptureRegion:
-            ok = preview::ShowRegion(std::move(*frame), d3dDevice_.Get(), copyToClipboard_);
+            (void)preview_.ShowRegion(std::move(*frame), services, copyToClipboard_);
             break;
         case MenuId::CaptureWindow:
-            ok = preview::ShowWindowCapture(std::move(*frame), d3dDevice_.Get(), copyToClipboard_);
+            (void)preview_.ShowWindowCapture(std::move(*frame), services, copyToClipboard_);
             break;
         case MenuId::CaptureFullDesktop:
-            ok = preview::Show(std::move(*frame), d3dDevice_.Get(), copyToClipboard_);
+            (void)preview_.Show(std::move(*frame), services, copyToClipboard_);
             break;
         default:
             break;
         }
-        NotifyResult(ok);
+        previewOpen_ = false;
+        break;
+    }
+    case MenuId::InstantReplay: {
+        if (previewOpen_) break;
+        if (replay_.Count() == 0) {
+            const wchar_t* text = instantReplay_
+                ? L"Nothing recorded yet."
+                : L"Turn on \"Keep Last Seconds for Instant Replay\" first.";
+            ::MessageBoxW(nullptr, text, L"ScreenCap", MB_OK | MB_ICONINFORMATION);
+            break;
+        }
+        const preview::OutputServices services{
+            &toneMapper_, &workers_, &readback_, &windowCapture_,
+            fastPng_ ? capture::PngPreset::Fast : capture::PngPreset::Compact,
+            saveHdrJxr_ ? capture::HdrFormat::Jxr : capture::HdrFormat::None,
+            &output_, &clipboard_, requestedAt};
+        previewOpen_ = true;
+        (void)preview_.ShowReplay(replay_, services, copyToClipboard_);
+        previewOpen_ = false;
         break;
     }
+    case MenuId::RecordVideo:
+        if (recorder_.IsRecording()) StopRecording();
+        else                         StartRecording();
+        break;
     case MenuId::CopyToClipboard:
         copyToClipboard_ = !copyToClipboard_;
         ::CheckMenuItem(menu_, static_cast<UINT>(MenuId::CopyToClipboard),
                         MF_BYCOMMAND | (copyToClipboard_ ? MF_CHECKED : MF_UNCHECKED));
         SaveSettings();
         break;
+    case MenuId::FastPng:
+        fastPng_ = !fastPng_;
+        ::CheckMenuItem(menu_, static_cast<UINT>(MenuId::FastPng),
+                        MF_BYCOMMAND | (fastPng_ ? MF_CHECKED : MF_UNCHECKED));
+        SaveSettings();
+        break;
+    case MenuId::SaveHdrJxr:
+        saveHdrJxr_ = !saveHdrJxr_;
+        ::CheckMenuItem(menu_, static_cast<UINT>(MenuId::SaveHdrJxr),
+                        MF_BYCOMMAND | (saveHdrJxr_ ? MF_CHECKED : MF_UNCHECKED));
+        SaveSettings();
+        break;
+    case MenuId::RecordHdrVideo:
+        recordHdrVideo_ = !recordHdrVideo_;
+        ::CheckMenuItem(menu_, static_cast<UINT>(MenuId::RecordHdrVideo),
+                        MF_BYCOMMAND | (recordHdrVideo_ ? MF_CHECKED : MF_UNCHECKED));
+        SaveSettings();
+        break;
+    case MenuId::KeepInstantReplay:
+        instantReplay_ = !instantReplay_;
+        if (instantReplay_) StartReplay();
+        else                StopReplay();
+        ::CheckMenuItem(menu_, static_cast<UINT>(MenuId::KeepInstantReplay),
+                        MF_BYCOMMAND | (instantReplay_ ? MF_CHECKED : MF_UNCHECKED));
+        SaveSettings();
+        break;
+    case MenuId::CaptureCursor:
+        captureCursor_ = !captureCursor_;
+        duplicator_.SetCursorOverlay(captureCursor_);
+        ::CheckMenuItem(menu_, static_cast<UINT>(MenuId::CaptureCursor),
+                        MF_BYCOMMAND | (captureCursor_ ? MF_CHECKED : MF_UNCHECKED));
+        SaveSettings();
+        break;
+    case MenuId::ToneMapClip:
+    case MenuId::ToneMapReinhard:
+    case MenuId::ToneMapBt2390:
+    case MenuId::ToneMapAces:
+        toneMapOperator_ = static_cast<capture::ToneMapOperator>(cmd - static_cast<UINT>(MenuId::ToneMapClip));
+        toneMapper_.SetOperator(toneMapOperator_);
+        ::CheckMenuRadioItem(toneMapMenu_, ToneMapMenuId(capture::ToneMapOperator::Clip),
+                             ToneMapMenuId(capture::ToneMapOperator::Aces), cmd, MF_BYCOMMAND);
+        SaveSettings();
+        break;
+    case MenuId::AutoExposure:
+        autoExposure_ = !autoExposure_;
+        toneMapper_.SetAutoExposure(autoExposure_);
+        ::CheckMenuItem(toneMapMenu_, static_cast<UINT>(MenuId::AutoExposure),
+                        MF_BYCOMMAND | (autoExposure_ ? MF_CHECKED : MF_UNCHECKED));
+        SaveSettings();
+        break;
+    case MenuId::RecordTimings:
+        recordTimings_ = !recordTimings_;
+        capture::SetTraceStatsEnabled(recordTimings_);
+        ::CheckMenuItem(menu_, static_cast<UINT>(MenuId::RecordTimings),
+                        MF_BYCOMMAND | (recordTimings_ ? MF_CHECKED : MF_UNCHECKED));
+        SaveSettings();
+        break;
+    case MenuId::ShowTimings: {
+        std::wstring report = capture::TraceStatsReport();
+        if (report.empty()) {
+            report = recordTimings_
+                ? L"No captures recorded yet."
+                : L"Turn on \"Record Capture Timings\" and take a few captures.";
+        } else {
+            report = L"Last 256 samples per stage:\n\n" + report;
+        }
+        ::MessageBoxW(nullptr, report.c_str(), L"ScreenCap Capture Timings", MB_OK | MB_ICONINFORMATION);
+        break;
+    }
     case MenuId::Exit:
         ::DestroyWindow(hwnd_);
         break;
     default:
         break;
     }
+
+    // Scripted captures that arrived while a preview was open.
+    if (!previewOpen_ && automation_.HasRequests()) {
+        ::PostMessageW(hwnd_, kAutomationMsg, 0, 0);
+    }
 }
 
 // ── Persisted settings ──────────────────────────────────────────────
@@ -474,6 +1107,71 @@ void TrayWindow::LoadSettings()
         copyToClipboard_ = (val != 0);
     }
 
+    val = 0;
+    size = sizeof(val);
+    if (::RegQueryValueExW(key, kRegValueFastPng, nullptr, &type,
+                           reinterpret_cast<BYTE*>(&val), &size) == ERROR_SUCCESS &&
+        type == REG_DWORD) {
+        fastPng_ = (val != 0);
+    }
+
+    val = 0;
+    size = sizeof(val);
+    if (::RegQueryValueExW(key, kRegValueHdrJxr, nullptr, &type,
+                           reinterpret_cast<BYTE*>(&val), &size) == ERROR_SUCCESS &&
+        type == REG_DWORD) {
+        saveHdrJxr_ = (val != 0);
+    }
+
+    val = 0;
+    size = sizeof(val);
+    if (::RegQueryValueExW(key, kRegValueRecordTimings, nullptr, &type,
+                           reinterpret_cast<BYTE*>(&val), &size) == ERROR_SUCCESS &&
+        type == REG_DWORD) {
+        recordTimings_ = (val != 0);
+        capture::SetTraceStatsEnabled(recordTimings_);
+    }
+
+    val = 0;
+    size = sizeof(val);
+    if (::RegQueryValueExW(key, kRegValueRecordHdrVideo, nullptr, &type,
+                           reinterpret_cast<BYTE*>(&val), &size) == ERROR_SUCCESS &&
+        type == REG_DWORD) {
+        recordHdrVideo_ = (val != 0);
+    }
+
+    val = 0;
+    size = sizeof(val);
+    if (::RegQueryValueExW(key, kRegValueInstantReplay, nullptr, &type,
+                           reinterpret_cast<BYTE*>(&val), &size) == ERROR_SUCCESS &&
+        type == REG_DWORD) {
+        instantReplay_ = (val != 0);
+    }
+
+    val = 0;
+    size = sizeof(val);
+    if (::RegQueryValueExW(key, kRegValueCaptureCursor, nullptr, &type,
+                           reinterpret_cast<BYTE*>(&val), &size) == ERROR_SUCCESS &&
+        type == REG_DWORD) {
+        captureCursor_ = (val != 0);
+    }
+
+    val = 0;
+    size = sizeof(val);
+    if (::RegQueryValueExW(key, kRegValueToneMapOperator, nullptr, &type,
+                           reinterpret_cast<BYTE*>(&val), &size) == ERROR_SUCCESS &&
+        type == REG_DWORD && val < capture::kToneMapOperatorCount) {
+        toneMapOperator_ = static_cast<capture::ToneMapOperator>(val);
+    }
+
+    val = 0;
+    size = sizeof(val);
+    if (::RegQueryValueExW(key, kRegValueAutoExposure, nullptr, &type,
+                           reinterpret_cast<BYTE*>(&val), &size) == ERROR_SUCCESS &&
+        type == REG_DWORD) {
+        autoExposure_ = (val != 0);
+    }
+
     ::RegCloseKey(key);
 }
 
@@ -490,6 +1188,38 @@ void TrayWindow::SaveSettings()
     (void)::RegSetValueExW(key, kRegValueClipboard, 0, REG_DWORD,
                            reinterpret_cast<const BYTE*>(&val), sizeof(val));
 
+    const DWORD fastPng = fastPng_ ? 1 : 0;
+    (void)::RegSetValueExW(key, kRegValueFastPng, 0, REG_DWORD,
+                           reinterpret_cast<const BYTE*>(&fastPng), sizeof(fastPng));
+
+    const DWORD hdrJxr = saveHdrJxr_ ? 1 : 0;
+    (void)::RegSetValueExW(key, kRegValueHdrJxr, 0, REG_DWORD,
+                           reinterpret_cast<const BYTE*>(&hdrJxr), sizeof(hdrJxr));
+
+    const DWORD timings = recordTimings_ ? 1 : 0;
+    (void)::RegSetValueExW(key, kRegValueRecordTimings, 0, REG_DWORD,
+                           reinterpret_cast<const BYTE*>(&timings), sizeof(timings));
+
+    const DWORD hdrVideo = recordHdrVideo_ ? 1 : 0;
+    (void)::RegSetValueExW(key, kRegValueRecordHdrVideo, 0, REG_DWORD,
+                           reinterpret_cast<const BYTE*>(&hdrVideo), sizeof(hdrVideo));
+
+    const DWORD replay = instantReplay_ ? 1 : 0;
+    (void)::RegSetValueExW(key, kRegValueInstantReplay, 0, REG_DWORD,
+                           reinterpret_cast<const BYTE*>(&replay), sizeof(replay));
+
+    const DWORD cursor = captureCursor_ ? 1 : 0;
+    (void)::RegSetValueExW(key, kRegValueCaptureCursor, 0, REG_DWORD,
+                           reinterpret_cast<const BYTE*>(&cursor), sizeof(cursor));
+
+    const DWORD toneMap = static_cast<DWORD>(toneMapOperator_);
+    (void)::RegSetValueExW(key, kRegValueToneMapOperator, 0, REG_DWORD,
+                           reinterpret_cast<const BYTE*>(&toneMap), sizeof(toneMap));
+
+    const DWORD exposure = autoExposure_ ? 1 : 0;
+    (void)::RegSetValueExW(key, kRegValueAutoExposure, 0, REG_DWORD,
+                           reinterpret_cast<const BYTE*>(&exposure), sizeof(exposure));
+
     ::RegCloseKey(key);
 }
 
@@ -4,9 +4,21 @@
 #include <wrl/client.h>
 
 #include <optional>
+#include <string>
 
+#include "AutomationServer.h"
 #include "TrayIcon.h"
+#include "capture/AsyncReadback.h"
+#include "capture/ClipboardImage.h"
 #include "capture/DesktopDuplicator.h"
+#include "capture/GpuToneMapper.h"
+#include "capture/KeydownCapture.h"
+#include "capture/OutputQueue.h"
+#include "capture/ReplayBuffer.h"
+#include "capture/ThreadPool.h"
+#include "capture/VideoRecorder.h"
+#include "capture/WindowCapture.h"
+#include "preview/PreviewWindow.h"
 
 struct ID3D11Device;
 
@@ -33,12 +45,40 @@ private:
     [[nodiscard]] bool CreateMenu();
     void EnsureTrayIcon();
     void ShowContextMenu();
-    void OnCommand(UINT cmd);
-    void NotifyResult(bool saved);
+    // requestedAt: capture::TraceNow() when the hotkey was pressed (0 = now).
+    void OnCommand(UINT cmd, int64_t requestedAt = 0);
+    void NotifyResult(bool saved, bool toClipboard, const std::wstring& thumbnailPath);
+    void ShowToast(const std::wstring& message, const std::wstring& imagePath);
 
-    // Capture with automatic re-init on stale duplications.
+    // Video recording of the whole desktop, paced by the recorder's ticks.
+    void StartRecording();
+    void StopRecording();
+    void OnRecordTick();
+
+    // Instant replay: the ring is fed from the live composite on a timer.
+    void StartReplay();
+    void StopReplay();
+    void OnReplayTick();
+
+    // Scripted captures: run every request the pipe has queued, as one
+    // batch.  Deferred while a preview is open.
+    void OnAutomation();
+    // `sel` of `source` (frame pixels), tone-mapped unless toneMapper is
+    // null.  GPU sources give a GPU-only frame for the queue to stream.
+    [[nodiscard]] bool CropForOutput(const capture::FrameData& source, RECT sel,
+                                     capture::GpuToneMapper* toneMapper, capture::FrameData& out);
+
+    // Capture with recovery of stale duplications.
     [[nodiscard]] std::optional<capture::FrameData> CaptureDesktop();
 
+    // Repair the duplicator (lost outputs, layout change) or, when the
+    // device was removed, rebuild the shared device once for everything
+    // that uses it.  Retried on kRecoverTimerId until it succeeds.
+    bool RecoverCapture();
+    [[nodiscard]] bool RecreateDevice();
+    void ScheduleRecovery(UINT delayMs, bool restart = false);
+    void OnHealthTick();
+
     // Low-level keyboard hook to intercept PrtScn before Windows/Snipping Tool.
     void InstallKeyboardHook();
     void RemoveKeyboardHook();
@@ -49,11 +89,35 @@ private:
 
     HWND hwnd_{};
     HMENU menu_{};
+    HMENU toneMapMenu_{};                   // "HDR to SDR" submenu, owned by menu_
     UINT taskbarCreatedMsg_{};
     std::optional<TrayIcon> icon_{};
     Microsoft::WRL::ComPtr<ID3D11Device> d3dDevice_;
     capture::DesktopDuplicator duplicator_;
+    capture::KeydownCapture keydown_;       // freezes duplicator_ at a hotkey press
+    capture::GpuToneMapper toneMapper_;
+    capture::ThreadPool workers_;           // capture path; kept alive between captures
+    capture::ThreadPool outputWorkers_;     // output queue and clipboard: a save's conversion never holds up a capture
+    capture::AsyncReadback readback_;
+    capture::WindowCaptureCache windowCapture_;
+    capture::ClipboardImage clipboard_;     // owned by hwnd_ for delayed rendering
+    AutomationServer automation_;           // before output_: its saves reply to it
+    capture::OutputQueue output_;           // after workers_ and clipboard_: joined before they go
+    capture::VideoRecorder recorder_;
+    capture::ReplayBuffer replay_;
+    uint64_t replayVersion_{};              // duplicator_.LiveVersion() last pushed
+    bool previewOpen_{false};               // a preview's modal loop is running
+    bool recoverPending_{false};            // kRecoverTimerId is set
+    preview::PreviewWindow preview_;        // pre-created, reused by every capture
     bool copyToClipboard_{false};
+    bool fastPng_{false};                   // PngPreset::Fast instead of Compact
+    bool saveHdrJxr_{false};                // HdrFormat::Jxr: FP16 saves skip tone mapping
+    bool recordTimings_{false};             // rolling per-stage latency stats (capture/Trace.h)
+    bool recordHdrVideo_{false};            // HEVC HDR10 instead of H.264 SDR
+    bool instantReplay_{false};             // keep the last seconds in replay_
+    bool captureCursor_{false};             // mouse pointer in captures
+    capture::ToneMapOperator toneMapOperator_{capture::ToneMapOperator::Clip};  // GPU SDR conversion
+    bool autoExposure_{false};              // histogram-picked exposure before tone mapping
 };
 
 } // namespace screencap::win
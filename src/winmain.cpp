@@ -1,11 +1,19 @@
+#include "capture/Trace.h"
+#include "win/AutomationServer.h"
 #include "win/ComInit.h"
 #include "win/TrayWindow.h"
 
 #include <windows.h>
 #include <ShObjIdl.h>
 
-int WINAPI wWinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrev*/, PWSTR /*cmdLine*/, int /*cmdShow*/)
+int WINAPI wWinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrev*/, PWSTR cmdLine, int /*cmdShow*/)
 {
+    // With arguments this is a client: hand them to the running instance
+    // as one automation request (win/AutomationServer.h) and exit.
+    if (cmdLine && *cmdLine) {
+        return screencap::win::RunAutomationClient(cmdLine);
+    }
+
     // Single-instance guard.
     const HANDLE hMutex = ::CreateMutexW(nullptr, TRUE, L"ScreenCap.SingleInstance");
     if (::GetLastError() == ERROR_ALREADY_EXISTS) {
@@ -25,8 +33,16 @@ int WINAPI wWinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrev*/, PWSTR /*cmdLin
         return 1;
     }
 
-    screencap::win::TrayWindow app;
-    const int ret = app.Run();
+    // ETW / WPA latency events (capture/Trace.h).
+    screencap::capture::TraceRegister();
+
+    int ret = 0;
+    {
+        screencap::win::TrayWindow app;
+        ret = app.Run();
+    }
+
+    screencap::capture::TraceUnregister();
 
     if (hMutex) ::CloseHandle(hMutex);
     return ret;